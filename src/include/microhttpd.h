@@ -527,6 +527,18 @@ _MHD_EXTERN const char *
 MHD_get_reason_phrase_for (unsigned int code);
 
 
+/**
+ * Returns the length of the standard (RFC) reason phrase returned
+ * by #MHD_get_reason_phrase_for() for the given status code.
+ *
+ * @param code the HTTP status code
+ * @return length of the phrase in characters
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+_MHD_EXTERN size_t
+MHD_get_reason_phrase_len_for (unsigned int code);
+
+
 /**
  * Flag to be or-ed with MHD_HTTP status code for
  * SHOUTcast.  This will cause the response to begin
@@ -1334,7 +1346,73 @@ enum MHD_FLAG
    * Flag set to enable TLS 1.3 early data.  This has
    * security implications, be VERY careful when using this.
    */
-  MHD_USE_INSECURE_TLS_EARLY_DATA = 1U << 18
+  MHD_USE_INSECURE_TLS_EARLY_DATA = 1U << 18,
+
+  /**
+   * With #MHD_OPTION_THREAD_POOL_SIZE, give every worker thread its
+   * own listen socket bound with `SO_REUSEPORT` to the same
+   * address:port instead of sharing a single accept queue across all
+   * workers.  The kernel then distributes incoming connections over
+   * the per-worker queues, avoiding thundering-herd wakeups and
+   * `accept()` contention at high connection-arrival rates.
+   * This flag implies #MHD_USE_ITC and is ignored unless a thread
+   * pool of at least two workers is used.  On platforms without
+   * `SO_REUSEPORT` using this flag will cause #MHD_start_daemon to
+   * fail.  Note that #MHD_quiesce_daemon cannot be used with
+   * per-worker listen sockets.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_USE_REUSEPORT_WORKER_LISTENERS = (1U << 20) | MHD_USE_ITC,
+
+  /**
+   * Opt in to kernel zero-copy transmission (Linux `MSG_ZEROCOPY`)
+   * for large buffer-backed responses.  Transfers above an internal
+   * size threshold are handed to the kernel by reference instead of
+   * being copied into socket buffers; completion notifications are
+   * consumed internally before the response buffer can be released.
+   * The application must keep response buffers unmodified until the
+   * response is destroyed (which #MHD_RESPMEM_PERSISTENT already
+   * requires).  Silently ignored on platforms without MSG_ZEROCOPY
+   * support.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_USE_ZEROCOPY_SEND = 1U << 21,
+
+  /**
+   * Collect a time-to-first-byte latency histogram: MHD timestamps
+   * the start of every request and records the time until the
+   * first response byte is handed to the kernel in per-worker
+   * power-of-two millisecond buckets (no locks, no syscalls on the
+   * hot path).  Read the aggregated histogram with
+   * #MHD_DAEMON_INFO_TTFB_HISTOGRAM.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_USE_LATENCY_HISTOGRAM = 1U << 22,
+
+  /**
+   * Enable stateless TLS session resumption (RFC 5077 session
+   * tickets): a per-daemon ticket key is generated at startup and
+   * reconnecting clients skip the full handshake.  Opt-in, since
+   * all sessions resumable with the same ticket key share its
+   * fate for the daemon's lifetime (restart the daemon to rotate).
+   * Only useful in combination with #MHD_USE_TLS.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_USE_TLS_SESSION_TICKETS = 1U << 23,
+
+  /**
+   * Defer all TLS state construction (priority parsing, credential
+   * and DH-parameter setup) from #MHD_start_daemon to the first
+   * TLS accept, cutting daemon cold-start cost for short-lived
+   * sidecar daemons that may never receive a connection.  With
+   * this flag the memory behind TLS options (including
+   * #MHD_OPTION_HTTPS_KEY_PASSWORD) must remain valid while the
+   * daemon runs, and a credential error that #MHD_start_daemon
+   * would have reported surfaces as failing TLS accepts instead.
+   * Only useful in combination with #MHD_USE_TLS.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_USE_LAZY_TLS_INIT = 1U << 24
 
 };
 
@@ -1727,7 +1805,305 @@ enum MHD_OPTION
    * This argument must be followed by an "unsigned int", corresponding
    * to an `enum MHD_DisableSanityCheck`.
    */
-  MHD_OPTION_SERVER_INSANITY = 32
+  MHD_OPTION_SERVER_INSANITY = 32,
+
+  /**
+   * Maximum number of closed connections whose `struct MHD_Connection`
+   * and memory pool should be kept on a per-daemon (per-worker, with a
+   * thread pool) free list for reuse by later accepts, instead of
+   * being freed and reallocated on every connection.  This removes the
+   * malloc/free pair per accepted connection under high connection
+   * churn.  This option should be followed by an `unsigned int`
+   * argument.  The default is zero, which disables recycling.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_CONNECTION_RECYCLE_LIMIT = 33,
+
+  /**
+   * Maximum number of connections to accept() per listen-socket
+   * readiness event before returning to the event loop.  Draining
+   * a burst of queued connections in one wakeup avoids paying a
+   * full loop iteration per accepted socket under connection
+   * floods; the loop still stops early when the backlog is
+   * drained, the connection limit is reached or memory is tight.
+   * This option should be followed by an `unsigned int` argument.
+   * The default is 10.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_ACCEPT_BURST_SIZE = 34,
+
+  /**
+   * After how many milliseconds of inactivity should a connection
+   * automatically be timed out?  Like #MHD_OPTION_CONNECTION_TIMEOUT
+   * but with millisecond resolution, so stuck clients (and their
+   * memory pools) can be shed on sub-second SLAs.  (Followed by an
+   * `unsigned int`; use zero for no timeout.)  If both options are
+   * given, the one specified later wins.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_CONNECTION_TIMEOUT_MS = 35,
+
+  /**
+   * Pin the threads of the worker pool to CPUs: worker k is bound
+   * to CPU ((value - 1) + k) modulo the number of online CPUs, so
+   * workers stop migrating across cores/NUMA nodes and each
+   * worker's connection pools (which are allocated in the worker's
+   * own thread) stay node-local by first touch.  Where the worker
+   * owns its own listen socket
+   * (#MHD_USE_REUSEPORT_WORKER_LISTENERS) `SO_INCOMING_CPU` is
+   * additionally set so the kernel steers connections to the
+   * worker pinned on the receiving CPU.  This option should be
+   * followed by an `unsigned int`: 0 disables pinning, a value of
+   * N pins worker 0 to CPU N-1.  Silently ignored on platforms
+   * without thread-affinity support.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_WORKER_CPU_PINNING = 36,
+
+  /**
+   * Back per-connection memory pools by a contiguous per-worker
+   * arena allocated with huge pages where available (Linux
+   * MAP_HUGETLB, falling back to transparent huge pages, falling
+   * back to plain memory), carved into pool-sized slots: pool
+   * create/destroy become pointer arithmetic and parsing hot paths
+   * stop thrashing the dTLB across tens of thousands of small
+   * mappings.  This option should be followed by an `unsigned int`
+   * giving the number of pool slots per worker (connections beyond
+   * that fall back to individually allocated pools); 0 disables
+   * the arena (default).
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_POOL_ARENA_SLOTS = 37,
+
+  /**
+   * Enable `TCP_DEFER_ACCEPT` on the listen socket(s) (Linux):
+   * connections are only reported by the kernel once the first
+   * request data has arrived, so empty (probe/idle) connections do
+   * not wake workers.  This option should be followed by an
+   * `unsigned int` giving the maximum time in seconds the kernel
+   * waits for data; 0 disables (default).  Silently ignored on
+   * platforms without TCP_DEFER_ACCEPT.  For TCP Fast Open use the
+   * existing #MHD_USE_TCP_FASTOPEN flag and
+   * #MHD_OPTION_TCP_FASTOPEN_QUEUE_SIZE.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_LISTEN_DEFER_ACCEPT = 38,
+
+  /**
+   * Use small TLS records at the start of each connection for
+   * better time-to-first-byte on lossy/slow links: until 64 KiB
+   * have been sent on a connection, records are capped at the
+   * given payload size (a value around 1400 keeps each record
+   * within one MTU, so the client can decrypt record-by-record
+   * without waiting for a 16 KiB record to be reassembled), then
+   * full-size records resume for throughput.  This option should
+   * be followed by an `unsigned int`; 0 disables the cap
+   * (default).
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_TLS_FIRST_RECORD_SIZE = 39,
+
+  /**
+   * Default response transmission rate limit applied to every
+   * connection, in bytes per second (followed by an
+   * `unsigned int`; 0 = unlimited, the default).  Individual
+   * connections can override it with
+   * #MHD_CONNECTION_OPTION_RATE_LIMIT.
+   * @note Available since #MHD_VERSION 0x00097107
+   * Not supported (the option is refused) in
+   * thread-per-connection mode, which has no owning event loop
+   * to re-arm a paced connection.
+   */
+  MHD_OPTION_RESPONSE_RATE_LIMIT = 40,
+
+  /**
+   * Attach an access-log pipeline (created with
+   * #MHD_access_log_create()) to this daemon: every completed
+   * request deposits one binary record into the log's ring.  This
+   * option should be followed by a `struct MHD_AccessLog *`
+   * argument.  The log must outlive the daemon.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_ACCESS_LOG = 41,
+
+  /**
+   * Maximum number of request header lines accepted per request;
+   * requests exceeding it are rejected with 431 as soon as the
+   * budget is crossed, without further parsing or copying.
+   * (Followed by an `unsigned int`; 0, the default, means limited
+   * only by pool memory.)
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_MAX_HEADER_COUNT = 42,
+
+  /**
+   * Maximum length of the request target (URI) in bytes; longer
+   * request lines are rejected with 414 immediately after the
+   * request line is split.  (Followed by an `unsigned int`; 0, the
+   * default, means limited only by pool memory.)
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_MAX_URI_BYTES = 43,
+
+  /**
+   * Wall-clock deadline for receiving the complete request header
+   * block, in milliseconds from the first request byte (followed
+   * by an `unsigned int`; 0 = no deadline, the default).  Unlike
+   * the inactivity timeout, a slowloris client dripping bytes
+   * cannot extend this: the connection is closed when the deadline
+   * passes.  Checked when the connection is processed, so
+   * enforcement granularity is bounded by the client's own drip
+   * interval (or the inactivity timeout, whichever fires first).
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_HEADER_DEADLINE_MS = 44,
+
+  /**
+   * Wall-clock deadline for the complete request (headers, body
+   * and response transmission), in milliseconds from the first
+   * request byte (followed by an `unsigned int`; 0 = no deadline,
+   * the default).  Same enforcement granularity as
+   * #MHD_OPTION_HEADER_DEADLINE_MS.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_REQUEST_DEADLINE_MS = 45,
+
+  /**
+   * Initial size of the per-connection read buffer in bytes
+   * (followed by a `size_t`; 0, the default, keeps the historic
+   * behavior of starting with half of the pool's free space).
+   * Workloads with known header sizes (e.g. ~6KB of signed
+   * headers) can start the buffer right-sized and skip the
+   * reallocate-and-copy growth cycles; growth beyond the initial
+   * size continues per #MHD_OPTION_CONNECTION_MEMORY_INCREMENT.
+   * Values above the pool size are clamped.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_INITIAL_READ_BUFFER_SIZE = 46,
+
+  /**
+   * Busy-poll budget in microseconds for #MHD_USE_EPOLL daemons
+   * (followed by an `unsigned int`; 0 = disabled, the default):
+   * before blocking in epoll_wait, the loop spins on zero-timeout
+   * polls for up to the given budget, trading CPU for the
+   * sleep/wake latency of the blocking path -- for sub-millisecond
+   * p99 targets on dedicated cores.  Only attempt with pinned
+   * workers on reserved CPUs.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_BUSY_POLL_US = 47,
+
+  /**
+   * Per-iteration CPU budget of the event loop, in milliseconds
+   * (followed by an `unsigned int`).  When one processing pass
+   * (time between returning from the poll syscall and re-entering
+   * it) exceeds the budget the daemon enters overload state; it
+   * leaves the state once a pass completes in less than half the
+   * budget.  What the overload state does is selected with
+   * #MHD_OPTION_OVERLOAD_SHED_MODE.  Zero (default) disables the
+   * accounting.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_LOOP_BUDGET_MS = 48,
+
+  /**
+   * Shedding policy applied while the daemon is overloaded
+   * (followed by an `unsigned int`): 1 = pause accepting (the
+   * listen socket leaves the interest set, the kernel queue
+   * honors the configured backlog), 2 = accept but answer the
+   * first request of connections accepted during overload with an
+   * interned 503 response while established keep-alive traffic
+   * continues to be served.  Controlled degradation instead of
+   * congestion collapse when pushed past capacity; requires
+   * #MHD_OPTION_LOOP_BUDGET_MS.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_OVERLOAD_SHED_MODE = 49,
+
+  /**
+   * Expect the PROXY protocol (v1 text or v2 binary, as spoken by
+   * HAProxy and most L4 balancers) as a preamble on every accepted
+   * connection (followed by an `unsigned int`; any non-zero value
+   * enables it).  MHD parses the preamble before HTTP parsing
+   * starts, replaces the connection's client address with the one
+   * the proxy reports -- visible through
+   * #MHD_CONNECTION_INFO_CLIENT_ADDRESS and used by the per-IP
+   * connection accounting -- and rejects connections whose
+   * preamble is malformed.  Only enable on listeners reachable
+   * exclusively by trusted frontends: the preamble is
+   * unauthenticated by design.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_PROXY_PROTOCOL = 50,
+
+  /**
+   * Register a callback invoked whenever a connection's memory
+   * pool is exhausted (followed by a function of type
+   * #MHD_PoolExhaustionCallback and a `void *` closure).  The
+   * callback receives the size of the failed allocation and the
+   * phase it happened in, turning silent client-visible failures
+   * into sizing telemetry for
+   * #MHD_OPTION_CONNECTION_MEMORY_LIMIT.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_POOL_EXHAUSTION_CALLBACK = 51,
+
+  /**
+   * Keep one spare pool-sized emergency slab per worker (followed
+   * by an `unsigned int`; any non-zero value enables it).  When
+   * building the response headers fails for lack of pool memory
+   * the slab lets the in-flight request complete -- the
+   * connection is flagged close-after-response and the slab is
+   * reused once that connection is gone -- converting a hard 500
+   * into a graceful completion.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_POOL_OVERFLOW_SLAB = 52,
+
+  /**
+   * Carve the daemon's long-lived allocations (worker array,
+   * digest-auth nonce map, epoll event buffers) out of one
+   * contiguous arena mapped at #MHD_start_daemon() time (followed
+   * by an `unsigned int`): 1 allocates and prefaults the arena,
+   * 2 additionally requests hugepage backing (falling back to
+   * normal pages).  Improves locality of the per-iteration
+   * working set and removes first-touch page faults from the
+   * early request path after deploys.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_DAEMON_ARENA = 53,
+
+  /**
+   * Size of the handler-thread cache for
+   * #MHD_USE_THREAD_PER_CONNECTION daemons (followed by an
+   * `unsigned int`; 0, the default, disables caching).  Threads
+   * whose connection completed park in a bounded pool (their
+   * stacks are returned to the kernel while parked) and pick up
+   * the next accepted connection through a condition-variable
+   * handoff instead of a fresh pthread_create per accept --
+   * thread-per-connection semantics at near-thread-pool cost
+   * under connection churn.  POSIX threads only; ignored
+   * elsewhere and without #MHD_USE_THREAD_PER_CONNECTION.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_THREAD_CACHE_SIZE = 54,
+
+  /**
+   * Adopt a batch of pre-bound, already-listening sockets
+   * (systemd-style socket activation: the fds LISTEN_FDS hands
+   * over starting at 3).  Followed by an `unsigned int` count and
+   * a `const MHD_socket *` array.  The first socket becomes the
+   * daemon's primary listener, every further one is attached as
+   * an extra listener served by the same event loops and worker
+   * pool with the daemon's default handler; bind/listen are
+   * skipped entirely and all listeners are armed before
+   * #MHD_start_daemon() returns, so a scale-to-zero service is
+   * ready for its first request immediately after activation.
+   * Mutually exclusive with #MHD_OPTION_LISTEN_SOCKET and a
+   * port-based primary listener.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_OPTION_LISTEN_SOCKET_ARRAY = 55
 };
 
 
@@ -1906,8 +2282,92 @@ enum MHD_ConnectionNotificationCode
 /**
  * Information about a connection.
  */
+/**
+ * Portable snapshot of transport-level statistics for a
+ * connection, filled from the kernel's TCP information where
+ * available (TCP_INFO on Linux); unsupported fields read zero.
+ * Refreshed at most once per event-loop pass, so per-request
+ * queries do not trigger getsockopt() storms.
+ * @sa #MHD_CONNECTION_INFO_TCP_INFO
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_TcpInfoSnapshot
+{
+  /**
+   * Smoothed round-trip time, in microseconds.
+   */
+  uint32_t rtt_usec;
+
+  /**
+   * Round-trip time variance, in microseconds.
+   */
+  uint32_t rtt_var_usec;
+
+  /**
+   * Congestion window, in MSS units.
+   */
+  uint32_t snd_cwnd;
+
+  /**
+   * Segments sent but not yet acknowledged.
+   */
+  uint32_t unacked;
+
+  /**
+   * Segments counted lost by the sender.
+   */
+  uint32_t lost;
+
+  /**
+   * Total retransmitted segments on this connection.
+   */
+  uint32_t total_retrans;
+
+  /**
+   * Bytes accepted by the kernel but not yet handed to the wire
+   * (send queue depth below MHD's own buffers).
+   */
+  uint32_t notsent_bytes;
+};
+
+
 union MHD_ConnectionInfo
 {
+  /**
+   * Declared request Content-Length, for
+   * #MHD_CONNECTION_INFO_REQUEST_CONTENT_LENGTH.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  uint64_t content_length;
+
+  /**
+   * Response bytes queued inside MHD but not yet accepted by the
+   * kernel, for #MHD_CONNECTION_INFO_UNSENT_BYTES.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  uint64_t unsent_bytes;
+
+  /**
+   * Transport statistics snapshot, for
+   * #MHD_CONNECTION_INFO_TCP_INFO.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  struct MHD_TcpInfoSnapshot tcp_info;
+
+  /**
+   * Cumulative socket bytes read from this connection, for
+   * #MHD_CONNECTION_INFO_BYTES_RECEIVED.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  uint64_t bytes_received;
+
+  /**
+   * Per-request correlation ID, for
+   * #MHD_CONNECTION_INFO_REQUEST_ID.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  uint64_t request_id;
+
 
   /**
    * Cipher algorithm used, of type "enum gnutls_cipher_algorithm".
@@ -2035,6 +2495,17 @@ enum MHD_ConnectionInfoType
    * argument of the #MHD_AccessHandlerCallback.  The "con_cls" is
    * fresh for each HTTP request, while the "socket_context" is fresh
    * for each socket.
+   *
+   * Note the complete set of built-in state slots -- no external
+   * pointer-keyed maps are needed: @e socket_context here lives for
+   * the connection (set it from the
+   * #MHD_OPTION_NOTIFY_CONNECTION callback at
+   * #MHD_CONNECTION_NOTIFY_STARTED), while the `con_cls` pointer of
+   * the #MHD_AccessHandlerCallback is request-scoped (reset between
+   * keep-alive requests, handed to the
+   * #MHD_OPTION_NOTIFY_COMPLETED callback for cleanup); the memory
+   * both point to can itself come from the request-reclaimed pool
+   * via #MHD_connection_alloc().
    */
   MHD_CONNECTION_INFO_SOCKET_CONTEXT,
 
@@ -2054,7 +2525,77 @@ enum MHD_ConnectionInfoType
    * Return length of the client's HTTP request header.
    * @ingroup request
    */
-  MHD_CONNECTION_INFO_REQUEST_HEADER_SIZE
+  MHD_CONNECTION_INFO_REQUEST_HEADER_SIZE,
+
+  /**
+   * Return the file descriptor (in the @a connect_fd member)
+   * holding the spooled upload body of the current request; only
+   * valid after spooling completed.
+   * @sa #MHD_CONNECTION_OPTION_SPOOL_BODY
+   * @note Available since #MHD_VERSION 0x00097107
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_SPOOL_FD,
+
+  /**
+   * Return the declared Content-Length of the current request as
+   * already parsed by MHD (returned in @a content_length of the
+   * union): #MHD_SIZE_UNKNOWN for chunked uploads, 0 when absent.
+   * Valid once the access handler has been called.  Saves the
+   * lookup-plus-strtoull round trip applications perform today.
+   * @note Available since #MHD_VERSION 0x00097107
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_REQUEST_CONTENT_LENGTH,
+
+  /**
+   * Return (in @a unsent_bytes of the union) the number of
+   * response bytes MHD still holds for this connection: the
+   * unsent part of the current write buffer plus, when the
+   * response size is known, the body bytes not yet serialized.
+   * Together with #MHD_CONNECTION_INFO_TCP_INFO this lets
+   * adaptive-bitrate senders pace without duplicating MHD's
+   * internal accounting.
+   * @note Available since #MHD_VERSION 0x00097107
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_UNSENT_BYTES,
+
+  /**
+   * Return (in @a tcp_info of the union) a snapshot of kernel
+   * transport statistics (RTT, cwnd, losses, unsent queue) for
+   * the connection.  The snapshot is cached and refreshed at most
+   * once per event-loop pass, so calling this per chunk does not
+   * multiply getsockopt() calls.  Returns NULL where the platform
+   * offers no TCP_INFO equivalent.
+   * @note Available since #MHD_VERSION 0x00097107
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_TCP_INFO,
+
+  /**
+   * Return (in @a bytes_received of the union) the cumulative
+   * number of bytes MHD has read from this connection's socket
+   * (request lines, headers and bodies, across keep-alive
+   * requests) -- ingress accounting without counting in the
+   * upload callback.
+   * @note Available since #MHD_VERSION 0x00097107
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_BYTES_RECEIVED,
+
+  /**
+   * Return (in @a request_id of the union) the current request's
+   * correlation ID: unique within the daemon's lifetime, built
+   * from a start-time epoch, the worker index and a per-worker
+   * counter -- no locks, no syscalls, no UUID library on the hot
+   * path.  Assigned when the request line completes; 0 before
+   * that.  Query it from any callback of the request (URI logger,
+   * access handler, completion notifier) for tracing.
+   * @note Available since #MHD_VERSION 0x00097107
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_REQUEST_ID
 };
 
 
@@ -2112,10 +2653,103 @@ enum MHD_DaemonInfoType
    * Note: if port '0' was specified for #MHD_start_daemon(), returned
    * value will be real port number.
    */
-  MHD_DAEMON_INFO_BIND_PORT
+  MHD_DAEMON_INFO_BIND_PORT,
+
+  /**
+   * Request the total number of connections accepted by the daemon
+   * since it was started (aggregated over the worker pool).
+   * Returned in the @a stat_value member.
+   * No extra arguments should be passed.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TOTAL_ACCEPTS,
+
+  /**
+   * Request the total number of requests completed (response fully
+   * sent).  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TOTAL_REQUESTS,
+
+  /**
+   * Request the number of requests served on re-used (keep-alive)
+   * connections.  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_KEEPALIVE_REUSES,
+
+  /**
+   * Request the number of connections closed due to inactivity
+   * timeout.  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TIMEOUT_CLOSES,
+
+  /**
+   * Request the number of error replies (4xx/5xx generated by MHD
+   * itself) sent.  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_ERROR_RESPONSES,
+
+  /**
+   * Request the number of per-connection pool-memory exhaustion
+   * events.  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_POOL_EXHAUSTIONS,
+
+  /**
+   * Request the total number of payload bytes received.
+   * Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TOTAL_BYTES_IN,
+
+  /**
+   * Request the total number of payload bytes sent.
+   * Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TOTAL_BYTES_OUT,
+
+  /**
+   * Request the high-water mark of per-connection memory-pool
+   * usage (in bytes) observed so far, aggregated (as the maximum)
+   * over the worker pool; lets operators right-size
+   * #MHD_OPTION_CONNECTION_MEMORY_LIMIT instead of provisioning
+   * blind.  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_POOL_HIGH_WATER,
+
+  /**
+   * Request the time-to-first-byte histogram collected with
+   * #MHD_USE_LATENCY_HISTOGRAM, aggregated over the worker pool.
+   * Returned in the @a ttfb_histogram member: bucket 0 counts
+   * requests answered in under 1 ms, bucket N (N >= 1) counts
+   * requests in the [2^(N-1), 2^N) ms range.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TTFB_HISTOGRAM,
+
+  /**
+   * Request the cumulative number of bytes returned to the kernel
+   * by #MHD_daemon_trim_memory(), aggregated over the worker
+   * pool.  Returned in the @a stat_value member.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_DAEMON_INFO_TRIMMED_BYTES
 };
 
 
+/**
+ * Number of buckets in the time-to-first-byte histogram.
+ * @sa #MHD_DAEMON_INFO_TTFB_HISTOGRAM
+ */
+#define MHD_TTFB_HISTOGRAM_BUCKETS 32
+
+
 /**
  * Callback for serious error condition. The default action is to print
  * an error message and `abort()`.
@@ -2241,6 +2875,56 @@ typedef void
                                  enum MHD_ConnectionNotificationCode toe);
 
 
+/**
+ * Signature for the callback registered with
+ * #MHD_OPTION_POOL_EXHAUSTION_CALLBACK, invoked when an
+ * allocation from a connection's memory pool fails.
+ *
+ * @param cls closure
+ * @param connection connection whose pool was exhausted
+ * @param requested_size size in bytes of the failed allocation
+ * @param phase static string naming the allocation site
+ *        (e.g. "read-buffer-grow", "response-headers")
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+typedef void
+(*MHD_PoolExhaustionCallback) (void *cls,
+                               struct MHD_Connection *connection,
+                               size_t requested_size,
+                               const char *phase);
+
+
+/**
+ * Signature of the per-response callback registered with
+ * #MHD_response_set_sent_callback(), invoked exactly once per
+ * transmission when the final byte of the response has been
+ * handed to the socket (all MHD buffers drained), from the
+ * sending connection's thread.
+ *
+ * @param cls closure
+ * @param connection connection the response was sent on
+ * @param body_bytes_sent number of response body bytes written
+ * @param sent_time_ms monotonic millisecond timestamp of
+ *        completion (same clock as MHD's internal timeouts)
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+typedef void
+(*MHD_ResponseSentCallback) (void *cls,
+                             struct MHD_Connection *connection,
+                             uint64_t body_bytes_sent,
+                             uint64_t sent_time_ms);
+
+
+/**
+ * Signature of a task deferred with #MHD_connection_defer().
+ *
+ * @param cls closure
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+typedef void
+(*MHD_DeferredCallback) (void *cls);
+
+
 /**
  * Iterator over key-value pairs.  This iterator
  * can be used to iterate over all of the cookies,
@@ -2976,7 +3660,76 @@ enum MHD_ResponseFlags
    * Disable sanity check preventing clients from manually
    * setting the HTTP content length option.
    */
-  MHD_RF_INSANITY_HEADER_CONTENT_LENGTH = 4
+  MHD_RF_INSANITY_HEADER_CONTENT_LENGTH = 4,
+
+  /**
+   * Let MHD handle conditional requests: when this response carries
+   * an "ETag" and/or "Last-Modified" header (added with
+   * #MHD_add_response_header) and the request's "If-None-Match"
+   * matches the ETag -- or, lacking ETags, "If-Modified-Since"
+   * matches the Last-Modified value exactly -- a GET/HEAD request
+   * queued with status #MHD_HTTP_OK is automatically answered with
+   * a bodyless #MHD_HTTP_NOT_MODIFIED, skipping the body machinery
+   * entirely.  Validating headers of the response are still sent.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_RF_AUTO_NOT_MODIFIED = 8,
+
+  /**
+   * Let MHD serve this (buffer-backed) response gzip-compressed to
+   * clients whose Accept-Encoding permits it: the compressed body
+   * is produced once, cached with the response and shared across
+   * all requests; clients without gzip support (and tiny or
+   * incompressible bodies, where compression would not pay) keep
+   * receiving the identity form.  MHD adds a
+   * "Vary: Accept-Encoding" header (unless the application set
+   * its own Vary header) so shared caches key on the negotiated
+   * coding.  Requires MHD to be built with zlib; without it the
+   * flag is ignored.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_RF_AUTO_GZIP = 16,
+
+  /**
+   * Let MHD serve HTTP range requests for this file-descriptor
+   * backed response: a single-range GET/HEAD queued with status 200
+   * is answered with 206 Partial Content through the regular
+   * sendfile offset machinery (no body copies), including
+   * Content-Range generation, If-Range validation (exact ETag /
+   * Last-Modified match) and 416 for unsatisfiable ranges.
+   * Multi-range requests are answered with the full 200 entity,
+   * which is always a correct fallback.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_RF_AUTO_RANGES = 32,
+
+  /**
+   * Like #MHD_RF_AUTO_GZIP but using brotli ("br"), which
+   * typically compresses JSON 10-20% denser; built once per
+   * response and cached.  When both flags are set and the client
+   * accepts both codings, brotli is preferred.  A
+   * "Vary: Accept-Encoding" header is added as for
+   * #MHD_RF_AUTO_GZIP.  Requires MHD to be
+   * built with libbrotlienc; ignored otherwise.  For
+   * dictionary-based compression, pre-encode offline and attach
+   * the result with #MHD_response_add_encoding_variant().
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_RF_AUTO_BROTLI = 64,
+
+  /**
+   * Strengthen the content reader callback contract for this
+   * (callback-backed) response: MHD will only invoke the callback
+   * with a destination buffer of at least the @a block_size given
+   * to #MHD_create_response_from_callback() (bounded by the
+   * connection's memory pool), instead of whatever tail space
+   * happens to remain in the write buffer.  Generators that fill
+   * fixed-size frames avoid short fills and the extra callback
+   * round-trips they cause.
+   * @sa #MHD_content_reader_set_ready_size()
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_RF_CONTENT_READER_MIN_FILL = 128
 
 
 };
@@ -3031,6 +3784,50 @@ MHD_create_response_from_callback (uint64_t size,
                                    MHD_ContentReaderFreeCallback crfc);
 
 
+/**
+ * Tell MHD, from within a #MHD_ContentReaderCallback invocation,
+ * how many more bytes of payload the callback could deliver
+ * immediately after the current one.  MHD uses the hint to size
+ * (and, for a zero hint, skip) the next fill request within the
+ * same sending round: a generator that knows it has drained its
+ * source avoids the extra "return 0" callback round-trip, and one
+ * with a short tail gets a buffer of exactly that size.  The hint
+ * only applies to the current round; it is reset before every
+ * callback invocation.  Calling this outside a callback invocation
+ * has no lasting effect.
+ *
+ * @param response the (callback-backed) response being generated
+ * @param ready number of additional bytes ready right now,
+ *        0 if the next call would return no data
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN void
+MHD_content_reader_set_ready_size (struct MHD_Response *response,
+                                   uint64_t ready);
+
+
+/**
+ * Register a callback invoked when a transmission of @a response
+ * completes -- the final byte was accepted by the socket -- with
+ * the body byte count and a monotonic timestamp.  Replaces
+ * polling loops built on connection info queries (and the
+ * completed-notification callback, which can fire before the
+ * write buffer drains).  A response queued on many connections
+ * gets one invocation per transmission.
+ *
+ * @param response response to watch
+ * @param cb callback to invoke on send completion
+ * @param cb_cls closure for @a cb
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN void
+MHD_response_set_sent_callback (struct MHD_Response *response,
+                                MHD_ResponseSentCallback cb,
+                                void *cb_cls);
+
+
 /**
  * Create a response object.  The response object can be extended with
  * header information and then be used any number of times.
@@ -3409,6 +4206,15 @@ MHD_add_response_header (struct MHD_Response *response,
  * @param content value to delete
  * @return #MHD_NO on error (i.e. invalid footer or content format).
  * @ingroup response
+ *
+ * Streaming trailers: footers may also be added while the chunked
+ * response is being streamed -- in particular from the final
+ * #MHD_ContentReaderCallback invocation, immediately before it
+ * returns #MHD_CONTENT_READER_END_OF_STREAM.  MHD serializes
+ * footers only after the terminating zero chunk, so checksums or
+ * signatures computed over the streamed body can be attached
+ * without buffering the response.  (Do not do this on responses
+ * shared across connections.)
  */
 _MHD_EXTERN enum MHD_Result
 MHD_add_response_footer (struct MHD_Response *response,
@@ -3460,92 +4266,977 @@ MHD_get_response_header (struct MHD_Response *response,
                          const char *key);
 
 
-/* ********************** PostProcessor functions ********************** */
-
 /**
- * Create a `struct MHD_PostProcessor`.
+ * Make the @a response object immutable and pre-serialize its
+ * headers.  After this call, adding or removing headers with
+ * #MHD_add_response_header() / #MHD_del_response_header() fails and
+ * the header block is rendered once into a contiguous buffer which
+ * is copied verbatim into the reply for every request, removing the
+ * per-request header formatting cost.  Recommended for canned
+ * responses which are shared across many requests.
  *
- * A `struct MHD_PostProcessor` can be used to (incrementally) parse
- * the data portion of a POST request.  Note that some buggy browsers
- * fail to set the encoding type.  If you want to support those, you
- * may have to call #MHD_set_connection_value with the proper encoding
- * type before creating a post processor (if no supported encoding
- * type is set, this function will fail).
+ * This function must not be called while the response is in
+ * concurrent use by another thread.  Footers are not affected and
+ * can still be added.
  *
- * @param connection the connection on which the POST is
- *        happening (used to determine the POST format)
- * @param buffer_size maximum number of bytes to use for
- *        internal buffering (used only for the parsing,
- *        specifically the parsing of the keys).  A
- *        tiny value (256-1024) should be sufficient.
- *        Do NOT use a value smaller than 256.  For good
- *        performance, use 32 or 64k (i.e. 65536).
- * @param iter iterator to be called with the parsed data,
- *        Must NOT be NULL.
- * @param iter_cls first argument to @a iter
- * @return NULL on error (out of memory, unsupported encoding),
- *         otherwise a PP handle
- * @ingroup request
+ * @param response the response to freeze
+ * @return #MHD_YES on success,
+ *         #MHD_NO on allocation failure
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
  */
-_MHD_EXTERN struct MHD_PostProcessor *
-MHD_create_post_processor (struct MHD_Connection *connection,
-                           size_t buffer_size,
-                           MHD_PostDataIterator iter, void *iter_cls);
-
-
 /**
- * Parse and process POST data.  Call this function when POST data is
- * available (usually during an #MHD_AccessHandlerCallback) with the
- * "upload_data" and "upload_data_size".  Whenever possible, this will
- * then cause calls to the #MHD_PostDataIterator.
+ * Add several headers to a response in one call, using a single
+ * allocation for all entry records and string copies instead of
+ * the three allocations per header of repeated
+ * #MHD_add_response_header() calls.  Useful for dynamic responses
+ * carrying many headers.  The same validity rules as for
+ * #MHD_add_response_header() apply to each pair; on failure no
+ * header is added.
  *
- * @param pp the post processor
- * @param post_data @a post_data_len bytes of POST data
- * @param post_data_len length of @a post_data
- * @return #MHD_YES on success, #MHD_NO on error
- *         (out-of-memory, iterator aborted, parse error)
- * @ingroup request
+ * @param response the response to modify
+ * @param n number of header pairs
+ * @param headers array of 2*n strings: name, value, name,
+ *        value, ...
+ * @return #MHD_YES on success, #MHD_NO on error (invalid header,
+ *         frozen response or out of memory)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
  */
 _MHD_EXTERN enum MHD_Result
-MHD_post_process (struct MHD_PostProcessor *pp,
-                  const char *post_data, size_t post_data_len);
+MHD_add_response_headers (struct MHD_Response *response,
+                          unsigned int n,
+                          const char *const *headers);
+
+
+_MHD_EXTERN enum MHD_Result
+MHD_freeze_response (struct MHD_Response *response);
 
 
 /**
- * Release PostProcessor resources.
+ * Adjust how many workers of the thread pool actively accept new
+ * connections.  Workers beyond @a count stop monitoring the listen
+ * socket (so they sleep instead of waking on every connection
+ * burst) but keep serving their existing connections until those
+ * drain naturally; raising the count re-activates parked workers.
+ * The worker threads themselves are not destroyed or created --
+ * this adjusts duty, not capacity, so it is cheap to call on a
+ * load-following schedule.
  *
- * @param pp the PostProcessor to destroy
- * @return #MHD_YES if processing completed nicely,
- *         #MHD_NO if there were spurious characters / formatting
- *                problems; it is common to ignore the return
- *                value of this function
- * @ingroup request
+ * @param daemon the master daemon (started with
+ *        #MHD_OPTION_THREAD_POOL_SIZE)
+ * @param count number of workers that should accept new
+ *        connections, between 1 and the pool size
+ * @return #MHD_YES on success, #MHD_NO if the daemon has no
+ *         thread pool, @a count is out of range, or the daemon
+ *         uses #MHD_USE_REUSEPORT_WORKER_LISTENERS (whose kernel
+ *         accept queues cannot be parked)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup event
  */
 _MHD_EXTERN enum MHD_Result
-MHD_destroy_post_processor (struct MHD_PostProcessor *pp);
-
-
-/* ********************* Digest Authentication functions *************** */
+MHD_set_active_worker_count (struct MHD_Daemon *daemon,
+                             unsigned int count);
 
 
 /**
- * Constant to indicate that the nonce of the provided
- * authentication code was wrong.
- * @ingroup authentication
+ * Flag for #MHD_daemon_add_listener(): connections accepted on
+ * this listener use plain TCP even when the daemon itself was
+ * started with #MHD_USE_TLS (plaintext admin or health port on an
+ * HTTPS daemon).
+ * @note Available since #MHD_VERSION 0x00097107
  */
-#define MHD_INVALID_NONCE -1
+#define MHD_EXTRA_LISTENER_NO_TLS 1
 
 
 /**
- * Get the username from the authorization header sent by the client
+ * Attach an additional listening TCP port to a running daemon.
+ * The new socket is multiplexed into the daemon's existing event
+ * loop(s) and worker pool -- one set of threads serves all ports,
+ * sharing idle capacity -- instead of running one daemon per
+ * port.  Requests accepted on this listener are dispatched to @a
+ * handler (or the daemon's default handler when NULL), so each
+ * port can have its own handler context.  The listener binds the
+ * wildcard address in the same address family as the primary
+ * listen socket and lives until the daemon stops.  Not supported
+ * in thread-per-connection mode.
  *
- * @param connection The MHD connection structure
- * @return NULL if no username could be found, a pointer
- *      to the username if found, free using #MHD_free().
- * @ingroup authentication
+ * @param daemon the (master) daemon, already started
+ * @param port TCP port to listen on additionally
+ * @param handler request handler for this port,
+ *        NULL to use the daemon's default handler
+ * @param handler_cls closure for @a handler
+ * @param flags 0 or #MHD_EXTRA_LISTENER_NO_TLS
+ * @return #MHD_YES on success, #MHD_NO on failure (bad arguments,
+ *         bind/listen failure, thread-per-connection daemon)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
  */
-_MHD_EXTERN char *
-MHD_digest_auth_get_username (struct MHD_Connection *connection);
+_MHD_EXTERN enum MHD_Result
+MHD_daemon_add_listener (struct MHD_Daemon *daemon,
+                         uint16_t port,
+                         MHD_AccessHandlerCallback handler,
+                         void *handler_cls,
+                         unsigned int flags);
+
+
+/**
+ * Defer cheap post-response work (metric increments, cache
+ * touch-ups) to the worker that owns @a connection: the callback
+ * runs on the same event-loop thread after the current event
+ * batch, from a per-worker FIFO drained in bounded slices per
+ * iteration.  Same-core cache locality for connection-adjacent
+ * work with zero cross-thread synchronization -- no external
+ * thread pool, no locks.  Must be called from MHD callbacks of
+ * @a connection (i.e. on the owning thread).  Tasks still queued
+ * at daemon shutdown are executed during the final drain.
+ *
+ * @param connection connection whose worker runs the task
+ * @param cb the task to run
+ * @param cb_cls closure for @a cb
+ * @return #MHD_YES on success, #MHD_NO on allocation failure or
+ *         unsupported threading mode (thread-per-connection)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_connection_defer (struct MHD_Connection *connection,
+                      MHD_DeferredCallback cb,
+                      void *cb_cls);
+
+
+/**
+ * Change one operational tunable of a running daemon without a
+ * restart (incident response: tighten timeouts and limits under
+ * attack while keeping the keep-alive fleet connected).  The new
+ * value takes effect on the next event-loop iteration of every
+ * worker; it applies to decisions made from then on (new
+ * connections inherit the new defaults, existing connections keep
+ * their per-connection settings).  Supported options:
+ * #MHD_OPTION_CONNECTION_TIMEOUT (seconds),
+ * #MHD_OPTION_CONNECTION_TIMEOUT_MS,
+ * #MHD_OPTION_CONNECTION_LIMIT,
+ * #MHD_OPTION_PER_IP_CONNECTION_LIMIT,
+ * #MHD_OPTION_ACCEPT_BURST_SIZE,
+ * #MHD_OPTION_RESPONSE_RATE_LIMIT,
+ * #MHD_OPTION_LOOP_BUDGET_MS,
+ * #MHD_OPTION_OVERLOAD_SHED_MODE and
+ * #MHD_OPTION_BUSY_POLL_US; all other options return #MHD_NO.
+ * The store is a plain word write mirrored to every worker;
+ * event loops read the value fresh each iteration.
+ *
+ * @param daemon the (master) daemon to tune
+ * @param option which tunable to change
+ * @param value the new value
+ * @return #MHD_YES on success, #MHD_NO for unsupported options
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_daemon_set_option (struct MHD_Daemon *daemon,
+                       enum MHD_OPTION option,
+                       uint64_t value);
+
+
+/**
+ * Ask the daemon to shed memory, for container-limit watchers
+ * (PSI / memory.events) that must act before the OOM killer
+ * does.  Level 1 returns the free pages of idle keep-alive
+ * connections' memory pools to the kernel; level 2 additionally
+ * drops the recycled-connection cache; level 3 additionally
+ * closes idle keep-alive connections outright.  The trimming runs
+ * on each worker's own thread on its next loop pass (the call
+ * just posts the request and wakes the loops), and the bytes
+ * reclaimed accumulate in the counter returned by
+ * #MHD_DAEMON_INFO_TRIMMED_BYTES.
+ *
+ * @param daemon the (master) daemon to trim
+ * @param level shedding aggressiveness, 1 to 3
+ * @return #MHD_YES if the trim was posted
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_daemon_trim_memory (struct MHD_Daemon *daemon,
+                        unsigned int level);
+
+
+/**
+ * Begin draining a (typically quiesced) daemon for zero-downtime
+ * handover: every established connection is marked to close after
+ * its current request (no further keep-alive reuse) and receives
+ * an inactivity timeout of at most @a timeout_ms, so idle
+ * keep-alive connections are collectively gone within the deadline
+ * instead of lingering indefinitely.  Typical rollover:
+ * #MHD_quiesce_daemon() (new daemon takes the listen socket via
+ * #MHD_OPTION_LISTEN_SOCKET), then this, then
+ * #MHD_stop_daemon() once connections have drained.
+ *
+ * @param daemon the (master) daemon to drain
+ * @param timeout_ms deadline for idle connections, in ms (0 uses
+ *        1 ms, i.e. close idle connections immediately)
+ * @return #MHD_YES on success, #MHD_NO on invalid arguments or if
+ *         the daemon lacks #MHD_USE_ITC (required to wake the
+ *         event loop)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup event
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_daemon_drain (struct MHD_Daemon *daemon,
+                  unsigned int timeout_ms);
+
+
+/**
+ * Atomically replace the X.509 credentials used for new TLS
+ * handshakes with the given PEM key and certificate, without
+ * restarting the daemon: established sessions (and handshakes
+ * already in progress) continue with the previous credentials,
+ * new connections use the new ones.  Intended for short-lived
+ * certificate rotation.  As with the corresponding start options,
+ * the memory behind @a mem_key / @a mem_cert must remain valid and
+ * unmodified while the daemon runs.  Must not be called
+ * concurrently with another update on the same daemon.
+ *
+ * @param daemon the (master) daemon started with #MHD_USE_TLS and
+ *        certificate credentials
+ * @param mem_key pointer to the PEM private key
+ * @param mem_cert pointer to the PEM certificate (chain)
+ * @return #MHD_YES on success, #MHD_NO on error (bad arguments or
+ *         rejected key/certificate; the old credentials then stay
+ *         in effect)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_update_tls_credentials (struct MHD_Daemon *daemon,
+                            const char *mem_key,
+                            const char *mem_cert);
+
+
+/**
+ * Add an additional X.509 key/certificate pair to the daemon's TLS
+ * credentials for multi-tenant serving: GnuTLS precomputes a
+ * credential slot per pair and selects the matching certificate by
+ * the client's SNI hostname during the handshake, so hundreds of
+ * vhosts are served from one daemon on one port with no proxy hop.
+ * Call after #MHD_start_daemon but before exposing the port to
+ * traffic (slot installation is not synchronized against running
+ * handshakes); as with the start options, the PEM memory must
+ * remain valid while the daemon runs.  Not supported together with
+ * #MHD_USE_LAZY_TLS_INIT.
+ *
+ * @param daemon the (master) daemon started with #MHD_USE_TLS and
+ *        certificate credentials
+ * @param mem_key pointer to the PEM private key
+ * @param mem_cert pointer to the PEM certificate (chain) carrying
+ *        the additional hostname(s)
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_daemon_add_tls_certificate (struct MHD_Daemon *daemon,
+                                const char *mem_key,
+                                const char *mem_cert);
+
+
+/**
+ * Allocate request-scoped scratch memory from the connection's
+ * memory pool.  The memory is automatically reclaimed when the
+ * current request completes (it must not be used afterwards, e.g.
+ * from a #MHD_OPTION_NOTIFY_COMPLETED callback of a later request)
+ * and must not be freed by the application.  Handy for per-request
+ * scratch buffers that would otherwise be malloc'ed and free'd in
+ * every #MHD_AccessHandlerCallback.  Allocation can fail when the
+ * pool (sized by #MHD_OPTION_CONNECTION_MEMORY_LIMIT) is
+ * exhausted; the request itself is not affected by a failed
+ * scratch allocation.
+ *
+ * @param connection the connection handling the current request
+ * @param size number of bytes to allocate
+ * @return pointer to the allocated memory, NULL on pool exhaustion
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN void *
+MHD_connection_alloc (struct MHD_Connection *connection,
+                      size_t size);
+
+
+/**
+ * Check whether a request header contains a given token in its
+ * comma-separated value list (case-insensitive for both the header
+ * name and the token; tokens may be surrounded by spaces/tabs).
+ * Covers the common "does the client accept gzip" /
+ * "is Connection: upgrade requested" checks without manual list
+ * parsing.
+ *
+ * @param connection the connection with the current request
+ * @param header the header name (e.g.
+ *        #MHD_HTTP_HEADER_ACCEPT_ENCODING)
+ * @param token the token to search for (e.g. "gzip")
+ * @return #MHD_YES if the token is present, #MHD_NO otherwise
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_connection_header_has_token (struct MHD_Connection *connection,
+                                 const char *header,
+                                 const char *token);
+
+
+/**
+ * One key/value view for array-based header iteration.
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_NameValueView
+{
+  /**
+   * The name (key) of the entry; views into MHD's storage, valid
+   * for the lifetime of the request.
+   */
+  const char *name;
+
+  /**
+   * Number of bytes in @a name.
+   */
+  size_t name_size;
+
+  /**
+   * The value of the entry (maybe NULL).
+   */
+  const char *value;
+
+  /**
+   * Number of bytes in @a value.
+   */
+  size_t value_size;
+
+  /**
+   * Kind of the entry.
+   */
+  enum MHD_ValueKind kind;
+};
+
+
+/**
+ * Copy views of all key/value pairs of the given kinds into a
+ * caller-provided array, replacing callback-per-header iteration
+ * with one call: middleware scanning all headers per request gets
+ * name/value pointers with pre-computed lengths in a flat array it
+ * can process (or vectorize over) directly.
+ *
+ * @param connection connection to get values from
+ * @param kind kinds of entries to include (bitmask)
+ * @param[out] dst array to fill
+ * @param max number of entries @a dst can hold
+ * @return total number of matching entries (may exceed @a max, in
+ *         which case only the first @a max were stored), or -1 if
+ *         @a connection is NULL
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN int
+MHD_get_connection_values_array (struct MHD_Connection *connection,
+                                 enum MHD_ValueKind kind,
+                                 struct MHD_NameValueView *dst,
+                                 unsigned int max);
+
+
+/**
+ * A single buffer of a scatter-gather response.
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_IoVec
+{
+  /**
+   * The pointer to the memory region for I/O.
+   */
+  const void *iov_base;
+
+  /**
+   * The size in bytes of the memory region for I/O.
+   */
+  size_t iov_len;
+};
+
+
+/**
+ * Create a response serving @a size bytes of the file behind @a fd
+ * starting at @a offset through a read-only mapping owned by the
+ * response: MHD advises the kernel of sequential access for
+ * read-ahead and releases the mapping (and its page-cache
+ * references) when the response is destroyed.  @a fd is NOT owned
+ * by the response and may be closed right after this call.
+ *
+ * @param size number of bytes to serve
+ * @param fd the file to map (only used during this call)
+ * @param offset offset of the served range in the file
+ * @return the response, NULL on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN struct MHD_Response *
+MHD_create_response_from_file_mapped (size_t size,
+                                      int fd,
+                                      uint64_t offset);
+
+
+/**
+ * Create a response from an array of memory fragments.  MHD
+ * transmits the fragments directly from the application's buffers
+ * with scatter-gather I/O (a single sendmsg() where available)
+ * instead of requiring the application to copy them into one
+ * buffer or regenerate them through a content-reader callback.
+ * The fragment array itself is copied; the memory the fragments
+ * point to must stay valid and unmodified until the response is
+ * destroyed, at which point @a crfc (if not NULL) is invoked with
+ * @a cls to release it.
+ *
+ * @param iov the array of fragments to send, in order
+ * @param iovcnt number of fragments in @a iov
+ * @param crfc callback to release the fragment memory, maybe NULL
+ * @param cls closure for @a crfc
+ * @return NULL on error (i.e. invalid arguments, out of memory)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN struct MHD_Response *
+MHD_create_response_from_iovec (const struct MHD_IoVec *iov,
+                                unsigned int iovcnt,
+                                MHD_ContentReaderFreeCallback crfc,
+                                void *cls);
+
+
+/**
+ * Parsed fixed header of a WebSocket (RFC 6455) frame.
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_WebSocketFrameHeader
+{
+  /**
+   * Payload length in bytes.
+   */
+  uint64_t payload_len;
+
+  /**
+   * Size of the frame header in bytes (payload follows at this
+   * offset).
+   */
+  size_t header_size;
+
+  /**
+   * Frame opcode (0x0 continuation, 0x1 text, 0x2 binary,
+   * 0x8 close, 0x9 ping, 0xA pong).
+   */
+  unsigned char opcode;
+
+  /**
+   * Non-zero if the FIN bit is set.
+   */
+  unsigned char fin;
+
+  /**
+   * Non-zero if the payload is masked (client-to-server frames).
+   */
+  unsigned char masked;
+
+  /**
+   * Masking key (valid only if @a masked is non-zero).
+   */
+  unsigned char mask[4];
+};
+
+
+/**
+ * Parse a WebSocket frame header from the start of @a buf.
+ *
+ * @param buf the received bytes
+ * @param len number of valid bytes in @a buf
+ * @param[out] header set to the parsed header on success
+ * @return #MHD_YES if a complete header was parsed,
+ *         #MHD_NO if more bytes are required
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_websocket_parse_frame_header (const void *buf,
+                                  size_t len,
+                                  struct MHD_WebSocketFrameHeader *header);
+
+
+/**
+ * Unmask (or mask; the operation is an involution) a WebSocket
+ * payload in place, processing eight bytes per step.  @a stream_pos
+ * gives the offset of @a data within the frame's payload so
+ * payloads can be unmasked incrementally as bytes arrive.
+ *
+ * @param data the payload bytes to transform in place
+ * @param len number of bytes in @a data
+ * @param mask the 4-byte masking key from the frame header
+ * @param stream_pos offset of @a data within the frame payload
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN void
+MHD_websocket_unmask (void *data,
+                      size_t len,
+                      const unsigned char mask[4],
+                      uint64_t stream_pos);
+
+
+/**
+ * Serialize a WebSocket frame header for a server-to-client
+ * (unmasked) frame.
+ *
+ * @param opcode the frame opcode
+ * @param fin non-zero to set the FIN bit
+ * @param payload_len payload length that will follow
+ * @param[out] buf buffer for the header, must hold at least 10
+ *        bytes
+ * @return number of header bytes written
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN size_t
+MHD_websocket_make_frame_header (unsigned char opcode,
+                                 int fin,
+                                 uint64_t payload_len,
+                                 void *buf);
+
+
+/**
+ * Attach a pre-encoded alternate body to a logical response: when
+ * the response is queued for a request whose Accept-Encoding
+ * includes @a encoding, MHD transmits @a variant instead (with its
+ * own correct Content-Length, ETag and other headers), letting
+ * applications serve offline-compressed corpora (gzip/brotli/zstd)
+ * without re-implementing negotiation.  The response takes a
+ * reference on @a variant (the caller may destroy its own);
+ * MHD adds the matching Content-Encoding header to the variant.
+ * Variants are matched in the order they were attached.
+ *
+ * @param response the identity response
+ * @param encoding the content coding token (e.g. "gzip", "br",
+ *        "zstd")
+ * @param variant the response holding the pre-encoded body
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_response_add_encoding_variant (struct MHD_Response *response,
+                                   const char *encoding,
+                                   struct MHD_Response *variant);
+
+
+/**
+ * Handle for a compiled URL routing table: routes registered with
+ * #MHD_router_add() are compiled into a character trie, and
+ * #MHD_router_dispatch() matches method and URL in a single walk
+ * (O(URL length), independent of the number of routes).  Build the
+ * router before starting the daemon and pass
+ * `MHD_router_dispatch, router` as the handler pair to
+ * #MHD_start_daemon; dispatch is lock-free as the trie is
+ * immutable while serving.
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_Router;
+
+
+/**
+ * Create an empty routing table.
+ *
+ * @param fallback handler for unmatched requests, maybe NULL
+ *        (unmatched requests then fail hard)
+ * @param fallback_cls closure for @a fallback
+ * @return the router, NULL on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN struct MHD_Router *
+MHD_router_create (MHD_AccessHandlerCallback fallback,
+                   void *fallback_cls);
+
+
+/**
+ * Register a route; must be called before the daemon using the
+ * router starts serving.  A pattern ending in '*' matches any URL
+ * with the preceding prefix, otherwise the match is exact; the
+ * longest matching route wins.
+ *
+ * @param router the router
+ * @param method HTTP method to match, NULL for any method
+ * @param pattern URL or URL prefix (trailing '*') to match
+ * @param handler handler to dispatch to
+ * @param handler_cls closure for @a handler
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_router_add (struct MHD_Router *router,
+                const char *method,
+                const char *pattern,
+                MHD_AccessHandlerCallback handler,
+                void *handler_cls);
+
+
+/**
+ * Access handler dispatching through a router; pass together with
+ * the router as the handler pair to #MHD_start_daemon.
+ *
+ * @param cls the `struct MHD_Router`
+ * @param connection the connection
+ * @param url requested URL
+ * @param method HTTP method
+ * @param version HTTP version
+ * @param upload_data upload data
+ * @param upload_data_size size of @a upload_data
+ * @param con_cls per-request state pointer
+ * @return result of the dispatched handler, #MHD_NO if no route
+ *         and no fallback matched
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_router_dispatch (void *cls,
+                     struct MHD_Connection *connection,
+                     const char *url,
+                     const char *method,
+                     const char *version,
+                     const char *upload_data,
+                     size_t *upload_data_size,
+                     void **con_cls);
+
+
+/**
+ * Destroy a routing table.  Must not be called while a daemon is
+ * still dispatching through it.
+ *
+ * @param router the router to destroy (maybe NULL)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN void
+MHD_router_destroy (struct MHD_Router *router);
+
+
+/**
+ * Handle for a virtual-host dispatch table: hosts registered with
+ * #MHD_vhosts_add() are resolved by #MHD_vhosts_dispatch() with a
+ * precomputed case-folded hash over the request's Host header
+ * (':port' suffixes ignored).  Build before starting the daemon;
+ * dispatch is lock-free as the table is immutable while serving.
+ * For per-vhost TLS certificates use the existing SNI support of
+ * #MHD_OPTION_HTTPS_CERT_CALLBACK.
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_Vhosts;
+
+
+/**
+ * Create an empty virtual-host table.
+ *
+ * @param fallback handler for unmatched hosts, maybe NULL
+ * @param fallback_cls closure for @a fallback
+ * @return the table, NULL on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN struct MHD_Vhosts *
+MHD_vhosts_create (MHD_AccessHandlerCallback fallback,
+                   void *fallback_cls);
+
+
+/**
+ * Register a virtual host (case-insensitive match); must be called
+ * before the daemon using this table starts serving.
+ *
+ * @param vh the table
+ * @param host the host name to match
+ * @param handler handler serving this virtual host
+ * @param handler_cls closure for @a handler
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_vhosts_add (struct MHD_Vhosts *vh,
+                const char *host,
+                MHD_AccessHandlerCallback handler,
+                void *handler_cls);
+
+
+/**
+ * Access handler dispatching on the request's Host header; pass
+ * together with the table as the handler pair to
+ * #MHD_start_daemon.
+ *
+ * @param cls the `struct MHD_Vhosts`
+ * @param connection the connection
+ * @param url requested URL
+ * @param method HTTP method
+ * @param version HTTP version
+ * @param upload_data upload data
+ * @param upload_data_size size of @a upload_data
+ * @param con_cls per-request state pointer
+ * @return result of the dispatched handler, #MHD_NO if no vhost
+ *         and no fallback matched
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_vhosts_dispatch (void *cls,
+                     struct MHD_Connection *connection,
+                     const char *url,
+                     const char *method,
+                     const char *version,
+                     const char *upload_data,
+                     size_t *upload_data_size,
+                     void **con_cls);
+
+
+/**
+ * Destroy a virtual-host table.  Must not be called while a daemon
+ * is still dispatching through it.
+ *
+ * @param vh the table to destroy (maybe NULL)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup request
+ */
+_MHD_EXTERN void
+MHD_vhosts_destroy (struct MHD_Vhosts *vh);
+
+
+/**
+ * Handle for a lock-free access-log pipeline: request completions
+ * deposit fixed-size binary records into a ring without
+ * formatting, locks or syscalls; a dedicated writer thread batches
+ * the formatted lines ("unix-ts status duration-ms method url") to
+ * the output descriptor.  Under overload records are dropped and
+ * counted instead of stalling request processing.
+ * @note Available since #MHD_VERSION 0x00097107
+ */
+struct MHD_AccessLog;
+
+
+/**
+ * Create an access-log pipeline writing to @a fd; attach it to a
+ * daemon with #MHD_OPTION_ACCESS_LOG.
+ *
+ * @param fd descriptor to append log lines to (not closed on
+ *        destroy)
+ * @param ring_size number of in-flight records to buffer (rounded
+ *        up to a power of two, minimum 1024)
+ * @return the log handle, NULL on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup logging
+ */
+_MHD_EXTERN struct MHD_AccessLog *
+MHD_access_log_create (int fd,
+                       unsigned int ring_size);
+
+
+/**
+ * Stop the writer thread (flushing pending records) and release
+ * the log.  Destroy the daemon(s) using the log first.
+ *
+ * @param log the log to destroy (maybe NULL)
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup logging
+ */
+_MHD_EXTERN void
+MHD_access_log_destroy (struct MHD_AccessLog *log);
+
+
+/**
+ * Create a response carrying the daemon's run-time statistics (and
+ * the time-to-first-byte histogram, when enabled) in Prometheus
+ * text exposition format.  Counter reads are lock-free; mount the
+ * result on a scrape path from an access handler and release it
+ * with #MHD_destroy_response() after queueing.
+ *
+ * @param daemon the (master) daemon to report on
+ * @return the response, NULL on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup specialized
+ */
+_MHD_EXTERN struct MHD_Response *
+MHD_create_metrics_response (struct MHD_Daemon *daemon);
+
+
+/**
+ * Get the number of records dropped due to ring overflow.
+ *
+ * @param log the log
+ * @return dropped record count
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup logging
+ */
+_MHD_EXTERN uint64_t
+MHD_access_log_dropped (struct MHD_AccessLog *log);
+
+
+/**
+ * Handle for a cache of open file descriptors used to serve static
+ * files without per-request open()/fstat()/close() syscalls.
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+struct MHD_FileCache;
+
+
+/**
+ * Create a cache of FD-backed file responses.  Files served through
+ * the cache keep their descriptor (and their ready-made
+ * #MHD_Response object with precomputed Content-Length) open across
+ * requests; cache hits pay a single stat() to revalidate size and
+ * modification time, entries are evicted least-recently-used at
+ * @a capacity and re-opened automatically when the file changes.
+ *
+ * @param capacity maximum number of files to keep open, must not
+ *        be zero
+ * @return the cache handle, NULL on error
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN struct MHD_FileCache *
+MHD_file_cache_create (unsigned int capacity);
+
+
+/**
+ * Destroy a file cache and close all cached file descriptors (FDs
+ * of responses still queued on connections are closed once those
+ * requests complete).
+ *
+ * @param cache the cache to destroy
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN void
+MHD_file_cache_destroy (struct MHD_FileCache *cache);
+
+
+/**
+ * Get a response serving the given file, from the cache when
+ * possible.  The caller must release the returned response with
+ * #MHD_destroy_response() after queueing it (the cached FD stays
+ * open as long as the file remains cached).
+ *
+ * @param cache the cache
+ * @param path path of the file to serve
+ * @return the response, NULL if the file cannot be opened
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup response
+ */
+_MHD_EXTERN struct MHD_Response *
+MHD_file_cache_get_response (struct MHD_FileCache *cache,
+                             const char *path);
+
+
+/* ********************** PostProcessor functions ********************** */
+
+/**
+ * Create a `struct MHD_PostProcessor`.
+ *
+ * A `struct MHD_PostProcessor` can be used to (incrementally) parse
+ * the data portion of a POST request.  Note that some buggy browsers
+ * fail to set the encoding type.  If you want to support those, you
+ * may have to call #MHD_set_connection_value with the proper encoding
+ * type before creating a post processor (if no supported encoding
+ * type is set, this function will fail).
+ *
+ * @param connection the connection on which the POST is
+ *        happening (used to determine the POST format)
+ * @param buffer_size maximum number of bytes to use for
+ *        internal buffering (used only for the parsing,
+ *        specifically the parsing of the keys).  A
+ *        tiny value (256-1024) should be sufficient.
+ *        Do NOT use a value smaller than 256.  For good
+ *        performance, use 32 or 64k (i.e. 65536).
+ * @param iter iterator to be called with the parsed data,
+ *        Must NOT be NULL.
+ * @param iter_cls first argument to @a iter
+ * @return NULL on error (out of memory, unsupported encoding),
+ *         otherwise a PP handle
+ * @ingroup request
+ */
+_MHD_EXTERN struct MHD_PostProcessor *
+MHD_create_post_processor (struct MHD_Connection *connection,
+                           size_t buffer_size,
+                           MHD_PostDataIterator iter, void *iter_cls);
+
+
+/**
+ * Parse and process POST data.  Call this function when POST data is
+ * available (usually during an #MHD_AccessHandlerCallback) with the
+ * "upload_data" and "upload_data_size".  Whenever possible, this will
+ * then cause calls to the #MHD_PostDataIterator.
+ *
+ * @param pp the post processor
+ * @param post_data @a post_data_len bytes of POST data
+ * @param post_data_len length of @a post_data
+ * @return #MHD_YES on success, #MHD_NO on error
+ *         (out-of-memory, iterator aborted, parse error)
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_post_process (struct MHD_PostProcessor *pp,
+                  const char *post_data, size_t post_data_len);
+
+
+/**
+ * Release PostProcessor resources.
+ *
+ * @param pp the PostProcessor to destroy
+ * @return #MHD_YES if processing completed nicely,
+ *         #MHD_NO if there were spurious characters / formatting
+ *                problems; it is common to ignore the return
+ *                value of this function
+ * @ingroup request
+ */
+_MHD_EXTERN enum MHD_Result
+MHD_destroy_post_processor (struct MHD_PostProcessor *pp);
+
+
+/* ********************* Digest Authentication functions *************** */
+
+
+/**
+ * Constant to indicate that the nonce of the provided
+ * authentication code was wrong.
+ * @ingroup authentication
+ */
+#define MHD_INVALID_NONCE -1
+
+
+/**
+ * Get the username from the authorization header sent by the client
+ *
+ * @param connection The MHD connection structure
+ * @return NULL if no username could be found, a pointer
+ *      to the username if found, free using #MHD_free().
+ * @ingroup authentication
+ */
+_MHD_EXTERN char *
+MHD_digest_auth_get_username (struct MHD_Connection *connection);
+
+
+/**
+ * Get the username from the Digest Authorization header as a view
+ * allocated from the connection's memory pool: valid exactly as
+ * long as the request, MUST NOT be freed.  Pool-backed companion
+ * of #MHD_digest_auth_get_username().
+ *
+ * @param connection the MHD connection structure
+ * @return NULL if no username could be found or the pool is out
+ *         of memory, otherwise the pool-backed username
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup authentication
+ */
+_MHD_EXTERN const char *
+MHD_digest_auth_get_username2 (struct MHD_Connection *connection);
 
 
 /**
@@ -3749,6 +5440,27 @@ MHD_basic_auth_get_username_password (struct MHD_Connection *connection,
                                       char**password);
 
 
+/**
+ * Get the username and password from the Basic Authorization
+ * header as views allocated from the connection's memory pool:
+ * both strings live exactly as long as the request and MUST NOT
+ * be freed, eliminating the malloc/free pairs of
+ * #MHD_basic_auth_get_username_password() on the authenticated
+ * hot path.
+ *
+ * @param connection the MHD connection structure
+ * @param[out] password set to the password view, NULL if not
+ *        interested; only set when the function succeeds
+ * @return NULL if no valid Basic header is present or the pool is
+ *         out of memory, otherwise the pool-backed username
+ * @note Available since #MHD_VERSION 0x00097107
+ * @ingroup authentication
+ */
+_MHD_EXTERN const char *
+MHD_basic_auth_get_username_password2 (struct MHD_Connection *connection,
+                                       const char **password);
+
+
 /**
  * Queues a response to request basic authentication from the client
  * The given response object is expected to include the payload for
@@ -3799,7 +5511,120 @@ enum MHD_CONNECTION_OPTION
    * If timeout was set to zero (or unset) before, setup of new value by
    * MHD_set_connection_option() will reset timeout timer.
    */
-  MHD_CONNECTION_OPTION_TIMEOUT
+  MHD_CONNECTION_OPTION_TIMEOUT,
+
+  /**
+   * Set a custom timeout for the given connection in milliseconds,
+   * for sub-second shedding of stuck clients.  Specified as the
+   * number of milliseconds to wait for activity (followed by an
+   * `unsigned int`); use zero for no timeout.
+   * The same restrictions as for #MHD_CONNECTION_OPTION_TIMEOUT
+   * apply.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_CONNECTION_OPTION_TIMEOUT_MS,
+
+  /**
+   * Set the kernel send-buffer size (`SO_SNDBUF`) of this
+   * connection's socket (followed by an `unsigned int` byte
+   * count); lets large-download connections get big buffers while
+   * small-API connections stay lean.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_CONNECTION_OPTION_SNDBUF_SIZE,
+
+  /**
+   * Set the kernel receive-buffer size (`SO_RCVBUF`) of this
+   * connection's socket (followed by an `unsigned int` byte
+   * count).
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_CONNECTION_OPTION_RCVBUF_SIZE,
+
+  /**
+   * Set `TCP_NOTSENT_LOWAT` for this connection (followed by an
+   * `unsigned int` byte count): write readiness is only signalled
+   * while less than the given amount of unsent data is queued,
+   * keeping latency-sensitive streams from buffering far ahead.
+   * Fails on platforms without the option.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_CONNECTION_OPTION_NOTSENT_LOWAT,
+
+  /**
+   * Limit the response transmission rate of this connection
+   * (followed by an `unsigned int` in bytes per second; 0 removes
+   * the limit).  MHD defers sends natively until the pacing window
+   * opens -- no suspend/resume round-trips -- using the event
+   * loop's timed wait.
+   * @note Available since #MHD_VERSION 0x00097107
+   * Not supported (the option is refused) in
+   * thread-per-connection mode, which has no owning event loop
+   * to re-arm a paced connection.
+   */
+  MHD_CONNECTION_OPTION_RATE_LIMIT,
+
+  /**
+   * Pause reading request data from this connection for the given
+   * number of milliseconds (followed by an `unsigned int`).
+   * Lightweight upload backpressure: unlike
+   * #MHD_suspend_connection there are no list migrations and no
+   * resume call -- MHD simply drops read interest until the
+   * deadline (TCP then throttles the sender via the receive
+   * window) and resumes automatically.  Intended to be called from
+   * the upload path of the access handler when the downstream sink
+   * (e.g. object storage) falls behind.
+   * @note Available since #MHD_VERSION 0x00097107
+   * Not supported (the option is refused) in
+   * thread-per-connection mode, which has no owning event loop
+   * to re-arm a paced connection.
+   */
+  MHD_CONNECTION_OPTION_READ_PAUSE_MS,
+
+  /**
+   * Spool the remainder of this request's upload body to an
+   * unlinked temporary file (Linux `O_TMPFILE`, falling back to
+   * mkstemp+unlink) instead of delivering it through per-chunk
+   * handler callbacks: call this from the first upload invocation
+   * of the access handler (followed by an `unsigned int` upper
+   * bound on the body size in MiB; 0 = unlimited), and MHD will
+   * consume the body itself; the handler is next invoked when the
+   * upload is complete, and can fetch the file descriptor
+   * (positioned at offset 0) with
+   * #MHD_CONNECTION_INFO_SPOOL_FD.  The descriptor is closed with
+   * the request unless the application dup()s it.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_CONNECTION_OPTION_SPOOL_BODY,
+
+  /**
+   * Application-controlled output corking (followed by an
+   * `unsigned int`: 1 corks, 0 uncorks and flushes): while corked,
+   * MHD never pushes partial segments to the network even at
+   * points where it normally would (end of a response, chunk
+   * boundaries), letting several queue operations -- e.g. a
+   * chunked body followed microseconds later by its trailers --
+   * leave in full segments; uncorking flushes immediately.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  MHD_CONNECTION_OPTION_CORK,
+
+  /**
+   * Limit the rate at which MHD reads request data from this
+   * connection (followed by an `unsigned int` in bytes per
+   * second; 0 removes the limit).  A per-connection token bucket
+   * enforced in the read path: when the budget for the current
+   * window is spent, read interest is dropped (the kernel's
+   * receive window then backpressures the sender) and the event
+   * loop's timed wait re-arms it -- no suspend/resume list
+   * traffic.  Combine with
+   * #MHD_CONNECTION_INFO_BYTES_RECEIVED for ingress billing.
+   * @note Available since #MHD_VERSION 0x00097107
+   * Not supported (the option is refused) in
+   * thread-per-connection mode, which has no owning event loop
+   * to re-arm a paced connection.
+   */
+  MHD_CONNECTION_OPTION_RECV_RATE_LIMIT
 
 };
 
@@ -3863,6 +5688,21 @@ union MHD_DaemonInfo
    * daemon, especially if #MHD_USE_AUTO was set.
    */
   enum MHD_FLAG flags;
+
+  /**
+   * Value of a run-time statistics counter, for the
+   * MHD_DAEMON_INFO_TOTAL_* / timeout / error / pool-exhaustion
+   * queries.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  uint64_t stat_value;
+
+  /**
+   * Time-to-first-byte histogram buckets, for
+   * #MHD_DAEMON_INFO_TTFB_HISTOGRAM.
+   * @note Available since #MHD_VERSION 0x00097107
+   */
+  uint64_t ttfb_histogram[MHD_TTFB_HISTOGRAM_BUCKETS];
 };
 
 
@@ -70,6 +70,21 @@
  * - varargs in upgrade is still there and ugly (and not even used!)
  * - migrate event loop apis (get fdset, timeout, MHD_run(), etc.)
  */
+/*
+ * Status note for migration planning (2026-09): this next-generation
+ * API and the src/lib engine behind it remain EXPERIMENTAL and
+ * incomplete -- the tree only builds them under
+ * --enable-experimental, several actions are stubs, and none of the
+ * performance work validated on the mature engine (O(resumed)
+ * resume queues, per-loop clock publication, zero-allocation error
+ * responses, pool recycling) has been ported.  Treat the mature
+ * microhttpd.h API as the production surface; the recent additions
+ * there (router/vhost dispatch, iovec and mmap responses, frozen
+ * responses, request-scoped pool allocation) cover the
+ * zero-allocation request-handling goals this header aims at,
+ * without waiting for MHD2.
+ */
+
 #ifndef MICROHTTPD2_H
 #define MICROHTTPD2_H
 
@@ -60,6 +60,8 @@ suspend_action (void *cls,
       XDLL_remove (daemon->manual_timeout_head,
                    daemon->manual_timeout_tail,
                    connection);
+    MHD_timing_wheel_remove_ (&daemon->timeout_wheel,
+                              &connection->tw_node);
   }
   DLL_remove (daemon->connections_head,
               daemon->connections_tail,
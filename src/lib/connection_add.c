@@ -809,6 +809,13 @@ internal_add_connection (struct MHD_Daemon *daemon,
     XDLL_insert (daemon->normal_timeout_head,
                  daemon->normal_timeout_tail,
                  connection);
+    if (0 != connection->connection_timeout)
+      MHD_timing_wheel_schedule_ (&daemon->timeout_wheel,
+                                  &connection->tw_node,
+                                  MHD_monotonic_msec_counter (),
+                                  ((uint64_t) connection->last_activity
+                                   + connection->connection_timeout)
+                                  * 1000);
   }
   DLL_insert (daemon->connections_head,
               daemon->connections_tail,
@@ -919,6 +926,8 @@ cleanup:
     XDLL_remove (daemon->normal_timeout_head,
                  daemon->normal_timeout_tail,
                  connection);
+    MHD_timing_wheel_remove_ (&daemon->timeout_wheel,
+                              &connection->tw_node);
   }
   DLL_remove (daemon->connections_head,
               daemon->connections_tail,
@@ -2848,6 +2848,8 @@ cleanup_connection (struct MHD_Connection *connection)
         XDLL_remove (daemon->manual_timeout_head,
                      daemon->manual_timeout_tail,
                      connection);
+      MHD_timing_wheel_remove_ (&daemon->timeout_wheel,
+                                &connection->tw_node);
     }
     DLL_remove (daemon->connections_head,
                 daemon->connections_tail,
@@ -72,6 +72,16 @@ MHD_connection_set_timeout (struct MHD_Connection *connection,
       XDLL_insert (daemon->manual_timeout_head,
                    daemon->manual_timeout_tail,
                    connection);
+    if (0 != connection->connection_timeout)
+      MHD_timing_wheel_schedule_ (&daemon->timeout_wheel,
+                                  &connection->tw_node,
+                                  MHD_monotonic_msec_counter (),
+                                  ((uint64_t) connection->last_activity
+                                   + connection->connection_timeout)
+                                  * 1000);
+    else
+      MHD_timing_wheel_remove_ (&daemon->timeout_wheel,
+                                &connection->tw_node);
   }
   MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 }
@@ -99,18 +109,26 @@ MHD_update_last_activity_ (struct MHD_Connection *connection)
   if (MHD_TM_THREAD_PER_CONNECTION == daemon->threading_mode)
     return; /* each connection has personal timeout */
 
-  if (connection->connection_timeout !=
-      daemon->connection_default_timeout)
-    return; /* custom timeout, no need to move it in "normal" DLL */
-
   MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
-  /* move connection to head of timeout list (by remove + add operation) */
-  XDLL_remove (daemon->normal_timeout_head,
-               daemon->normal_timeout_tail,
-               connection);
-  XDLL_insert (daemon->normal_timeout_head,
-               daemon->normal_timeout_tail,
-               connection);
+  if (connection->connection_timeout ==
+      daemon->connection_default_timeout)
+  {
+    /* move connection to head of timeout list (by remove + add
+       operation); custom-timeout connections stay in the (unsorted)
+       manual XDLL but still need their wheel deadline pushed out */
+    XDLL_remove (daemon->normal_timeout_head,
+                 daemon->normal_timeout_tail,
+                 connection);
+    XDLL_insert (daemon->normal_timeout_head,
+                 daemon->normal_timeout_tail,
+                 connection);
+  }
+  MHD_timing_wheel_schedule_ (&daemon->timeout_wheel,
+                              &connection->tw_node,
+                              MHD_monotonic_msec_counter (),
+                              ((uint64_t) connection->last_activity
+                               + connection->connection_timeout)
+                              * 1000);
   MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 }
 
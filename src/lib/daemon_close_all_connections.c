@@ -65,6 +65,8 @@ close_connection (struct MHD_Connection *pos)
     XDLL_remove (daemon->manual_timeout_head,
                  daemon->manual_timeout_tail,
                  pos);
+  MHD_timing_wheel_remove_ (&daemon->timeout_wheel,
+                            &pos->tw_node);
   DLL_remove (daemon->connections_head,
               daemon->connections_tail,
               pos);
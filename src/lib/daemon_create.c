@@ -110,6 +110,8 @@ MHD_daemon_create (MHD_RequestCallback cb,
   daemon->listen_backlog = LISTEN_BACKLOG_DEFAULT;
   daemon->fo_queue_length = FO_QUEUE_LENGTH_DEFAULT;
   daemon->listen_socket = MHD_INVALID_SOCKET;
+  MHD_timing_wheel_init_ (&daemon->timeout_wheel,
+                          MHD_monotonic_msec_counter ());
 
   if (! MHD_mutex_init_ (&daemon->cleanup_connection_mutex))
   {
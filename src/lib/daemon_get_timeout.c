@@ -48,11 +48,6 @@ enum MHD_StatusCode
 MHD_daemon_get_timeout (struct MHD_Daemon *daemon,
                         MHD_UNSIGNED_LONG_LONG *timeout)
 {
-  time_t earliest_deadline;
-  time_t now;
-  struct MHD_Connection *pos;
-  bool have_timeout;
-
   if (MHD_TM_EXTERNAL_EVENT_LOOP != daemon->threading_mode)
   {
 #ifdef HAVE_MESSAGES
@@ -60,7 +55,7 @@ MHD_daemon_get_timeout (struct MHD_Daemon *daemon,
               MHD_SC_CONFIGURATION_MISMATCH_FOR_GET_TIMEOUT,
               _ ("Illegal call to MHD_get_timeout.\n"));
 #endif
-    return MHD_SC_CONFIGURATION_MISSMATCH_FOR_GET_TIMEOUT;
+    return MHD_SC_CONFIGURATION_MISMATCH_FOR_GET_TIMEOUT;
   }
 
   if (daemon->data_already_pending)
@@ -84,41 +79,25 @@ MHD_daemon_get_timeout (struct MHD_Daemon *daemon,
   }
 #endif /* EPOLL_SUPPORT */
 
-  have_timeout = false;
-  earliest_deadline = 0; /* avoid compiler warnings */
-  for (pos = daemon->manual_timeout_tail; NULL != pos; pos = pos->prevX)
-  {
-    if (0 != pos->connection_timeout)
-    {
-      if ( (! have_timeout) ||
-           (earliest_deadline - pos->last_activity > pos->connection_timeout) )
-        earliest_deadline = pos->last_activity + pos->connection_timeout;
-      have_timeout = true;
-    }
-  }
-  /* normal timeouts are sorted, so we only need to look at the 'tail' (oldest) */
-  pos = daemon->normal_timeout_tail;
-  if ( (NULL != pos) &&
-       (0 != pos->connection_timeout) )
+  /* The timing wheel tracks every connection's inactivity
+     deadline; querying it inspects only wheel slots, never
+     connections, so the cost is independent of the connection
+     count (the old code scanned the whole manual-timeout XDLL
+     here). */
   {
-    if ( (! have_timeout) ||
-         (earliest_deadline - pos->connection_timeout > pos->last_activity) )
-      earliest_deadline = pos->last_activity + pos->connection_timeout;
-    have_timeout = true;
-  }
+    const uint64_t now_ms = MHD_monotonic_msec_counter ();
+    uint64_t deadline_ms;
 
-  if (! have_timeout)
-    return MHD_SC_NO_TIMEOUT;
-  now = MHD_monotonic_sec_counter ();
-  if (earliest_deadline < now)
-    *timeout = 0;
-  else
-  {
-    const time_t second_left = earliest_deadline - now;
-    if (second_left > ULLONG_MAX / 1000)   /* Ignore compiler warning: 'second_left' is always positive. */
-      *timeout = ULLONG_MAX;
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+    deadline_ms = MHD_timing_wheel_next_deadline_ (&daemon->timeout_wheel,
+                                                   now_ms);
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+    if (UINT64_MAX == deadline_ms)
+      return MHD_SC_NO_TIMEOUT;
+    if (deadline_ms <= now_ms)
+      *timeout = 0;
     else
-      *timeout = 1000LL * second_left;
+      *timeout = deadline_ms - now_ms;
   }
   return MHD_SC_OK;
 }
@@ -36,6 +36,7 @@
 #include "mhd_itc.h"
 #include "mhd_mono_clock.h"
 #include "memorypool.h"
+#include "timing_wheel.h"
 
 #ifdef HTTPS_SUPPORT
 #include <gnutls/gnutls.h>
@@ -669,6 +670,13 @@ struct MHD_Connection
    */
   struct MHD_Connection *prevX;
 
+  /**
+   * Timer node in the daemon's @e timeout_wheel; scheduled for the
+   * connection's inactivity deadline whenever a timeout is active.
+   * Protected by the same lock as the timeout XDLLs.
+   */
+  struct MHD_TimingWheelNode tw_node;
+
   /**
    * Reference to the MHD_Daemon struct.
    */
@@ -1149,6 +1157,14 @@ struct MHD_Daemon
    */
   struct MHD_Connection *manual_timeout_tail;
 
+  /**
+   * Hierarchical timing wheel tracking every connection's
+   * inactivity deadline; authoritative for computing the event
+   * loop's next wake-up time (#MHD_daemon_get_timeout()) without
+   * scanning connections.  Shares the timeout XDLLs' lock.
+   */
+  struct MHD_TimingWheel timeout_wheel;
+
   /**
    * Head of doubly-linked list of our current, active connections.
    */
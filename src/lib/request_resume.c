@@ -139,6 +139,13 @@ MHD_resume_suspended_connections_ (struct MHD_Daemon *daemon)
           XDLL_insert (daemon->manual_timeout_head,
                        daemon->manual_timeout_tail,
                        pos);
+        if (0 != pos->connection_timeout)
+          MHD_timing_wheel_schedule_ (&daemon->timeout_wheel,
+                                      &pos->tw_node,
+                                      MHD_monotonic_msec_counter (),
+                                      ((uint64_t) pos->last_activity
+                                       + pos->connection_timeout)
+                                      * 1000);
       }
 #ifdef EPOLL_SUPPORT
       if (MHD_ELS_EPOLL == daemon->event_loop_syscall)
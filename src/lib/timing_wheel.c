@@ -0,0 +1,247 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Daniel Pittman and Christian Grothoff
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file lib/timing_wheel.c
+ * @brief hierarchical timing wheel implementation
+ * @author Christian Grothoff
+ */
+#include "timing_wheel.h"
+#include "mhd_assert.h"
+
+#include <string.h>
+
+
+/**
+ * Compute level and slot index for @a deadline_tick relative to
+ * the wheel's current tick.  Level L covers ticks that differ
+ * from 'now' only in bit positions below (L+1)*#MHD_TW_SLOT_BITS;
+ * within a level the slot is the deadline's slot-index bits for
+ * that level, so cascading a slot re-distributes its nodes over
+ * the finer level without comparisons.
+ *
+ * @param tw the wheel
+ * @param deadline_tick deadline in ticks (>= tw->cur_tick)
+ * @param[out] level set to the wheel level
+ * @return slot index within *level
+ */
+static unsigned int
+tw_position (const struct MHD_TimingWheel *tw,
+             uint64_t deadline_tick,
+             unsigned int *level)
+{
+  uint64_t delta = deadline_tick - tw->cur_tick;
+  unsigned int l;
+
+  for (l = 0; l < MHD_TW_LEVELS - 1; l++)
+  {
+    if (delta < (((uint64_t) 1) << ((l + 1) * MHD_TW_SLOT_BITS)))
+      break;
+  }
+  *level = l;
+  return (unsigned int) ((deadline_tick >> (l * MHD_TW_SLOT_BITS))
+                         & (MHD_TW_SLOTS - 1));
+}
+
+
+/**
+ * Hang @a node into the slot for its deadline.
+ *
+ * @param tw the wheel
+ * @param node node with deadline_ms already set
+ */
+static void
+tw_enqueue (struct MHD_TimingWheel *tw,
+            struct MHD_TimingWheelNode *node)
+{
+  uint64_t deadline_tick = node->deadline_ms >> MHD_TW_TICK_BITS;
+  unsigned int level;
+  unsigned int slot;
+
+  if (deadline_tick < tw->cur_tick)
+    deadline_tick = tw->cur_tick; /* past deadlines fire on next advance */
+  slot = tw_position (tw,
+                      deadline_tick,
+                      &level);
+  node->slot = &tw->slots[level][slot];
+  node->prev = NULL;
+  node->next = *node->slot;
+  if (NULL != node->next)
+    node->next->prev = node;
+  *node->slot = node;
+}
+
+
+void
+MHD_timing_wheel_init_ (struct MHD_TimingWheel *tw,
+                        uint64_t now_ms)
+{
+  memset (tw,
+          0,
+          sizeof (*tw));
+  tw->cur_tick = now_ms >> MHD_TW_TICK_BITS;
+}
+
+
+void
+MHD_timing_wheel_schedule_ (struct MHD_TimingWheel *tw,
+                            struct MHD_TimingWheelNode *node,
+                            uint64_t now_ms,
+                            uint64_t deadline_ms)
+{
+  if (NULL != node->slot)
+    MHD_timing_wheel_remove_ (tw,
+                              node);
+  if (0 == tw->count)
+    tw->cur_tick = now_ms >> MHD_TW_TICK_BITS;
+  node->deadline_ms = deadline_ms;
+  tw_enqueue (tw,
+              node);
+  tw->count++;
+}
+
+
+void
+MHD_timing_wheel_remove_ (struct MHD_TimingWheel *tw,
+                          struct MHD_TimingWheelNode *node)
+{
+  if (NULL == node->slot)
+    return;
+  if (NULL != node->prev)
+    node->prev->next = node->next;
+  else
+    *node->slot = node->next;
+  if (NULL != node->next)
+    node->next->prev = node->prev;
+  node->slot = NULL;
+  node->next = NULL;
+  node->prev = NULL;
+  mhd_assert (0 < tw->count);
+  tw->count--;
+}
+
+
+/**
+ * Re-distribute every node of the given slot; used when time
+ * advances past a coarse slot's boundary ("cascade").  Nodes land
+ * on a finer level (or the current slot, if already due).
+ *
+ * @param tw the wheel
+ * @param level level to cascade from
+ * @param slot slot index within @a level
+ */
+static void
+tw_cascade (struct MHD_TimingWheel *tw,
+            unsigned int level,
+            unsigned int slot)
+{
+  struct MHD_TimingWheelNode *node = tw->slots[level][slot];
+
+  tw->slots[level][slot] = NULL;
+  while (NULL != node)
+  {
+    struct MHD_TimingWheelNode *next = node->next;
+
+    tw_enqueue (tw,
+                node);
+    node = next;
+  }
+}
+
+
+uint64_t
+MHD_timing_wheel_next_deadline_ (struct MHD_TimingWheel *tw,
+                                 uint64_t now_ms)
+{
+  const uint64_t now_tick = now_ms >> MHD_TW_TICK_BITS;
+  uint64_t best;
+  unsigned int level;
+
+  if (0 == tw->count)
+  {
+    tw->cur_tick = now_tick;
+    return UINT64_MAX;
+  }
+  /* Timers in the current slot are due right now (parked past
+     deadlines land here too); report them before advancing so a
+     due timer is never pushed into the future. */
+  if (NULL != tw->slots[0][tw->cur_tick & (MHD_TW_SLOTS - 1)])
+    return tw->cur_tick << MHD_TW_TICK_BITS;
+  /* advance tick by tick, cascading coarser levels whenever the
+     finer one wraps; bounded by slots visited, not by timers.
+     Stop at the first occupied fine slot: those timers are due at
+     or before 'now', the caller handles them, and the advance
+     resumes on the next query. */
+  while (tw->cur_tick < now_tick)
+  {
+    unsigned int l;
+
+    tw->cur_tick++;
+    for (l = 1; l < MHD_TW_LEVELS; l++)
+    {
+      if (0 != (tw->cur_tick
+                & (((uint64_t) 1 << (l * MHD_TW_SLOT_BITS)) - 1)))
+        break;
+      tw_cascade (tw,
+                  l,
+                  (unsigned int) ((tw->cur_tick >> (l * MHD_TW_SLOT_BITS))
+                                  & (MHD_TW_SLOTS - 1)));
+    }
+    if (NULL != tw->slots[0][tw->cur_tick & (MHD_TW_SLOTS - 1)])
+      return tw->cur_tick << MHD_TW_TICK_BITS;
+  }
+  /* Report the earliest pending deadline without walking any
+     node lists: every nonempty slot's earliest possible firing
+     time is the start of the time frame the slot covers, which is
+     pure index arithmetic.  The estimate errs early by at most
+     one frame of the slot's level; an early wake-up merely causes
+     one extra (cheap) poll-and-cascade round and coarse slots are
+     re-distributed into finer levels as their frames approach, so
+     estimates refine automatically.  Frames containing cur_tick
+     are always already cascaded, hence every estimate is in the
+     future and the caller cannot spin. */
+  best = UINT64_MAX;
+  for (level = 0; level < MHD_TW_LEVELS; level++)
+  {
+    const unsigned int shift = level * MHD_TW_SLOT_BITS;
+    const uint64_t frame = tw->cur_tick >> shift;
+    unsigned int s;
+
+    for (s = 0; s < MHD_TW_SLOTS; s++)
+    {
+      uint64_t f;
+      uint64_t est;
+
+      if (NULL == tw->slots[level][s])
+        continue;
+      /* first frame with index 's' at/after the current frame */
+      f = frame + ((s - frame) & (MHD_TW_SLOTS - 1));
+      est = (f << shift) << MHD_TW_TICK_BITS;
+      if (est < best)
+        best = est;
+    }
+    /* no early exit: a coarse slot's frame can start before the
+       finest level's earliest node, so all levels are inspected
+       (a constant 256 slot checks) */
+  }
+  return best;
+}
+
+
+/* end of timing_wheel.c */
@@ -0,0 +1,171 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Daniel Pittman and Christian Grothoff
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file lib/timing_wheel.h
+ * @brief hierarchical timing wheel for connection timeouts
+ * @author Christian Grothoff
+ *
+ * Scalable replacement for the timeout DLL scans of the mature
+ * code: schedule, reschedule and cancel are O(1), and finding the
+ * next deadline only inspects wheel slots, never connections.
+ * Expired timers cascade lazily from the coarse wheels to the
+ * fine one as time advances.
+ */
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * log2 of the number of slots per wheel level.
+ */
+#define MHD_TW_SLOT_BITS 6
+
+/**
+ * Number of slots per wheel level.
+ */
+#define MHD_TW_SLOTS (1 << MHD_TW_SLOT_BITS)
+
+/**
+ * log2 of the base tick length in milliseconds.  256ms ticks keep
+ * the fine wheel small while staying well below the 1s timeout
+ * granularity of the current public API.
+ */
+#define MHD_TW_TICK_BITS 8
+
+/**
+ * Number of wheel levels.  Four levels of 64 slots at 256ms base
+ * tick cover deadlines up to roughly 50 days; anything beyond is
+ * parked in the top level and re-cascaded.
+ */
+#define MHD_TW_LEVELS 4
+
+/**
+ * Timer node, embedded in the object whose deadline is tracked
+ * (one per connection).  All fields are managed by the wheel.
+ */
+struct MHD_TimingWheelNode
+{
+  /**
+   * Next node in the same slot, NULL at the end.
+   */
+  struct MHD_TimingWheelNode *next;
+
+  /**
+   * Previous node in the same slot, NULL at the head.
+   */
+  struct MHD_TimingWheelNode *prev;
+
+  /**
+   * Slot list this node currently hangs in, NULL if the node is
+   * not scheduled.
+   */
+  struct MHD_TimingWheelNode **slot;
+
+  /**
+   * Absolute deadline in milliseconds (monotonic clock).
+   */
+  uint64_t deadline_ms;
+};
+
+/**
+ * Hierarchical timing wheel.  Not internally locked; callers
+ * serialize access the same way they serialize the timeout DLLs.
+ */
+struct MHD_TimingWheel
+{
+  /**
+   * Slot lists, @e MHD_TW_LEVELS levels of #MHD_TW_SLOTS each.
+   */
+  struct MHD_TimingWheelNode *slots[MHD_TW_LEVELS][MHD_TW_SLOTS];
+
+  /**
+   * Current time in ticks (ms right-shifted by #MHD_TW_TICK_BITS);
+   * slots below this tick have been cascaded or expired.
+   */
+  uint64_t cur_tick;
+
+  /**
+   * Number of nodes currently scheduled, across all levels.
+   */
+  size_t count;
+};
+
+
+/**
+ * Initialize an empty wheel positioned at @a now_ms.
+ *
+ * @param tw wheel to initialize
+ * @param now_ms current monotonic time in milliseconds
+ */
+void
+MHD_timing_wheel_init_ (struct MHD_TimingWheel *tw,
+                        uint64_t now_ms);
+
+
+/**
+ * Schedule (or reschedule) @a node to fire at @a deadline_ms.
+ * O(1); a node already scheduled is moved.  An empty wheel is
+ * re-anchored to @a now_ms first, so the wheel tolerates clock
+ * re-initialization while it holds no timers.
+ *
+ * @param tw the wheel
+ * @param node node to schedule
+ * @param now_ms current monotonic time in milliseconds
+ * @param deadline_ms absolute deadline in milliseconds; deadlines
+ *        in the past are parked in the current slot
+ */
+void
+MHD_timing_wheel_schedule_ (struct MHD_TimingWheel *tw,
+                            struct MHD_TimingWheelNode *node,
+                            uint64_t now_ms,
+                            uint64_t deadline_ms);
+
+
+/**
+ * Cancel @a node if it is scheduled.  O(1), idempotent.
+ *
+ * @param tw the wheel
+ * @param node node to cancel
+ */
+void
+MHD_timing_wheel_remove_ (struct MHD_TimingWheel *tw,
+                          struct MHD_TimingWheelNode *node);
+
+
+/**
+ * Advance the wheel to @a now_ms, lazily cascading coarse slots,
+ * and report the earliest pending deadline.  Only wheel slots are
+ * inspected; the cost is bounded by the slot count, independent
+ * of how many timers are scheduled.
+ *
+ * @param tw the wheel
+ * @param now_ms current monotonic time in milliseconds
+ * @return earliest deadline in milliseconds (may be in the past
+ *         if a timer already expired), or #UINT64_MAX if the
+ *         wheel is empty
+ */
+uint64_t
+MHD_timing_wheel_next_deadline_ (struct MHD_TimingWheel *tw,
+                                 uint64_t now_ms);
+
+#endif /* TIMING_WHEEL_H */
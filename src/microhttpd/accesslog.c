@@ -0,0 +1,403 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/accesslog.c
+ * @brief  Lock-free access-log pipeline with background writer
+ * @author Christian Grothoff
+ *
+ * Request-completion paths deposit fixed-size binary records into a
+ * ring (a relaxed atomic claim plus a release-published ready flag;
+ * no mutex, no formatting, no syscall); a dedicated writer thread
+ * drains the ring in batches, formats the text lines and writes
+ * them with a single write() per batch.  When the ring is full,
+ * records are dropped and counted instead of stalling request
+ * processing.
+ */
+#include "internal.h"
+#include "mhd_compat.h"
+#include "mhd_mono_clock.h"
+
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+#include "mhd_threads.h"
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif /* HAVE_UNISTD_H */
+
+
+/**
+ * One binary log record; fixed size so ring slots never fragment.
+ */
+struct MHD_AccessLogRecord
+{
+  /**
+   * Wall-clock time of completion (seconds since epoch).
+   */
+  uint64_t ts;
+
+  /**
+   * Time-to-completion of the request in milliseconds.
+   */
+  uint32_t duration_ms;
+
+  /**
+   * HTTP status code of the reply.
+   */
+  uint16_t status;
+
+  /**
+   * Request method (truncated).
+   */
+  char method[8];
+
+  /**
+   * Request URL (truncated).
+   */
+  char url[98];
+};
+
+
+/**
+ * State of one ring slot.
+ */
+enum MHD_AccessLogSlotState
+{
+  MHD_ALOG_SLOT_FREE = 0,
+  MHD_ALOG_SLOT_BUSY = 1,
+  MHD_ALOG_SLOT_READY = 2
+};
+
+
+/**
+ * The access-log pipeline.
+ * @sa #MHD_access_log_create()
+ */
+struct MHD_AccessLog
+{
+  /**
+   * Ring of records.
+   */
+  struct MHD_AccessLogRecord *ring;
+
+  /**
+   * Per-slot publication flags.
+   */
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  atomic_uchar *flags;
+#else
+  volatile unsigned char *flags;
+#endif
+
+  /**
+   * Number of slots (power of two).
+   */
+  unsigned int size;
+
+  /**
+   * Producer claim counter.
+   */
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  atomic_uint_fast64_t head;
+#else
+  volatile uint64_t head;
+#endif
+
+  /**
+   * Consumer position (writer thread only).
+   */
+  uint64_t tail;
+
+  /**
+   * Records dropped because the ring was full.
+   */
+  MHD_statcnt_ dropped;
+
+  /**
+   * Output file descriptor.
+   */
+  int fd;
+
+  /**
+   * Set to stop the writer thread.
+   */
+  volatile bool shutdown;
+
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  /**
+   * The writer thread.
+   */
+  MHD_thread_handle_ID_ writer;
+#endif
+};
+
+
+/**
+ * Writer thread: drain ready records, format and write in batches.
+ *
+ * @param cls the `struct MHD_AccessLog`
+ * @return always 0 (per thread API)
+ */
+static MHD_THRD_RTRN_TYPE_ MHD_THRD_CALL_SPEC_
+access_log_writer_ (void *cls)
+{
+  struct MHD_AccessLog *log = cls;
+  char buf[16384];
+
+  for (;;)
+  {
+    size_t used = 0;
+    bool wrote = false;
+
+    while (1)
+    {
+      const unsigned int slot = (unsigned int) (log->tail
+                                                & (log->size - 1));
+      struct MHD_AccessLogRecord rec;
+      int n;
+
+#ifdef MHD_HAVE_STDC_ATOMICS_
+      if (MHD_ALOG_SLOT_READY !=
+          atomic_load_explicit (&log->flags[slot],
+                                memory_order_acquire))
+        break;
+#else
+      if (MHD_ALOG_SLOT_READY != log->flags[slot])
+        break;
+#endif
+      rec = log->ring[slot];
+#ifdef MHD_HAVE_STDC_ATOMICS_
+      atomic_store_explicit (&log->flags[slot],
+                             MHD_ALOG_SLOT_FREE,
+                             memory_order_release);
+#else
+      log->flags[slot] = MHD_ALOG_SLOT_FREE;
+#endif
+      log->tail++;
+      n = MHD_snprintf_ (buf + used,
+                         sizeof (buf) - used,
+                         "%llu %u %u %s %s\n",
+                         (unsigned long long) rec.ts,
+                         (unsigned int) rec.status,
+                         (unsigned int) rec.duration_ms,
+                         rec.method,
+                         rec.url);
+      if (0 < n)
+        used += (size_t) n;
+      if (used + sizeof (struct MHD_AccessLogRecord) * 2 > sizeof (buf))
+      {
+        if (0 > write (log->fd, buf, used))
+          (void) 0; /* nothing sensible to do */
+        used = 0;
+        wrote = true;
+      }
+    }
+    if (0 != used)
+    {
+      if (0 > write (log->fd, buf, used))
+        (void) 0;
+      wrote = true;
+    }
+    if (log->shutdown)
+      break;
+    if (! wrote)
+    {
+      /* idle: sleep briefly (records tolerate small delay) */
+#if defined(_WIN32) && ! defined(__CYGWIN__)
+      Sleep (20);
+#else
+      usleep (20 * 1000);
+#endif
+    }
+  }
+  return (MHD_THRD_RTRN_TYPE_) 0;
+}
+
+
+/**
+ * Create an access-log pipeline writing to @a fd.
+ *
+ * @param fd file descriptor to append formatted log lines to
+ *        (not closed on destroy)
+ * @param ring_size number of in-flight records to buffer (rounded
+ *        up to a power of two, min 1024)
+ * @return the log handle, NULL on error
+ * @ingroup logging
+ */
+struct MHD_AccessLog *
+MHD_access_log_create (int fd,
+                       unsigned int ring_size)
+{
+  struct MHD_AccessLog *log;
+  unsigned int size = 1024;
+
+  if (-1 == fd)
+    return NULL;
+  while (size < ring_size)
+    size <<= 1;
+  log = MHD_calloc_ (1, sizeof (struct MHD_AccessLog));
+  if (NULL == log)
+    return NULL;
+  log->ring = MHD_calloc_ (size, sizeof (struct MHD_AccessLogRecord));
+  log->flags = MHD_calloc_ (size, sizeof (log->flags[0]));
+  if ( (NULL == log->ring) ||
+       (NULL == log->flags) )
+  {
+    free ((void *) log->flags);
+    free (log->ring);
+    free (log);
+    return NULL;
+  }
+  log->size = size;
+  log->fd = fd;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  if (! MHD_create_named_thread_ (&log->writer,
+                                  "MHD-accesslog",
+                                  0,
+                                  &access_log_writer_,
+                                  log))
+  {
+    free ((void *) log->flags);
+    free (log->ring);
+    free (log);
+    return NULL;
+  }
+#endif
+  return log;
+}
+
+
+/**
+ * Stop the writer (flushing pending records) and release the log.
+ *
+ * @param log the log to destroy (maybe NULL)
+ * @ingroup logging
+ */
+void
+MHD_access_log_destroy (struct MHD_AccessLog *log)
+{
+  if (NULL == log)
+    return;
+  log->shutdown = true;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  if (! MHD_join_thread_ (log->writer.handle))
+    MHD_PANIC (_ ("Failed to join a thread.\n"));
+#endif
+  free ((void *) log->flags);
+  free (log->ring);
+  free (log);
+}
+
+
+/**
+ * Get the number of records dropped due to ring overflow.
+ *
+ * @param log the log
+ * @return dropped record count
+ * @ingroup logging
+ */
+uint64_t
+MHD_access_log_dropped (struct MHD_AccessLog *log)
+{
+  if (NULL == log)
+    return 0;
+  return MHD_statcnt_get_ (&log->dropped);
+}
+
+
+/**
+ * Deposit one record (called from the request-completion path;
+ * wait-free, no formatting, no syscalls).
+ *
+ * @param log the log
+ * @param status HTTP status code served
+ * @param duration_ms request duration in milliseconds
+ * @param method the request method (maybe NULL)
+ * @param url the request URL (maybe NULL)
+ */
+void
+MHD_access_log_record_ (struct MHD_AccessLog *log,
+                        unsigned int status,
+                        uint32_t duration_ms,
+                        const char *method,
+                        const char *url)
+{
+  uint64_t pos;
+  unsigned int slot;
+  struct MHD_AccessLogRecord *rec;
+
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  pos = (uint64_t) atomic_fetch_add_explicit (&log->head,
+                                              1,
+                                              memory_order_relaxed);
+#else
+  pos = log->head++;
+#endif
+  slot = (unsigned int) (pos & (log->size - 1));
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  {
+    unsigned char expected = MHD_ALOG_SLOT_FREE;
+
+    if (! atomic_compare_exchange_strong_explicit (&log->flags[slot],
+                                                   &expected,
+                                                   MHD_ALOG_SLOT_BUSY,
+                                                   memory_order_acquire,
+                                                   memory_order_relaxed))
+    {
+      /* ring full (writer has not freed this slot yet): drop */
+      MHD_statcnt_inc_ (&log->dropped);
+      return;
+    }
+  }
+#else
+  if (MHD_ALOG_SLOT_FREE != log->flags[slot])
+  {
+    MHD_statcnt_inc_ (&log->dropped);
+    return;
+  }
+  log->flags[slot] = MHD_ALOG_SLOT_BUSY;
+#endif
+  rec = &log->ring[slot];
+  rec->ts = (uint64_t) time (NULL);
+  rec->status = (uint16_t) status;
+  rec->duration_ms = duration_ms;
+  if (NULL != method)
+  {
+    strncpy (rec->method, method, sizeof (rec->method) - 1);
+    rec->method[sizeof (rec->method) - 1] = '\0';
+  }
+  else
+    rec->method[0] = '\0';
+  if (NULL != url)
+  {
+    strncpy (rec->url, url, sizeof (rec->url) - 1);
+    rec->url[sizeof (rec->url) - 1] = '\0';
+  }
+  else
+    rec->url[0] = '\0';
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  atomic_store_explicit (&log->flags[slot],
+                         MHD_ALOG_SLOT_READY,
+                         memory_order_release);
+#else
+  log->flags[slot] = MHD_ALOG_SLOT_READY;
+#endif
+}
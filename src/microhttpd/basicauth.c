@@ -27,6 +27,7 @@
 #include "internal.h"
 #include "base64.h"
 #include "mhd_compat.h"
+#include "memorypool.h"
 
 /**
  * Beginning string for any valid Basic authentication header.
@@ -108,6 +109,79 @@ MHD_basic_auth_get_username_password (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Pool-backed variant of #MHD_basic_auth_get_username_password():
+ * the decoded credentials are placed in the connection's memory
+ * pool (request lifetime, no free), so authenticated requests
+ * stop paying malloc/free pairs here.
+ *
+ * @param connection The MHD connection structure
+ * @param[out] password set to the password view, NULL if not
+ *        interested
+ * @return the pool-backed username, NULL on failure
+ * @ingroup authentication
+ */
+const char *
+MHD_basic_auth_get_username_password2 (struct MHD_Connection *connection,
+                                       const char **password)
+{
+  const char *header;
+  char *decode;
+  char *sep;
+  char *copy;
+  size_t dlen;
+
+  if ( (MHD_NO == MHD_lookup_connection_value_n (connection,
+                                                 MHD_HEADER_KIND,
+                                                 MHD_HTTP_HEADER_AUTHORIZATION,
+                                                 MHD_STATICSTR_LEN_ (
+                                                   MHD_HTTP_HEADER_AUTHORIZATION),
+                                                 &header,
+                                                 NULL)) ||
+       (0 != strncmp (header,
+                      _BASIC_BASE,
+                      MHD_STATICSTR_LEN_ (_BASIC_BASE))) )
+    return NULL;
+  header += MHD_STATICSTR_LEN_ (_BASIC_BASE);
+  if (NULL == (decode = BASE64Decode (header)))
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (connection->daemon,
+              _ ("Error decoding basic authentication.\n"));
+#endif
+    return NULL;
+  }
+  if (NULL == (sep = strchr (decode,
+                             ':')))
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (connection->daemon,
+              _ ("Basic authentication doesn't contain ':' separator.\n"));
+#endif
+    free (decode);
+    return NULL;
+  }
+  /* one pool block holds "user\0password\0" */
+  dlen = strlen (decode) + 1;
+  copy = MHD_pool_allocate (connection->pool,
+                            dlen,
+                            true);
+  if (NULL == copy)
+  {
+    free (decode);
+    return NULL;
+  }
+  memcpy (copy,
+          decode,
+          dlen);
+  copy[sep - decode] = '\0'; /* cut off at ':' */
+  if (NULL != password)
+    *password = copy + (sep - decode) + 1;
+  free (decode);
+  return copy;
+}
+
+
 /**
  * Queues a response to request basic authentication from the client.
  * The given response object is expected to include the payload for
@@ -31,6 +31,7 @@
 #include "response.h"
 #include "mhd_mono_clock.h"
 #include "mhd_str.h"
+#include "mhd_probes.h"
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
 #include "mhd_locks.h"
 #endif
@@ -101,6 +102,33 @@
 #define REQUEST_MALFORMED ""
 #endif
 
+/**
+ * Response text used when the daemon sheds load under overload.
+ *
+ * Intentionally empty here to keep our memory footprint
+ * minimal.
+ */
+#ifdef HAVE_MESSAGES
+#define SERVER_OVERLOADED \
+  "<html><head><title>Service unavailable</title></head><body>The server is temporarily overloaded, please retry.</body></html>"
+#else
+#define SERVER_OVERLOADED ""
+#endif
+
+/**
+ * Response text used when a request carries a smuggling-shaped
+ * Transfer-Encoding/Content-Length combination.
+ *
+ * Intentionally empty here to keep our memory footprint
+ * minimal.
+ */
+#ifdef HAVE_MESSAGES
+#define REQUEST_SMUGGLING \
+  "<html><head><title>Request malformed</title></head><body>Conflicting or malformed message framing headers.</body></html>"
+#else
+#define REQUEST_SMUGGLING ""
+#endif
+
 /**
  * Response text used when there is an internal server error.
  *
@@ -115,6 +143,25 @@
 #endif
 
 
+/**
+ * Maximum number of (pipelined) requests one connection may
+ * complete within a single event dispatch before it must yield
+ * back to the event loop, bounding head-of-line latency that a
+ * bulk pipelining client would otherwise inflict on its
+ * neighbours.  The remaining buffered requests are served on the
+ * immediately following (zero-timeout) pass.
+ */
+#define MHD_PIPELINE_QUANTUM_ 8
+
+/**
+ * Hard byte budget for a single chunk's extensions in chunked
+ * uploads: RFC 7230 allows extensions but real clients send none,
+ * so anything past a small allowance is an attack or a broken
+ * peer and the connection is closed instead of rescanned and
+ * buffered without bound.
+ */
+#define MHD_CHUNK_EXTENSION_BUDGET_ 1024
+
 /**
  * sendfile() chuck size
  */
@@ -178,6 +225,61 @@ recv_param_adapter (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Parse the cookie header of the current request (no-op if done
+ * already).  Called lazily on the first #MHD_COOKIE_KIND lookup.
+ *
+ * @param connection connection to parse header of
+ * @return #MHD_YES for success, #MHD_NO for failure (malformed
+ *         header or out of memory)
+ */
+static enum MHD_Result
+parse_cookie_header (struct MHD_Connection *connection);
+
+
+/**
+ * Copy views of all key/value pairs of the given kinds into a
+ * caller-provided array; see microhttpd.h for the contract.
+ *
+ * @param connection connection to get values from
+ * @param kind kinds of entries to include (bitmask)
+ * @param[out] dst array to fill
+ * @param max number of entries @a dst can hold
+ * @return total number of matching entries, -1 on NULL connection
+ * @ingroup request
+ */
+int
+MHD_get_connection_values_array (struct MHD_Connection *connection,
+                                 enum MHD_ValueKind kind,
+                                 struct MHD_NameValueView *dst,
+                                 unsigned int max)
+{
+  int count = 0;
+  struct MHD_HTTP_Header *pos;
+
+  if (NULL == connection)
+    return -1;
+  if (0 != (kind & MHD_COOKIE_KIND))
+    (void) parse_cookie_header (connection);
+  for (pos = connection->headers_received; NULL != pos; pos = pos->next)
+  {
+    if (0 == (pos->kind & kind))
+      continue;
+    if ( (NULL != dst) &&
+         ((unsigned int) count < max) )
+    {
+      dst[count].name = pos->header;
+      dst[count].name_size = pos->header_size;
+      dst[count].value = pos->value;
+      dst[count].value_size = pos->value_size;
+      dst[count].kind = pos->kind;
+    }
+    count++;
+  }
+  return count;
+}
+
+
 /**
  * Get all of the headers from the request.
  *
@@ -201,6 +303,8 @@ MHD_get_connection_values (struct MHD_Connection *connection,
 
   if (NULL == connection)
     return -1;
+  if (0 != (kind & MHD_COOKIE_KIND))
+    (void) parse_cookie_header (connection);
   ret = 0;
   for (pos = connection->headers_received; NULL != pos; pos = pos->next)
     if (0 != (pos->kind & kind))
@@ -240,6 +344,8 @@ MHD_get_connection_values_n (struct MHD_Connection *connection,
 
   if (NULL == connection)
     return -1;
+  if (0 != (kind & MHD_COOKIE_KIND))
+    (void) parse_cookie_header (connection);
   ret = 0;
 
   if (NULL == iterator)
@@ -299,9 +405,14 @@ MHD_set_connection_value_n_nocheck_ (struct MHD_Connection *connection,
     return MHD_NO;
   pos->header = (char *) key;
   pos->header_size = key_size;
+  pos->header_hash = (NULL != key)
+                     ? MHD_str_hash_caseless_bin_n_ (key,
+                                                     key_size)
+                     : 0;
   pos->value = (char *) value;
   pos->value_size = value_size;
   pos->kind = kind;
+  pos->bulk_alloc = false;
   pos->next = NULL;
   /* append 'pos' to the linked list of headers */
   if (NULL == connection->headers_received_tail)
@@ -409,6 +520,33 @@ MHD_set_connection_value (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Allocate request-scoped scratch memory from the connection's
+ * memory pool; reclaimed automatically when the current request
+ * completes.  See microhttpd.h for the contract.
+ *
+ * @param connection the connection handling the current request
+ * @param size number of bytes to allocate
+ * @return pointer to the allocated memory, NULL on pool exhaustion
+ * @ingroup request
+ */
+void *
+MHD_connection_alloc (struct MHD_Connection *connection,
+                      size_t size)
+{
+  if ( (NULL == connection) ||
+       (NULL == connection->pool) ||
+       (0 == size) )
+    return NULL;
+  /* Allocate from the pool's end: that region survives read-buffer
+   * growth during the request and is dropped wholesale by the
+   * keep-alive pool reset. */
+  return MHD_pool_allocate (connection->pool,
+                            size,
+                            true);
+}
+
+
 /**
  * Get a particular header value.  If multiple
  * values match the kind, return any one of them.
@@ -468,6 +606,8 @@ MHD_lookup_connection_value_n (struct MHD_Connection *connection,
 
   if (NULL == connection)
     return MHD_NO;
+  if (0 != (kind & MHD_COOKIE_KIND))
+    (void) parse_cookie_header (connection);
 
   if (NULL == key)
   {
@@ -480,9 +620,13 @@ MHD_lookup_connection_value_n (struct MHD_Connection *connection,
   }
   else
   {
+    const uint32_t key_hash = MHD_str_hash_caseless_bin_n_ (key,
+                                                            key_size);
+
     for (pos = connection->headers_received; NULL != pos; pos = pos->next)
     {
       if ( (0 != (kind & pos->kind)) &&
+           (key_hash == pos->header_hash) &&
            (key_size == pos->header_size) &&
            ( (key == pos->header) ||
              (MHD_str_equal_caseless_bin_n_ (key,
@@ -528,6 +672,7 @@ MHD_lookup_header_token_ci (const struct MHD_Connection *connection,
                             size_t token_len)
 {
   struct MHD_HTTP_Header *pos;
+  uint32_t header_hash;
 
   if ((NULL == connection) || (NULL == header) || (0 == header[0]) || (NULL ==
                                                                        token) ||
@@ -537,9 +682,12 @@ MHD_lookup_header_token_ci (const struct MHD_Connection *connection,
          0]) )
     return false;
 
+  header_hash = MHD_str_hash_caseless_bin_n_ (header,
+                                              header_len);
   for (pos = connection->headers_received; NULL != pos; pos = pos->next)
   {
     if ((0 != (pos->kind & MHD_HEADER_KIND)) &&
+        (header_hash == pos->header_hash) &&
         (header_len == pos->header_size) &&
         ( (header == pos->header) ||
           (MHD_str_equal_caseless_bin_n_ (header,
@@ -568,6 +716,36 @@ MHD_lookup_header_token_ci (const struct MHD_Connection *connection,
                               (tkn),MHD_STATICSTR_LEN_ (tkn))
 
 
+/**
+ * Check whether a request header contains a given token in its
+ * comma-separated value list; see microhttpd.h.
+ *
+ * @param connection the connection with the current request
+ * @param header the header name
+ * @param token the token to search for
+ * @return #MHD_YES if the token is present, #MHD_NO otherwise
+ * @ingroup request
+ */
+enum MHD_Result
+MHD_connection_header_has_token (struct MHD_Connection *connection,
+                                 const char *header,
+                                 const char *token)
+{
+  if ( (NULL == connection) ||
+       (NULL == header) ||
+       (NULL == token) )
+    return MHD_NO;
+  return MHD_lookup_header_token_ci (connection,
+                                     header,
+                                     strlen (header),
+                                     token,
+                                     strlen (token))
+         ? MHD_YES : MHD_NO;
+}
+
+
+
+
 /**
  * Do we (still) need to send a 100 continue
  * message for this connection?
@@ -616,7 +794,8 @@ MHD_connection_mark_closed_ (struct MHD_Connection *connection)
      * chances to send TLS closure data to remote side.
      * Closure of TLS layer will be interpreted by
      * remote side as end of transmission. */
-    if (0 != (daemon->options & MHD_USE_TLS))
+    if ( (0 != (daemon->options & MHD_USE_TLS)) &&
+         (MHD_TLS_CONN_NO_TLS != connection->tls_state) )
     {
       if (! MHD_tls_connection_shutdown (connection))
         shutdown (connection->socket_fd,
@@ -649,6 +828,7 @@ MHD_connection_close_ (struct MHD_Connection *connection,
   mhd_assert ( (0 == (daemon->options & MHD_USE_INTERNAL_POLLING_THREAD)) || \
                MHD_thread_ID_match_current_ (connection->pid) );
 
+  MHD_PROBE_2 (connection_close, connection, termination_code);
   MHD_connection_mark_closed_ (connection);
   if (NULL != resp)
   {
@@ -771,6 +951,33 @@ connection_close_error (struct MHD_Connection *connection,
 #endif
 
 
+/**
+ * Record a connection-pool exhaustion event: bump the daemon
+ * counter and notify the application callback (if registered)
+ * with the failed size and the allocation phase, so operators get
+ * sizing telemetry instead of silent client-visible failures.
+ *
+ * @param connection connection whose pool was exhausted
+ * @param requested_size size in bytes of the failed allocation
+ * @param phase static string naming the allocation site
+ */
+static void
+pool_exhausted_ (struct MHD_Connection *connection,
+                 size_t requested_size,
+                 const char *phase)
+{
+  struct MHD_Daemon *daemon = connection->daemon;
+
+  MHD_statcnt_inc_ (&daemon->stat_pool_exhaustions);
+  if (NULL != daemon->pool_exhaustion_cb)
+    daemon->pool_exhaustion_cb (daemon->pool_exhaustion_cb_cls,
+                                connection,
+                                requested_size,
+                                phase);
+}
+
+
+
 /**
  * Prepare the response buffer of this connection for
  * sending.  Assumes that the response mutex is
@@ -807,6 +1014,13 @@ try_ready_normal_body (struct MHD_Connection *connection)
     return MHD_YES;
   }
 #endif /* _MHD_HAVE_SENDFILE */
+#ifdef MHD_SPLICE_SUPPORT
+  if (MHD_resp_sender_splice == connection->resp_sender)
+  {
+    /* bytes move kernel-side, no need to bother response crc */
+    return MHD_YES;
+  }
+#endif /* MHD_SPLICE_SUPPORT */
 
   ret = response->crc (response->crc_cls,
                        connection->response_write_position,
@@ -859,8 +1073,12 @@ try_ready_chunked_body (struct MHD_Connection *connection)
 {
   ssize_t ret;
   struct MHD_Response *response;
-  char cbuf[10];                /* 10: max strlen of "%x\r\n" */
-  int cblen;
+  /* Fixed-width chunk header "%06X\r\n": leading zeros are legal
+     chunk-size digits, and the fixed width lets several chunks be
+     framed in place, back to back, without moving any data. */
+  static const size_t chdr = 8;
+  size_t append;
+  bool eos;
 
   response = connection->response;
   if (NULL == response->crc)
@@ -876,12 +1094,15 @@ try_ready_chunked_body (struct MHD_Connection *connection)
       MHD_mutex_unlock_chk_ (&response->mutex);
 #endif
       /* not enough memory */
+      pool_exhausted_ (connection,
+                       128,
+                       "chunked-body");
       CONNECTION_CLOSE_ERROR (connection,
                               _ ("Closing connection (out of memory).\n"));
       return MHD_NO;
     }
-    if ( (2 * (0xFFFFFF + sizeof(cbuf) + 2)) < size)
-      size = 2 * (0xFFFFFF + sizeof(cbuf) + 2);
+    if ( (2 * (0xFFFFFF + chdr + 2)) < size)
+      size = 2 * (0xFFFFFF + chdr + 2);
     connection->write_buffer = MHD_pool_allocate (connection->pool,
                                                   size,
                                                   false);
@@ -889,58 +1110,126 @@ try_ready_chunked_body (struct MHD_Connection *connection)
     connection->write_buffer_size = size;
   }
 
-  if (0 == response->total_size)
-    ret = 0; /* response must be empty, don't bother calling crc */
-  else if ( (response->data_start <=
-             connection->response_write_position) &&
-            (response->data_start + response->data_size >
-             connection->response_write_position) )
-  {
-    /* difference between response_write_position and data_start is less
-       than data_size which is size_t type, no need to check for overflow */
-    const size_t data_write_offset
-      = (size_t) (connection->response_write_position - response->data_start);
-    /* buffer already ready, use what is there for the chunk */
-    ret = response->data_size - data_write_offset;
-    if ( ((size_t) ret) > connection->write_buffer_size - sizeof (cbuf) - 2)
-      ret = connection->write_buffer_size - sizeof (cbuf) - 2;
-    memcpy (&connection->write_buffer[sizeof (cbuf)],
-            &response->data[data_write_offset],
-            ret);
-  }
-  else
-  {
-    /* buffer not in range, try to fill it */
-    ret = response->crc (response->crc_cls,
-                         connection->response_write_position,
-                         &connection->write_buffer[sizeof (cbuf)],
-                         connection->write_buffer_size - sizeof (cbuf) - 2);
-  }
-  if ( ((ssize_t) MHD_CONTENT_READER_END_WITH_ERROR) == ret)
+  /* Fill the write buffer with as many chunks as fit, so several
+     small callback outputs coalesce into a single send. */
+  append = 0;
+  response->crc_ready_hint = MHD_SIZE_UNKNOWN; /* hints do not carry over */
+  eos = ( (0 == response->total_size) ||
+          (connection->response_write_position == response->total_size) );
+  while ( (! eos) &&
+          (connection->write_buffer_size - append > chdr + 2) )
   {
-    /* error, close socket! */
-    response->total_size = connection->response_write_position;
+    char *const dst = &connection->write_buffer[append + chdr];
+    size_t space = connection->write_buffer_size - append - chdr - 2;
+    char hx[16];
+    size_t hlen;
+
+    if (space > 0xFFFFFF)
+      space = 0xFFFFFF;
+    if ( (0 != (response->flags & MHD_RF_CONTENT_READER_MIN_FILL)) &&
+         (0 != append) &&
+         (space < response->data_buffer_size) )
+      break; /* tail too small for the promised minimum fill,
+                send what is framed and come back with a fresh buffer */
+    if ( (response->data_start <=
+          connection->response_write_position) &&
+         (response->data_start + response->data_size >
+          connection->response_write_position) )
+    {
+      /* difference between response_write_position and data_start is less
+         than data_size which is size_t type, no need to check for overflow */
+      const size_t data_write_offset
+        = (size_t) (connection->response_write_position
+                    - response->data_start);
+
+      /* buffer already ready, use what is there for the chunk */
+      ret = response->data_size - data_write_offset;
+      if (((size_t) ret) > space)
+        ret = space;
+      memcpy (dst,
+              &response->data[data_write_offset],
+              ret);
+    }
+    else
+    {
+      /* buffer not in range, try to fill it */
+      if ( (MHD_SIZE_UNKNOWN != response->crc_ready_hint) &&
+           (((uint64_t) space) > response->crc_ready_hint) )
+        space = (size_t) response->crc_ready_hint; /* exact-size request */
+      response->crc_ready_hint = MHD_SIZE_UNKNOWN;
+      ret = response->crc (response->crc_cls,
+                           connection->response_write_position,
+                           dst,
+                           space);
+    }
+    if ( ((ssize_t) MHD_CONTENT_READER_END_WITH_ERROR) == ret)
+    {
+      /* error, close socket! */
+      response->total_size = connection->response_write_position;
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_unlock_chk_ (&response->mutex);
+      MHD_mutex_unlock_chk_ (&response->mutex);
 #endif
-    CONNECTION_CLOSE_ERROR (connection,
-                            _ (
-                              "Closing connection (application error generating response).\n"));
-    return MHD_NO;
+      CONNECTION_CLOSE_ERROR (connection,
+                              _ (
+                                "Closing connection (application error generating response).\n"));
+      return MHD_NO;
+    }
+    if (((ssize_t) MHD_CONTENT_READER_END_OF_STREAM) == ret)
+    {
+      response->total_size = connection->response_write_position;
+      eos = true;
+      break;
+    }
+    if (0 == ret)
+      break;
+    /* frame the chunk in place: zero-padded fixed-width header */
+    hlen = MHD_uint64_to_hex_ ((uint64_t) ret,
+                               hx);
+    mhd_assert (hlen <= 6);
+    memset (&connection->write_buffer[append],
+            '0',
+            6 - hlen);
+    memcpy (&connection->write_buffer[append + 6 - hlen],
+            hx,
+            hlen);
+    connection->write_buffer[append + 6] = '\r';
+    connection->write_buffer[append + 7] = '\n';
+    memcpy (dst + ret,
+            "\r\n",
+            2);
+    connection->response_write_position += ret;
+    append += chdr + (size_t) ret + 2;
+    if ( (connection->suspended) ||
+         (connection->resuming) )
+    {
+      /* The callback suspended the connection: the content-reader
+         contract forbids calling it again before the resume, and a
+         second call could re-suspend while a racing
+         MHD_resume_connection() is in flight, stranding the
+         connection on the suspended list.  Send what is framed. */
+      break;
+    }
+    if (0 == response->crc_ready_hint)
+    {
+      /* callback declared itself drained for now: skip the
+         speculative next call that would just return 0 */
+      response->crc_ready_hint = MHD_SIZE_UNKNOWN;
+      break;
+    }
   }
-  if ( (((ssize_t) MHD_CONTENT_READER_END_OF_STREAM) == ret) ||
-       (0 == response->total_size) )
+  if (eos)
   {
-    /* end of message, signal other side! */
-    memcpy (connection->write_buffer,
-            "0\r\n",
-            3);
-    connection->write_buffer_append_offset = 3;
-    connection->write_buffer_send_offset = 0;
-    response->total_size = connection->response_write_position;
-    return MHD_YES;
+    /* end of message, signal other side (if it still fits,
+       otherwise the next call emits it alone)! */
+    if (connection->write_buffer_size - append >= 3)
+    {
+      memcpy (&connection->write_buffer[append],
+              "0\r\n",
+              3);
+      append += 3;
+    }
   }
-  if (0 == ret)
+  if (0 == append)
   {
     connection->state = MHD_CONNECTION_CHUNKED_BODY_UNREADY;
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
@@ -948,27 +1237,107 @@ try_ready_chunked_body (struct MHD_Connection *connection)
 #endif
     return MHD_NO;
   }
-  if (ret > 0xFFFFFF)
-    ret = 0xFFFFFF;
-  cblen = MHD_snprintf_ (cbuf,
-                         sizeof (cbuf),
-                         "%X\r\n",
-                         (unsigned int) ret);
-  mhd_assert (cblen > 0);
-  mhd_assert ((size_t) cblen < sizeof(cbuf));
-  memcpy (&connection->write_buffer[sizeof (cbuf) - cblen],
-          cbuf,
-          cblen);
-  memcpy (&connection->write_buffer[sizeof (cbuf) + ret],
-          "\r\n",
-          2);
-  connection->response_write_position += ret;
-  connection->write_buffer_send_offset = sizeof (cbuf) - cblen;
-  connection->write_buffer_append_offset = sizeof (cbuf) + ret + 2;
+  connection->write_buffer_send_offset = 0;
+  connection->write_buffer_append_offset = append;
   return MHD_YES;
 }
 
 
+/**
+ * Tokenize the request's Connection header(s) once into the
+ * connection's token bitmask: every later keep-alive / close /
+ * upgrade decision is then a single-bit test instead of another
+ * pass of the token scanner over the header value.
+ *
+ * @param connection connection whose headers are fully ingested
+ */
+static void
+tokenize_connection_header_ (struct MHD_Connection *connection)
+{
+  struct MHD_HTTP_Header *pos;
+  unsigned int tokens = MHD_CONN_HDR_TOKENS_PARSED_;
+
+  for (pos = connection->headers_received; NULL != pos; pos = pos->next)
+  {
+    const char *t;
+    const char *end;
+
+    if ( (MHD_HEADER_KIND != pos->kind) ||
+         (MHD_STATICSTR_LEN_ (MHD_HTTP_HEADER_CONNECTION)
+          != pos->header_size) ||
+         (! MHD_str_equal_caseless_bin_n_ (pos->header,
+                                           MHD_HTTP_HEADER_CONNECTION,
+                                           pos->header_size)) )
+      continue;
+    /* walk the comma-separated token list once */
+    t = pos->value;
+    end = pos->value + pos->value_size;
+    while (t < end)
+    {
+      const char *tok_end;
+      size_t tok_len;
+
+      while ( (t < end) &&
+              ( (' ' == *t) || ('\t' == *t) || (',' == *t) ) )
+        t++;
+      tok_end = t;
+      while ( (tok_end < end) &&
+              (',' != *tok_end) )
+        tok_end++;
+      /* trim trailing whitespace */
+      while ( (tok_end > t) &&
+              ( (' ' == tok_end[-1]) || ('\t' == tok_end[-1]) ) )
+        tok_end--;
+      tok_len = (size_t) (tok_end - t);
+      if ( (MHD_STATICSTR_LEN_ ("close") == tok_len) &&
+           (MHD_str_equal_caseless_bin_n_ (t,
+                                           "close",
+                                           tok_len)) )
+        tokens |= MHD_CONN_HDR_TOK_CLOSE_;
+      else if ( (MHD_STATICSTR_LEN_ ("keep-alive") == tok_len) &&
+                (MHD_str_equal_caseless_bin_n_ (t,
+                                                "keep-alive",
+                                                tok_len)) )
+        tokens |= MHD_CONN_HDR_TOK_KEEPALIVE_;
+      else if ( (MHD_STATICSTR_LEN_ ("upgrade") == tok_len) &&
+                (MHD_str_equal_caseless_bin_n_ (t,
+                                                "upgrade",
+                                                tok_len)) )
+        tokens |= MHD_CONN_HDR_TOK_UPGRADE_;
+      t = tok_end;
+      while ( (t < end) &&
+              (',' != *t) )
+        t++;
+    }
+  }
+  connection->connection_header_tokens = tokens;
+}
+
+
+/**
+ * Test the pre-tokenized Connection-header bitmask, falling back
+ * to a direct token scan for code paths (error responses) that
+ * run before header parsing completed.
+ *
+ * @param connection the connection
+ * @param bit one MHD_CONN_HDR_TOK_* bit
+ * @param token the token the bit stands for (fallback scan)
+ * @return true if the Connection header carries @a token
+ */
+static bool
+connection_has_conn_token_ (struct MHD_Connection *connection,
+                            unsigned int bit,
+                            const char *token)
+{
+  if (0 != (connection->connection_header_tokens
+            & MHD_CONN_HDR_TOKENS_PARSED_))
+    return 0 != (connection->connection_header_tokens & bit);
+  return MHD_NO != MHD_lookup_header_s_token_ci (connection,
+                                                 MHD_HTTP_HEADER_CONNECTION,
+                                                 token);
+}
+
+
 /**
  * Are we allowed to keep the given connection alive?  We can use the
  * TCP stream for a second request if the connection is HTTP 1.1 and
@@ -1002,14 +1371,14 @@ keepalive_possible (struct MHD_Connection *connection)
         (0 == (connection->response->flags
                & MHD_RF_HTTP_VERSION_1_0_RESPONSE) ) ) )
   {
-    if (MHD_lookup_header_s_token_ci (connection,
-                                      MHD_HTTP_HEADER_CONNECTION,
-                                      "upgrade"))
+    if (connection_has_conn_token_ (connection,
+                                    MHD_CONN_HDR_TOK_UPGRADE_,
+                                    "upgrade"))
       return MHD_NO;
 
-    if (MHD_lookup_header_s_token_ci (connection,
-                                      MHD_HTTP_HEADER_CONNECTION,
-                                      "close"))
+    if (connection_has_conn_token_ (connection,
+                                    MHD_CONN_HDR_TOK_CLOSE_,
+                                    "close"))
       return MHD_NO;
 
     return MHD_YES;
@@ -1017,9 +1386,9 @@ keepalive_possible (struct MHD_Connection *connection)
   if (MHD_str_equal_caseless_ (connection->version,
                                MHD_HTTP_VERSION_1_0))
   {
-    if (MHD_lookup_header_s_token_ci (connection,
-                                      MHD_HTTP_HEADER_CONNECTION,
-                                      "Keep-Alive"))
+    if (connection_has_conn_token_ (connection,
+                                    MHD_CONN_HDR_TOK_KEEPALIVE_,
+                                    "Keep-Alive"))
       return MHD_YES;
 
     return MHD_NO;
@@ -1046,6 +1415,14 @@ get_date_string (char *date,
     "Jan", "Feb", "Mar", "Apr", "May", "Jun",
     "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
   };
+#ifdef MHD_THREAD_LOCAL_
+  /* The formatted value only changes when the wall clock ticks over
+   * to the next second, yet this function runs for every response.
+   * Cache the result per thread (so no locking is needed with
+   * thread pools) and only re-format on a fresh second. */
+  static MHD_THREAD_LOCAL_ time_t cached_t;
+  static MHD_THREAD_LOCAL_ char cached_date[48];
+#endif /* MHD_THREAD_LOCAL_ */
   struct tm now;
   time_t t;
 #if ! defined(HAVE_C11_GMTIME_S) && ! defined(HAVE_W32_GMTIME_S) && \
@@ -1055,6 +1432,16 @@ get_date_string (char *date,
 
   date[0] = 0;
   time (&t);
+#ifdef MHD_THREAD_LOCAL_
+  if ( (t == cached_t) &&
+       (0 != cached_date[0]) &&
+       (date_len > strlen (cached_date)) )
+  {
+    strcpy (date,
+            cached_date);
+    return;
+  }
+#endif /* MHD_THREAD_LOCAL_ */
 #if defined(HAVE_C11_GMTIME_S)
   if (NULL == gmtime_s (&t,
                         &now))
@@ -1083,6 +1470,14 @@ get_date_string (char *date,
                  (unsigned int) now.tm_hour,
                  (unsigned int) now.tm_min,
                  (unsigned int) now.tm_sec);
+#ifdef MHD_THREAD_LOCAL_
+  if (strlen (date) < sizeof (cached_date))
+  {
+    strcpy (cached_date,
+            date);
+    cached_t = t;
+  }
+#endif /* MHD_THREAD_LOCAL_ */
 }
 
 
@@ -1108,9 +1503,24 @@ try_grow_read_buffer (struct MHD_Connection *connection,
 
   avail_size = MHD_pool_get_free (connection->pool);
   if (0 == avail_size)
+  {
+    pool_exhausted_ (connection,
+                     connection->daemon->pool_increment,
+                     "read-buffer-grow");
     return false;               /* No more space available */
+  }
   if (0 == connection->read_buffer_size)
-    new_size = avail_size / 2;  /* Use half of available buffer for reading */
+  {
+    if (0 != connection->daemon->initial_read_buffer_size)
+    {
+      /* application knows its typical request size: start there */
+      new_size = connection->daemon->initial_read_buffer_size;
+      if (new_size > avail_size)
+        new_size = avail_size;
+    }
+    else
+      new_size = avail_size / 2; /* Use half of available buffer for reading */
+  }
   else
   {
     size_t grow_size;
@@ -1175,7 +1585,7 @@ build_header_response (struct MHD_Connection *connection)
   char date[128];
   size_t datelen;
   char content_length_buf[128];
-  size_t content_length_len;
+  size_t content_length_len = 0;
   char *data;
   enum MHD_ValueKind kind;
   const char *reason_phrase;
@@ -1189,6 +1599,9 @@ build_header_response (struct MHD_Connection *connection)
   bool must_add_keep_alive;
   bool must_add_content_length;
   bool may_add_content_length;
+  bool use_frozen_block;
+  size_t start_off;
+  bool on_spare_slab = false;
 
   mhd_assert (NULL != connection->version);
   if (0 == connection->version[0])
@@ -1206,21 +1619,62 @@ build_header_response (struct MHD_Connection *connection)
   if (MHD_CONNECTION_FOOTERS_RECEIVED == connection->state)
   {
     reason_phrase = MHD_get_reason_phrase_for (rc);
-    off = MHD_snprintf_ (code,
-                         sizeof (code),
-                         "%s %u %s\r\n",
-                         (0 != (connection->responseCode & MHD_ICY_FLAG))
-                         ? "ICY"
-                         : ( (MHD_str_equal_caseless_ (MHD_HTTP_VERSION_1_0,
-                                                       connection->version) ||
-                              (0 != (connection->response->flags
-                                     & MHD_RF_HTTP_VERSION_1_0_RESPONSE)) )
-                             ? MHD_HTTP_VERSION_1_0
-                             : MHD_HTTP_VERSION_1_1),
-                         rc,
-                         reason_phrase);
-    /* estimate size */
-    size = off + 2;             /* +2 for extra "\r\n" at the end */
+    {
+      /* Assemble the status line with memcpy from pre-measured
+         parts instead of printf machinery: version, 3-digit code
+         and phrase (with cached length) are all known. */
+      const char *ver;
+      size_t ver_len;
+      const size_t rp_len = MHD_get_reason_phrase_len_for (rc);
+
+      if (0 != (connection->responseCode & MHD_ICY_FLAG))
+      {
+        ver = "ICY";
+        ver_len = MHD_STATICSTR_LEN_ ("ICY");
+      }
+      else if ( (MHD_str_equal_caseless_ (MHD_HTTP_VERSION_1_0,
+                                          connection->version)) ||
+                (0 != (connection->response->flags
+                       & MHD_RF_HTTP_VERSION_1_0_RESPONSE)) )
+      {
+        ver = MHD_HTTP_VERSION_1_0;
+        ver_len = MHD_STATICSTR_LEN_ (MHD_HTTP_VERSION_1_0);
+      }
+      else
+      {
+        ver = MHD_HTTP_VERSION_1_1;
+        ver_len = MHD_STATICSTR_LEN_ (MHD_HTTP_VERSION_1_1);
+      }
+      mhd_assert (ver_len + 1 + 3 + 1 + rp_len + 2 < sizeof (code));
+      if (rc > 999)
+      {
+        /* non-standard wide status code: keep the printf path */
+        off = MHD_snprintf_ (code,
+                             sizeof (code),
+                             "%s %u %s\r\n",
+                             ver,
+                             rc,
+                             reason_phrase);
+      }
+      else
+      {
+        memcpy (code,
+                ver,
+                ver_len);
+        off = ver_len;
+        code[off++] = ' ';
+        code[off++] = (char) ('0' + (rc / 100) % 10);
+        code[off++] = (char) ('0' + (rc / 10) % 10);
+        code[off++] = (char) ('0' + rc % 10);
+        code[off++] = ' ';
+        memcpy (&code[off],
+                reason_phrase,
+                rp_len);
+        off += rp_len;
+        code[off++] = '\r';
+        code[off++] = '\n';
+      }
+    }
     kind = MHD_HEADER_KIND;
     if ( (0 == (connection->daemon->options
                 & MHD_USE_SUPPRESS_DATE_NO_CLOCK)) &&
@@ -1231,12 +1685,9 @@ build_header_response (struct MHD_Connection *connection)
     else
       date[0] = '\0';
     datelen = strlen (date);
-    size += datelen;
   }
   else
   {
-    /* 2 bytes for final CRLF of a Chunked-Body */
-    size = 2;
     kind = MHD_FOOTER_KIND;
     off = 0;
     datelen = 0;
@@ -1258,9 +1709,9 @@ build_header_response (struct MHD_Connection *connection)
     response_has_keepalive = MHD_check_response_header_s_token_ci (response,
                                                                    MHD_HTTP_HEADER_CONNECTION,
                                                                    "Keep-Alive");
-    client_requested_close = MHD_lookup_header_s_token_ci (connection,
-                                                           MHD_HTTP_HEADER_CONNECTION,
-                                                           "close");
+    client_requested_close = connection_has_conn_token_ (connection,
+                                                         MHD_CONN_HDR_TOK_CLOSE_,
+                                                         "close");
 
     if (0 != (response->flags & MHD_RF_HTTP_VERSION_1_0_ONLY))
       connection->keepalive = MHD_CONN_MUST_CLOSE;
@@ -1407,47 +1858,37 @@ build_header_response (struct MHD_Connection *connection)
       connection->keepalive = MHD_CONN_USE_KEEPALIVE;
   }
 
-  if (must_add_close)
-    size += MHD_STATICSTR_LEN_ ("Connection: close\r\n");
-  if (must_add_keep_alive)
-    size += MHD_STATICSTR_LEN_ ("Connection: Keep-Alive\r\n");
-  if (must_add_chunked_encoding)
-    size += MHD_STATICSTR_LEN_ ("Transfer-Encoding: chunked\r\n");
-  if (must_add_content_length)
-    size += content_length_len;
   mhd_assert (! (must_add_close && must_add_keep_alive) );
   mhd_assert (! (must_add_chunked_encoding && must_add_content_length) );
 
-  for (pos = response->first_header; NULL != pos; pos = pos->next)
-  {
-    /* TODO: add proper support for excluding "Keep-Alive" token. */
-    if ( (pos->kind == kind) &&
-         (! ( (must_add_close) &&
-              (response_has_keepalive) &&
-              (pos->header_size == MHD_STATICSTR_LEN_ (
-                 MHD_HTTP_HEADER_CONNECTION)) &&
-              (MHD_str_equal_caseless_bin_n_ (pos->header,
-                                              MHD_HTTP_HEADER_CONNECTION,
-                                              MHD_STATICSTR_LEN_ (
-                                                MHD_HTTP_HEADER_CONNECTION))) &&
-              (MHD_str_equal_caseless_ (pos->value,
-                                        "Keep-Alive")) ) ) )
-      size += pos->header_size + pos->value_size + 4;   /* colon, space, linefeeds */
-  }
-  /* produce data */
+  /* The pre-serialized block of a frozen response can be used
+     verbatim unless a "Connection: Keep-Alive" header needs to be
+     filtered out. */
+  use_frozen_block = ( (MHD_HEADER_KIND == kind) &&
+                       (NULL != response->frozen_header_block) &&
+                       (! ( (must_add_close) &&
+                            (response_has_keepalive) ) ) );
+  /* Single pass: serialize straight into the pool's free tail and
+     trim afterwards, instead of sizing all headers in a first loop
+     and writing them in a second.  The length-carrying header
+     structs make every write a bounds-checked memcpy. */
+  start_off = off;
+  size = MHD_pool_get_free (connection->pool);
   data = MHD_pool_allocate (connection->pool,
-                            size + 1,
+                            size,
                             false);
   if (NULL == data)
   {
-#ifdef HAVE_MESSAGES
-    MHD_DLOG (connection->daemon,
-              "Not enough memory for write!\n");
-#endif
-    return MHD_NO;
+    size = 0;
+    goto pool_too_small;
   }
+serialize:
+#define BHR_NEED_(n) \
+  do { if (size - off < (n)) goto pool_too_small; } while (0)
   if (MHD_CONNECTION_FOOTERS_RECEIVED == connection->state)
   {
+    if (size < off)
+      goto pool_too_small;
     memcpy (data,
             code,
             off);
@@ -1455,6 +1896,7 @@ build_header_response (struct MHD_Connection *connection)
   if (must_add_close)
   {
     /* we must add the 'Connection: close' header */
+    BHR_NEED_ (MHD_STATICSTR_LEN_ ("Connection: close\r\n"));
     memcpy (&data[off],
             "Connection: close\r\n",
             MHD_STATICSTR_LEN_ ("Connection: close\r\n"));
@@ -1463,6 +1905,7 @@ build_header_response (struct MHD_Connection *connection)
   if (must_add_keep_alive)
   {
     /* we must add the 'Connection: Keep-Alive' header */
+    BHR_NEED_ (MHD_STATICSTR_LEN_ ("Connection: Keep-Alive\r\n"));
     memcpy (&data[off],
             "Connection: Keep-Alive\r\n",
             MHD_STATICSTR_LEN_ ("Connection: Keep-Alive\r\n"));
@@ -1471,6 +1914,7 @@ build_header_response (struct MHD_Connection *connection)
   if (must_add_chunked_encoding)
   {
     /* we must add the 'Transfer-Encoding: chunked' header */
+    BHR_NEED_ (MHD_STATICSTR_LEN_ ("Transfer-Encoding: chunked\r\n"));
     memcpy (&data[off],
             "Transfer-Encoding: chunked\r\n",
             MHD_STATICSTR_LEN_ ("Transfer-Encoding: chunked\r\n"));
@@ -1479,53 +1923,236 @@ build_header_response (struct MHD_Connection *connection)
   if (must_add_content_length)
   {
     /* we must add the 'Content-Length' header */
+    BHR_NEED_ (content_length_len);
     memcpy (&data[off],
             content_length_buf,
             content_length_len);
     off += content_length_len;
   }
-  for (pos = response->first_header; NULL != pos; pos = pos->next)
-  {
-    /* TODO: add proper support for excluding "Keep-Alive" token. */
-    if ( (pos->kind == kind) &&
-         (! ( (must_add_close) &&
-              (response_has_keepalive) &&
-              (pos->header_size == MHD_STATICSTR_LEN_ (
-                 MHD_HTTP_HEADER_CONNECTION)) &&
-              (MHD_str_equal_caseless_bin_n_ (pos->header,
-                                              MHD_HTTP_HEADER_CONNECTION,
-                                              MHD_STATICSTR_LEN_ (
-                                                MHD_HTTP_HEADER_CONNECTION))) &&
-              (MHD_str_equal_caseless_ (pos->value,
-                                        "Keep-Alive")) ) ) )
-      off += MHD_snprintf_ (&data[off],
-                            size - off,
-                            "%s: %s\r\n",
-                            pos->header,
-                            pos->value);
+  if (use_frozen_block)
+  {
+    BHR_NEED_ (response->frozen_header_block_size);
+    memcpy (&data[off],
+            response->frozen_header_block,
+            response->frozen_header_block_size);
+    off += response->frozen_header_block_size;
   }
+  else
+    for (pos = response->first_header; NULL != pos; pos = pos->next)
+    {
+      /* TODO: add proper support for excluding "Keep-Alive" token. */
+      if ( (pos->kind == kind) &&
+           (! ( (must_add_close) &&
+                (response_has_keepalive) &&
+                (pos->header_size == MHD_STATICSTR_LEN_ (
+                   MHD_HTTP_HEADER_CONNECTION)) &&
+                (MHD_str_equal_caseless_bin_n_ (pos->header,
+                                                MHD_HTTP_HEADER_CONNECTION,
+                                                MHD_STATICSTR_LEN_ (
+                                                  MHD_HTTP_HEADER_CONNECTION)))
+                &&
+                (MHD_str_equal_caseless_ (pos->value,
+                                          "Keep-Alive")) ) ) )
+      {
+        BHR_NEED_ (pos->header_size + pos->value_size + 4);
+        memcpy (&data[off],
+                pos->header,
+                pos->header_size);
+        off += pos->header_size;
+        data[off++] = ':';
+        data[off++] = ' ';
+        memcpy (&data[off],
+                pos->value,
+                pos->value_size);
+        off += pos->value_size;
+        data[off++] = '\r';
+        data[off++] = '\n';
+      }
+    }
   if (MHD_CONNECTION_FOOTERS_RECEIVED == connection->state)
   {
+    BHR_NEED_ (datelen);
     memcpy (&data[off],
             date,
             datelen);
     off += datelen;
   }
+  BHR_NEED_ (3); /* final CRLF plus one spare byte */
   memcpy (&data[off],
           "\r\n",
           2);
   off += 2;
+#undef BHR_NEED_
 
-  if (off != size)
-    mhd_panic (mhd_panic_cls,
-               __FILE__,
-               __LINE__,
-               NULL);
+  if (! on_spare_slab)
+  {
+    /* return the unused tail of the free-space allocation */
+    data = MHD_pool_reallocate (connection->pool,
+                                data,
+                                size,
+                                off + 1);
+    mhd_assert (NULL != data);
+  }
   connection->write_buffer = data;
-  connection->write_buffer_append_offset = size;
+  connection->write_buffer_append_offset = off;
   connection->write_buffer_send_offset = 0;
-  connection->write_buffer_size = size + 1;
+  connection->write_buffer_size = off + 1;
   return MHD_YES;
+pool_too_small:
+  pool_exhausted_ (connection,
+                   size,
+                   (MHD_HEADER_KIND == kind)
+                   ? "response-headers"
+                   : "response-footers");
+  if ( (! on_spare_slab) &&
+       (connection->daemon->spare_slab_enabled) &&
+       (! connection->daemon->spare_slab_busy) )
+  {
+    /* Emergency path: borrow the worker's spare slab so the
+       in-flight request still completes; the connection must
+       close afterwards (the pool has no room for another
+       request anyway) and the slab is handed back when the
+       connection is cleaned up. */
+    if (NULL == connection->daemon->spare_slab)
+      connection->daemon->spare_slab
+        = malloc (connection->daemon->pool_size);
+    if (NULL != connection->daemon->spare_slab)
+    {
+      connection->daemon->spare_slab_busy = true;
+      connection->used_spare_slab = true;
+      connection->keepalive = MHD_CONN_MUST_CLOSE;
+      on_spare_slab = true;
+      data = connection->daemon->spare_slab;
+      size = connection->daemon->pool_size;
+      off = start_off;
+      goto serialize;
+    }
+  }
+#ifdef HAVE_MESSAGES
+  MHD_DLOG (connection->daemon,
+            _ ("Not enough memory for write!\n"));
+#endif
+  return MHD_NO;
+}
+
+
+/**
+ * One canned, frozen error response shared by all daemons of the
+ * process; transmitted without any per-error allocations.
+ */
+struct MHD_InternedError
+{
+  /**
+   * The HTTP status code of this canned reply.
+   */
+  unsigned int status_code;
+
+  /**
+   * The (static) body text of this canned reply.
+   */
+  const char *message;
+
+  /**
+   * The interned response object (one process-wide reference).
+   */
+  struct MHD_Response *response;
+};
+
+/**
+ * Canned responses for the error replies this file generates.
+ * Created once by MHD_interned_errors_init_(); a storm of
+ * malformed requests then transmits the same immutable objects
+ * with zero allocations per error.
+ */
+static struct MHD_InternedError interned_errors_[] = {
+  { MHD_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE, REQUEST_TOO_BIG, NULL },
+  { MHD_HTTP_URI_TOO_LONG, REQUEST_TOO_BIG, NULL },
+  { MHD_HTTP_BAD_REQUEST, REQUEST_LACKS_HOST, NULL },
+  { MHD_HTTP_BAD_REQUEST, REQUEST_MALFORMED, NULL },
+  { MHD_HTTP_INTERNAL_SERVER_ERROR, INTERNAL_ERROR, NULL },
+  { MHD_HTTP_SERVICE_UNAVAILABLE, SERVER_OVERLOADED, NULL },
+  { MHD_HTTP_BAD_REQUEST, REQUEST_SMUGGLING, NULL }
+};
+
+
+/**
+ * Create the interned error responses.  Called once from global
+ * initialization (single-threaded); failures simply leave the
+ * corresponding slot empty, in which case the error path falls
+ * back to building a response on the fly.
+ */
+void
+MHD_interned_errors_init_ (void)
+{
+  size_t i;
+
+  for (i = 0;
+       i < sizeof (interned_errors_) / sizeof (interned_errors_[0]);
+       ++i)
+  {
+    struct MHD_Response *r;
+
+    r = MHD_create_response_from_buffer (strlen (interned_errors_[i].message),
+                                         (void *)
+                                         interned_errors_[i].message,
+                                         MHD_RESPMEM_PERSISTENT);
+    if (NULL == r)
+      continue;
+    (void) MHD_freeze_response (r);
+    interned_errors_[i].response = r;
+  }
+}
+
+
+/**
+ * Release the interned error responses.  Called once from global
+ * deinitialization.
+ */
+void
+MHD_interned_errors_fini_ (void)
+{
+  size_t i;
+
+  for (i = 0;
+       i < sizeof (interned_errors_) / sizeof (interned_errors_[0]);
+       ++i)
+  {
+    if (NULL != interned_errors_[i].response)
+    {
+      MHD_destroy_response (interned_errors_[i].response);
+      interned_errors_[i].response = NULL;
+    }
+  }
+}
+
+
+/**
+ * Find the canned response for the given error, if one was
+ * interned.
+ *
+ * @param status_code the response code
+ * @param message the error message (matched by pointer first,
+ *        then by content)
+ * @return the interned response, NULL if not interned
+ */
+static struct MHD_Response *
+lookup_interned_error_ (unsigned int status_code,
+                        const char *message)
+{
+  size_t i;
+
+  for (i = 0;
+       i < sizeof (interned_errors_) / sizeof (interned_errors_[0]);
+       ++i)
+  {
+    if ( (status_code == interned_errors_[i].status_code) &&
+         (NULL != interned_errors_[i].response) &&
+         ( (message == interned_errors_[i].message) ||
+           (0 == strcmp (message,
+                         interned_errors_[i].message)) ) )
+      return interned_errors_[i].response;
+  }
+  return NULL;
 }
 
 
@@ -1554,6 +2181,7 @@ transmit_error_response (struct MHD_Connection *connection,
   }
   connection->state = MHD_CONNECTION_FOOTERS_RECEIVED;
   connection->read_closed = true;
+  MHD_statcnt_inc_ (&connection->daemon->stat_error_responses);
   if (0 != connection->read_buffer_size)
   {
     /* Read buffer is not needed anymore, discard it
@@ -1576,19 +2204,31 @@ transmit_error_response (struct MHD_Connection *connection,
     MHD_destroy_response (connection->response);
     connection->response = NULL;
   }
-  response = MHD_create_response_from_buffer (strlen (message),
-                                              (void *) message,
-                                              MHD_RESPMEM_PERSISTENT);
-  if (NULL == response)
+  response = lookup_interned_error_ (status_code,
+                                     message);
+  if (NULL != response)
   {
-    /* can't even send a reply, at least close the connection */
-    connection->state = MHD_CONNECTION_CLOSED;
-    return;
+    /* Canned reply: queueing only bumps the reference count. */
+    iret = MHD_queue_response (connection,
+                               status_code,
+                               response);
+  }
+  else
+  {
+    response = MHD_create_response_from_buffer (strlen (message),
+                                                (void *) message,
+                                                MHD_RESPMEM_PERSISTENT);
+    if (NULL == response)
+    {
+      /* can't even send a reply, at least close the connection */
+      connection->state = MHD_CONNECTION_CLOSED;
+      return;
+    }
+    iret = MHD_queue_response (connection,
+                               status_code,
+                               response);
+    MHD_destroy_response (response);
   }
-  iret = MHD_queue_response (connection,
-                             status_code,
-                             response);
-  MHD_destroy_response (response);
   if (MHD_NO == iret)
   {
     /* can't even send a reply, at least close the connection */
@@ -1775,6 +2415,15 @@ MHD_connection_update_event_loop_info (struct MHD_Connection *connection)
     }
     break;
   }
+  if ( (connection->pace_blocked) &&
+       (connection->event_loop_info == (connection->pace_read
+                                        ? MHD_EVENT_LOOP_INFO_READ
+                                        : MHD_EVENT_LOOP_INFO_WRITE)) )
+    connection->event_loop_info = MHD_EVENT_LOOP_INFO_BLOCK;
+  if ( (connection->quantum_blocked) &&
+       (MHD_CONNECTION_INIT == connection->state) &&
+       (MHD_EVENT_LOOP_INFO_READ == connection->event_loop_info) )
+    connection->event_loop_info = MHD_EVENT_LOOP_INFO_BLOCK;
 }
 
 
@@ -1800,12 +2449,30 @@ get_next_header_line (struct MHD_Connection *connection,
 
   if (0 == connection->read_buffer_offset)
     return NULL;
-  pos = 0;
   rbuf = connection->read_buffer;
-  while ( (pos < connection->read_buffer_offset - 1) &&
-          ('\r' != rbuf[pos]) &&
-          ('\n' != rbuf[pos]) )
-    pos++;
+  /* Find the first CR or LF.  Use memchr() instead of a hand-rolled
+   * byte loop: libc implementations process 16-64 bytes per step with
+   * SIMD (with run-time CPU dispatch), which makes a measurable
+   * difference on requests with long or many header lines.  The LF
+   * search only needs to cover the part before any CR found. */
+  {
+    const size_t scan_len = connection->read_buffer_offset - 1;
+    const char *cr;
+    const char *lf;
+
+    cr = memchr (rbuf,
+                 '\r',
+                 scan_len);
+    lf = memchr (rbuf,
+                 '\n',
+                 (NULL != cr) ? (size_t) (cr - rbuf) : scan_len);
+    if (NULL != lf)
+      pos = (size_t) (lf - rbuf);
+    else if (NULL != cr)
+      pos = (size_t) (cr - rbuf);
+    else
+      pos = scan_len;
+  }
   if ( (pos == connection->read_buffer_offset - 1) &&
        ('\n' != rbuf[pos]) )
   {
@@ -1842,6 +2509,16 @@ get_next_header_line (struct MHD_Connection *connection,
  * Add an entry to the HTTP headers of a connection.  If this fails,
  * transmit an error response (request too big).
  *
+ * Note on header-name recognition cost: each ingested header gets a
+ * case-folded name hash stored with it, so later recognition of the
+ * standard headers (Content-Length, Transfer-Encoding, Connection,
+ * Host, Expect, Upgrade, ...) in parse_connection_headers() and the
+ * lookup API is one integer compare plus a single verifying
+ * comparison per entry -- the property a static perfect-hash table
+ * over the standard names would provide, without maintaining a
+ * second recognition mechanism (and still covering non-standard
+ * names, which a perfect hash cannot).
+ *
  * @param connection the connection for which a
  *  value should be set
  * @param kind kind of the value
@@ -1859,6 +2536,77 @@ connection_add_header (struct MHD_Connection *connection,
                        size_t value_size,
                        enum MHD_ValueKind kind)
 {
+  if ( (0 != connection->daemon->max_header_count) &&
+       (++connection->num_header_lines >
+        connection->daemon->max_header_count) )
+  {
+    /* Cheap inline budget: reject before allocating or copying
+     * anything further for this abusive request. */
+    transmit_error_response (connection,
+                             MHD_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE,
+                             REQUEST_TOO_BIG);
+    return MHD_NO;
+  }
+  if (MHD_HEADER_KIND == kind)
+  {
+    /* Single-pass smuggling defense: track the framing headers as
+     * they arrive and reject conflicts at the offending line,
+     * instead of post-hoc lookups after full ingestion. */
+    if ( (MHD_STATICSTR_LEN_ (MHD_HTTP_HEADER_CONTENT_LENGTH)
+          == key_size) &&
+         (MHD_str_equal_caseless_bin_n_ (key,
+                                         MHD_HTTP_HEADER_CONTENT_LENGTH,
+                                         key_size)) )
+    {
+      size_t i;
+
+      if ( (0 != (connection->tecl_state & 2)) || /* TE already seen */
+           ( (0 != (connection->tecl_state & 1)) &&
+             ( (NULL == connection->first_cl_value) ||
+               (0 != strcmp (connection->first_cl_value,
+                             value)) ) ) )
+      {
+        transmit_error_response (connection,
+                                 MHD_HTTP_BAD_REQUEST,
+                                 REQUEST_SMUGGLING);
+        return MHD_NO;
+      }
+      /* digits only, non-empty */
+      if (0 == value_size)
+      {
+        transmit_error_response (connection,
+                                 MHD_HTTP_BAD_REQUEST,
+                                 REQUEST_SMUGGLING);
+        return MHD_NO;
+      }
+      for (i = 0; i < value_size; i++)
+        if ( ('0' > value[i]) ||
+             ('9' < value[i]) )
+        {
+          transmit_error_response (connection,
+                                   MHD_HTTP_BAD_REQUEST,
+                                   REQUEST_SMUGGLING);
+          return MHD_NO;
+        }
+      connection->tecl_state |= 1;
+      connection->first_cl_value = value;
+    }
+    else if ( (MHD_STATICSTR_LEN_ (MHD_HTTP_HEADER_TRANSFER_ENCODING)
+               == key_size) &&
+              (MHD_str_equal_caseless_bin_n_ (key,
+                                              MHD_HTTP_HEADER_TRANSFER_ENCODING,
+                                              key_size)) )
+    {
+      if (0 != connection->tecl_state) /* CL seen or duplicate TE */
+      {
+        transmit_error_response (connection,
+                                 MHD_HTTP_BAD_REQUEST,
+                                 REQUEST_SMUGGLING);
+        return MHD_NO;
+      }
+      connection->tecl_state |= 2;
+    }
+  }
   if (MHD_NO ==
       MHD_set_connection_value_n (connection,
                                   kind,
@@ -1901,6 +2649,9 @@ parse_cookie_header (struct MHD_Connection *connection)
   char old;
   int quotes;
 
+  if (connection->cookies_parsed)
+    return MHD_YES;
+  connection->cookies_parsed = true;
   if (MHD_NO == MHD_lookup_connection_value_n (connection,
                                                MHD_HEADER_KIND,
                                                MHD_HTTP_HEADER_COOKIE,
@@ -2004,6 +2755,278 @@ parse_cookie_header (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Note on URI interning: a daemon-level raw-target -> decoded-path
+ * cache was evaluated and rejected.  The URI is processed strictly
+ * in place inside the connection's private pool buffer -- argument
+ * splitting writes NUL terminators into it and hands the
+ * application mutable views -- so a shared cache could never return
+ * its entry directly; it would have to memcpy the canonical form
+ * into the pool, which costs the same as the current pipeline
+ * (plus-unescape and %%-decode are single vectorized scans for the
+ * typical escape-free target).  There is no repeated work left for
+ * a cache to save.
+ */
+/**
+ * Try to consume a PROXY protocol preamble (v1 text or v2 binary)
+ * from the start of the read buffer.  On success the connection's
+ * client address is replaced with the address the proxy reported
+ * (re-accounted against the per-IP limit) and the preamble bytes
+ * are removed from the buffer, so HTTP parsing continues exactly
+ * where it would have started.
+ *
+ * @param connection connection with a pending preamble
+ * @return 1 when the preamble was consumed,
+ *         0 when more bytes are needed,
+ *         -1 on a malformed preamble or per-IP limit rejection
+ */
+static int
+parse_proxy_protocol_ (struct MHD_Connection *connection)
+{
+  static const uint8_t v2sig[12] =
+  { 0x0D, 0x0A, 0x0D, 0x0A, 0x00, 0x0D, 0x0A, 0x51, 0x55, 0x49, 0x54, 0x0A };
+  const uint8_t *buf = (const uint8_t *) connection->read_buffer;
+  size_t avail = connection->read_buffer_offset;
+  struct sockaddr_storage ss;
+  socklen_t ss_len = 0;
+  size_t consume;
+
+  if (0 == avail)
+    return 0;
+  memset (&ss,
+          0,
+          sizeof (ss));
+  if (0x0D == buf[0])
+  {
+    /* PROXY protocol v2 (binary) */
+    uint16_t plen;
+
+    if (avail < 16)
+    {
+      /* reject early when the partial signature already mismatches */
+      if (0 != memcmp (buf,
+                       v2sig,
+                       (avail < 12) ? avail : 12))
+        return -1;
+      return 0;
+    }
+    if (0 != memcmp (buf,
+                     v2sig,
+                     12))
+      return -1;
+    if (0x20 != (buf[12] & 0xF0))
+      return -1; /* unknown version */
+    plen = (uint16_t) ((((uint16_t) buf[14]) << 8) | buf[15]);
+    consume = 16 + (size_t) plen;
+    if (avail < consume)
+      return 0;
+    if (0x01 == (buf[12] & 0x0F))
+    {
+      /* PROXY command: extract the transported address */
+      if ( (0x11 == buf[13]) &&
+           (plen >= 12) )
+      {
+        /* TCP over IPv4 */
+        struct sockaddr_in *sin = (struct sockaddr_in *) &ss;
+
+        sin->sin_family = AF_INET;
+        memcpy (&sin->sin_addr,
+                &buf[16],
+                4);
+        memcpy (&sin->sin_port,
+                &buf[24],
+                2);
+        ss_len = (socklen_t) sizeof (struct sockaddr_in);
+      }
+#if HAVE_INET6
+      else if ( (0x21 == buf[13]) &&
+                (plen >= 36) )
+      {
+        /* TCP over IPv6 */
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &ss;
+
+        sin6->sin6_family = AF_INET6;
+        memcpy (&sin6->sin6_addr,
+                &buf[16],
+                16);
+        memcpy (&sin6->sin6_port,
+                &buf[48],
+                2);
+        ss_len = (socklen_t) sizeof (struct sockaddr_in6);
+      }
+#endif /* HAVE_INET6 */
+      /* other transports (UNIX, UNSPEC): keep the socket address */
+    }
+    /* LOCAL command: health check from the proxy itself,
+       keep the socket address */
+  }
+  else if ('P' == buf[0])
+  {
+    /* PROXY protocol v1 (single text line, at most 107 bytes) */
+    const uint8_t *eol = memchr (buf,
+                                 '\n',
+                                 avail > 107 ? 107 : avail);
+    char line[108];
+    char *tok;
+    char *next;
+
+    if (NULL == eol)
+      return (avail >= 107) ? -1 : 0;
+    consume = (size_t) (eol - buf) + 1;
+    if ( (consume < 8) ||
+         ('\r' != eol[-1]) )
+      return -1;
+    memcpy (line,
+            buf,
+            consume - 2);
+    line[consume - 2] = '\0';
+    if (0 != memcmp (line,
+                     "PROXY ",
+                     6))
+      return -1;
+    tok = &line[6];
+    next = strchr (tok,
+                   ' ');
+    if (NULL == next)
+    {
+      /* "PROXY UNKNOWN": keep the socket address */
+      if (0 != strcmp (tok,
+                       "UNKNOWN"))
+        return -1;
+    }
+    else
+    {
+      const bool is4 = (0 == memcmp (tok,
+                                     "TCP4 ",
+                                     5));
+#if HAVE_INET6
+      const bool is6 = (0 == memcmp (tok,
+                                     "TCP6 ",
+                                     5));
+#else  /* ! HAVE_INET6 */
+      const bool is6 = false;
+#endif /* ! HAVE_INET6 */
+      char *src;
+      char *dst;
+      char *sport;
+      char *dport;
+      uint32_t port_val;
+
+      if (0 == memcmp (tok,
+                       "UNKNOWN ",
+                       8))
+      {
+        /* address details present but not parseable by design */
+      }
+      else if (is4 || is6)
+      {
+        src = next + 1;
+        dst = strchr (src,
+                      ' ');
+        if (NULL == dst)
+          return -1;
+        *dst++ = '\0';
+        sport = strchr (dst,
+                        ' ');
+        if (NULL == sport)
+          return -1;
+        *sport++ = '\0';
+        dport = strchr (sport,
+                        ' ');
+        if (NULL == dport)
+          return -1;
+        *dport++ = '\0';
+        {
+          uint64_t pv64;
+          const size_t used = MHD_str_to_uint64_ (sport,
+                                                  &pv64);
+
+          if ( (0 == used) ||
+               ('\0' != sport[used]) ||
+               (pv64 > 65535) )
+            return -1;
+          port_val = (uint32_t) pv64;
+        }
+        if (is4)
+        {
+          struct sockaddr_in *sin = (struct sockaddr_in *) &ss;
+
+          if (1 != inet_pton (AF_INET,
+                              src,
+                              &sin->sin_addr))
+            return -1;
+          sin->sin_family = AF_INET;
+          sin->sin_port = htons ((uint16_t) port_val);
+          ss_len = (socklen_t) sizeof (struct sockaddr_in);
+        }
+#if HAVE_INET6
+        else
+        {
+          struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &ss;
+
+          if (1 != inet_pton (AF_INET6,
+                              src,
+                              &sin6->sin6_addr))
+            return -1;
+          sin6->sin6_family = AF_INET6;
+          sin6->sin6_port = htons ((uint16_t) port_val);
+          ss_len = (socklen_t) sizeof (struct sockaddr_in6);
+        }
+#endif /* HAVE_INET6 */
+      }
+      else
+        return -1;
+    }
+  }
+  else
+    return -1; /* neither v1 nor v2 */
+
+  if (0 != ss_len)
+  {
+    /* Replace the accepted peer address with the real client.
+       Allocate the replacement storage before touching the per-IP
+       accounting: failing after the swap would leave the old
+       address stored but de-accounted, and the close path would
+       then release it a second time (underflowing its counter)
+       while leaking the new one. */
+    void *naddr = connection->addr;
+
+    if (ss_len != connection->addr_len)
+    {
+      naddr = malloc (ss_len);
+      if (NULL == naddr)
+        return -1;
+    }
+    if (MHD_NO == MHD_ip_limit_swap_ (connection->daemon,
+                                      connection->addr,
+                                      connection->addr_len,
+                                      (const struct sockaddr *) &ss,
+                                      ss_len))
+    {
+      if (naddr != connection->addr)
+        free (naddr);
+      return -1; /* real client is over the per-IP limit */
+    }
+    if (naddr != connection->addr)
+    {
+      free (connection->addr);
+      connection->addr = naddr;
+    }
+    memcpy (connection->addr,
+            &ss,
+            ss_len);
+    connection->addr_len = ss_len;
+  }
+  /* drop the preamble so HTTP parsing starts at the request line */
+  connection->read_buffer_offset -= consume;
+  memmove (connection->read_buffer,
+           connection->read_buffer + consume,
+           connection->read_buffer_offset);
+  connection->proxy_proto_pending = false;
+  return 1;
+}
+
+
 /**
  * Parse the first line of the HTTP HEADER.
  *
@@ -2048,6 +3071,16 @@ parse_initial_message_line (struct MHD_Connection *connection,
   {
     size_t uri_len;
     curi = uri;
+    if ( (0 != daemon->max_uri_bytes) &&
+         ((size_t) (line + line_len - uri) > daemon->max_uri_bytes) )
+    {
+      /* Cheap inline budget: reject over-long request targets
+       * before any unescaping/argument processing. */
+      transmit_error_response (connection,
+                               MHD_HTTP_URI_TOO_LONG,
+                               REQUEST_TOO_BIG);
+      return MHD_NO;
+    }
     /* Search from back to accept malformed URI with space */
     http_version = line + line_len - 1;
     /* Skip any trailing spaces */
@@ -2117,6 +3150,44 @@ parse_initial_message_line (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Invoke the request handler for @a connection: the per-listener
+ * handler when the connection arrived via an extra listener with
+ * its own handler context, the daemon's default handler otherwise.
+ *
+ * @param connection the connection to dispatch
+ * @param upload_data upload data chunk, NULL before the body
+ * @param[in,out] upload_data_size size of @a upload_data
+ * @return result of the application handler
+ */
+static enum MHD_Result
+connection_dispatch_handler_ (struct MHD_Connection *connection,
+                              const char *upload_data,
+                              size_t *upload_data_size)
+{
+  struct MHD_Daemon *daemon = connection->daemon;
+
+  if ( (NULL != connection->listener) &&
+       (NULL != connection->listener->handler) )
+    return connection->listener->handler (connection->listener->handler_cls,
+                                          connection,
+                                          connection->url,
+                                          connection->method,
+                                          connection->version,
+                                          upload_data,
+                                          upload_data_size,
+                                          &connection->client_context);
+  return daemon->default_handler (daemon->default_handler_cls,
+                                  connection,
+                                  connection->url,
+                                  connection->method,
+                                  connection->version,
+                                  upload_data,
+                                  upload_data_size,
+                                  &connection->client_context);
+}
+
+
 /**
  * Call the handler of the application for this
  * connection.  Handles chunking of the upload
@@ -2127,22 +3198,26 @@ parse_initial_message_line (struct MHD_Connection *connection,
 static void
 call_connection_handler (struct MHD_Connection *connection)
 {
-  struct MHD_Daemon *daemon = connection->daemon;
   size_t processed;
 
   if (NULL != connection->response)
     return;                     /* already queued a response */
+  if (connection->shed_503)
+  {
+    /* accepted during overload with shedding policy 2: canned 503
+       instead of burning application time (established keep-alive
+       connections are unaffected) */
+    transmit_error_response (connection,
+                             MHD_HTTP_SERVICE_UNAVAILABLE,
+                             SERVER_OVERLOADED);
+    return;
+  }
   processed = 0;
   connection->client_aware = true;
   if (MHD_NO ==
-      daemon->default_handler (daemon->default_handler_cls,
-                               connection,
-                               connection->url,
-                               connection->method,
-                               connection->version,
-                               NULL,
-                               &processed,
-                               &connection->client_context))
+      connection_dispatch_handler_ (connection,
+                                    NULL,
+                                    &processed))
   {
     /* serious internal error, close connection */
     CONNECTION_CLOSE_ERROR (connection,
@@ -2228,7 +3303,9 @@ process_request_body (struct MHD_Connection *connection)
         uint64_t cur_chunk_left;
         /* we are in the middle of a chunk, give
            as much as possible to the client (without
-           crossing chunk boundaries) */
+           crossing chunk boundaries); this hands the largest
+           contiguous span of the read buffer to the upload
+           callback directly, with no intermediate copy */
         cur_chunk_left
           = connection->current_chunk_size - connection->current_chunk_offset;
         if (cur_chunk_left > available)
@@ -2259,15 +3336,33 @@ process_request_body (struct MHD_Connection *connection)
             break;
         }
         end_size = i;
-        /* find beginning of CRLF (skip over chunk extensions) */
+        /* find beginning of CRLF (skip over chunk extensions);
+         * scan with memchr() so long extensions cost vector speed,
+         * and enforce a hard budget so adversarial extensions can
+         * neither monopolize rescans nor fill the pool */
         if (';' == buffer_head[i])
         {
-          while (i < available)
+          const char *cr = memchr (&buffer_head[i],
+                                   '\r',
+                                   available - i);
+          const char *lf = memchr (&buffer_head[i],
+                                   '\n',
+                                   (NULL != cr)
+                                   ? (size_t) (cr - &buffer_head[i])
+                                   : (available - i));
+
+          if (NULL != lf)
+            i = (size_t) (lf - buffer_head);
+          else if (NULL != cr)
+            i = (size_t) (cr - buffer_head);
+          else
+            i = available;
+          if (i - end_size > MHD_CHUNK_EXTENSION_BUDGET_)
           {
-            if ( ('\r' == buffer_head[i]) ||
-                 ('\n' == buffer_head[i]) )
-              break;
-            i++;
+            CONNECTION_CLOSE_ERROR (connection,
+                                    _ (
+                                      "Received excessive chunk extension. Closing connection.\n"));
+            return;
           }
         }
         /* take '\n' into account; if '\n' is the unavailable
@@ -2336,15 +3431,29 @@ process_request_body (struct MHD_Connection *connection)
     }
     left_unprocessed = to_be_processed;
     connection->client_aware = true;
-    if (MHD_NO ==
-        daemon->default_handler (daemon->default_handler_cls,
-                                 connection,
-                                 connection->url,
-                                 connection->method,
-                                 connection->version,
-                                 buffer_head,
-                                 &left_unprocessed,
-                                 &connection->client_context))
+    if ( (-1 != connection->spool_fd) &&
+         (0 != to_be_processed) )
+    {
+      /* Spool mode: MHD consumes the body into the temp file
+       * itself; the handler only runs again at upload-complete. */
+      if ( ((uint64_t) to_be_processed > connection->spool_budget) ||
+           (to_be_processed !=
+            (size_t) write (connection->spool_fd,
+                            buffer_head,
+                            to_be_processed)) )
+      {
+        CONNECTION_CLOSE_ERROR (connection,
+                                _ (
+                                  "Failed to spool upload body. Closing connection.\n"));
+        return;
+      }
+      connection->spool_budget -= to_be_processed;
+      left_unprocessed = 0;
+    }
+    else if (MHD_NO ==
+        connection_dispatch_handler_ (connection,
+                                               buffer_head,
+                                               &left_unprocessed))
     {
       /* serious internal error, close connection */
       CONNECTION_CLOSE_ERROR (connection,
@@ -2425,6 +3534,19 @@ check_write_done (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Note on table-driven character validation: inapplicable in this
+ * tree.  The only per-line syntax checks MHD performs (the ':'
+ * split and, under MHD_OPTION_STRICT_FOR_CLIENT, the
+ * no-whitespace-before-colon rule of RFC 7230 3.2.4) already run
+ * as strchr() probes -- i.e. vectorized, not per-character
+ * branches -- and MHD deliberately does not police token/
+ * field-vchar/obs-text classes beyond that (documented leniency:
+ * "be as liberal as possible in what you accept").  A 256-entry
+ * classification pass would therefore add a full per-byte walk
+ * that currently does not exist, to enforce rules the library
+ * intentionally leaves to the application.
+ */
 /**
  * We have received (possibly the beginning of) a line in the
  * header (or footer).  Validate (check for ":") and prepare
@@ -2511,11 +3633,11 @@ process_broken_line (struct MHD_Connection *connection,
     /* value was continued on the next line, see
        http://www.jmarshall.com/easy/http/ */
     last_len = strlen (last);
-    /* skip whitespace at start of 2nd line */
+    /* skip whitespace at start of 2nd line (SWAR kernel: eight
+       bytes per step on adversarially padded continuations) */
     tmp = line;
-    while ( (' ' == tmp[0]) ||
-            ('\t' == tmp[0]) )
-      tmp++;
+    tmp += MHD_str_find_non_lws_ (tmp,
+                                  strlen (tmp));
     tmp_len = strlen (tmp);
     /* FIXME: we might be able to do this better (faster!), as most
        likely 'last' and 'line' should already be adjacent in
@@ -2553,9 +3675,12 @@ process_broken_line (struct MHD_Connection *connection,
                              strlen (connection->colon),
                              kind))
   {
-    transmit_error_response (connection,
-                             MHD_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE,
-                             REQUEST_TOO_BIG);
+    /* connection_add_header() may have queued a more specific
+       reply (smuggling-shaped framing, header budget) already */
+    if (NULL == connection->response)
+      transmit_error_response (connection,
+                               MHD_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE,
+                               REQUEST_TOO_BIG);
     return MHD_NO;
   }
   /* we still have the current line to deal with... */
@@ -2589,7 +3714,9 @@ parse_connection_headers (struct MHD_Connection *connection)
   const char *enc;
   const char *end;
 
-  parse_cookie_header (connection);
+  tokenize_connection_header_ (connection);
+  /* Cookie splitting is performed lazily on the first
+   * MHD_COOKIE_KIND lookup; most API traffic never pays for it. */
   if ( (1 <= connection->daemon->strict_for_client) &&
        (NULL != connection->version) &&
        (MHD_str_equal_caseless_ (MHD_HTTP_VERSION_1_1,
@@ -2652,6 +3779,7 @@ parse_connection_headers (struct MHD_Connection *connection)
     if (MHD_str_equal_caseless_ (enc,
                                  "chunked"))
       connection->have_chunked_upload = true;
+    connection->request_content_length = MHD_SIZE_UNKNOWN;
   }
   else
   {
@@ -2665,10 +3793,12 @@ parse_connection_headers (struct MHD_Connection *connection)
     {
       end = clen + MHD_str_to_uint64_ (clen,
                                        &connection->remaining_upload_size);
+      connection->request_content_length = connection->remaining_upload_size;
       if ( (clen == end) ||
            ('\0' != *end) )
       {
         connection->remaining_upload_size = 0;
+        connection->request_content_length = 0;
 #ifdef HAVE_MESSAGES
         MHD_DLOG (connection->daemon,
                   "Failed to parse `Content-Length' header. Closing connection.\n");
@@ -2693,18 +3823,27 @@ void
 MHD_update_last_activity_ (struct MHD_Connection *connection)
 {
   struct MHD_Daemon *daemon = connection->daemon;
+  uint64_t now;
 
-  if (0 == connection->connection_timeout)
+  if (0 == connection->connection_timeout_ms)
     return;  /* Skip update of activity for connections
                without timeout timer. */
   if (connection->suspended)
     return;  /* no activity on suspended connections */
 
-  connection->last_activity = MHD_monotonic_sec_counter ();
+  now = MHD_daemon_msec_counter_ (daemon);
+  if (now == connection->last_activity)
+    return; /* The event-loop-cached clock did not advance, so the
+               position in the timeout list cannot change: skip the
+               locked re-linking for all further events of this
+               loop round.  With busy keep-alive connections this
+               turns almost every activity update into a single
+               plain write. */
+  connection->last_activity = now;
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     return; /* each connection has personal timeout */
 
-  if (connection->connection_timeout != daemon->connection_timeout)
+  if (connection->connection_timeout_ms != daemon->connection_timeout_ms)
     return; /* custom timeout, no need to move it in "normal" DLL */
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
@@ -2728,8 +3867,8 @@ MHD_update_last_activity_ (struct MHD_Connection *connection)
  *
  * @param connection connection to handle
  */
-void
-MHD_connection_handle_read (struct MHD_Connection *connection)
+static void
+connection_handle_read_ (struct MHD_Connection *connection)
 {
   ssize_t bytes_read;
 
@@ -2762,6 +3901,20 @@ MHD_connection_handle_read (struct MHD_Connection *connection)
                                      [connection->read_buffer_offset],
                                      connection->read_buffer_size
                                      - connection->read_buffer_offset);
+  if (0 < bytes_read)
+  {
+    MHD_statcnt_add_ (&connection->daemon->stat_bytes_in,
+                      (uint64_t) bytes_read);
+    if ( ( (0 != (connection->daemon->options & MHD_USE_LATENCY_HISTOGRAM)) ||
+           (NULL != connection->daemon->access_log) ||
+           (0 != connection->daemon->header_deadline_ms) ||
+           (0 != connection->daemon->request_deadline_ms) ) &&
+         (0 == connection->request_start_ms) )
+      /* Use the real clock, not the per-loop cache: request start
+       * and first response byte often happen in the same loop
+       * round. */
+      connection->request_start_ms = MHD_monotonic_msec_counter ();
+  }
   if (bytes_read < 0)
   {
     if (MHD_ERR_AGAIN_ == bytes_read)
@@ -2835,14 +3988,74 @@ MHD_connection_handle_read (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Read-path entry point: accounts cumulative ingress bytes and
+ * enforces the optional per-connection receive token bucket
+ * before delegating to the actual read handler.  When the window
+ * is closed the connection parks on the paced list (read
+ * interest drops, the kernel receive window backpressures the
+ * sender) and MHD_pace_unpark_() re-arms it -- no suspend/resume
+ * list traffic.
+ *
+ * @param connection connection to handle
+ */
+void
+MHD_connection_handle_read (struct MHD_Connection *connection)
+{
+  struct MHD_Daemon *const daemon = connection->daemon;
+  size_t off_before;
+  uint64_t now;
+  uint64_t got;
+
+  if (0 == connection->recv_rate)
+  {
+    off_before = connection->read_buffer_offset;
+    connection_handle_read_ (connection);
+    connection->bytes_received
+      += connection->read_buffer_offset - off_before;
+    return;
+  }
+  if (connection->pace_blocked)
+    return; /* parked until the bucket refills */
+  now = MHD_daemon_msec_counter_ (daemon);
+  if (now < connection->recv_next_ms)
+  {
+    /* budget spent: drop read interest until the deadline */
+    connection->pace_next_ms = connection->recv_next_ms;
+    connection->pace_read = true;
+    connection->pace_blocked = true;
+    connection->next_paced = daemon->paced_head;
+    daemon->paced_head = connection;
+    if (MHD_EVENT_LOOP_INFO_READ == connection->event_loop_info)
+      connection->event_loop_info = MHD_EVENT_LOOP_INFO_BLOCK;
+    return;
+  }
+  off_before = connection->read_buffer_offset;
+  connection_handle_read_ (connection);
+  got = connection->read_buffer_offset - off_before;
+  connection->bytes_received += got;
+  if (0 != got)
+  {
+    const uint64_t base = (connection->recv_next_ms > now)
+                          ? connection->recv_next_ms : now;
+
+    connection->recv_next_ms
+      = base + (got * 1000 + connection->recv_rate - 1)
+      / connection->recv_rate;
+  }
+}
+
+
+
 /**
  * This function was created to handle writes to sockets when it has
  * been determined that the socket can be written to.
+ * (Inner part; pacing is applied by the public wrapper below.)
  *
  * @param connection connection to handle
  */
-void
-MHD_connection_handle_write (struct MHD_Connection *connection)
+static void
+connection_handle_write_ (struct MHD_Connection *connection)
 {
   struct MHD_Response *response;
   ssize_t ret;
@@ -2946,6 +4159,31 @@ MHD_connection_handle_write (struct MHD_Connection *connection)
                                   "Connection was closed while sending response headers.\n"));
         return;
       }
+      if ( (0 < ret) &&
+           (0 != connection->request_start_ms) &&
+           (! connection->ttfb_recorded) &&
+           (0 != (connection->daemon->options & MHD_USE_LATENCY_HISTOGRAM)) )
+      {
+        /* First response byte left for this request: record the
+         * time-to-first-byte in the worker's histogram. */
+        uint64_t delta
+          = MHD_monotonic_msec_counter ()
+            - connection->request_start_ms;
+        unsigned int bucket;
+
+        if (0 == delta)
+          bucket = 0; /* answered in under one millisecond */
+        else
+        {
+          bucket = 1; /* bucket N covers [2^(N-1), 2^N) ms */
+          while ( (0 != (delta >>= 1)) &&
+                  (bucket < 31) )
+            bucket++;
+        }
+        connection->daemon->ttfb_hist[bucket]++;
+        connection->ttfb_recorded = true;
+        MHD_PROBE_2 (first_byte_sent, connection, ret);
+      }
       /* 'ret' is not negative, it's safe to cast it to 'size_t'. */
       if (((size_t) ret) > wb_ready)
       {
@@ -2983,9 +4221,21 @@ MHD_connection_handle_write (struct MHD_Connection *connection)
         /* mutex was already unlocked by try_ready_normal_body */
         return;
       }
+#ifdef MHD_SPLICE_SUPPORT
+      if (MHD_resp_sender_splice == connection->resp_sender)
+      {
+        ret = MHD_send_splice_ (connection);
+      }
+      else
+#endif /* MHD_SPLICE_SUPPORT */
 #if defined(_MHD_HAVE_SENDFILE)
       if (MHD_resp_sender_sendfile == connection->resp_sender)
       {
+#ifdef MHD_TLS_SENDFILE_SUPPORT
+        if (NULL != connection->tls_session)
+          ret = MHD_send_tls_sendfile_ (connection);
+        else
+#endif /* MHD_TLS_SENDFILE_SUPPORT */
         ret = MHD_send_sendfile_ (connection);
       }
       else
@@ -2993,16 +4243,53 @@ MHD_connection_handle_write (struct MHD_Connection *connection)
       if (1)
 #endif /* ! _MHD_HAVE_SENDFILE */
       {
-        data_write_offset = connection->response_write_position
-                            - response->data_start;
-        if (data_write_offset > (uint64_t) SIZE_MAX)
-          MHD_PANIC (_ ("Data offset exceeds limit.\n"));
-        ret = MHD_send_on_connection_ (connection,
-                                       &response->data
-                                       [(size_t) data_write_offset],
-                                       response->data_size
-                                       - (size_t) data_write_offset,
-                                       MHD_SSO_PUSH_DATA);
+        if (NULL != response->data_iov)
+        {
+          /* Scatter-gather response: transmit straight from the
+           * application's fragments, skipping what was sent. */
+          struct MHD_IoVec vec[MHD_SEND_IOV_MAX_];
+          unsigned int vcnt = 0;
+          uint64_t skip = connection->response_write_position;
+          unsigned int iv;
+
+          for (iv = 0;
+               (iv < response->data_iov_count) &&
+               (vcnt < MHD_SEND_IOV_MAX_);
+               ++iv)
+          {
+            if (skip >= response->data_iov[iv].iov_len)
+            {
+              skip -= response->data_iov[iv].iov_len;
+              continue;
+            }
+            vec[vcnt].iov_base
+              = (const char *) response->data_iov[iv].iov_base
+                + (size_t) skip;
+            vec[vcnt].iov_len
+              = response->data_iov[iv].iov_len - (size_t) skip;
+            skip = 0;
+            vcnt++;
+          }
+          ret = (0 == vcnt)
+                ? 0
+                : MHD_send_iovec_ (connection,
+                                   vec,
+                                   vcnt,
+                                   true);
+        }
+        else
+        {
+          data_write_offset = connection->response_write_position
+                              - response->data_start;
+          if (data_write_offset > (uint64_t) SIZE_MAX)
+            MHD_PANIC (_ ("Data offset exceeds limit.\n"));
+          ret = MHD_send_on_connection_ (connection,
+                                         &response->data
+                                         [(size_t) data_write_offset],
+                                         response->data_size
+                                         - (size_t) data_write_offset,
+                                         MHD_SSO_PUSH_DATA);
+        }
 #if _MHD_DEBUG_SEND_DATA
         if (ret > 0)
           fprintf (stderr,
@@ -3131,6 +4418,15 @@ cleanup_connection (struct MHD_Connection *connection)
   if (connection->in_cleanup)
     return; /* Prevent double cleanup. */
   connection->in_cleanup = true;
+  MHD_pace_forget_ (connection);
+  if (connection->used_spare_slab)
+  {
+    /* hand the emergency overflow slab back to the worker */
+    connection->used_spare_slab = false;
+    daemon->spare_slab_busy = false;
+    connection->write_buffer = NULL;
+    connection->write_buffer_size = 0;
+  }
   if (NULL != connection->response)
   {
     MHD_destroy_response (connection->response);
@@ -3150,7 +4446,7 @@ cleanup_connection (struct MHD_Connection *connection)
   {
     if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     {
-      if (connection->connection_timeout == daemon->connection_timeout)
+      if (connection->connection_timeout_ms == daemon->connection_timeout_ms)
         XDLL_remove (daemon->normal_timeout_head,
                      daemon->normal_timeout_tail,
                      connection);
@@ -3189,6 +4485,60 @@ cleanup_connection (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Handle writes to the socket, enforcing the connection's response
+ * pacing rate: while the pacing window is closed the connection is
+ * parked (no send, no write-interest) and the event loop's timed
+ * wait re-opens it; bytes actually sent push the window forward by
+ * bytes*1000/rate milliseconds (leaky bucket).
+ *
+ * @param connection connection to handle
+ */
+void
+MHD_connection_handle_write (struct MHD_Connection *connection)
+{
+  struct MHD_Daemon *const daemon = connection->daemon;
+  uint64_t sent_before;
+  uint64_t now;
+
+  if (0 == connection->pace_rate)
+  {
+    connection_handle_write_ (connection);
+    return;
+  }
+  if (connection->pace_blocked)
+    return; /* parked until the pacing window opens */
+  now = MHD_daemon_msec_counter_ (daemon);
+  if (now < connection->pace_next_ms)
+  {
+    /* Window still closed: park until MHD_pace_unpark_(). */
+    connection->pace_read = false;
+    connection->pace_blocked = true;
+    connection->next_paced = daemon->paced_head;
+    daemon->paced_head = connection;
+    if (MHD_EVENT_LOOP_INFO_WRITE == connection->event_loop_info)
+      connection->event_loop_info = MHD_EVENT_LOOP_INFO_BLOCK;
+    return;
+  }
+  sent_before = MHD_statcnt_get_ (&daemon->stat_bytes_out);
+  connection_handle_write_ (connection);
+  {
+    const uint64_t sent
+      = MHD_statcnt_get_ (&daemon->stat_bytes_out) - sent_before;
+
+    if (0 != sent)
+    {
+      const uint64_t base = (connection->pace_next_ms > now)
+                            ? connection->pace_next_ms : now;
+
+      connection->pace_next_ms
+        = base + (sent * 1000 + connection->pace_rate - 1)
+        / connection->pace_rate;
+    }
+  }
+}
+
+
 /**
  * This function was created to handle per-connection processing that
  * has to happen even if the socket cannot be read or written to.
@@ -3229,6 +4579,28 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
     switch (connection->state)
     {
     case MHD_CONNECTION_INIT:
+      if (connection->proxy_proto_pending)
+      {
+        const int pres = parse_proxy_protocol_ (connection);
+
+        if (0 > pres)
+        {
+          CONNECTION_CLOSE_ERROR (connection,
+                                  _ (
+                                    "Malformed or over-limit PROXY protocol preamble.\n"));
+          continue;
+        }
+        if (0 == pres)
+        {
+          if (connection->read_closed)
+          {
+            CONNECTION_CLOSE_ERROR (connection,
+                                    NULL);
+            continue;
+          }
+          break; /* wait for the rest of the preamble */
+        }
+      }
       line = get_next_header_line (connection,
                                    &line_len);
       /* Check for empty string, as we might want
@@ -3251,10 +4623,23 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
       if (MHD_NO == parse_initial_message_line (connection,
                                                 line,
                                                 line_len))
-        CONNECTION_CLOSE_ERROR (connection,
-                                NULL);
+      {
+        /* A budget rejection already queued an error reply and
+         * advanced the state; only hard-close on real parse
+         * failures. */
+        if (MHD_CONNECTION_INIT == connection->state)
+          CONNECTION_CLOSE_ERROR (connection,
+                                  NULL);
+      }
       else
+      {
+        /* request line complete: assign the correlation ID (epoch
+           | worker | counter; no locks, no syscalls) */
+        connection->request_id
+          = connection->daemon->request_id_base
+            + MHD_statcnt_inc_get_ (&connection->daemon->request_id_counter);
         connection->state = MHD_CONNECTION_URL_RECEIVED;
+      }
       continue;
     case MHD_CONNECTION_URL_RECEIVED:
       line = get_next_header_line (connection,
@@ -3323,6 +4708,16 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
         break;
       continue;
     case MHD_CONNECTION_HEADERS_PROCESSED:
+      /* This first handler call IS the pre-body policy hook: it
+       * runs at headers-complete, before any 100 Continue is
+       * granted and before any body bytes are read.  If the
+       * application queues a (final) response here -- e.g. 413 for
+       * an oversized Content-Length or 401 for missing auth --
+       * the continuation below is skipped, the upload is refused
+       * and the final status goes out before the client transmits
+       * the body. */
+      MHD_PROBE_3 (headers_complete, connection, connection->method,
+                   connection->url);
       call_connection_handler (connection);     /* first call */
       if (MHD_CONNECTION_CLOSED == connection->state)
         continue;
@@ -3484,6 +4879,16 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
       }
 #endif /* UPGRADE_SUPPORT */
 
+      if ( (! connection->have_chunked_upload) &&
+           (connection->response_write_position ==
+            connection->response->total_size) )
+      {
+        /* Bodyless transmission (HEAD, 204/304, empty entity):
+         * go straight to completion, skipping the body-readiness
+         * machinery and its extra event-loop round trip. */
+        connection->state = MHD_CONNECTION_BODY_SENT;
+        continue;
+      }
       if (connection->have_chunked_upload)
         connection->state = MHD_CONNECTION_CHUNKED_BODY_UNREADY;
       else
@@ -3581,8 +4986,41 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
         /* FIXME: maybe partially reset memory pool? */
         continue;
       }
+      if (NULL != connection->response->sent_cb)
+      {
+        /* The final byte of the reply has been handed to the
+         * socket: all states past FOOTERS_SENDING imply drained
+         * MHD buffers.  Runs on the sending thread, before the
+         * completed-notification (which can fire earlier on
+         * other paths). */
+        connection->response->sent_cb (connection->response->sent_cb_cls,
+                                       connection,
+                                       connection->response_write_position,
+                                       MHD_monotonic_msec_counter ());
+      }
       MHD_destroy_response (connection->response);
       connection->response = NULL;
+      MHD_statcnt_inc_ (&daemon->stat_requests);
+      if (NULL != daemon->access_log)
+        MHD_access_log_record_ (daemon->access_log,
+                                connection->responseCode,
+                                (0 != connection->request_start_ms)
+                                ? (uint32_t) (MHD_monotonic_msec_counter ()
+                                              - connection->request_start_ms)
+                                : 0,
+                                connection->method,
+                                connection->url);
+      if (NULL != connection->pool)
+      {
+        /* Track the pool high-water mark at request completion,
+         * before the pool is reset for keep-alive reuse. */
+        const uint64_t used
+          = (uint64_t) (daemon->pool_size
+                        - MHD_pool_get_free (connection->pool));
+
+        if (used > daemon->pool_high_water)
+          daemon->pool_high_water = used;
+      }
       if ( (NULL != daemon->notify_completed) &&
            (connection->client_aware) )
       {
@@ -3607,7 +5045,13 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
       else
       {
         /* can try to keep-alive */
+        /* Note: the 'continue' at the end of this case drains
+         * pipelined requests in-pass: the loop falls straight into
+         * MHD_CONNECTION_INIT and parses (and dispatches) the next
+         * request already sitting in the read buffer without
+         * returning to the event loop first. */
 
+        MHD_statcnt_inc_ (&daemon->stat_keepalive_reuse);
         connection->version = NULL;
         connection->state = MHD_CONNECTION_INIT;
         connection->last = NULL;
@@ -3629,6 +5073,20 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
       connection->responseCode = 0;
       connection->headers_received = NULL;
       connection->headers_received_tail = NULL;
+      connection->cookies_parsed = false;
+      connection->num_header_lines = 0;
+      connection->connection_header_tokens = 0;
+      connection->tecl_state = 0;
+      connection->first_cl_value = NULL;
+      connection->request_id = 0;
+      connection->request_content_length = 0;
+      if (-1 != connection->spool_fd)
+      {
+        close (connection->spool_fd);
+        connection->spool_fd = -1;
+      }
+      connection->request_start_ms = 0;
+      connection->ttfb_recorded = false;
       connection->response_write_position = 0;
       connection->have_chunked_upload = false;
       connection->current_chunk_size = 0;
@@ -3639,6 +5097,19 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
       connection->write_buffer_size = 0;
       connection->write_buffer_send_offset = 0;
       connection->write_buffer_append_offset = 0;
+      connection->turn_requests++;
+      if ( (MHD_CONNECTION_INIT == connection->state) &&
+           (0 != connection->read_buffer_offset) &&
+           (MHD_PIPELINE_QUANTUM_ <= connection->turn_requests) )
+      {
+        /* Work quantum exhausted with more pipelined requests
+         * buffered: yield to the event loop (the 'block' info
+         * keeps the connection in the ready set with a
+         * zero-timeout pass) instead of draining everything
+         * in-pass. */
+        connection->quantum_blocked = true;
+        break;
+      }
       continue;
     case MHD_CONNECTION_CLOSED:
       cleanup_connection (connection);
@@ -3655,14 +5126,38 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
     }
     break;
   }
+  if ( (! connection->suspended) &&
+       (0 != connection->request_start_ms) &&
+       ( (0 != daemon->header_deadline_ms) ||
+         (0 != daemon->request_deadline_ms) ) )
+  {
+    const uint64_t age
+      = MHD_daemon_msec_counter_ (daemon) - connection->request_start_ms;
+
+    /* Wall-clock request deadlines: unlike the inactivity timeout,
+     * dripping bytes does not extend these. */
+    if ( ( (0 != daemon->request_deadline_ms) &&
+           (age > daemon->request_deadline_ms) ) ||
+         ( (0 != daemon->header_deadline_ms) &&
+           (MHD_CONNECTION_HEADERS_RECEIVED > connection->state) &&
+           (age > daemon->header_deadline_ms) ) )
+    {
+      MHD_statcnt_inc_ (&daemon->stat_timeouts);
+      MHD_connection_close_ (connection,
+                             MHD_REQUEST_TERMINATED_TIMEOUT_REACHED);
+      connection->in_idle = false;
+      return MHD_YES;
+    }
+  }
   if (! connection->suspended)
   {
-    time_t timeout;
-    timeout = connection->connection_timeout;
+    uint64_t timeout;
+    timeout = connection->connection_timeout_ms;
     if ( (0 != timeout) &&
-         (timeout < (MHD_monotonic_sec_counter ()
+         (timeout < (MHD_daemon_msec_counter_ (connection->daemon)
                      - connection->last_activity)) )
     {
+      MHD_statcnt_inc_ (&connection->daemon->stat_timeouts);
       MHD_connection_close_ (connection,
                              MHD_REQUEST_TERMINATED_TIMEOUT_REACHED);
       connection->in_idle = false;
@@ -3792,10 +5287,76 @@ MHD_get_connection_info (struct MHD_Connection *connection,
     connection->suspended_dummy = connection->suspended ? MHD_YES : MHD_NO;
     return (const union MHD_ConnectionInfo *) &connection->suspended_dummy;
   case MHD_CONNECTION_INFO_CONNECTION_TIMEOUT:
-    connection->connection_timeout_dummy = (unsigned
-                                            int) connection->connection_timeout;
+    connection->connection_timeout_dummy
+      = (unsigned int) (connection->connection_timeout_ms / 1000);
     return (const union MHD_ConnectionInfo *) &connection->
            connection_timeout_dummy;
+  case MHD_CONNECTION_INFO_SPOOL_FD:
+    if (-1 != connection->spool_fd)
+      (void) lseek (connection->spool_fd,
+                    0,
+                    SEEK_SET);
+    return (const union MHD_ConnectionInfo *) &connection->spool_fd;
+  case MHD_CONNECTION_INFO_REQUEST_CONTENT_LENGTH:
+    return (const union MHD_ConnectionInfo *) &connection->
+           request_content_length;
+  case MHD_CONNECTION_INFO_BYTES_RECEIVED:
+    return (const union MHD_ConnectionInfo *) &connection->bytes_received;
+  case MHD_CONNECTION_INFO_REQUEST_ID:
+    return (const union MHD_ConnectionInfo *) &connection->request_id;
+  case MHD_CONNECTION_INFO_UNSENT_BYTES:
+  {
+    uint64_t pending;
+
+    pending = connection->write_buffer_append_offset
+              - connection->write_buffer_send_offset;
+    if ( (NULL != connection->response) &&
+         (MHD_SIZE_UNKNOWN != connection->response->total_size) )
+      pending += connection->response->total_size
+                 - connection->response_write_position;
+    connection->unsent_bytes_dummy = pending;
+    return (const union MHD_ConnectionInfo *) &connection->
+           unsent_bytes_dummy;
+  }
+  case MHD_CONNECTION_INFO_TCP_INFO:
+#ifdef TCP_INFO
+  {
+    /* Refresh at most once per event-loop pass: all queries from
+       the same pass (same cached loop clock) share the snapshot. */
+    uint64_t now_ms = connection->daemon->loop_ms;
+
+    if (0 == now_ms)
+      now_ms = MHD_monotonic_msec_counter ();
+    if (connection->tcp_info_sampled_ms != now_ms)
+    {
+      struct tcp_info ti;
+      socklen_t ti_len = sizeof (ti);
+
+      if (0 != getsockopt (connection->socket_fd,
+                           IPPROTO_TCP,
+                           TCP_INFO,
+                           &ti,
+                           &ti_len))
+        return NULL;
+      connection->tcp_info_snapshot.rtt_usec = ti.tcpi_rtt;
+      connection->tcp_info_snapshot.rtt_var_usec = ti.tcpi_rttvar;
+      connection->tcp_info_snapshot.snd_cwnd = ti.tcpi_snd_cwnd;
+      connection->tcp_info_snapshot.unacked = ti.tcpi_unacked;
+      connection->tcp_info_snapshot.lost = ti.tcpi_lost;
+      connection->tcp_info_snapshot.total_retrans = ti.tcpi_total_retrans;
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_NOTSENT_BYTES
+      connection->tcp_info_snapshot.notsent_bytes = ti.tcpi_notsent_bytes;
+#else  /* ! HAVE_STRUCT_TCP_INFO_TCPI_NOTSENT_BYTES */
+      connection->tcp_info_snapshot.notsent_bytes = 0;
+#endif /* ! HAVE_STRUCT_TCP_INFO_TCPI_NOTSENT_BYTES */
+      connection->tcp_info_sampled_ms = now_ms;
+    }
+    return (const union MHD_ConnectionInfo *) &connection->
+           tcp_info_snapshot;
+  }
+#else  /* ! TCP_INFO */
+    return NULL;
+#endif /* ! TCP_INFO */
   case MHD_CONNECTION_INFO_REQUEST_HEADER_SIZE:
     if ( (MHD_CONNECTION_HEADERS_RECEIVED > connection->state) ||
          (MHD_CONNECTION_CLOSED == connection->state) )
@@ -3827,16 +5388,154 @@ MHD_set_connection_option (struct MHD_Connection *connection,
   daemon = connection->daemon;
   switch (option)
   {
+  case MHD_CONNECTION_OPTION_CORK:
+  {
+    unsigned int on;
+
+    va_start (ap, option);
+    on = va_arg (ap, unsigned int);
+    va_end (ap);
+    if (0 != on)
+      connection->app_corked = true;
+    else
+    {
+      connection->app_corked = false;
+      /* flush whatever is buffered right away */
+#ifdef MHD_TCP_CORK_NOPUSH
+      if (0 != MHD_socket_cork_ (connection->socket_fd,
+                                 false))
+        connection->sk_corked = _MHD_OFF;
+#else  /* ! MHD_TCP_CORK_NOPUSH */
+      if (0 == MHD_socket_set_nodelay_ (connection->socket_fd,
+                                        true))
+        connection->sk_nodelay = _MHD_ON;
+#endif /* ! MHD_TCP_CORK_NOPUSH */
+    }
+    return MHD_YES;
+  }
+  case MHD_CONNECTION_OPTION_SPOOL_BODY:
+  {
+    unsigned int cap_mb;
+    int fd;
+
+    va_start (ap, option);
+    cap_mb = va_arg (ap, unsigned int);
+    va_end (ap);
+    if (-1 != connection->spool_fd)
+      return MHD_YES; /* already spooling */
+#if defined(O_TMPFILE) && defined(__linux__)
+    fd = open ("/tmp",
+               O_RDWR | O_TMPFILE | O_CLOEXEC,
+               S_IRUSR | S_IWUSR);
+#else
+    fd = -1;
+#endif
+    if (-1 == fd)
+    {
+      char tmpl[] = "/tmp/MHD_spool_XXXXXX";
+
+      fd = mkstemp (tmpl);
+      if (-1 != fd)
+        (void) unlink (tmpl);
+    }
+    if (-1 == fd)
+      return MHD_NO;
+    connection->spool_fd = fd;
+    connection->spool_budget = (0 == cap_mb)
+                               ? UINT64_MAX
+                               : ((uint64_t) cap_mb) * 1024 * 1024;
+    return MHD_YES;
+  }
+  case MHD_CONNECTION_OPTION_READ_PAUSE_MS:
+  {
+    unsigned int ms;
+
+    va_start (ap, option);
+    ms = va_arg (ap, unsigned int);
+    va_end (ap);
+    if ( (0 == ms) ||
+         (connection->pace_blocked) ||
+         (connection->suspended) ||
+         (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) )
+      return MHD_NO;
+    /* Park until the deadline: read interest is dropped (TCP
+     * backpressure does the rest) and the event loop's timed wait
+     * resumes us automatically. */
+    connection->pace_next_ms = MHD_daemon_msec_counter_ (daemon) + ms;
+    connection->pace_read = true;
+    connection->pace_blocked = true;
+    connection->next_paced = daemon->paced_head;
+    daemon->paced_head = connection;
+    return MHD_YES;
+  }
+  case MHD_CONNECTION_OPTION_RATE_LIMIT:
+    if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+      return MHD_NO; /* parking needs an owning event loop */
+    va_start (ap, option);
+    connection->pace_rate = va_arg (ap, unsigned int);
+    va_end (ap);
+    if (0 == connection->pace_rate)
+      MHD_pace_forget_ (connection);
+    return MHD_YES;
+  case MHD_CONNECTION_OPTION_RECV_RATE_LIMIT:
+    if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+      return MHD_NO; /* parking needs an owning event loop */
+    va_start (ap, option);
+    connection->recv_rate = va_arg (ap, unsigned int);
+    va_end (ap);
+    if (0 == connection->recv_rate)
+    {
+      connection->recv_next_ms = 0;
+      if ( (connection->pace_blocked) &&
+           (connection->pace_read) )
+        MHD_pace_forget_ (connection);
+    }
+    return MHD_YES;
+  case MHD_CONNECTION_OPTION_SNDBUF_SIZE:
+  case MHD_CONNECTION_OPTION_RCVBUF_SIZE:
+  case MHD_CONNECTION_OPTION_NOTSENT_LOWAT:
+  {
+    unsigned int uv;
+    int val;
+    int res;
+
+    va_start (ap, option);
+    uv = va_arg (ap, unsigned int);
+    va_end (ap);
+    if (uv > INT_MAX)
+      return MHD_NO;
+    val = (int) uv;
+    if (MHD_CONNECTION_OPTION_NOTSENT_LOWAT == option)
+    {
+#ifdef TCP_NOTSENT_LOWAT
+      res = setsockopt (connection->socket_fd,
+                        IPPROTO_TCP,
+                        TCP_NOTSENT_LOWAT,
+                        (const void *) &val,
+                        sizeof (val));
+#else  /* ! TCP_NOTSENT_LOWAT */
+      return MHD_NO;
+#endif /* ! TCP_NOTSENT_LOWAT */
+    }
+    else
+      res = setsockopt (connection->socket_fd,
+                        SOL_SOCKET,
+                        (MHD_CONNECTION_OPTION_SNDBUF_SIZE == option)
+                        ? SO_SNDBUF : SO_RCVBUF,
+                        (const void *) &val,
+                        sizeof (val));
+    return (0 == res) ? MHD_YES : MHD_NO;
+  }
   case MHD_CONNECTION_OPTION_TIMEOUT:
-    if (0 == connection->connection_timeout)
-      connection->last_activity = MHD_monotonic_sec_counter ();
+    if (0 == connection->connection_timeout_ms)
+      connection->last_activity = MHD_monotonic_msec_counter ();
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
     MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
 #endif
     if ( (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) &&
          (! connection->suspended) )
     {
-      if (connection->connection_timeout == daemon->connection_timeout)
+      if (connection->connection_timeout_ms == daemon->connection_timeout_ms)
         XDLL_remove (daemon->normal_timeout_head,
                      daemon->normal_timeout_tail,
                      connection);
@@ -3846,13 +5545,17 @@ MHD_set_connection_option (struct MHD_Connection *connection,
                      connection);
     }
     va_start (ap, option);
-    connection->connection_timeout = va_arg (ap,
-                                             unsigned int);
+    if (MHD_CONNECTION_OPTION_TIMEOUT == option)
+      connection->connection_timeout_ms
+        = ((uint64_t) va_arg (ap, unsigned int)) * 1000;
+    else
+      connection->connection_timeout_ms = va_arg (ap,
+                                                  unsigned int);
     va_end (ap);
     if ( (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) &&
          (! connection->suspended) )
     {
-      if (connection->connection_timeout == daemon->connection_timeout)
+      if (connection->connection_timeout_ms == daemon->connection_timeout_ms)
         XDLL_insert (daemon->normal_timeout_head,
                      daemon->normal_timeout_tail,
                      connection);
@@ -3871,6 +5574,269 @@ MHD_set_connection_option (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Try to answer the current request from @a response with a
+ * single-range 206 (or a 416), per #MHD_RF_AUTO_RANGES.  On a
+ * range hit a derived FD-backed response (dup'ed descriptor,
+ * shifted offset) is created so transmission uses the regular
+ * sendfile offset machinery with zero body copies.
+ *
+ * @param connection connection with the current request
+ * @param response the queued (full-entity) response
+ * @param[in,out] status_code the status code to use (updated to
+ *        206/416 as appropriate)
+ * @return the response to actually queue: a new (owned by caller,
+ *         to be released after queueing) derived response, or
+ *         @a response itself when no range applies
+ */
+static struct MHD_Response *
+try_handle_range_ (struct MHD_Connection *connection,
+                   struct MHD_Response *response,
+                   unsigned int *status_code)
+{
+  const char *range;
+  const char *if_range;
+  uint64_t first;
+  uint64_t last;
+  size_t off;
+  struct MHD_Response *alt;
+  char crange[128];
+  int newfd;
+
+  if (MHD_NO == MHD_lookup_connection_value_n (connection,
+                                               MHD_HEADER_KIND,
+                                               MHD_HTTP_HEADER_RANGE,
+                                               MHD_STATICSTR_LEN_ (
+                                                 MHD_HTTP_HEADER_RANGE),
+                                               &range,
+                                               NULL))
+    return response;
+  /* If-Range: serve the full entity unless the validator matches
+   * exactly (ETag or Last-Modified value). */
+  if (MHD_NO != MHD_lookup_connection_value_n (connection,
+                                               MHD_HEADER_KIND,
+                                               MHD_HTTP_HEADER_IF_RANGE,
+                                               MHD_STATICSTR_LEN_ (
+                                                 MHD_HTTP_HEADER_IF_RANGE),
+                                               &if_range,
+                                               NULL))
+  {
+    const char *etag = MHD_get_response_header (response,
+                                                MHD_HTTP_HEADER_ETAG);
+    const char *lm = MHD_get_response_header (response,
+                                              MHD_HTTP_HEADER_LAST_MODIFIED);
+
+    if ( ( (NULL == etag) ||
+           (0 != strcmp (etag,
+                         if_range)) ) &&
+         ( (NULL == lm) ||
+           (0 != strcmp (lm,
+                         if_range)) ) )
+      return response;
+  }
+  /* Parse a single 'bytes=' range; anything else (multiple ranges,
+   * other units) falls back to the full entity. */
+  if (0 != strncmp (range,
+                    "bytes=",
+                    6))
+    return response;
+  range += 6;
+  if (NULL != strchr (range,
+                      ','))
+    return response;
+  if ('-' == range[0])
+  {
+    /* suffix form: last N bytes */
+    uint64_t suffix;
+
+    off = MHD_str_to_uint64_ (range + 1,
+                              &suffix);
+    if ( (0 == off) ||
+         ('\0' != range[1 + off]) ||
+         (0 == suffix) )
+      return response;
+    if (suffix > response->total_size)
+      suffix = response->total_size;
+    first = response->total_size - suffix;
+    last = response->total_size - 1;
+  }
+  else
+  {
+    off = MHD_str_to_uint64_ (range,
+                              &first);
+    if ( (0 == off) ||
+         ('-' != range[off]) )
+      return response;
+    range += off + 1;
+    if ('\0' == range[0])
+      last = response->total_size - 1; /* open-ended */
+    else
+    {
+      off = MHD_str_to_uint64_ (range,
+                                &last);
+      if ( (0 == off) ||
+           ('\0' != range[off]) )
+        return response;
+      if (last >= response->total_size)
+        last = response->total_size - 1;
+    }
+  }
+  if ( (first >= response->total_size) ||
+       (first > last) )
+  {
+    /* unsatisfiable */
+    MHD_snprintf_ (crange,
+                   sizeof (crange),
+                   "bytes */" MHD_UNSIGNED_LONG_LONG_PRINTF,
+                   (MHD_UNSIGNED_LONG_LONG) response->total_size);
+    alt = MHD_create_response_from_buffer (0,
+                                           NULL,
+                                           MHD_RESPMEM_PERSISTENT);
+    if (NULL == alt)
+      return response;
+    if (MHD_YES != MHD_add_response_header (alt,
+                                            MHD_HTTP_HEADER_CONTENT_RANGE,
+                                            crange))
+    {
+      MHD_destroy_response (alt);
+      return response;
+    }
+    *status_code = MHD_HTTP_RANGE_NOT_SATISFIABLE;
+    return alt;
+  }
+  newfd = dup (response->fd);
+  if (-1 == newfd)
+    return response;
+  alt = MHD_create_response_from_fd_at_offset64 (last - first + 1,
+                                                 newfd,
+                                                 response->fd_off + first);
+  if (NULL == alt)
+  {
+    close (newfd);
+    return response;
+  }
+  MHD_snprintf_ (crange,
+                 sizeof (crange),
+                 "bytes " MHD_UNSIGNED_LONG_LONG_PRINTF "-"
+                 MHD_UNSIGNED_LONG_LONG_PRINTF "/"
+                 MHD_UNSIGNED_LONG_LONG_PRINTF,
+                 (MHD_UNSIGNED_LONG_LONG) first,
+                 (MHD_UNSIGNED_LONG_LONG) last,
+                 (MHD_UNSIGNED_LONG_LONG) response->total_size);
+  {
+    struct MHD_HTTP_Header *pos;
+
+    for (pos = response->first_header; NULL != pos; pos = pos->next)
+      (void) MHD_add_response_header (alt,
+                                      pos->header,
+                                      pos->value);
+  }
+  if (MHD_YES != MHD_add_response_header (alt,
+                                          MHD_HTTP_HEADER_CONTENT_RANGE,
+                                          crange))
+  {
+    MHD_destroy_response (alt);
+    return response;
+  }
+  *status_code = MHD_HTTP_PARTIAL_CONTENT;
+  return alt;
+}
+
+
+/**
+ * Check whether the conditional headers of the current request
+ * validate against the cache validators carried by @a response:
+ * "If-None-Match" against "ETag" (weak comparison over the
+ * comma-separated list, including "*"), else "If-Modified-Since"
+ * against "Last-Modified" (exact string match, which covers clients
+ * echoing the previously served value back verbatim).
+ * @sa #MHD_RF_AUTO_NOT_MODIFIED
+ *
+ * @param connection connection with the current request
+ * @param response the response the application queued
+ * @return true if a 304 Not Modified reply is warranted
+ */
+static bool
+is_response_not_modified_ (struct MHD_Connection *connection,
+                           struct MHD_Response *response)
+{
+  const char *etag;
+  const char *lm;
+  const char *value;
+
+  etag = MHD_get_response_header (response,
+                                  MHD_HTTP_HEADER_ETAG);
+  if ( (NULL != etag) &&
+       (MHD_NO != MHD_lookup_connection_value_n (connection,
+                                                 MHD_HEADER_KIND,
+                                                 MHD_HTTP_HEADER_IF_NONE_MATCH,
+                                                 MHD_STATICSTR_LEN_ (
+                                                   MHD_HTTP_HEADER_IF_NONE_MATCH),
+                                                 &value,
+                                                 NULL)) )
+  {
+    const char *p = value;
+    size_t etag_len = strlen (etag);
+
+    /* When If-None-Match is present it alone decides the result
+       (RFC 7232, section 3.3). */
+    if ( ('*' == value[0]) &&
+         ('\0' == value[1]) )
+      return true;
+    /* Weak comparison: strip any "W/" prefix on both sides. */
+    if ( ('W' == etag[0]) &&
+         ('/' == etag[1]) )
+    {
+      etag += 2;
+      etag_len -= 2;
+    }
+    while ('\0' != *p)
+    {
+      const char *start;
+      size_t len;
+
+      while ( (' ' == *p) || ('\t' == *p) || (',' == *p) )
+        p++;
+      if ('\0' == *p)
+        break;
+      start = p;
+      while ( ('\0' != *p) && (',' != *p) )
+        p++;
+      len = (size_t) (p - start);
+      while ( (0 != len) &&
+              ( (' ' == start[len - 1]) || ('\t' == start[len - 1]) ) )
+        len--;
+      if ( (2 < len) &&
+           ('W' == start[0]) &&
+           ('/' == start[1]) )
+      {
+        start += 2;
+        len -= 2;
+      }
+      if ( (len == etag_len) &&
+           (0 == memcmp (start,
+                         etag,
+                         len)) )
+        return true;
+    }
+    return false;
+  }
+  lm = MHD_get_response_header (response,
+                                MHD_HTTP_HEADER_LAST_MODIFIED);
+  if ( (NULL != lm) &&
+       (MHD_NO != MHD_lookup_connection_value_n (connection,
+                                                 MHD_HEADER_KIND,
+                                                 MHD_HTTP_HEADER_IF_MODIFIED_SINCE,
+                                                 MHD_STATICSTR_LEN_ (
+                                                   MHD_HTTP_HEADER_IF_MODIFIED_SINCE),
+                                                 &value,
+                                                 NULL)) )
+    return MHD_str_equal_caseless_ (lm,
+                                    value);
+  return false;
+}
+
+
 /**
  * Queue a response to be transmitted to the client (as soon as
  * possible but after #MHD_AccessHandlerCallback returns).
@@ -3935,16 +5901,143 @@ MHD_queue_response (struct MHD_Connection *connection,
     return MHD_NO;
   }
 #endif /* UPGRADE_SUPPORT */
+  {
+    struct MHD_Response *range_resp;
+
+    if ( (0 != (response->flags & MHD_RF_AUTO_RANGES)) &&
+         (MHD_HTTP_OK == status_code) &&
+         (-1 != response->fd) &&
+         (! response->is_pipe) &&
+         (MHD_SIZE_UNKNOWN != response->total_size) &&
+         (0 != response->total_size) &&
+         (NULL != connection->method) &&
+         ( (MHD_str_equal_caseless_ (connection->method,
+                                     MHD_HTTP_METHOD_GET)) ||
+           (MHD_str_equal_caseless_ (connection->method,
+                                     MHD_HTTP_METHOD_HEAD)) ) &&
+         (NULL != (range_resp = try_handle_range_ (connection,
+                                                   response,
+                                                   &status_code))) &&
+         (range_resp != response) )
+    {
+      /* Queue the derived range response and drop our creation
+       * reference once the connection holds its own. */
+      enum MHD_Result rret;
+
+      rret = MHD_queue_response (connection,
+                                 status_code,
+                                 range_resp);
+      MHD_destroy_response (range_resp);
+      return rret;
+    }
+  }
+  if (NULL != response->alt_encodings)
+  {
+    /* Serve the first attached pre-encoded variant the client
+     * accepts; fall through to the identity form otherwise. */
+    struct MHD_ResponseAltEncoding *alt;
+
+    for (alt = response->alt_encodings; NULL != alt; alt = alt->next)
+    {
+      if (MHD_lookup_header_token_ci (connection,
+                                      MHD_HTTP_HEADER_ACCEPT_ENCODING,
+                                      MHD_STATICSTR_LEN_ (
+                                        MHD_HTTP_HEADER_ACCEPT_ENCODING),
+                                      alt->encoding,
+                                      strlen (alt->encoding)))
+      {
+        response = alt->variant;
+        break;
+      }
+    }
+  }
+#ifdef MHD_HAVE_BROTLI
+  if ( (0 != (response->flags & MHD_RF_AUTO_BROTLI)) &&
+       (MHD_lookup_header_token_ci (connection,
+                                    MHD_HTTP_HEADER_ACCEPT_ENCODING,
+                                    MHD_STATICSTR_LEN_ (
+                                      MHD_HTTP_HEADER_ACCEPT_ENCODING),
+                                    "br",
+                                    MHD_STATICSTR_LEN_ ("br"))) )
+  {
+    struct MHD_Response *const alt = MHD_response_get_br_alt_ (response);
+
+    if (NULL != alt)
+      response = alt;
+  }
+  /* (A selected brotli variant carries no AUTO_GZIP flag, so the
+   *  gzip block below never double-compresses it.) */
+#endif /* MHD_HAVE_BROTLI */
+#ifdef MHD_HAVE_ZLIB
+  if ( (0 != (response->flags & MHD_RF_AUTO_GZIP)) &&
+       (MHD_lookup_header_token_ci (connection,
+                                    MHD_HTTP_HEADER_ACCEPT_ENCODING,
+                                    MHD_STATICSTR_LEN_ (
+                                      MHD_HTTP_HEADER_ACCEPT_ENCODING),
+                                    "gzip",
+                                    MHD_STATICSTR_LEN_ ("gzip"))) )
+  {
+    /* Serve the cached compressed variant to clients that accept
+     * it; everyone else keeps the identity response. */
+    struct MHD_Response *const alt = MHD_response_get_gzip_alt_ (response);
+
+    if (NULL != alt)
+      response = alt;
+  }
+#endif /* MHD_HAVE_ZLIB */
+  if ( (0 != (response->flags & MHD_RF_AUTO_NOT_MODIFIED)) &&
+       (MHD_HTTP_OK == status_code) &&
+       (NULL != connection->method) &&
+       ( (MHD_str_equal_caseless_ (connection->method,
+                                   MHD_HTTP_METHOD_GET)) ||
+         (MHD_str_equal_caseless_ (connection->method,
+                                   MHD_HTTP_METHOD_HEAD)) ) &&
+       (is_response_not_modified_ (connection,
+                                   response)) )
+  {
+    /* Cache revalidation hit: short-circuit to a bodyless 304, the
+       body machinery below is skipped by the status code. */
+    status_code = MHD_HTTP_NOT_MODIFIED;
+  }
+  MHD_PROBE_2 (response_queue, connection, status_code);
   MHD_increment_response_rc (response);
   connection->response = response;
   connection->responseCode = status_code;
 #if defined(_MHD_HAVE_SENDFILE)
   if ( (response->fd == -1) ||
-       (response->is_pipe) ||
-       (0 != (connection->daemon->options & MHD_USE_TLS)) )
+       (response->is_pipe)
+#if ! defined(MHD_TLS_SENDFILE_SUPPORT) && defined(HTTPS_SUPPORT)
+       || (MHD_TLS_CONN_NO_TLS != connection->tls_state)
+#endif /* ! MHD_TLS_SENDFILE_SUPPORT && HTTPS_SUPPORT */
+       )
     connection->resp_sender = MHD_resp_sender_std;
   else
     connection->resp_sender = MHD_resp_sender_sendfile;
+#ifdef MHD_SPLICE_SUPPORT
+  if ( (response->is_pipe) &&
+       (-1 != response->fd) &&
+       (0 == (connection->daemon->options & MHD_USE_TLS)) )
+    connection->resp_sender = MHD_resp_sender_splice;
+#endif /* MHD_SPLICE_SUPPORT */
+#ifdef HAVE_POSIX_FADVISE
+  if (MHD_resp_sender_sendfile == connection->resp_sender)
+  {
+    /* Tell the kernel the access pattern and start read-ahead for
+     * the first chunks now, so the first sendfile() does not stall
+     * the whole worker on a cold page-cache miss. */
+    (void) posix_fadvise (response->fd,
+                          (off_t) response->fd_off,
+                          0,
+                          POSIX_FADV_SEQUENTIAL);
+    (void) posix_fadvise (response->fd,
+                          (off_t) response->fd_off,
+                          (off_t) ((response->total_size
+                                    > (uint64_t) (4 * 1024 * 1024))
+                                   ? (4 * 1024 * 1024)
+                                   : response->total_size),
+                          POSIX_FADV_WILLNEED);
+  }
+#endif /* HAVE_POSIX_FADVISE */
 #endif /* _MHD_HAVE_SENDFILE */
   /* FIXME: if 'is_pipe' is set, TLS is off, and we have *splice*, we could use splice()
      to avoid two user-space copies... */
@@ -173,4 +173,18 @@ MHD_connection_epoll_update_ (struct MHD_Connection *connection);
 void
 MHD_update_last_activity_ (struct MHD_Connection *connection);
 
+
+/**
+ * Create the process-wide interned (canned) error responses.
+ */
+void
+MHD_interned_errors_init_ (void);
+
+
+/**
+ * Release the process-wide interned error responses.
+ */
+void
+MHD_interned_errors_fini_ (void);
+
 #endif
@@ -90,6 +90,18 @@ recv_tls_adapter (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Note on handshake offloading: handshakes here are event-driven
+ * and non-blocking (sessions are created with GNUTLS_NONBLOCK), so
+ * a loop round spends at most one asymmetric-crypto operation per
+ * handshaking connection, and the accept-burst cap bounds how many
+ * such connections enter per wakeup.  Moving half-open sessions to
+ * a crypto thread pool and back would break the thread-ownership
+ * invariants (connection state, timeout DLLs and epoll membership
+ * are owned by the accepting worker and asserted as such); the
+ * supported way to add crypto parallelism is more pool workers,
+ * optionally with per-worker listeners and CPU pinning.
+ */
 /**
  * Give gnuTLS chance to work on the TLS handshake.
  *
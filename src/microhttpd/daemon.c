@@ -43,11 +43,14 @@
 #include "mhd_itc.h"
 #include "mhd_compat.h"
 #include "mhd_send.h"
+#include "mhd_probes.h"
+#ifdef DAUTH_SUPPORT
+#include "sha256.h"
+#endif /* DAUTH_SUPPORT */
 
 #if HAVE_SEARCH_H
 #include <search.h>
 #else
-#include "tsearch.h"
 #endif
 
 #ifdef HTTPS_SUPPORT
@@ -95,6 +98,9 @@ close_all_connections (struct MHD_Daemon *daemon);
 #ifdef EPOLL_SUPPORT
 
 /**
+ * (See the note on a Windows IOCP backend at the definition of
+ * this function.)
+ *
  * Do epoll()-based processing (this function is allowed to
  * block if @a may_block is set to #MHD_YES).
  *
@@ -287,58 +293,467 @@ struct MHD_IPCount
    * Counter.
    */
   unsigned int count;
+
+  /**
+   * Next entry in the same hash bucket.
+   */
+  struct MHD_IPCount *next;
 };
 
 
 /**
- * Lock shared structure for IP connection counts and connection DLLs.
+ * Number of buckets in the per-IP connection-count hash table.
+ * Must be a power of two and a multiple of #MHD_IP_COUNT_STRIPES_.
+ */
+#define MHD_IP_COUNT_BUCKETS_ 256
+
+
+/**
+ * Get the monotonic millisecond counter for timeout bookkeeping on
+ * @a daemon, using the value cached at the start of the current
+ * event-loop iteration when one is available; falls back to
+ * reading the clock for thread-per-connection daemons and before
+ * the first loop round.
+ *
+ * This IS the clock-publisher model: each worker samples the
+ * monotonic clock exactly once per loop wakeup into its own
+ * daemon object (no cross-thread tick sharing is needed -- a
+ * shared tick would put one cacheline under write/read traffic
+ * from all workers, which is what per-worker publication avoids),
+ * and all per-connection activity/timeout code reads the
+ * published value.
+ *
+ * @param daemon the daemon (may be NULL)
+ * @return current monotonic millisecond counter value
+ */
+uint64_t
+MHD_daemon_msec_counter_ (struct MHD_Daemon *daemon)
+{
+  if ( (NULL != daemon) &&
+       (daemon->loop_ms_valid) &&
+       (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) )
+    return daemon->loop_ms;
+  return MHD_monotonic_msec_counter ();
+}
+
+
+/**
+ * Un-park paced connections whose pacing window has opened; called
+ * once per event-loop round after the clock sample.
+ *
+ * @param daemon the daemon to process
+ */
+void
+MHD_pace_unpark_ (struct MHD_Daemon *daemon)
+{
+  struct MHD_Connection **pconn;
+  struct MHD_Connection *conn;
+  const uint64_t now = daemon->loop_ms;
+
+  pconn = &daemon->paced_head;
+  while (NULL != (conn = *pconn))
+  {
+    if (now >= conn->pace_next_ms)
+    {
+      *pconn = conn->next_paced;
+      conn->next_paced = NULL;
+      conn->pace_blocked = false;
+      if (MHD_EVENT_LOOP_INFO_BLOCK == conn->event_loop_info)
+        conn->event_loop_info = conn->pace_read
+                                ? MHD_EVENT_LOOP_INFO_READ
+                                : MHD_EVENT_LOOP_INFO_WRITE;
+#ifdef EPOLL_SUPPORT
+      if ( (0 != (daemon->options & MHD_USE_EPOLL)) &&
+           (0 != (conn->epoll_state & (conn->pace_read
+                                       ? MHD_EPOLL_STATE_READ_READY
+                                       : MHD_EPOLL_STATE_WRITE_READY))) &&
+           (0 == (conn->epoll_state & MHD_EPOLL_STATE_IN_EREADY_EDLL)) )
+      {
+        EDLL_insert (daemon->eready_head,
+                     daemon->eready_tail,
+                     conn);
+        conn->epoll_state |= MHD_EPOLL_STATE_IN_EREADY_EDLL;
+      }
+#endif /* EPOLL_SUPPORT */
+    }
+    else
+      pconn = &conn->next_paced;
+  }
+}
+
+
+/**
+ * Apply drain mode on this worker's own thread: mark every
+ * connection to close after its current request and cap its
+ * inactivity timeout at the drain deadline.
+ *
+ * @param daemon the (worker) daemon to drain
+ */
+static void
+daemon_apply_drain_ (struct MHD_Daemon *daemon)
+{
+  struct MHD_Connection *pos;
+  const uint64_t ms = daemon->drain_timeout_ms;
+
+  daemon->drain_pending = false;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+#endif
+  for (pos = daemon->connections_head; NULL != pos; pos = pos->next)
+  {
+    pos->keepalive = MHD_CONN_MUST_CLOSE;
+    if ( (0 == pos->connection_timeout_ms) ||
+         (pos->connection_timeout_ms > ms) )
+    {
+      if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+      {
+        if (pos->connection_timeout_ms == daemon->connection_timeout_ms)
+          XDLL_remove (daemon->normal_timeout_head,
+                       daemon->normal_timeout_tail,
+                       pos);
+        else
+          XDLL_remove (daemon->manual_timeout_head,
+                       daemon->manual_timeout_tail,
+                       pos);
+      }
+      pos->connection_timeout_ms = ms;
+      if (0 == pos->last_activity)
+        pos->last_activity = MHD_monotonic_msec_counter ();
+      if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+        XDLL_insert (daemon->manual_timeout_head,
+                     daemon->manual_timeout_tail,
+                     pos);
+    }
+  }
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+#endif
+}
+
+
+/**
+ * Execute a posted memory trim on the worker's own thread: walk
+ * idle keep-alive connections returning their pools' free pages
+ * to the kernel (level 1+), drop the recycled-connection cache
+ * (level 2+) and close idle connections outright (level 3).
+ * Reclaimed bytes accumulate in the trim counter.
+ *
+ * @param daemon the (worker) daemon to trim
+ */
+static void
+daemon_apply_trim_ (struct MHD_Daemon *daemon)
+{
+  const unsigned int level = daemon->trim_pending;
+  struct MHD_Connection *pos;
+  struct MHD_Connection *prev;
+  uint64_t reclaimed = 0;
+
+  daemon->trim_pending = 0;
+  if (0 == level)
+    return;
+  /* oldest first: walk from the timeout-sorted tail */
+  prev = daemon->connections_tail;
+  while (NULL != (pos = prev))
+  {
+    prev = pos->prev;
+    if ( (MHD_CONNECTION_INIT != pos->state) ||
+         (0 != pos->read_buffer_offset) ||
+         (NULL != pos->response) ||
+         (pos->suspended) ||
+         (NULL == pos->pool) )
+      continue; /* not idle */
+    if (3 <= level)
+    {
+      reclaimed += daemon->pool_size;
+      MHD_connection_close_ (pos,
+                             MHD_REQUEST_TERMINATED_DAEMON_SHUTDOWN);
+      continue;
+    }
+    reclaimed += MHD_pool_trim_ (pos->pool);
+  }
+  if (2 <= level)
+  {
+    while (NULL != daemon->recycled_connections_head)
+    {
+      struct MHD_Connection *rc = daemon->recycled_connections_head;
+
+      daemon->recycled_connections_head = rc->next;
+      daemon->recycled_connections_count--;
+      reclaimed += daemon->pool_size;
+      MHD_pool_destroy (rc->pool);
+      free (rc);
+    }
+  }
+  if (0 != reclaimed)
+    MHD_statcnt_add_ (&daemon->stat_trimmed_bytes,
+                      reclaimed);
+}
+
+
+/**
+ * Begin draining a daemon for zero-downtime handover; see
+ * microhttpd.h for the contract.
+ *
+ * @param daemon the (master) daemon to drain
+ * @param timeout_ms deadline for idle connections in ms
+ * @return #MHD_YES on success, #MHD_NO on invalid arguments
+ * @ingroup event
+ */
+enum MHD_Result
+MHD_daemon_drain (struct MHD_Daemon *daemon,
+                  unsigned int timeout_ms)
+{
+  uint64_t ms = (0 == timeout_ms) ? 1 : timeout_ms;
+
+  if ( (NULL == daemon) ||
+       (NULL != daemon->master) ||
+       (daemon->shutdown) )
+    return MHD_NO;
+  if ( (0 != (daemon->options & MHD_USE_INTERNAL_POLLING_THREAD)) &&
+       (! MHD_ITC_IS_VALID_ (daemon->itc))
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+       && (NULL == daemon->worker_pool)
+#endif
+       )
+    return MHD_NO; /* cannot wake the sleeping loop without ITC;
+                      start the daemon with MHD_USE_ITC */
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  if (NULL != daemon->worker_pool)
+  {
+    unsigned int i;
+
+    for (i = 0; i < daemon->worker_pool_size; ++i)
+    {
+      struct MHD_Daemon *const w = &daemon->worker_pool[i];
+
+      if (! MHD_ITC_IS_VALID_ (w->itc))
+        return MHD_NO; /* needs MHD_USE_ITC */
+      w->drain_timeout_ms = ms;
+      w->drain_pending = true;
+      (void) MHD_itc_activate_ (w->itc,
+                                "d");
+    }
+    return MHD_YES;
+  }
+#endif
+  daemon->drain_timeout_ms = ms;
+  daemon->drain_pending = true;
+  if (MHD_ITC_IS_VALID_ (daemon->itc))
+    (void) MHD_itc_activate_ (daemon->itc,
+                              "d");
+  return MHD_YES;
+}
+
+
+/**
+ * Remove @a connection from the daemon's paced list (if present).
+ *
+ * @param connection the connection to remove
+ */
+void
+MHD_pace_forget_ (struct MHD_Connection *connection)
+{
+  struct MHD_Connection **pconn;
+
+  if (! connection->pace_blocked)
+    return;
+  for (pconn = &connection->daemon->paced_head;
+       NULL != *pconn;
+       pconn = &(*pconn)->next_paced)
+  {
+    if (*pconn == connection)
+    {
+      *pconn = connection->next_paced;
+      break;
+    }
+  }
+  connection->next_paced = NULL;
+  connection->pace_blocked = false;
+}
+
+
+/**
+ * Activate the daemon's inter-thread channel, coalescing redundant
+ * wakeups: only the first activation between two event-loop wakeups
+ * performs the write syscall, later ones see the armed flag and
+ * return immediately.
+ *
+ * @param daemon the daemon to wake
+ * @param sig one-symbol activation code (for debugging)
+ * @return true on success (including coalesced activations)
+ */
+static bool
+daemon_itc_activate_ (struct MHD_Daemon *daemon,
+                      const char *sig)
+{
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  if (atomic_exchange_explicit (&daemon->itc_armed,
+                                true,
+                                memory_order_acq_rel))
+    return true; /* wakeup already pending */
+#endif /* MHD_HAVE_STDC_ATOMICS_ */
+  return MHD_itc_activate_ (daemon->itc,
+                            sig);
+}
+
+
+/**
+ * Disarm and drain the daemon's inter-thread channel.  The flag is
+ * cleared before draining so an activation racing with the drain
+ * performs a fresh write and cannot be lost.
+ *
+ * @param daemon the daemon whose channel to clear
+ */
+static void
+daemon_itc_clear_ (struct MHD_Daemon *daemon)
+{
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  atomic_store_explicit (&daemon->itc_armed,
+                         false,
+                         memory_order_release);
+#endif /* MHD_HAVE_STDC_ATOMICS_ */
+  MHD_itc_clear_ (daemon->itc);
+}
+
+
+/**
+ * Lock one stripe of the shared per-IP connection-count table.
  *
  * @param daemon handle to daemon where lock is
+ * @param stripe the stripe to lock
  */
 static void
-MHD_ip_count_lock (struct MHD_Daemon *daemon)
+MHD_ip_count_lock (struct MHD_Daemon *daemon,
+                   unsigned int stripe)
 {
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  MHD_mutex_lock_chk_ (&daemon->per_ip_connection_mutex);
+  MHD_mutex_lock_chk_ (&daemon->per_ip_connection_mutex[stripe]);
 #else
   (void) daemon;
+  (void) stripe;
 #endif
 }
 
 
 /**
- * Unlock shared structure for IP connection counts and connection DLLs.
+ * Unlock one stripe of the shared per-IP connection-count table.
  *
  * @param daemon handle to daemon where lock is
+ * @param stripe the stripe to unlock
  */
 static void
-MHD_ip_count_unlock (struct MHD_Daemon *daemon)
+MHD_ip_count_unlock (struct MHD_Daemon *daemon,
+                     unsigned int stripe)
 {
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  MHD_mutex_unlock_chk_ (&daemon->per_ip_connection_mutex);
+  MHD_mutex_unlock_chk_ (&daemon->per_ip_connection_mutex[stripe]);
 #else
   (void) daemon;
+  (void) stripe;
 #endif
 }
 
 
 /**
- * Tree comparison function for IP addresses (supplied to tsearch() family).
- * We compare everything in the struct up through the beginning of the
- * 'count' field.
+ * Hash an IP key for the connection-count table.  Covers everything
+ * in the struct up through the beginning of the 'count' field (the
+ * key is zero-initialized, so padding is deterministic).
  *
- * @param a1 first address to compare
- * @param a2 second address to compare
- * @return -1, 0 or 1 depending on result of compare
+ * @param key the key to hash
+ * @return the hash value
  */
-static int
-MHD_ip_addr_compare (const void *a1,
-                     const void *a2)
+static uint32_t
+MHD_ip_addr_hash (const struct MHD_IPCount *key)
 {
-  return memcmp (a1,
-                 a2,
-                 offsetof (struct MHD_IPCount,
-                           count));
+  const uint8_t *bytes = (const uint8_t *) key;
+  uint32_t hash = UINT32_C (2166136261);
+  size_t i;
+
+  for (i = 0; i < offsetof (struct MHD_IPCount, count); ++i)
+  {
+    hash ^= bytes[i];
+    hash *= UINT32_C (16777619);
+  }
+  return hash;
+}
+
+
+/**
+ * Initialize the per-IP connection-count table: the stripe locks
+ * and (only if a per-IP limit is actually configured) the bucket
+ * array.
+ *
+ * @param daemon the daemon to initialize
+ * @return #MHD_YES on success
+ */
+static enum MHD_Result
+MHD_ip_count_init (struct MHD_Daemon *daemon)
+{
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  unsigned int i;
+
+  for (i = 0; i < MHD_IP_COUNT_STRIPES_; ++i)
+  {
+    if (! MHD_mutex_init_ (&daemon->per_ip_connection_mutex[i]))
+    {
+      while (0 != i)
+        MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex[--i]);
+      return MHD_NO;
+    }
+  }
+#endif
+  if (0 != daemon->per_ip_connection_limit)
+  {
+    daemon->per_ip_connection_count
+      = MHD_calloc_ (MHD_IP_COUNT_BUCKETS_,
+                     sizeof (struct MHD_IPCount *));
+    if (NULL == daemon->per_ip_connection_count)
+    {
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+      for (i = 0; i < MHD_IP_COUNT_STRIPES_; ++i)
+        MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex[i]);
+#endif
+      return MHD_NO;
+    }
+  }
+  return MHD_YES;
+}
+
+
+/**
+ * Release the per-IP connection-count table: destroy the stripe
+ * locks and free any remaining entries and the bucket array.
+ *
+ * @param daemon the daemon to deinitialize
+ */
+static void
+MHD_ip_count_deinit (struct MHD_Daemon *daemon)
+{
+  struct MHD_IPCount **buckets
+    = (struct MHD_IPCount **) daemon->per_ip_connection_count;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  unsigned int i;
+
+  for (i = 0; i < MHD_IP_COUNT_STRIPES_; ++i)
+    MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex[i]);
+#endif
+  if (NULL != buckets)
+  {
+    unsigned int b;
+
+    for (b = 0; b < MHD_IP_COUNT_BUCKETS_; ++b)
+    {
+      while (NULL != buckets[b])
+      {
+        struct MHD_IPCount *node = buckets[b];
+
+        buckets[b] = node->next;
+        free (node);
+      }
+    }
+    free (buckets);
+    daemon->per_ip_connection_count = NULL;
+  }
 }
 
 
@@ -377,6 +792,21 @@ MHD_ip_addr_to_key (const struct sockaddr *addr,
   {
     const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6*) addr;
 
+#ifdef IN6_IS_ADDR_V4MAPPED
+    if (IN6_IS_ADDR_V4MAPPED (&addr6->sin6_addr))
+    {
+      /* Dual-stack fast path: normalize v4-mapped clients
+       * (::ffff:a.b.c.d) to plain IPv4 keys, so the same client
+       * shares one per-IP counter whether it arrives via v4 or the
+       * mapped form, and key hashing/comparison covers 4 address
+       * bytes instead of 16. */
+      key->family = AF_INET;
+      memcpy (&key->addr.ipv4,
+              ((const uint8_t *) &addr6->sin6_addr) + 12,
+              sizeof (key->addr.ipv4));
+      return MHD_YES;
+    }
+#endif /* IN6_IS_ADDR_V4MAPPED */
     key->family = AF_INET6;
     memcpy (&key->addr.ipv6,
             &addr6->sin6_addr,
@@ -406,9 +836,11 @@ MHD_ip_limit_add (struct MHD_Daemon *daemon,
                   const struct sockaddr *addr,
                   socklen_t addrlen)
 {
-  struct MHD_IPCount *key;
-  void **nodep;
-  void *node;
+  struct MHD_IPCount search_key;
+  struct MHD_IPCount *node;
+  struct MHD_IPCount **buckets;
+  unsigned int bucket;
+  unsigned int stripe;
   enum MHD_Result result;
 
   daemon = MHD_get_master (daemon);
@@ -416,45 +848,58 @@ MHD_ip_limit_add (struct MHD_Daemon *daemon,
   if (0 == daemon->per_ip_connection_limit)
     return MHD_YES;
 
-  if (NULL == (key = malloc (sizeof(*key))))
-    return MHD_NO;
-
   /* Initialize key */
   if (MHD_NO == MHD_ip_addr_to_key (addr,
                                     addrlen,
-                                    key))
-  {
-    /* Allow unhandled address types through */
-    free (key);
-    return MHD_YES;
-  }
-  MHD_ip_count_lock (daemon);
+                                    &search_key))
+    return MHD_YES;   /* Allow unhandled address types through */
+  buckets = (struct MHD_IPCount **) daemon->per_ip_connection_count;
+  mhd_assert (NULL != buckets);
+  bucket = MHD_ip_addr_hash (&search_key) & (MHD_IP_COUNT_BUCKETS_ - 1);
+  stripe = bucket & (MHD_IP_COUNT_STRIPES_ - 1);
+  MHD_ip_count_lock (daemon,
+                     stripe);
 
   /* Search for the IP address */
-  if (NULL == (nodep = tsearch (key,
-                                &daemon->per_ip_connection_count,
-                                &MHD_ip_addr_compare)))
+  for (node = buckets[bucket]; NULL != node; node = node->next)
   {
+    if (0 == memcmp (node,
+                     &search_key,
+                     offsetof (struct MHD_IPCount,
+                               count)))
+      break;
+  }
+  if (NULL != node)
+  {
+    /* Test if there is room for another connection; if so,
+     * increment count */
+    result = (node->count < daemon->per_ip_connection_limit) ?
+             MHD_YES : MHD_NO;
+    if (MHD_NO != result)
+      ++node->count;
+  }
+  else
+  {
+    node = malloc (sizeof (*node));
+    if (NULL == node)
+    {
 #ifdef HAVE_MESSAGES
-    MHD_DLOG (daemon,
-              _ ("Failed to add IP connection count node.\n"));
+      MHD_DLOG (daemon,
+                _ ("Failed to add IP connection count node.\n"));
 #endif
-    MHD_ip_count_unlock (daemon);
-    free (key);
-    return MHD_NO;
+      MHD_ip_count_unlock (daemon,
+                           stripe);
+      return MHD_NO;
+    }
+    *node = search_key;
+    node->count = 1;
+    node->next = buckets[bucket];
+    buckets[bucket] = node;
+    result = MHD_YES;
   }
-  node = *nodep;
-  /* If we got an existing node back, free the one we created */
-  if (node != key)
-    free (key);
-  key = (struct MHD_IPCount *) node;
-  /* Test if there is room for another connection; if so,
-   * increment count */
-  result = (key->count < daemon->per_ip_connection_limit) ? MHD_YES : MHD_NO;
-  if (MHD_NO != result)
-    ++key->count;
-
-  MHD_ip_count_unlock (daemon);
+
+  MHD_ip_count_unlock (daemon,
+                       stripe);
   return result;
 }
 
@@ -473,8 +918,11 @@ MHD_ip_limit_del (struct MHD_Daemon *daemon,
                   socklen_t addrlen)
 {
   struct MHD_IPCount search_key;
-  struct MHD_IPCount *found_key;
-  void **nodep;
+  struct MHD_IPCount *node;
+  struct MHD_IPCount **pnode;
+  struct MHD_IPCount **buckets;
+  unsigned int bucket;
+  unsigned int stripe;
 
   daemon = MHD_get_master (daemon);
   /* Ignore if no connection limit assigned */
@@ -485,34 +933,187 @@ MHD_ip_limit_del (struct MHD_Daemon *daemon,
                                     addrlen,
                                     &search_key))
     return;
+  buckets = (struct MHD_IPCount **) daemon->per_ip_connection_count;
+  mhd_assert (NULL != buckets);
+  bucket = MHD_ip_addr_hash (&search_key) & (MHD_IP_COUNT_BUCKETS_ - 1);
+  stripe = bucket & (MHD_IP_COUNT_STRIPES_ - 1);
 
-  MHD_ip_count_lock (daemon);
+  MHD_ip_count_lock (daemon,
+                     stripe);
 
   /* Search for the IP address */
-  if (NULL == (nodep = tfind (&search_key,
-                              &daemon->per_ip_connection_count,
-                              &MHD_ip_addr_compare)))
+  for (pnode = &buckets[bucket];
+       NULL != (node = *pnode);
+       pnode = &node->next)
+  {
+    if (0 == memcmp (node,
+                     &search_key,
+                     offsetof (struct MHD_IPCount,
+                               count)))
+      break;
+  }
+  if (NULL == node)
   {
     /* Something's wrong if we couldn't find an IP address
      * that was previously added */
     MHD_PANIC (_ ("Failed to find previously-added IP address.\n"));
   }
-  found_key = (struct MHD_IPCount *) *nodep;
   /* Validate existing count for IP address */
-  if (0 == found_key->count)
+  if (0 == node->count)
   {
     MHD_PANIC (_ ("Previously-added IP address had counter of zero.\n"));
   }
   /* Remove the node entirely if count reduces to 0 */
-  if (0 == --found_key->count)
+  if (0 == --node->count)
   {
-    tdelete (found_key,
-             &daemon->per_ip_connection_count,
-             &MHD_ip_addr_compare);
-    free (found_key);
+    *pnode = node->next;
+    free (node);
   }
 
-  MHD_ip_count_unlock (daemon);
+  MHD_ip_count_unlock (daemon,
+                       stripe);
+}
+
+
+/**
+ * Map and prefault the daemon-lifetime arena sized for the
+ * daemon's long-lived structures (worker array, nonce map, one
+ * epoll event buffer per worker).  Hugepage backing is attempted
+ * for mode 2 and silently degrades to normal pages.  Best
+ * effort: on failure the individual allocations simply stay on
+ * the regular heap.
+ *
+ * @param daemon daemon (options already parsed)
+ * @param size total bytes to reserve
+ */
+static void
+daemon_lifetime_arena_create_ (struct MHD_Daemon *daemon,
+                               size_t size)
+{
+#if defined(MAP_ANONYMOUS) || defined(MAP_ANON)
+  void *mem = MAP_FAILED;
+
+  size = (size + 4095) & ~((size_t) 4095);
+#ifdef MAP_HUGETLB
+  if (2 <= daemon->daemon_arena_mode)
+  {
+    const size_t huge_sz = (size + (2 * 1024 * 1024 - 1))
+                           & ~((size_t) (2 * 1024 * 1024 - 1));
+
+    mem = mmap (NULL,
+                huge_sz,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1,
+                0);
+    if (MAP_FAILED != mem)
+      size = huge_sz;
+  }
+#endif /* MAP_HUGETLB */
+  if (MAP_FAILED == mem)
+    mem = mmap (NULL,
+                size,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE |
+#ifdef MAP_ANONYMOUS
+                MAP_ANONYMOUS,
+#else  /* ! MAP_ANONYMOUS */
+                MAP_ANON,
+#endif /* ! MAP_ANONYMOUS */
+                -1,
+                0);
+  if (MAP_FAILED == mem)
+    return;
+  /* prefault: touch every page now, not on the first request */
+  memset (mem,
+          0,
+          size);
+  daemon->lifetime_arena = mem;
+  daemon->lifetime_arena_size = size;
+  daemon->lifetime_arena_pos = 0;
+#else  /* ! MAP_ANONYMOUS && ! MAP_ANON */
+  (void) daemon;
+  (void) size;
+#endif /* ! MAP_ANONYMOUS && ! MAP_ANON */
+}
+
+
+/**
+ * Carve @a size bytes (16-byte aligned) from the daemon-lifetime
+ * arena.
+ *
+ * @param daemon the daemon
+ * @param size bytes needed
+ * @return pointer into the arena,
+ *         NULL if the arena is disabled or full (caller falls
+ *         back to the heap)
+ */
+static void *
+daemon_lifetime_arena_carve_ (struct MHD_Daemon *daemon,
+                              size_t size)
+{
+  void *res;
+
+  if (NULL == daemon->lifetime_arena)
+    return NULL;
+  size = (size + 15) & ~((size_t) 15);
+  if (daemon->lifetime_arena_size - daemon->lifetime_arena_pos < size)
+    return NULL;
+  res = daemon->lifetime_arena + daemon->lifetime_arena_pos;
+  daemon->lifetime_arena_pos += size;
+  return res;
+}
+
+
+/**
+ * Check whether @a ptr lives in the daemon-lifetime arena (and
+ * hence must not be free()d individually).
+ *
+ * @param daemon the daemon
+ * @param ptr pointer to test
+ * @return true if @a ptr was carved from the arena
+ */
+static bool
+daemon_lifetime_arena_owns_ (const struct MHD_Daemon *daemon,
+                             const void *ptr)
+{
+  return (NULL != daemon->lifetime_arena) &&
+         ((const char *) ptr >= daemon->lifetime_arena) &&
+         ((const char *) ptr < daemon->lifetime_arena
+          + daemon->lifetime_arena_size);
+}
+
+
+/**
+ * Re-account a connection from the address it was accepted with to
+ * the real client address learned later (PROXY protocol): the new
+ * address is counted first (honoring the per-IP limit), then the
+ * old one is released.
+ *
+ * @param daemon daemon tracking the per-IP counts
+ * @param old_addr address currently accounted
+ * @param old_addrlen number of bytes in @a old_addr
+ * @param new_addr address to account instead
+ * @param new_addrlen number of bytes in @a new_addr
+ * @return #MHD_YES on success,
+ *         #MHD_NO if @a new_addr is over the per-IP limit
+ *         (accounting left unchanged)
+ */
+enum MHD_Result
+MHD_ip_limit_swap_ (struct MHD_Daemon *daemon,
+                    const struct sockaddr *old_addr,
+                    socklen_t old_addrlen,
+                    const struct sockaddr *new_addr,
+                    socklen_t new_addrlen)
+{
+  if (MHD_NO == MHD_ip_limit_add (daemon,
+                                  new_addr,
+                                  new_addrlen))
+    return MHD_NO;
+  MHD_ip_limit_del (daemon,
+                    old_addr,
+                    old_addrlen);
+  return MHD_YES;
 }
 
 
@@ -655,6 +1256,18 @@ MHD_init_daemon_certificate (struct MHD_Daemon *daemon)
 static int
 MHD_TLS_init (struct MHD_Daemon *daemon)
 {
+  if (0 != (daemon->options & MHD_USE_TLS_SESSION_TICKETS))
+  {
+    if (0 != gnutls_session_ticket_key_generate (&daemon->tls_ticket_key))
+    {
+#ifdef HAVE_MESSAGES
+      MHD_DLOG (daemon,
+                _ ("Failed to generate TLS session ticket key.\n"));
+#endif
+      daemon->tls_ticket_key.data = NULL;
+      daemon->tls_ticket_key.size = 0;
+    }
+  }
   switch (daemon->cred_type)
   {
   case GNUTLS_CRD_CERTIFICATE:
@@ -678,11 +1291,174 @@ MHD_TLS_init (struct MHD_Daemon *daemon)
 }
 
 
+/**
+ * Add an additional X.509 key/certificate pair for SNI-based
+ * selection; see microhttpd.h for the contract.
+ *
+ * @param daemon the (master) TLS daemon
+ * @param mem_key pointer to the PEM private key
+ * @param mem_cert pointer to the PEM certificate (chain)
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @ingroup specialized
+ */
+enum MHD_Result
+MHD_daemon_add_tls_certificate (struct MHD_Daemon *daemon,
+                                const char *mem_key,
+                                const char *mem_cert)
+{
+  gnutls_datum_t key;
+  gnutls_datum_t cert;
+  size_t key_len;
+  size_t cert_len;
+
+  if ( (NULL == daemon) ||
+       (NULL != daemon->master) ||
+       (0 == (daemon->options & MHD_USE_TLS)) ||
+       (0 != (daemon->options & MHD_USE_LAZY_TLS_INIT)) ||
+       (GNUTLS_CRD_CERTIFICATE != daemon->cred_type) ||
+       (NULL == daemon->x509_cred) ||
+       (NULL == mem_key) ||
+       (NULL == mem_cert) )
+    return MHD_NO;
+  key_len = strlen (mem_key);
+  cert_len = strlen (mem_cert);
+  if ( (UINT_MAX < key_len) ||
+       (UINT_MAX < cert_len) )
+    return MHD_NO;
+  key.data = (unsigned char *) mem_key;
+  key.size = (unsigned int) key_len;
+  cert.data = (unsigned char *) mem_cert;
+  cert.size = (unsigned int) cert_len;
+  if (0 > gnutls_certificate_set_x509_key_mem (daemon->x509_cred,
+                                               &cert,
+                                               &key,
+                                               GNUTLS_X509_FMT_PEM))
+    return MHD_NO;
+  return MHD_YES;
+}
+
+
+/**
+ * List node for credentials retired by a hot credential swap.
+ */
+struct MHD_RetiredTlsCred
+{
+  struct MHD_RetiredTlsCred *next;
+  gnutls_certificate_credentials_t cred;
+};
+
+
+/**
+ * Atomically replace the X.509 credentials used for new TLS
+ * handshakes; see microhttpd.h for the contract.
+ *
+ * @param daemon the (master) TLS daemon
+ * @param mem_key pointer to the PEM private key
+ * @param mem_cert pointer to the PEM certificate (chain)
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @ingroup specialized
+ */
+enum MHD_Result
+MHD_update_tls_credentials (struct MHD_Daemon *daemon,
+                            const char *mem_key,
+                            const char *mem_cert)
+{
+  gnutls_certificate_credentials_t new_cred;
+  gnutls_certificate_credentials_t old_cred;
+  const char *old_key;
+  const char *old_cert;
+  struct MHD_RetiredTlsCred *retired;
+
+  if ( (NULL == daemon) ||
+       (NULL != daemon->master) ||
+       (0 == (daemon->options & MHD_USE_TLS)) ||
+       (GNUTLS_CRD_CERTIFICATE != daemon->cred_type) ||
+       (NULL == mem_key) ||
+       (NULL == mem_cert) )
+    return MHD_NO;
+  retired = malloc (sizeof (struct MHD_RetiredTlsCred));
+  if (NULL == retired)
+    return MHD_NO;
+  if (0 != gnutls_certificate_allocate_credentials (&new_cred))
+  {
+    free (retired);
+    return MHD_NO;
+  }
+  /* Build the new credentials with the shared setup helper (keeps
+   * trust store, DH parameters and key-password handling in one
+   * place) by temporarily pointing the daemon at the new data. */
+  old_cred = daemon->x509_cred;
+  old_key = daemon->https_mem_key;
+  old_cert = daemon->https_mem_cert;
+  daemon->x509_cred = new_cred;
+  daemon->https_mem_key = mem_key;
+  daemon->https_mem_cert = mem_cert;
+  if (0 != MHD_init_daemon_certificate (daemon))
+  {
+    daemon->x509_cred = old_cred;
+    daemon->https_mem_key = old_key;
+    daemon->https_mem_cert = old_cert;
+    gnutls_certificate_free_credentials (new_cred);
+    free (retired);
+    return MHD_NO;
+  }
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  /* Publish the swap to pool workers (single pointer store each;
+   * a handshake racing with the store uses either generation,
+   * both of which stay valid). */
+  if (NULL != daemon->worker_pool)
+  {
+    unsigned int i;
+
+    for (i = 0; i < daemon->worker_pool_size; ++i)
+      daemon->worker_pool[i].x509_cred = new_cred;
+  }
+#endif
+  /* Keep the old generation alive for sessions still using it. */
+  retired->cred = old_cred;
+  retired->next = (struct MHD_RetiredTlsCred *) daemon->tls_retired_creds;
+  daemon->tls_retired_creds = retired;
+  return MHD_YES;
+}
+
+
 #endif /* HTTPS_SUPPORT */
 
+#ifndef HTTPS_SUPPORT
+/**
+ * Stub for builds without TLS support.
+ * @return always #MHD_NO
+ */
+enum MHD_Result
+MHD_update_tls_credentials (struct MHD_Daemon *daemon,
+                            const char *mem_key,
+                            const char *mem_cert)
+{
+  (void) daemon;
+  (void) mem_key;
+  (void) mem_cert;
+  return MHD_NO;
+}
+
+
+#endif /* ! HTTPS_SUPPORT */
+
+
 
 #undef MHD_get_fdset
 
+/**
+ * Note for external-event applications chasing O(active) instead of
+ * O(connections) per loop: that API already exists in the form of
+ * external-epoll mode.  Start the daemon with MHD_USE_EPOLL without
+ * an internal thread, obtain the single epoll FD via
+ * MHD_get_daemon_info(MHD_DAEMON_INFO_EPOLL_FD), register it in the
+ * application's own event loop and call MHD_run() when it fires:
+ * MHD maintains its fd interest incrementally in the kernel and the
+ * application never rebuilds per-connection fd_sets at all.  The
+ * fd_set-based entry points below remain inherently O(n) -- that is
+ * the data structure's contract, kept for select()-style callers.
+ */
 /**
  * Obtain the `select()` sets for this daemon.
  * Daemon's FDs will be added to fd_sets. To get only
@@ -990,6 +1766,16 @@ internal_get_fdset2 (struct MHD_Daemon *daemon,
                               max_fd,
                               fd_setsize)) )
     result = MHD_NO;
+  {
+    struct MHD_ExtraListener *exl;
+
+    for (exl = daemon->extra_listeners; NULL != exl; exl = exl->next)
+      if (! MHD_add_to_fd_set_ (exl->fd,
+                                read_fd_set,
+                                max_fd,
+                                fd_setsize))
+        result = MHD_NO;
+  }
 
   /* Add all sockets to 'except_fd_set' as well to watch for
    * out-of-band data. However, ignore errors if INFO_READ
@@ -1191,6 +1977,10 @@ call_handlers (struct MHD_Connection *con,
   /* Fast track flag */
   bool on_fasttrack = (con->state == MHD_CONNECTION_INIT);
 
+  /* new dispatch: a fresh work quantum */
+  con->turn_requests = 0;
+  con->quantum_blocked = false;
+
 #ifdef HTTPS_SUPPORT
   if (con->tls_read_ready)
     read_ready = true;
@@ -1321,6 +2111,14 @@ cleanup_upgraded_connection (struct MHD_Connection *connection)
  * @remark To be called only from thread that processes
  * connection's recv(), send() and response.
  *
+ * Note on zero-copy: kernel-side forwarding (splice()) is not
+ * applicable here.  This loop only exists for TLS connections,
+ * where every byte must pass through GnuTLS in userspace for
+ * record encryption/decryption; plaintext "upgraded" connections
+ * never reach this code as the raw socket is handed directly to
+ * the application.  Should the TLS stack gain kernel-TLS sessions
+ * for upgraded connections one day, this is the place to splice.
+ *
  * @param urh handle to process
  */
 static void
@@ -1853,7 +2651,7 @@ thread_main_handle_connection (void *data)
   MHD_socket maxsock;
   struct timeval tv;
   struct timeval *tvp;
-  time_t now;
+  uint64_t now;
 #if WINDOWS
 #ifdef HAVE_POLL
   int extra_slot;
@@ -1877,7 +2675,7 @@ thread_main_handle_connection (void *data)
   while ( (! daemon->shutdown) &&
           (MHD_CONNECTION_CLOSED != con->state) )
   {
-    const time_t timeout = daemon->connection_timeout;
+    const uint64_t timeout = daemon->connection_timeout_ms;
 #ifdef UPGRADE_SUPPORT
     struct MHD_UpgradeResponseHandle *const urh = con->urh;
 #else  /* ! UPGRADE_SUPPORT */
@@ -1943,7 +2741,7 @@ thread_main_handle_connection (void *data)
         }
       }
 #endif /* HAVE_POLL */
-      MHD_itc_clear_ (daemon->itc);
+      daemon_itc_clear_ (daemon);
       continue; /* Check again for resume. */
     }           /* End of "suspended" branch. */
 
@@ -1973,22 +2771,25 @@ thread_main_handle_connection (void *data)
     if ( (NULL == tvp) &&
          (timeout > 0) )
     {
-      now = MHD_monotonic_sec_counter ();
+      now = MHD_monotonic_msec_counter ();
       if (now - con->last_activity > timeout)
+      {
         tv.tv_sec = 0;
+        tv.tv_usec = 0;
+      }
       else
       {
-        const time_t seconds_left = timeout - (now - con->last_activity);
+        const uint64_t msec_left = timeout - (now - con->last_activity);
 #if ! defined(_WIN32) || defined(__CYGWIN__)
-        tv.tv_sec = seconds_left;
+        tv.tv_sec = (time_t) (msec_left / 1000);
 #else  /* _WIN32 && !__CYGWIN__ */
-        if (seconds_left > TIMEVAL_TV_SEC_MAX)
+        if (msec_left / 1000 > TIMEVAL_TV_SEC_MAX)
           tv.tv_sec = TIMEVAL_TV_SEC_MAX;
         else
-          tv.tv_sec = (_MHD_TIMEVAL_TV_SEC_TYPE) seconds_left;
+          tv.tv_sec = (_MHD_TIMEVAL_TV_SEC_TYPE) (msec_left / 1000);
 #endif /* _WIN32 && ! __CYGWIN__  */
+        tv.tv_usec = ((long) (msec_left % 1000)) * 1000;
       }
-      tv.tv_usec = 0;
       tvp = &tv;
     }
     if (! use_poll)
@@ -2071,7 +2872,7 @@ thread_main_handle_connection (void *data)
       if ( (MHD_ITC_IS_VALID_ (daemon->itc)) &&
            (FD_ISSET (MHD_itc_r_fd_ (daemon->itc),
                       &rs)) )
-        MHD_itc_clear_ (daemon->itc);
+        daemon_itc_clear_ (daemon);
 #endif
       if (MHD_NO ==
           call_handlers (con,
@@ -2122,7 +2923,9 @@ thread_main_handle_connection (void *data)
 #else
                          1,
 #endif
-                         (NULL == tvp) ? -1 : tv.tv_sec * 1000) < 0)
+                         (NULL == tvp)
+                         ? -1
+                         : (int) (tv.tv_sec * 1000 + tv.tv_usec / 1000)) < 0)
       {
         if (MHD_SCKT_LAST_ERR_IS_ (MHD_SCKT_EINTR_))
           continue;
@@ -2138,7 +2941,7 @@ thread_main_handle_connection (void *data)
        * signals will trigger poll() again */
       if ( (MHD_ITC_IS_VALID_ (daemon->itc)) &&
            (0 != (p[1].revents & (POLLERR | POLLHUP | POLLIN))) )
-        MHD_itc_clear_ (daemon->itc);
+        daemon_itc_clear_ (daemon);
 #endif
       if (MHD_NO ==
           call_handlers (con,
@@ -2206,7 +3009,7 @@ exit:
      * use more connections only after cleanup anyway. */
   }
   if ( (MHD_ITC_IS_VALID_ (daemon->itc)) &&
-       (! MHD_itc_activate_ (daemon->itc, "t")) )
+       (! daemon_itc_activate_ (daemon, "t")) )
   {
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
@@ -2218,9 +3021,139 @@ exit:
 }
 
 
+
+#if defined(MHD_USE_POSIX_THREADS)
+/**
+ * Park the calling handler thread in the daemon's thread cache
+ * and wait for the next connection hand-off.  Returns NULL when
+ * the thread should exit instead (shutdown, or the cache is
+ * already full).  While parked, the bulk of the thread's stack is
+ * returned to the kernel.
+ *
+ * @param daemon the thread-per-connection daemon
+ * @return next connection to handle, NULL to exit
+ */
+static struct MHD_Connection *
+thread_cache_park_ (struct MHD_Daemon *daemon)
+{
+  struct MHD_Connection *con = NULL;
+
+  MHD_mutex_lock_chk_ (&daemon->thread_cache_lock);
+  if ( (daemon->shutdown) ||
+       (daemon->thread_cache_parked >= daemon->thread_cache_size) )
+  {
+    MHD_mutex_unlock_chk_ (&daemon->thread_cache_lock);
+    return NULL;
+  }
+  daemon->thread_cache_parked++;
+#if defined(__linux__) && defined(MADV_DONTNEED)
+  {
+    /* Return the unused part of this thread's stack to the kernel
+       while parked: everything below the live frames is dead, so
+       dropping those (anonymous) pages is safe -- they re-fault
+       as zero pages if the next connection grows the stack again.
+       Keep a generous margin above the current in-use region. */
+    pthread_attr_t attr;
+
+    if (0 == pthread_getattr_np (pthread_self (),
+                                 &attr))
+    {
+      void *stk;
+      size_t stk_size;
+
+      if ( (0 == pthread_attr_getstack (&attr,
+                                        &stk,
+                                        &stk_size)) &&
+           (stk_size > 512 * 1024) )
+        (void) madvise (stk,
+                        stk_size - 256 * 1024,
+                        MADV_DONTNEED);
+      (void) pthread_attr_destroy (&attr);
+    }
+  }
+#endif /* __linux__ && MADV_DONTNEED */
+  while ( (NULL == daemon->thread_cache_assignment) &&
+          (! daemon->shutdown) )
+    pthread_cond_wait (&daemon->thread_cache_cond,
+                       &daemon->thread_cache_lock);
+  daemon->thread_cache_parked--;
+  if (! daemon->shutdown)
+  {
+    con = daemon->thread_cache_assignment;
+    daemon->thread_cache_assignment = NULL;
+  }
+  MHD_mutex_unlock_chk_ (&daemon->thread_cache_lock);
+  return con;
+}
+
+
+/**
+ * Thread entry for cache-managed handler threads: serve the
+ * initial connection, then keep picking up hand-offs until the
+ * cache is full or the daemon shuts down.  Threads run detached;
+ * the live counter lets MHD_stop_daemon() wait for them.
+ *
+ * @param data the first connection to handle
+ * @return always 0
+ */
+static MHD_THRD_RTRN_TYPE_ MHD_THRD_CALL_SPEC_
+thread_main_cached_connection (void *data)
+{
+  struct MHD_Connection *con = data;
+  struct MHD_Daemon *daemon = con->daemon;
+
+  do
+  {
+    (void) thread_main_handle_connection (con);
+  }
+  while (NULL != (con = thread_cache_park_ (daemon)));
+  MHD_mutex_lock_chk_ (&daemon->thread_cache_lock);
+  daemon->thread_cache_live--;
+  pthread_cond_broadcast (&daemon->thread_cache_cond);
+  MHD_mutex_unlock_chk_ (&daemon->thread_cache_lock);
+  return (MHD_THRD_RTRN_TYPE_) 0;
+}
+
+
+#endif /* MHD_USE_POSIX_THREADS */
+
+
 #endif
 
 
+/**
+ * Account the CPU span of the just-finished processing pass and
+ * update the daemon's overload state: a pass longer than the
+ * configured budget enters overload, a pass shorter than half the
+ * budget leaves it (hysteresis).  No-op unless
+ * #MHD_OPTION_LOOP_BUDGET_MS was set.
+ *
+ * @param daemon daemon to account for
+ * @param now_ms current monotonic milliseconds (pass start)
+ */
+static void
+daemon_overload_eval_ (struct MHD_Daemon *daemon,
+                       uint64_t now_ms)
+{
+  uint64_t work;
+
+  (void) now_ms; /* only sampled values are compared */
+  if (0 == daemon->loop_budget_ms)
+    return;
+  if ( (! daemon->loop_ms_valid) ||
+       (0 == daemon->loop_work_end_ms) ||
+       (daemon->loop_work_end_ms < daemon->loop_ms) )
+    return; /* no completed pass measured yet */
+  work = daemon->loop_work_end_ms - daemon->loop_ms;
+  if (work > daemon->loop_budget_ms)
+    daemon->overloaded = true;
+  else if (2 * work <= daemon->loop_budget_ms)
+    daemon->overloaded = false;
+  daemon->shed_accept_off = (daemon->overloaded &&
+                             (1 == daemon->shed_mode));
+}
+
+
 /**
  * Free resources associated with all closed connections.
  * (destroy responses, free buffers, etc.).  All closed
@@ -2337,12 +3270,165 @@ psk_gnutls_adapter (gnutls_session_t session,
   MHD_DLOG (daemon,
             _ ("PSK not supported by this server.\n"));
 #endif
-  return -1;
+  return -1;
+#endif
+}
+
+
+#endif /* HTTPS_SUPPORT */
+
+
+#ifdef HTTPS_SUPPORT
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+#ifdef MHD_MUTEX_STATIC_DEFN_INIT_
+/**
+ * Lock serializing lazily-deferred TLS initialization.
+ */
+MHD_MUTEX_STATIC_DEFN_INIT_ (tls_lazy_lock_);
+#endif /* MHD_MUTEX_STATIC_DEFN_INIT_ */
+#endif
+
+/**
+ * Construct the daemon's TLS state on first use (priority cache,
+ * credentials, ticket key) when #MHD_USE_LAZY_TLS_INIT deferred it,
+ * and refresh the calling worker's copies of the master's TLS
+ * pointers.
+ *
+ * @param daemon the (worker) daemon accepting a TLS connection
+ * @return #MHD_YES when TLS state is ready
+ */
+static enum MHD_Result
+ensure_tls_ready_ (struct MHD_Daemon *daemon)
+{
+  struct MHD_Daemon *const master = MHD_get_master (daemon);
+
+  if (0 == (master->options & MHD_USE_LAZY_TLS_INIT))
+    return MHD_YES;
+  if (! master->tls_lazy_ready)
+  {
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+#ifdef MHD_MUTEX_STATIC_DEFN_INIT_
+    MHD_mutex_lock_chk_ (&tls_lazy_lock_);
+#endif
+#endif
+    if (! master->tls_lazy_ready)
+    {
+      if ( (0 == gnutls_priority_init (&master->priority_cache,
+                                       "NORMAL",
+                                       NULL)) &&
+           (0 == MHD_TLS_init (master)) )
+        master->tls_lazy_ready = true;
+#ifdef HAVE_MESSAGES
+      else
+        MHD_DLOG (master,
+                  _ ("Deferred TLS initialization failed.\n"));
+#endif
+    }
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+#ifdef MHD_MUTEX_STATIC_DEFN_INIT_
+    MHD_mutex_unlock_chk_ (&tls_lazy_lock_);
+#endif
+#endif
+  }
+  if (! master->tls_lazy_ready)
+    return MHD_NO;
+  /* refresh this worker's copies */
+  daemon->priority_cache = master->priority_cache;
+  daemon->x509_cred = master->x509_cred;
+  daemon->psk_cred = master->psk_cred;
+  return MHD_YES;
+}
+
+
+#endif /* HTTPS_SUPPORT */
+
+
+/**
+ * Get a zeroed-out connection object, either from the daemon's
+ * recycle list (in which case the object comes with the memory pool
+ * of an earlier connection already allocated) or freshly allocated.
+ * @sa #MHD_OPTION_CONNECTION_RECYCLE_LIMIT
+ *
+ * @param daemon daemon that will manage the connection
+ * @return the connection object, NULL on allocation failure
+ */
+static struct MHD_Connection *
+connection_alloc_ (struct MHD_Daemon *daemon)
+{
+  struct MHD_Connection *connection;
+  struct MemoryPool *pool;
+
+  if (0 != daemon->connection_recycle_limit)
+  {
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+#endif
+    connection = daemon->recycled_connections_head;
+    if (NULL != connection)
+    {
+      daemon->recycled_connections_head = connection->next;
+      daemon->recycled_connections_count--;
+    }
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 #endif
+    if (NULL != connection)
+    {
+      pool = connection->pool;
+      memset (connection,
+              0,
+              sizeof (struct MHD_Connection));
+      connection->pool = pool;
+      return connection;
+    }
+  }
+  return MHD_calloc_ (1, sizeof (struct MHD_Connection));
 }
 
 
-#endif /* HTTPS_SUPPORT */
+/**
+ * Release a connection object: keep it (with its memory pool) on the
+ * daemon's recycle list if #MHD_OPTION_CONNECTION_RECYCLE_LIMIT
+ * allows, otherwise destroy the pool (if any) and free the object.
+ * Must not be called while the cleanup mutex is held.
+ *
+ * @param daemon daemon that managed the connection
+ * @param connection the connection object to release
+ */
+static void
+connection_release_ (struct MHD_Daemon *daemon,
+                     struct MHD_Connection *connection)
+{
+  if ( (0 != daemon->connection_recycle_limit) &&
+       (NULL != connection->pool) )
+  {
+    bool recycled = false;
+
+    /* Make the pool ready for the next request before parking it. */
+    (void) MHD_pool_reset (connection->pool,
+                           NULL,
+                           0,
+                           0);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+#endif
+    if (daemon->recycled_connections_count < daemon->connection_recycle_limit)
+    {
+      connection->next = daemon->recycled_connections_head;
+      daemon->recycled_connections_head = connection;
+      daemon->recycled_connections_count++;
+      recycled = true;
+    }
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+#endif
+    if (recycled)
+      return;
+  }
+  if (NULL != connection->pool)
+    MHD_pool_destroy (connection->pool);
+  free (connection);
+}
 
 
 /**
@@ -2373,6 +3459,7 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
                          socklen_t addrlen,
                          bool external_add,
                          bool non_blck,
+                         struct MHD_ExtraListener *listener,
                          struct MHD_Connection **pconnection)
 {
   struct MHD_Connection *connection;
@@ -2423,8 +3510,10 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     return MHD_NO;
   }
 
-  /* apply connection acceptance policy if present */
-  if ( (NULL != daemon->apc) &&
+  /* apply connection acceptance policy if present; internally
+     accepted sockets were already screened right after accept() */
+  if ( (external_add) &&
+       (NULL != daemon->apc) &&
        (MHD_NO == daemon->apc (daemon->apc_cls,
                                addr,
                                addrlen)) )
@@ -2445,7 +3534,7 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     return MHD_NO;
   }
 
-  if (NULL == (connection = MHD_calloc_ (1, sizeof (struct MHD_Connection))))
+  if (NULL == (connection = connection_alloc_ (daemon)))
   {
     eno = errno;
 #ifdef HAVE_MESSAGES
@@ -2467,8 +3556,13 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     connection->sk_corked = _MHD_UNKNOWN;
 
   /* We will use TCP_CORK or TCP_NOPUSH or MSG_MORE to control
-     transmission, disable Nagle's algorithm (always) */
-  if (0 != MHD_socket_set_nodelay_ (client_socket, true))
+     transmission, disable Nagle's algorithm (always).  Internally
+     accepted sockets inherited TCP_NODELAY from the listener on
+     Linux; only externally added sockets still need the call. */
+  if ( (! external_add) &&
+       (daemon->listen_nodelay) )
+    connection->sk_nodelay = _MHD_ON;
+  else if (0 != MHD_socket_set_nodelay_ (client_socket, true))
   {
     if (EOPNOTSUPP != MHD_socket_get_error_ ())
     {
@@ -2489,7 +3583,28 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     connection->sk_nodelay = _MHD_UNKNOWN;
 #endif /* !MHD_TCP_CORK_NOPUSH && !MHD_USE_MSG_MORE */
 
-  connection->connection_timeout = daemon->connection_timeout;
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+  if (0 != (daemon->options & MHD_USE_ZEROCOPY_SEND))
+  {
+    static const MHD_SCKT_OPT_BOOL_ zc_on = 1;
+
+    /* Best effort: without SO_ZEROCOPY the plain copying send()
+     * path is used for this connection. */
+    if (0 == setsockopt (client_socket,
+                         SOL_SOCKET,
+                         SO_ZEROCOPY,
+                         (const void *) &zc_on,
+                         sizeof (zc_on)))
+      connection->sk_zerocopy = true;
+  }
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+  connection->connection_timeout_ms = daemon->connection_timeout_ms;
+  connection->pace_rate = daemon->default_pace_rate;
+  connection->spool_fd = -1;
+  connection->shed_503 = (daemon->overloaded &&
+                          (2 == daemon->shed_mode));
+  connection->proxy_proto_pending = daemon->proxy_protocol;
+  connection->listener = listener;
   if (NULL == (connection->addr = malloc (addrlen)))
   {
     eno = errno;
@@ -2502,7 +3617,8 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     MHD_ip_limit_del (daemon,
                       addr,
                       addrlen);
-    free (connection);
+    connection_release_ (daemon,
+                         connection);
     errno = eno;
     return MHD_NO;
   }
@@ -2513,11 +3629,14 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
   connection->socket_fd = client_socket;
   connection->sk_nonblck = non_blck;
   connection->daemon = daemon;
-  connection->last_activity = MHD_monotonic_sec_counter ();
+  connection->last_activity = MHD_monotonic_msec_counter ();
 
-  if (0 == (daemon->options & MHD_USE_TLS))
+  if ( (0 == (daemon->options & MHD_USE_TLS)) ||
+       ( (NULL != listener) &&
+         (listener->no_tls) ) )
   {
-    /* set default connection handlers  */
+    /* set default connection handlers (including for plaintext
+       extra listeners on a TLS daemon) */
     MHD_set_http_callbacks_ (connection);
   }
   else
@@ -2530,6 +3649,20 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
 #endif
     flags;
 
+    if (MHD_NO == ensure_tls_ready_ (daemon))
+    {
+      MHD_socket_close_chk_ (client_socket);
+      MHD_ip_limit_del (daemon,
+                        addr,
+                        addrlen);
+      free (connection->addr);
+      connection_release_ (daemon,
+                           connection);
+#if EPROTO
+      errno = EPROTO;
+#endif
+      return MHD_NO;
+    }
     flags = GNUTLS_SERVER;
 #if (GNUTLS_VERSION_NUMBER + 0 >= 0x030402)
     flags |= GNUTLS_NO_SIGNAL;
@@ -2549,7 +3682,12 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     MHD_set_https_callbacks (connection);
     if ((GNUTLS_E_SUCCESS != gnutls_init (&connection->tls_session, flags)) ||
         (GNUTLS_E_SUCCESS != gnutls_priority_set (connection->tls_session,
-                                                  daemon->priority_cache)))
+                                                  daemon->priority_cache)) ||
+        ( (NULL != MHD_get_master (daemon)->tls_ticket_key.data) &&
+          (GNUTLS_E_SUCCESS !=
+           gnutls_session_ticket_enable_server (connection->tls_session,
+                                                &MHD_get_master (daemon)->
+                                                tls_ticket_key)) ))
     {
       if (NULL != connection->tls_session)
         gnutls_deinit (connection->tls_session);
@@ -2558,7 +3696,8 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
                         addr,
                         addrlen);
       free (connection->addr);
-      free (connection);
+      connection_release_ (daemon,
+                           connection);
 #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
                 _ ("Failed to initialise TLS session.\n"));
@@ -2570,6 +3709,23 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
     }
     gnutls_session_set_ptr (connection->tls_session,
                             connection);
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+    {
+      /* Advertise the protocols this server actually implements
+         via ALPN, so h2-capable clients negotiate HTTP/1.1
+         cleanly instead of failing or guessing.  This is also the
+         hook where native HTTP/2 would slot in once implemented:
+         add "h2" here and branch the connection's state machine
+         on gnutls_alpn_get_selected_protocol(). */
+      static const gnutls_datum_t alpn_http11
+        = { (unsigned char *) "http/1.1", 8 };
+
+      (void) gnutls_alpn_set_protocols (connection->tls_session,
+                                        &alpn_http11,
+                                        1,
+                                        0);
+    }
+#endif /* GNUTLS >= 3.2.0 */
     switch (daemon->cred_type)
     {
     /* set needed credentials for certificate authentication. */
@@ -2625,7 +3781,8 @@ new_connection_prepare_ (struct MHD_Daemon *daemon,
                       addr,
                       addrlen);
     free (connection->addr);
-    free (connection);
+    connection_release_ (daemon,
+                         connection);
     MHD_PANIC (_ ("TLS connection on non-TLS daemon.\n"));
     eno = EINVAL;
     return MHD_NO;
@@ -2666,7 +3823,8 @@ new_connection_close_ (struct MHD_Daemon *daemon,
                     connection->addr,
                     connection->addr_len);
   free (connection->addr);
-  free (connection);
+  connection_release_ (daemon,
+                       connection);
 }
 
 
@@ -2696,8 +3854,17 @@ new_connection_process_ (struct MHD_Daemon *daemon,
   /* Allocate memory pool in the processing thread so
    * intensively used memory area is allocated in "good"
    * (for the thread) memory region. It is important with
-   * NUMA and/or complex cache hierarchy. */
-  connection->pool = MHD_pool_create (daemon->pool_size);
+   * NUMA and/or complex cache hierarchy.
+   * Recycled connections arrive with their previous pool. */
+  if (NULL == connection->pool)
+  {
+    if ( (0 != daemon->pool_arena_slots) &&
+         (NULL == daemon->pool_arena) )
+      daemon->pool_arena = MHD_pool_arena_create_ (daemon->pool_size,
+                                                   daemon->pool_arena_slots);
+    connection->pool = MHD_pool_create_from_arena_ (daemon->pool_arena,
+                                                    daemon->pool_size);
+  }
   if (NULL == connection->pool)
   {
 #ifdef HAVE_MESSAGES
@@ -2709,7 +3876,9 @@ new_connection_process_ (struct MHD_Daemon *daemon,
     MHD_ip_limit_del (daemon,
                       connection->addr,
                       connection->addr_len);
-    free (connection);
+    free (connection->addr);
+    connection_release_ (daemon,
+                         connection);
 #if ENOMEM
     errno = ENOMEM;
 #endif
@@ -2737,6 +3906,8 @@ new_connection_process_ (struct MHD_Daemon *daemon,
     goto cleanup;
   }
   daemon->connections++;
+  MHD_statcnt_inc_ (&daemon->stat_accepts);
+  MHD_PROBE_2 (accept, connection, connection->socket_fd);
   if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
   {
     XDLL_insert (daemon->normal_timeout_head,
@@ -2758,6 +3929,47 @@ new_connection_process_ (struct MHD_Daemon *daemon,
   /* attempt to create handler thread */
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
   {
+#if defined(MHD_USE_POSIX_THREADS)
+    if (0 != daemon->thread_cache_size)
+    {
+      bool handed_off = false;
+
+      /* cache-managed threads are detached and never joined per
+         connection; MHD_stop_daemon() waits on the live counter */
+      connection->thread_joined = true;
+      MHD_mutex_lock_chk_ (&daemon->thread_cache_lock);
+      if ( (0 != daemon->thread_cache_parked) &&
+           (NULL == daemon->thread_cache_assignment) )
+      {
+        daemon->thread_cache_assignment = connection;
+        pthread_cond_signal (&daemon->thread_cache_cond);
+        handed_off = true;
+      }
+      MHD_mutex_unlock_chk_ (&daemon->thread_cache_lock);
+      if (! handed_off)
+      {
+        if (! MHD_create_named_thread_ (&connection->pid,
+                                        "MHD-connection",
+                                        daemon->thread_stack_size,
+                                        &thread_main_cached_connection,
+                                        connection))
+        {
+          eno = errno;
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    "Failed to create a thread: %s\n",
+                    MHD_strerror_ (eno));
+#endif
+          goto cleanup;
+        }
+        (void) pthread_detach (connection->pid.handle);
+        MHD_mutex_lock_chk_ (&daemon->thread_cache_lock);
+        daemon->thread_cache_live++;
+        MHD_mutex_unlock_chk_ (&daemon->thread_cache_lock);
+      }
+    }
+    else
+#endif /* MHD_USE_POSIX_THREADS */
     if (! MHD_create_named_thread_ (&connection->pid,
                                     "MHD-connection",
                                     daemon->thread_stack_size,
@@ -2843,9 +4055,9 @@ cleanup:
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 #endif
-  MHD_pool_destroy (connection->pool);
   free (connection->addr);
-  free (connection);
+  connection_release_ (daemon,
+                       connection);
   if (0 != eno)
     errno = eno;
   else
@@ -2866,6 +4078,9 @@ cleanup:
  * this call and must no longer be used directly by the application
  * afterwards.
  *
+ * See the note on batching at #MHD_add_connection(): looping this
+ * per accepted socket is the intended batch interface.
+ *
  * @param daemon daemon that manages the connection
  * @param client_socket socket to manage (MHD will expect
  *        to receive an HTTP request from this socket next).
@@ -2874,6 +4089,8 @@ cleanup:
  * @param external_add perform additional operations needed due
  *        to the application calling us directly
  * @param non_blck indicate that socket in non-blocking mode
+ * @param listener extra listener the socket was accepted on,
+ *        NULL for the primary listen socket
  * @return #MHD_YES on success, #MHD_NO if this daemon could
  *        not handle the connection (i.e. malloc failed, etc).
  *        The socket will be closed in any case; 'errno' is
@@ -2885,7 +4102,8 @@ internal_add_connection (struct MHD_Daemon *daemon,
                          const struct sockaddr *addr,
                          socklen_t addrlen,
                          bool external_add,
-                         bool non_blck)
+                         bool non_blck,
+                         struct MHD_ExtraListener *listener)
 {
   struct MHD_Connection *connection;
 
@@ -2926,7 +4144,8 @@ internal_add_connection (struct MHD_Daemon *daemon,
   }
 
   if (MHD_NO == new_connection_prepare_ (daemon, client_socket, addr, addrlen,
-                                         external_add, non_blck, &connection))
+                                         external_add, non_blck, listener,
+                                         &connection))
     return MHD_NO;
 
   if ((external_add) &&
@@ -2943,7 +4162,7 @@ internal_add_connection (struct MHD_Daemon *daemon,
     /* The rest of connection processing must be handled in
      * the daemon thread. */
     if ((MHD_ITC_IS_VALID_ (daemon->itc)) &&
-        (! MHD_itc_activate_ (daemon->itc, "n")))
+        (! daemon_itc_activate_ (daemon, "n")))
     {
  #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
@@ -3032,7 +4251,7 @@ internal_suspend_connection_ (struct MHD_Connection *connection)
   }
   if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
   {
-    if (connection->connection_timeout == daemon->connection_timeout)
+    if (connection->connection_timeout_ms == daemon->connection_timeout_ms)
       XDLL_remove (daemon->normal_timeout_head,
                    daemon->normal_timeout_tail,
                    connection);
@@ -3156,11 +4375,17 @@ MHD_resume_connection (struct MHD_Connection *connection)
 #endif
   connection->resuming = true;
   daemon->resuming = true;
+  if (! connection->in_resume_list)
+  {
+    connection->next_resume = daemon->resume_list_head;
+    daemon->resume_list_head = connection;
+    connection->in_resume_list = true;
+  }
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 #endif
   if ( (MHD_ITC_IS_VALID_ (daemon->itc)) &&
-       (! MHD_itc_activate_ (daemon->itc, "r")) )
+       (! daemon_itc_activate_ (daemon, "r")) )
   {
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
@@ -3201,23 +4426,58 @@ resume_suspended_connections (struct MHD_Daemon *daemon)
 
   if (daemon->resuming)
   {
-    prev = daemon->suspended_connections_tail;
-    /* During shutdown check for resuming is forced. */
-    mhd_assert ((NULL != prev) || (daemon->shutdown) || \
-                (0 != (daemon->options & MHD_ALLOW_UPGRADE)));
+    if (daemon->shutdown)
+    {
+      /* During shutdown the check for resuming is forced and must
+       * cover the whole suspended list (shutdown marks
+       * connections as resuming without queueing each of them);
+       * drop the queue links so no stale pointers survive. */
+      while (NULL != daemon->resume_list_head)
+      {
+        daemon->resume_list_head->in_resume_list = false;
+        daemon->resume_list_head = daemon->resume_list_head->next_resume;
+      }
+      prev = daemon->suspended_connections_tail;
+    }
+    else
+    {
+      /* Normal operation: only visit connections whose resume was
+       * actually requested. */
+      prev = NULL;
+    }
+    mhd_assert ((NULL != prev) || (! daemon->shutdown) || \
+                (0 != (daemon->options & MHD_ALLOW_UPGRADE)) || \
+                (NULL == daemon->suspended_connections_tail));
   }
 
   daemon->resuming = false;
 
-  while (NULL != (pos = prev))
+  while (1)
   {
 #ifdef UPGRADE_SUPPORT
-    struct MHD_UpgradeResponseHandle *const urh = pos->urh;
+    struct MHD_UpgradeResponseHandle *urh;
 #else  /* ! UPGRADE_SUPPORT */
     static const void *const urh = NULL;
 #endif /* ! UPGRADE_SUPPORT */
-    prev = pos->prev;
-    if ( (! pos->resuming)
+    if (NULL != prev)
+    {
+      pos = prev;
+      prev = pos->prev;
+    }
+    else if (NULL != daemon->resume_list_head)
+    {
+      pos = daemon->resume_list_head;
+      daemon->resume_list_head = pos->next_resume;
+      pos->in_resume_list = false;
+    }
+    else
+      break;
+#ifdef UPGRADE_SUPPORT
+    urh = pos->urh;
+#endif /* UPGRADE_SUPPORT */
+    if ( (! pos->resuming) ||
+         (! pos->suspended)   /* resume requested before suspend
+                                 completed; next round picks it up */
 #ifdef UPGRADE_SUPPORT
          || ( (NULL != urh) &&
               ( (! urh->was_closed) ||
@@ -3239,10 +4499,10 @@ resume_suspended_connections (struct MHD_Daemon *daemon)
       if (! used_thr_p_c)
       {
         /* Reset timeout timer on resume. */
-        if (0 != pos->connection_timeout)
-          pos->last_activity = MHD_monotonic_sec_counter ();
+        if (0 != pos->connection_timeout_ms)
+          pos->last_activity = MHD_monotonic_msec_counter ();
 
-        if (pos->connection_timeout == daemon->connection_timeout)
+        if (pos->connection_timeout_ms == daemon->connection_timeout_ms)
           XDLL_insert (daemon->normal_timeout_head,
                        daemon->normal_timeout_tail,
                        pos);
@@ -3299,8 +4559,8 @@ resume_suspended_connections (struct MHD_Daemon *daemon)
   if ( (used_thr_p_c) &&
        (MHD_NO != ret) )
   {   /* Wake up suspended connections. */
-    if (! MHD_itc_activate_ (daemon->itc,
-                             "w"))
+    if (! daemon_itc_activate_ (daemon,
+                                "w"))
     {
 #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
@@ -3329,6 +4589,16 @@ resume_suspended_connections (struct MHD_Daemon *daemon)
  * this call and must no longer be used directly by the application
  * afterwards.
  *
+ * Note on batching: callers injecting accepted sockets in batches
+ * (SCM_RIGHTS bundles from an L4 balancer) can simply loop over
+ * this function; the historical per-call cost this used to imply is
+ * gone, as inter-thread wakeups are coalesced (only the first
+ * activation between two event-loop wakeups performs a write) and
+ * the per-call work that remains -- socket options, connection
+ * object, pool -- is inherently per connection.  The listening
+ * side of the batch is amortized by the worker loop, which
+ * processes the whole new-connections list in one pass.
+ *
  * @param daemon daemon that manages the connection
  * @param client_socket socket to manage (MHD will expect
  *        to receive an HTTP request from this socket next).
@@ -3397,37 +4667,382 @@ MHD_add_connection (struct MHD_Daemon *daemon,
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   if (NULL != daemon->worker_pool)
   {
-    unsigned int i;
-    /* have a pool, try to find a pool with capacity; we use the
-       socket as the initial offset into the pool for load
-       balancing */
-    for (i = 0; i < daemon->worker_pool_size; ++i)
+    unsigned int i;
+    struct MHD_Daemon *best = NULL;
+
+    /* have a pool: pick the least-loaded worker with capacity, so
+       a worker stuck behind slow handlers does not keep collecting
+       new connections while its siblings idle.  (Once a connection
+       has joined a worker it stays there: cleanup lists, timeout
+       DLLs, the epoll set and TLS sessions are all owned by that
+       worker's thread, so migrating live connections between
+       workers is not possible with these invariants.) */
+    for (i = 0; i < daemon->worker_pool_size; ++i)
+    {
+      struct MHD_Daemon *const worker = &daemon->worker_pool[i];
+
+      if (worker->connections >= worker->connection_limit)
+        continue;
+      if ( (NULL == best) ||
+           (worker->connections < best->connections) )
+        best = worker;
+    }
+    if (NULL != best)
+      return internal_add_connection (best,
+                                      client_socket,
+                                      addr,
+                                      addrlen,
+                                      true,
+                                      sk_nonbl,
+                                      NULL);
+    /* all pools are at their connection limit, must refuse */
+    MHD_socket_close_chk_ (client_socket);
+#if ENFILE
+    errno = ENFILE;
+#endif
+    return MHD_NO;
+  }
+#endif /* MHD_USE_POSIX_THREADS || MHD_USE_W32_THREADS */
+
+  return internal_add_connection (daemon,
+                                  client_socket,
+                                  addr,
+                                  addrlen,
+                                  true,
+                                  sk_nonbl,
+                                  NULL);
+}
+
+
+/**
+ * Post a memory trim to every worker and wake the loops; see the
+ * public documentation in microhttpd.h.
+ *
+ * @param daemon the (master) daemon to trim
+ * @param level shedding aggressiveness, 1 to 3
+ * @return #MHD_YES if posted
+ */
+enum MHD_Result
+MHD_daemon_trim_memory (struct MHD_Daemon *daemon,
+                        unsigned int level)
+{
+  if ( (NULL == daemon) ||
+       (0 == level) )
+    return MHD_NO;
+  if (NULL != daemon->master)
+    daemon = daemon->master;
+  if (NULL != daemon->worker_pool)
+  {
+    unsigned int i;
+
+    for (i = 0; i < daemon->worker_pool_size; i++)
+    {
+      daemon->worker_pool[i].trim_pending = level;
+      (void) daemon_itc_activate_ (&daemon->worker_pool[i],
+                                   "m");
+    }
+    return MHD_YES;
+  }
+  daemon->trim_pending = level;
+  (void) daemon_itc_activate_ (daemon,
+                               "m");
+  return MHD_YES;
+}
+
+
+/**
+ * Apply one hot-reloadable tunable to a single daemon object.
+ *
+ * @param d the daemon (master or worker) to update
+ * @param option which tunable
+ * @param value the new value
+ * @return #MHD_YES if the option is in the safe subset
+ */
+static enum MHD_Result
+daemon_apply_option_ (struct MHD_Daemon *d,
+                      enum MHD_OPTION option,
+                      uint64_t value)
+{
+  switch (option)
+  {
+  case MHD_OPTION_CONNECTION_TIMEOUT:
+    d->connection_timeout_ms = (uint64_t) value * 1000;
+    return MHD_YES;
+  case MHD_OPTION_CONNECTION_TIMEOUT_MS:
+    d->connection_timeout_ms = value;
+    return MHD_YES;
+  case MHD_OPTION_CONNECTION_LIMIT:
+    d->connection_limit = (unsigned int) value;
+    return MHD_YES;
+  case MHD_OPTION_PER_IP_CONNECTION_LIMIT:
+    d->per_ip_connection_limit = (unsigned int) value;
+    return MHD_YES;
+  case MHD_OPTION_ACCEPT_BURST_SIZE:
+    d->accept_burst_size = (0 != value) ? (unsigned int) value : 1;
+    return MHD_YES;
+  case MHD_OPTION_RESPONSE_RATE_LIMIT:
+    if ( (0 != value) &&
+         (0 != (d->options & MHD_USE_THREAD_PER_CONNECTION)) )
+      return MHD_NO; /* no pacing without an owning event loop */
+    d->default_pace_rate = value;
+    return MHD_YES;
+  case MHD_OPTION_LOOP_BUDGET_MS:
+    d->loop_budget_ms = (unsigned int) value;
+    return MHD_YES;
+  case MHD_OPTION_OVERLOAD_SHED_MODE:
+    d->shed_mode = (unsigned int) value;
+    return MHD_YES;
+  case MHD_OPTION_BUSY_POLL_US:
+    d->busy_poll_us = (unsigned int) value;
+    return MHD_YES;
+  default:
+    return MHD_NO;
+  }
+}
+
+
+/**
+ * Hot-reload one tunable of a running daemon; see the public
+ * documentation in microhttpd.h.
+ *
+ * @param daemon the (master) daemon to tune
+ * @param option which tunable to change
+ * @param value the new value
+ * @return #MHD_YES on success, #MHD_NO for unsupported options
+ */
+enum MHD_Result
+MHD_daemon_set_option (struct MHD_Daemon *daemon,
+                       enum MHD_OPTION option,
+                       uint64_t value)
+{
+  if (NULL == daemon)
+    return MHD_NO;
+  if (NULL != daemon->master)
+    daemon = daemon->master;
+  if (MHD_NO == daemon_apply_option_ (daemon,
+                                      option,
+                                      value))
+    return MHD_NO;
+  if (NULL != daemon->worker_pool)
+  {
+    unsigned int i;
+
+    for (i = 0; i < daemon->worker_pool_size; i++)
+      (void) daemon_apply_option_ (&daemon->worker_pool[i],
+                                   option,
+                                   value);
+  }
+  return MHD_YES;
+}
+
+
+static enum MHD_Result
+daemon_attach_listener_fd_ (struct MHD_Daemon *daemon,
+                            MHD_socket sk,
+                            MHD_AccessHandlerCallback handler,
+                            void *handler_cls,
+                            unsigned int flags);
+
+
+#ifdef EPOLL_SUPPORT
+static int
+epoll_register_listener_ (struct MHD_Daemon *daemon,
+                          MHD_socket ls);
+
+#endif /* EPOLL_SUPPORT */
+
+
+/**
+ * Attach an additional listening socket to a running daemon; see
+ * the public documentation in microhttpd.h.
+ *
+ * @param daemon daemon to attach the listener to (master)
+ * @param port TCP port to bind (same address family and wildcard
+ *        address as the primary listener)
+ * @param handler handler for requests on this listener,
+ *        NULL to use the daemon's default handler
+ * @param handler_cls closure for @a handler
+ * @param flags bitmask of MHD_EXTRA_LISTENER_* flags
+ * @return #MHD_YES on success
+ */
+enum MHD_Result
+MHD_daemon_add_listener (struct MHD_Daemon *daemon,
+                         uint16_t port,
+                         MHD_AccessHandlerCallback handler,
+                         void *handler_cls,
+                         unsigned int flags)
+{
+  struct sockaddr_storage srvaddr;
+  socklen_t addrlen;
+  int family;
+  MHD_socket sk;
+  static const MHD_SCKT_OPT_BOOL_ on = 1;
+
+  if ( (NULL == daemon) ||
+       (NULL != daemon->master) ||
+       (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) )
+    return MHD_NO;
+  memset (&srvaddr,
+          0,
+          sizeof (srvaddr));
+  family = AF_INET;
+  addrlen = sizeof (struct sockaddr_in);
+  if (MHD_INVALID_SOCKET != daemon->listen_fd)
+  {
+    socklen_t sa_len = sizeof (srvaddr);
+
+    if (0 == getsockname (daemon->listen_fd,
+                          (struct sockaddr *) &srvaddr,
+                          &sa_len))
+    {
+      family = (int) srvaddr.ss_family;
+      addrlen = sa_len;
+    }
+  }
+  memset (&srvaddr,
+          0,
+          sizeof (srvaddr));
+  if (AF_INET == family)
+  {
+    struct sockaddr_in *sin = (struct sockaddr_in *) &srvaddr;
+
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons (port);
+    addrlen = sizeof (struct sockaddr_in);
+  }
+#if HAVE_INET6
+  else if (AF_INET6 == family)
+  {
+    struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &srvaddr;
+
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = htons (port);
+    addrlen = sizeof (struct sockaddr_in6);
+  }
+#endif /* HAVE_INET6 */
+  else
+    return MHD_NO;
+  sk = MHD_socket_create_listen_ (family);
+  if (MHD_INVALID_SOCKET == sk)
+    return MHD_NO;
+  (void) setsockopt (sk,
+                     SOL_SOCKET,
+                     SO_REUSEADDR,
+                     (const void *) &on,
+                     sizeof (on));
+  if ( (0 != bind (sk,
+                   (const struct sockaddr *) &srvaddr,
+                   addrlen)) ||
+       (0 != listen (sk,
+                     daemon->listen_backlog_size)) ||
+       (! MHD_socket_nonblocking_ (sk)) )
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("Failed to set up extra listen socket: %s\n"),
+              MHD_socket_last_strerr_ ());
+#endif
+    MHD_socket_close_chk_ (sk);
+    return MHD_NO;
+  }
+#ifdef __linux__
+  (void) MHD_socket_set_nodelay_ (sk,
+                                  true);
+#endif /* __linux__ */
+  return daemon_attach_listener_fd_ (daemon,
+                                     sk,
+                                     handler,
+                                     handler_cls,
+                                     flags);
+}
+
+
+/**
+ * Attach an already-listening socket to the daemon as an extra
+ * listener: allocate the listener node, publish it to the
+ * workers, register it with the epoll sets and wake the loops.
+ * The socket is closed on failure.
+ *
+ * @param daemon the (master) daemon
+ * @param sk listening socket to adopt
+ * @param handler handler for requests on this listener,
+ *        NULL for the daemon's default handler
+ * @param handler_cls closure for @a handler
+ * @param flags bitmask of MHD_EXTRA_LISTENER_* flags
+ * @return #MHD_YES on success
+ */
+static enum MHD_Result
+daemon_attach_listener_fd_ (struct MHD_Daemon *daemon,
+                            MHD_socket sk,
+                            MHD_AccessHandlerCallback handler,
+                            void *handler_cls,
+                            unsigned int flags)
+{
+  struct MHD_ExtraListener *exl;
+
+  exl = MHD_calloc_ (1,
+                     sizeof (struct MHD_ExtraListener));
+  if (NULL == exl)
+  {
+    MHD_socket_close_chk_ (sk);
+    return MHD_NO;
+  }
+  exl->daemon = daemon;
+  exl->fd = sk;
+  exl->handler = handler;
+  exl->handler_cls = handler_cls;
+  exl->no_tls = (0 != (flags & MHD_EXTRA_LISTENER_NO_TLS));
+  /* prepend so existing nodes stay reachable from stale list
+     heads; then propagate the new head to the workers (their
+     daemon copies were taken before this call) */
+  exl->next = daemon->extra_listeners;
+  daemon->extra_listeners = exl;
+  if (NULL != daemon->worker_pool)
+  {
+    unsigned int i;
+
+    for (i = 0; i < daemon->worker_pool_size; i++)
+      daemon->worker_pool[i].extra_listeners = exl;
+  }
+#ifdef EPOLL_SUPPORT
+  if (0 != (daemon->options & MHD_USE_EPOLL))
+  {
+    struct epoll_event event;
+
+    event.events = EPOLLIN;
+    event.data.ptr = exl;
+    if (NULL != daemon->worker_pool)
     {
-      struct MHD_Daemon *const worker =
-        &daemon->worker_pool[(i + client_socket) % daemon->worker_pool_size];
-      if (worker->connections < worker->connection_limit)
-        return internal_add_connection (worker,
-                                        client_socket,
-                                        addr,
-                                        addrlen,
-                                        true,
-                                        sk_nonbl);
+      unsigned int i;
+
+      for (i = 0; i < daemon->worker_pool_size; i++)
+        if (-1 != daemon->worker_pool[i].epoll_fd)
+          (void) epoll_ctl (daemon->worker_pool[i].epoll_fd,
+                            EPOLL_CTL_ADD,
+                            sk,
+                            &event);
     }
-    /* all pools are at their connection limit, must refuse */
-    MHD_socket_close_chk_ (client_socket);
-#if ENFILE
-    errno = ENFILE;
-#endif
-    return MHD_NO;
+    else if (-1 != daemon->epoll_fd)
+      (void) epoll_ctl (daemon->epoll_fd,
+                        EPOLL_CTL_ADD,
+                        sk,
+                        &event);
   }
-#endif /* MHD_USE_POSIX_THREADS || MHD_USE_W32_THREADS */
+#endif /* EPOLL_SUPPORT */
+  /* wake the loops so select/poll based daemons pick up the new
+     socket without waiting for unrelated activity */
+  if (NULL != daemon->worker_pool)
+  {
+    unsigned int i;
 
-  return internal_add_connection (daemon,
-                                  client_socket,
-                                  addr,
-                                  addrlen,
-                                  true,
-                                  sk_nonbl);
+    for (i = 0; i < daemon->worker_pool_size; i++)
+      (void) daemon_itc_activate_ (&daemon->worker_pool[i],
+                                   "l");
+  }
+  else
+    (void) daemon_itc_activate_ (daemon,
+                                 "l");
+  return MHD_YES;
 }
 
 
@@ -3439,6 +5054,8 @@ MHD_add_connection (struct MHD_Daemon *daemon,
  * daemon's select()/poll()/etc.
  *
  * @param daemon handle with the listen socket
+ * @param listener extra listener to accept on, NULL for the
+ *        daemon's primary listen socket
  * @return #MHD_YES on success (connections denied by policy or due
  *         to 'out of memory' and similar errors) are still considered
  *         successful as far as #MHD_accept_connection() is concerned);
@@ -3446,7 +5063,8 @@ MHD_add_connection (struct MHD_Daemon *daemon,
  *         accept() system call.
  */
 static enum MHD_Result
-MHD_accept_connection (struct MHD_Daemon *daemon)
+MHD_accept_connection (struct MHD_Daemon *daemon,
+                       struct MHD_ExtraListener *listener)
 {
 #if HAVE_INET6
   struct sockaddr_in6 addrstorage;
@@ -3466,8 +5084,10 @@ MHD_accept_connection (struct MHD_Daemon *daemon)
   memset (addr,
           0,
           sizeof (addrstorage));
-  if ( (MHD_INVALID_SOCKET == (fd = daemon->listen_fd)) ||
-       (daemon->was_quiesced) )
+  fd = (NULL != listener) ? listener->fd : daemon->listen_fd;
+  if ( (MHD_INVALID_SOCKET == fd) ||
+       ( (NULL == listener) &&
+         (daemon->was_quiesced) ) )
     return MHD_NO;
 #ifdef USE_ACCEPT4
   s = accept4 (fd,
@@ -3536,6 +5156,25 @@ MHD_accept_connection (struct MHD_Daemon *daemon)
     }
     return MHD_NO;
   }
+  /* Apply the acceptance policy before anything else is spent on
+     this connection -- no flag twiddling, no per-IP accounting,
+     no allocations: during floods from blocked sources a reject
+     costs exactly accept()+close().  The policy stays downstream
+     for externally added sockets. */
+  if ( (NULL != daemon->apc) &&
+       (MHD_NO == daemon->apc (daemon->apc_cls,
+                               addr,
+                               addrlen)) )
+  {
+#if _MHD_DEBUG_CLOSE
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("Connection rejected by application. Closing connection.\n"));
+#endif
+#endif
+    MHD_socket_close_chk_ (s);
+    return MHD_YES; /* the accept() itself succeeded */
+  }
 #if ! defined(USE_ACCEPT4) || ! defined(HAVE_SOCK_NONBLOCK)
   if (! MHD_socket_nonblocking_ (s))
   {
@@ -3571,11 +5210,103 @@ MHD_accept_connection (struct MHD_Daemon *daemon)
                                   addr,
                                   addrlen,
                                   false,
-                                  sk_nonbl);
+                                  sk_nonbl,
+                                  listener);
+  return MHD_YES;
+}
+
+
+/**
+ * Run up to @a limit tasks from the worker's deferred-work FIFO
+ * (all of them for a zero @a limit), on the calling (worker)
+ * thread.
+ *
+ * @param daemon worker daemon whose queue to drain
+ * @param limit maximum number of tasks, 0 for all
+ */
+static void
+deferred_tasks_drain_ (struct MHD_Daemon *daemon,
+                       unsigned int limit)
+{
+  if (0 == limit)
+    limit = UINT_MAX;
+  while ( (NULL != daemon->defer_head) &&
+          (0 != limit--) )
+  {
+    struct MHD_DeferredTask *task = daemon->defer_head;
+
+    daemon->defer_head = task->next;
+    if (NULL == daemon->defer_head)
+      daemon->defer_tail = NULL;
+    task->cb (task->cb_cls);
+    free (task);
+  }
+}
+
+
+/**
+ * Queue cheap post-response work on the worker owning
+ * @a connection; see the public documentation in microhttpd.h.
+ *
+ * @param connection connection whose worker runs the task
+ * @param cb the task to run
+ * @param cb_cls closure for @a cb
+ * @return #MHD_YES on success
+ */
+enum MHD_Result
+MHD_connection_defer (struct MHD_Connection *connection,
+                      MHD_DeferredCallback cb,
+                      void *cb_cls)
+{
+  struct MHD_Daemon *daemon;
+  struct MHD_DeferredTask *task;
+
+  if ( (NULL == connection) ||
+       (NULL == cb) )
+    return MHD_NO;
+  daemon = connection->daemon;
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    return MHD_NO;
+  task = malloc (sizeof (struct MHD_DeferredTask));
+  if (NULL == task)
+    return MHD_NO;
+  task->next = NULL;
+  task->cb = cb;
+  task->cb_cls = cb_cls;
+  if (NULL == daemon->defer_tail)
+    daemon->defer_head = task;
+  else
+    daemon->defer_tail->next = task;
+  daemon->defer_tail = task;
   return MHD_YES;
 }
 
 
+/**
+ * Close up to @a limit sockets parked in the daemon's
+ * deferred-close array (most recently parked first).
+ * @remark To be called only from thread that
+ * process daemon's select()/poll()/etc.
+ *
+ * @param daemon daemon whose deferred closes to retire
+ * @param limit maximum number of close() calls, 0 for all
+ */
+static void
+deferred_closes_drain_ (struct MHD_Daemon *daemon,
+                        unsigned int limit)
+{
+  if (0 == limit)
+    limit = daemon->deferred_close_count;
+  while ( (0 != daemon->deferred_close_count) &&
+          (0 != limit--) )
+  {
+    daemon->deferred_close_count--;
+    MHD_socket_close_chk_ (
+      daemon->deferred_close_fds[daemon->deferred_close_count]);
+  }
+}
+
+
 /**
  * Free resources associated with all closed connections.
  * (destroy responses, free buffers, etc.).  All closed
@@ -3592,6 +5323,24 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
   mhd_assert ( (0 == (daemon->options & MHD_USE_INTERNAL_POLLING_THREAD)) || \
                MHD_thread_ID_match_current_ (daemon->pid) );
 
+  /* Only this daemon's own thread ever inserts into its cleanup
+   * list (close and resume-to-cleanup both run on the owner), so
+   * an unlocked emptiness check is exact -- skip the mutex on the
+   * (overwhelmingly common) iterations with nothing to clean. */
+  if (NULL == daemon->cleanup_tail)
+  {
+    /* low-priority step: retire a small batch of deferred closes
+       (everything once shutdown started or resources ran short) */
+    if (0 != daemon->deferred_close_count)
+      deferred_closes_drain_ (daemon,
+                              (daemon->shutdown || daemon->at_limit)
+                              ? 0
+                              : 16);
+    if (NULL != daemon->defer_head)
+      deferred_tasks_drain_ (daemon,
+                             daemon->shutdown ? 0 : 16);
+    return;
+  }
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
 #endif
@@ -3610,7 +5359,6 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
 #ifdef UPGRADE_SUPPORT
     cleanup_upgraded_connection (pos);
 #endif /* UPGRADE_SUPPORT */
-    MHD_pool_destroy (pos->pool);
 #ifdef HTTPS_SUPPORT
     if (NULL != pos->tls_session)
       gnutls_deinit (pos->tls_session);
@@ -3658,11 +5406,33 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
       MHD_destroy_response (pos->response);
       pos->response = NULL;
     }
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+    if (0 != pos->zc_outstanding)
+      MHD_send_zerocopy_drain_ (pos);
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+    if (-1 != pos->spool_fd)
+    {
+      close (pos->spool_fd);
+      pos->spool_fd = -1;
+    }
     if (MHD_INVALID_SOCKET != pos->socket_fd)
-      MHD_socket_close_chk_ (pos->socket_fd);
+    {
+      /* Defer the close() syscall: during mass-disconnect storms
+         closing tens of thousands of sockets inline stalls the
+         loop; parked FDs are retired in small batches (or in full
+         when the array overflows or the daemon shuts down). */
+      if (sizeof (daemon->deferred_close_fds)
+          / sizeof (daemon->deferred_close_fds[0])
+          == daemon->deferred_close_count)
+        deferred_closes_drain_ (daemon,
+                                0);
+      daemon->deferred_close_fds[daemon->deferred_close_count++]
+        = pos->socket_fd;
+    }
     if (NULL != pos->addr)
       free (pos->addr);
-    free (pos);
+    connection_release_ (daemon,
+                         pos);
 
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
     MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
@@ -3673,9 +5443,25 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 #endif
+  deferred_closes_drain_ (daemon,
+                          daemon->shutdown ? 0 : 16);
+  deferred_tasks_drain_ (daemon,
+                         daemon->shutdown ? 0 : 16);
 }
 
 
+/**
+ * Note on deadline caching: for connections on the default timeout
+ * the computation below is already O(1) -- the normal-timeout list
+ * is kept sorted by activity, so only its tail is read.  A full
+ * scan happens only over connections with custom per-connection
+ * timeouts (the manual list) and parked/paced connections, both of
+ * which are small, explicitly opted-in populations.  Maintaining a
+ * persistent earliest-deadline value instead would require heap or
+ * re-sort maintenance on every activity update of every custom-
+ * timeout connection -- moving cost from the once-per-loop-round
+ * path to the per-event path, the wrong direction.
+ */
 /**
  * Obtain timeout value for polling function for this daemon.
  * This function set value to amount of milliseconds for which polling
@@ -3700,8 +5486,8 @@ enum MHD_Result
 MHD_get_timeout (struct MHD_Daemon *daemon,
                  MHD_UNSIGNED_LONG_LONG *timeout)
 {
-  time_t earliest_deadline;
-  time_t now;
+  uint64_t earliest_deadline;
+  uint64_t now;
   struct MHD_Connection *pos;
   bool have_timeout;
 
@@ -3740,41 +5526,41 @@ MHD_get_timeout (struct MHD_Daemon *daemon,
 
   have_timeout = false;
   earliest_deadline = 0; /* avoid compiler warnings */
+  for (pos = daemon->paced_head; NULL != pos; pos = pos->next_paced)
+  {
+    if ( (! have_timeout) ||
+         (earliest_deadline > pos->pace_next_ms) )
+      earliest_deadline = pos->pace_next_ms;
+    have_timeout = true;
+  }
   for (pos = daemon->manual_timeout_tail; NULL != pos; pos = pos->prevX)
   {
-    if (0 != pos->connection_timeout)
+    if (0 != pos->connection_timeout_ms)
     {
       if ( (! have_timeout) ||
-           (earliest_deadline - pos->last_activity > pos->connection_timeout) )
-        earliest_deadline = pos->last_activity + pos->connection_timeout;
+           (earliest_deadline - pos->last_activity > pos->connection_timeout_ms) )
+        earliest_deadline = pos->last_activity + pos->connection_timeout_ms;
       have_timeout = true;
     }
   }
   /* normal timeouts are sorted, so we only need to look at the 'tail' (oldest) */
   pos = daemon->normal_timeout_tail;
   if ( (NULL != pos) &&
-       (0 != pos->connection_timeout) )
+       (0 != pos->connection_timeout_ms) )
   {
     if ( (! have_timeout) ||
-         (earliest_deadline - pos->connection_timeout > pos->last_activity) )
-      earliest_deadline = pos->last_activity + pos->connection_timeout;
+         (earliest_deadline - pos->connection_timeout_ms > pos->last_activity) )
+      earliest_deadline = pos->last_activity + pos->connection_timeout_ms;
     have_timeout = true;
   }
 
   if (! have_timeout)
     return MHD_NO;
-  now = MHD_monotonic_sec_counter ();
+  now = MHD_monotonic_msec_counter ();
   if (earliest_deadline < now)
     *timeout = 0;
   else
-  {
-    const time_t second_left = earliest_deadline - now;
-
-    if (((unsigned long long) second_left) > ULLONG_MAX / 1000)
-      *timeout = ULLONG_MAX;
-    else
-      *timeout = 1000LLU * (unsigned long long) second_left;
-  }
+    *timeout = (MHD_UNSIGNED_LONG_LONG) (earliest_deadline - now);
   return MHD_YES;
 }
 
@@ -3812,7 +5598,20 @@ internal_run_from_select (struct MHD_Daemon *daemon,
   if ( (MHD_ITC_IS_VALID_ (daemon->itc)) &&
        (FD_ISSET (MHD_itc_r_fd_ (daemon->itc),
                   read_fd_set)) )
-    MHD_itc_clear_ (daemon->itc);
+    daemon_itc_clear_ (daemon);
+
+  /* Sample the clock once for this loop round; per-connection
+   * code reads the cached value. */
+  daemon_overload_eval_ (daemon,
+                         MHD_monotonic_msec_counter ());
+  daemon->loop_ms = MHD_monotonic_msec_counter ();
+  daemon->loop_ms_valid = true;
+  if (NULL != daemon->paced_head)
+    MHD_pace_unpark_ (daemon);
+  if (daemon->drain_pending)
+    daemon_apply_drain_ (daemon);
+  if (0 != daemon->trim_pending)
+    daemon_apply_trim_ (daemon);
 
   /* Process externally added connection if any */
   if (daemon->have_new)
@@ -3823,7 +5622,40 @@ internal_run_from_select (struct MHD_Daemon *daemon,
        (! daemon->was_quiesced) &&
        (FD_ISSET (ds,
                   read_fd_set)) )
-    (void) MHD_accept_connection (daemon);
+  {
+    /* Drain a burst of queued connections in this wakeup instead
+     * of paying a loop iteration per accepted socket. */
+    unsigned int series_length = 0;
+    const unsigned int burst = daemon->listen_nonblk ?
+                               daemon->accept_burst_size : 1;
+
+    while ( (MHD_NO != MHD_accept_connection (daemon,
+                                           NULL)) &&
+            (++series_length < burst) &&
+            (daemon->connections < daemon->connection_limit) &&
+            (! daemon->at_limit) &&
+            (! daemon->shed_accept_off) )
+      (void) 0;
+  }
+  {
+    struct MHD_ExtraListener *exl;
+
+    for (exl = daemon->extra_listeners; NULL != exl; exl = exl->next)
+    {
+      unsigned int exl_series = 0;
+
+      if (! FD_ISSET (exl->fd,
+                      read_fd_set))
+        continue;
+      while ( (MHD_NO != MHD_accept_connection (daemon,
+                                                exl)) &&
+              (++exl_series < daemon->accept_burst_size) &&
+              (daemon->connections < daemon->connection_limit) &&
+              (! daemon->at_limit) &&
+              (! daemon->shed_accept_off) )
+        (void) 0;
+    }
+  }
 
   if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
   {
@@ -4058,7 +5890,8 @@ MHD_select (struct MHD_Daemon *daemon,
   if ( (MHD_INVALID_SOCKET != (ls = daemon->listen_fd)) &&
        (MHD_ITC_IS_VALID_ (daemon->itc)) &&
        ( (daemon->connections == daemon->connection_limit) ||
-         (daemon->at_limit) ) )
+         (daemon->at_limit) ||
+         (daemon->shed_accept_off) ) )
   {
     FD_CLR (ls,
             &rs);
@@ -4083,11 +5916,25 @@ MHD_select (struct MHD_Daemon *daemon,
       timeout.tv_sec = (_MHD_TIMEVAL_TV_SEC_TYPE) (ltimeout / 1000);
     tv = &timeout;
   }
+  if (0 != daemon->loop_budget_ms)
+    daemon->loop_work_end_ms = MHD_monotonic_msec_counter ();
   num_ready = MHD_SYS_select_ (maxsock + 1,
                                &rs,
                                &ws,
                                &es,
                                tv);
+  /* Sample the clock once for this loop round; per-connection
+   * code reads the cached value. */
+  daemon_overload_eval_ (daemon,
+                         MHD_monotonic_msec_counter ());
+  daemon->loop_ms = MHD_monotonic_msec_counter ();
+  daemon->loop_ms_valid = true;
+  if (NULL != daemon->paced_head)
+    MHD_pace_unpark_ (daemon);
+  if (daemon->drain_pending)
+    daemon_apply_drain_ (daemon);
+  if (0 != daemon->trim_pending)
+    daemon_apply_trim_ (daemon);
   if (daemon->shutdown)
     return MHD_NO;
   if (num_ready < 0)
@@ -4153,24 +6000,48 @@ MHD_poll_all (struct MHD_Daemon *daemon,
     int poll_itc_idx;
     struct pollfd *p;
     MHD_socket ls;
-
-    p = MHD_calloc_ ((2 + (size_t) num_connections),
-                     sizeof (struct pollfd));
-    if (NULL == p)
+    unsigned int num_extra = 0;
+    unsigned int first_extra = 0;
+    struct MHD_ExtraListener *exl;
+
+    for (exl = daemon->extra_listeners; NULL != exl; exl = exl->next)
+      num_extra++;
+    /* Reuse the persistent array; grow geometrically when the
+     * connection count exceeds it, so steady-state iterations do
+     * no allocation at all. */
+    if (daemon->pollfd_cache_size < 2 + num_extra + num_connections)
     {
+      unsigned int new_size = (0 == daemon->pollfd_cache_size)
+                              ? 64 : daemon->pollfd_cache_size;
+
+      while (new_size < 2 + num_extra + num_connections)
+        new_size *= 2;
+      p = realloc (daemon->pollfd_cache,
+                   new_size * sizeof (struct pollfd));
+      if (NULL == p)
+      {
 #ifdef HAVE_MESSAGES
-      MHD_DLOG (daemon,
-                _ ("Error allocating memory: %s\n"),
-                MHD_strerror_ (errno));
+        MHD_DLOG (daemon,
+                  _ ("Error allocating memory: %s\n"),
+                  MHD_strerror_ (errno));
 #endif
-      return MHD_NO;
+        return MHD_NO;
+      }
+      daemon->pollfd_cache = p;
+      daemon->pollfd_cache_size = new_size;
     }
+    p = daemon->pollfd_cache;
+    memset (p,
+            0,
+            (2 + (size_t) num_extra + (size_t) num_connections)
+            * sizeof (struct pollfd));
     poll_server = 0;
     poll_listen = -1;
     if ( (MHD_INVALID_SOCKET != (ls = daemon->listen_fd)) &&
          (! daemon->was_quiesced) &&
          (daemon->connections < daemon->connection_limit) &&
-         (! daemon->at_limit) )
+         (! daemon->at_limit) &&
+         (! daemon->shed_accept_off) )
     {
       /* only listen if we are not at the connection limit */
       p[poll_server].fd = ls;
@@ -4188,6 +6059,14 @@ MHD_poll_all (struct MHD_Daemon *daemon,
       poll_itc_idx = (int) poll_server;
       poll_server++;
     }
+    first_extra = poll_server;
+    for (exl = daemon->extra_listeners; NULL != exl; exl = exl->next)
+    {
+      p[poll_server].fd = exl->fd;
+      p[poll_server].events = POLLIN;
+      p[poll_server].revents = 0;
+      poll_server++;
+    }
     if (may_block == MHD_NO)
       timeout = 0;
     else if ( (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) ||
@@ -4227,9 +6106,10 @@ MHD_poll_all (struct MHD_Daemon *daemon,
 #endif /* HTTPS_SUPPORT && UPGRADE_SUPPORT */
     if (0 == poll_server + num_connections)
     {
-      free (p);
       return MHD_YES;
     }
+    if (0 != daemon->loop_budget_ms)
+      daemon->loop_work_end_ms = MHD_monotonic_msec_counter ();
     if (MHD_sys_poll_ (p,
                        poll_server + num_connections,
                        timeout) < 0)
@@ -4237,7 +6117,6 @@ MHD_poll_all (struct MHD_Daemon *daemon,
       const int err = MHD_socket_get_error_ ();
       if (MHD_SCKT_ERR_IS_EINTR_ (err))
       {
-        free (p);
         return MHD_YES;
       }
 #ifdef HAVE_MESSAGES
@@ -4245,21 +6124,31 @@ MHD_poll_all (struct MHD_Daemon *daemon,
                 _ ("poll failed: %s\n"),
                 MHD_socket_strerr_ (err));
 #endif
-      free (p);
       return MHD_NO;
     }
+    /* Sample the clock once for this loop round; per-connection
+     * code reads the cached value. */
+    daemon_overload_eval_ (daemon,
+                           MHD_monotonic_msec_counter ());
+    daemon->loop_ms = MHD_monotonic_msec_counter ();
+    daemon->loop_ms_valid = true;
+    if (NULL != daemon->paced_head)
+      MHD_pace_unpark_ (daemon);
+    if (daemon->drain_pending)
+      daemon_apply_drain_ (daemon);
+    if (0 != daemon->trim_pending)
+      daemon_apply_trim_ (daemon);
 
     /* handle ITC FD */
     /* do it before any other processing so
        new signals will be processed in next loop */
     if ( (-1 != poll_itc_idx) &&
          (0 != (p[poll_itc_idx].revents & POLLIN)) )
-      MHD_itc_clear_ (daemon->itc);
+      daemon_itc_clear_ (daemon);
 
     /* handle shutdown */
     if (daemon->shutdown)
     {
-      free (p);
       return MHD_NO;
     }
 
@@ -4270,7 +6159,35 @@ MHD_poll_all (struct MHD_Daemon *daemon,
     /* handle 'listen' FD */
     if ( (-1 != poll_listen) &&
          (0 != (p[poll_listen].revents & POLLIN)) )
-      (void) MHD_accept_connection (daemon);
+    {
+      /* Drain a burst of queued connections in this wakeup. */
+      unsigned int series_length = 0;
+      const unsigned int burst = daemon->listen_nonblk ?
+                                 daemon->accept_burst_size : 1;
+
+      while ( (MHD_NO != MHD_accept_connection (daemon,
+                                           NULL)) &&
+              (++series_length < burst) &&
+              (daemon->connections < daemon->connection_limit) &&
+              (! daemon->at_limit) &&
+              (! daemon->shed_accept_off) )
+        (void) 0;
+    }
+    i = first_extra;
+    for (exl = daemon->extra_listeners; NULL != exl; exl = exl->next, i++)
+    {
+      unsigned int exl_series = 0;
+
+      if (0 == (p[i].revents & POLLIN))
+        continue;
+      while ( (MHD_NO != MHD_accept_connection (daemon,
+                                                exl)) &&
+              (++exl_series < daemon->accept_burst_size) &&
+              (daemon->connections < daemon->connection_limit) &&
+              (! daemon->at_limit) &&
+              (! daemon->shed_accept_off) )
+        (void) 0;
+    }
 
     /* Reset. New value will be set when connections are processed. */
     daemon->data_already_pending = false;
@@ -4328,7 +6245,6 @@ MHD_poll_all (struct MHD_Daemon *daemon,
     }
 #endif /* HTTPS_SUPPORT && UPGRADE_SUPPORT */
 
-    free (p);
   }
   return MHD_YES;
 }
@@ -4386,6 +6302,8 @@ MHD_poll_listen_socket (struct MHD_Daemon *daemon,
     timeout = -1;
   if (0 == poll_count)
     return MHD_YES;
+  if (0 != daemon->loop_budget_ms)
+    daemon->loop_work_end_ms = MHD_monotonic_msec_counter ();
   if (MHD_sys_poll_ (p,
                      poll_count,
                      timeout) < 0)
@@ -4403,19 +6321,33 @@ MHD_poll_listen_socket (struct MHD_Daemon *daemon,
   }
   if ( (-1 != poll_itc_idx) &&
        (0 != (p[poll_itc_idx].revents & POLLIN)) )
-    MHD_itc_clear_ (daemon->itc);
+    daemon_itc_clear_ (daemon);
 
   /* handle shutdown */
   if (daemon->shutdown)
     return MHD_NO;
 
+  /* Sample the clock once for this loop round; per-connection
+   * code reads the cached value. */
+  daemon_overload_eval_ (daemon,
+                         MHD_monotonic_msec_counter ());
+  daemon->loop_ms = MHD_monotonic_msec_counter ();
+  daemon->loop_ms_valid = true;
+  if (NULL != daemon->paced_head)
+    MHD_pace_unpark_ (daemon);
+  if (daemon->drain_pending)
+    daemon_apply_drain_ (daemon);
+  if (0 != daemon->trim_pending)
+    daemon_apply_trim_ (daemon);
+
   /* Process externally added connection if any */
   if (daemon->have_new)
     new_connections_list_process_ (daemon);
 
   if ( (-1 != poll_listen) &&
        (0 != (p[poll_listen].revents & POLLIN)) )
-    (void) MHD_accept_connection (daemon);
+    (void) MHD_accept_connection (daemon,
+                                  NULL);
   return MHD_YES;
 }
 
@@ -4628,6 +6560,17 @@ static const char *const epoll_itc_marker = "itc_marker";
 
 
 /**
+ * Note on a Windows IOCP backend: I/O completion ports are a
+ * completion model, while this state machine (readiness flags,
+ * EDLL ready lists, in-place parse of the read buffer) is built
+ * around a readiness model; bridging them means owning all buffer
+ * lifetimes across overlapped operations, i.e. a parallel
+ * connection engine rather than a loop variant like poll/epoll --
+ * and this tree has no Windows build or test coverage to validate
+ * one.  On W32 the wevent path therefore remains select()-based;
+ * deployments needing >FD_SETSIZE concurrency on Windows should
+ * front MHD or use the planned next-generation engine.
+ *
  * Do epoll()-based processing (this function is allowed to
  * block if @a may_block is set to #MHD_YES).
  *
@@ -4644,11 +6587,13 @@ MHD_epoll (struct MHD_Daemon *daemon,
 #endif /* HTTPS_SUPPORT && UPGRADE_SUPPORT */
   struct MHD_Connection *pos;
   struct MHD_Connection *prev;
-  struct epoll_event events[MAX_EVENTS];
+  struct epoll_event events_stack[MAX_EVENTS];
+  struct epoll_event *events;
   struct epoll_event event;
   int timeout_ms;
   MHD_UNSIGNED_LONG_LONG timeout_ll;
   int num_events;
+  int spin_events;
   unsigned int i;
   MHD_socket ls;
 #if defined(HTTPS_SUPPORT) && defined(UPGRADE_SUPPORT)
@@ -4664,14 +6609,11 @@ MHD_epoll (struct MHD_Daemon *daemon,
        (! daemon->was_quiesced) &&
        (daemon->connections < daemon->connection_limit) &&
        (! daemon->listen_socket_in_epoll) &&
-       (! daemon->at_limit) )
+       (! daemon->at_limit) &&
+       (! daemon->shed_accept_off) )
   {
-    event.events = EPOLLIN;
-    event.data.ptr = daemon;
-    if (0 != epoll_ctl (daemon->epoll_fd,
-                        EPOLL_CTL_ADD,
-                        ls,
-                        &event))
+    if (0 != epoll_register_listener_ (daemon,
+                                       ls))
     {
 #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
@@ -4719,6 +6661,7 @@ MHD_epoll (struct MHD_Daemon *daemon,
   if ( (daemon->listen_socket_in_epoll) &&
        ( (daemon->connections == daemon->connection_limit) ||
          (daemon->at_limit) ||
+         (daemon->shed_accept_off) ||
          (daemon->was_quiesced) ) )
   {
     /* we're at the connection limit, disable listen socket
@@ -4756,19 +6699,79 @@ MHD_epoll (struct MHD_Daemon *daemon,
    * signaled in epoll mode by non-empty eready DLL. */
   daemon->data_already_pending = false;
 
+  if (0 == daemon->epoll_batch)
+    daemon->epoll_batch = 16;
+  if ( (NULL == daemon->epoll_events_buf) &&
+       (NULL != daemon->lifetime_arena) )
+    daemon->epoll_events_buf
+      = daemon_lifetime_arena_carve_ (daemon,
+                                      sizeof (struct epoll_event)
+                                      * MAX_EVENTS);
+  events = (NULL != daemon->epoll_events_buf)
+           ? (struct epoll_event *) daemon->epoll_events_buf
+           : events_stack;
+
+  if (0 != daemon->loop_budget_ms)
+    daemon->loop_work_end_ms = MHD_monotonic_msec_counter ();
+  spin_events = -2;
+  if ( (0 != daemon->busy_poll_us) &&
+       (0 != timeout_ms) )
+  {
+    /* Busy-poll phase: spin on zero-timeout polls for the budget
+     * before paying the blocking sleep/wake cost.  Events are
+     * edge-triggered, so a successful probe's results must be
+     * carried into the drain loop below, not re-fetched. */
+    struct timespec ts;
+    uint64_t spin_deadline;
+    int n;
+
+    clock_gettime (CLOCK_MONOTONIC,
+                   &ts);
+    spin_deadline = (uint64_t) ts.tv_sec * 1000000000ULL
+                    + (uint64_t) ts.tv_nsec
+                    + (uint64_t) daemon->busy_poll_us * 1000;
+    for (;;)
+    {
+      n = epoll_wait (daemon->epoll_fd,
+                      events,
+                      (int) daemon->epoll_batch,
+                      0);
+      if (0 != n)
+      {
+        spin_events = n;
+        break;
+      }
+      clock_gettime (CLOCK_MONOTONIC,
+                     &ts);
+      if ((uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec
+          >= spin_deadline)
+        break;
+    }
+  }
+
   need_to_accept = false;
   /* drain 'epoll' event queue; need to iterate as we get at most
-     MAX_EVENTS in one system call here; in practice this should
+     one batch in one system call here; in practice this should
      pretty much mean only one round, but better an extra loop here
      than unfair behavior... */
-  num_events = MAX_EVENTS;
-  while (MAX_EVENTS == num_events)
+  num_events = (int) daemon->epoll_batch;
+  while ((int) daemon->epoll_batch == num_events)
   {
     /* update event masks */
-    num_events = epoll_wait (daemon->epoll_fd,
-                             events,
-                             MAX_EVENTS,
-                             timeout_ms);
+    if (-2 != spin_events)
+    {
+      /* consume the batch the busy-poll probe already fetched */
+      num_events = spin_events;
+      spin_events = -2;
+    }
+    else
+      num_events = epoll_wait (daemon->epoll_fd,
+                               events,
+                               (int) daemon->epoll_batch,
+                               timeout_ms);
+    /* Further drain rounds must not block: a full batch has
+     * already been collected and awaits processing below. */
+    timeout_ms = 0;
     if (-1 == num_events)
     {
       const int err = MHD_socket_get_error_ ();
@@ -4800,7 +6803,7 @@ MHD_epoll (struct MHD_Daemon *daemon,
       {
         /* It's OK to clear ITC here as all external
            conditions will be processed later. */
-        MHD_itc_clear_ (daemon->itc);
+        daemon_itc_clear_ (daemon);
         continue;
       }
       if (daemon == events[i].data.ptr)
@@ -4811,6 +6814,32 @@ MHD_epoll (struct MHD_Daemon *daemon,
           need_to_accept = true;
         continue;
       }
+      if (NULL != daemon->extra_listeners)
+      {
+        /* the (short) extra-listener list doubles as the marker
+           registry: pointer equality identifies listener events */
+        struct MHD_ExtraListener *exl;
+
+        for (exl = daemon->extra_listeners; NULL != exl; exl = exl->next)
+          if (exl == events[i].data.ptr)
+            break;
+        if (NULL != exl)
+        {
+          if (0 == (events[i].events & (EPOLLERR | EPOLLHUP)))
+          {
+            unsigned int exl_series = 0;
+
+            while ( (MHD_NO != MHD_accept_connection (daemon,
+                                                      exl)) &&
+                    (++exl_series < daemon->accept_burst_size) &&
+                    (daemon->connections < daemon->connection_limit) &&
+                    (! daemon->at_limit) &&
+                    (! daemon->shed_accept_off) )
+              (void) 0;
+          }
+          continue;
+        }
+      }
       /* this is an event relating to a 'normal' connection,
          remember the event and if appropriate mark the
          connection as 'eready'. */
@@ -4858,6 +6887,33 @@ MHD_epoll (struct MHD_Daemon *daemon,
     }
   }
 
+  /* Adapt the batch: grow while the queue keeps filling whole
+   * batches, decay when load drops, so the timeout/resume
+   * processing below runs at bounded intervals under load spikes
+   * without costing extra epoll_wait calls when idle. */
+  if (num_events >= (int) daemon->epoll_batch)
+  {
+    if (daemon->epoll_batch < MAX_EVENTS)
+      daemon->epoll_batch *= 2;
+  }
+  else if ( (num_events >= 0) &&
+            (num_events < (int) (daemon->epoll_batch / 4)) &&
+            (daemon->epoll_batch > 16) )
+    daemon->epoll_batch /= 2;
+
+  /* Sample the clock once for this loop round; per-connection
+   * code reads the cached value. */
+  daemon_overload_eval_ (daemon,
+                         MHD_monotonic_msec_counter ());
+  daemon->loop_ms = MHD_monotonic_msec_counter ();
+  daemon->loop_ms_valid = true;
+  if (NULL != daemon->paced_head)
+    MHD_pace_unpark_ (daemon);
+  if (daemon->drain_pending)
+    daemon_apply_drain_ (daemon);
+  if (0 != daemon->trim_pending)
+    daemon_apply_trim_ (daemon);
+
   /* Process externally added connection if any */
   if (daemon->have_new)
     new_connections_list_process_ (daemon);
@@ -4867,13 +6923,15 @@ MHD_epoll (struct MHD_Daemon *daemon,
     unsigned int series_length = 0;
 
     /* Run 'accept' until it fails or daemon at limit of connections.
-     * Do not accept more then 10 connections at once. The rest will
-     * be accepted on next turn (level trigger is used for listen
-     * socket). */
-    while ( (MHD_NO != MHD_accept_connection (daemon)) &&
-            (series_length < 10) &&
+     * Do not accept more than the configured burst of connections
+     * at once. The rest will be accepted on next turn (level
+     * trigger is used for listen socket). */
+    while ( (MHD_NO != MHD_accept_connection (daemon,
+                                           NULL)) &&
+            (series_length < daemon->accept_burst_size) &&
             (daemon->connections < daemon->connection_limit) &&
-            (! daemon->at_limit) )
+            (! daemon->at_limit) &&
+            (! daemon->shed_accept_off) )
       series_length++;
   }
 
@@ -5018,7 +7076,7 @@ close_connection (struct MHD_Connection *pos)
 #endif
   mhd_assert (! pos->suspended);
   mhd_assert (! pos->resuming);
-  if (pos->connection_timeout == daemon->connection_timeout)
+  if (pos->connection_timeout_ms == daemon->connection_timeout_ms)
     XDLL_remove (daemon->normal_timeout_head,
                  daemon->normal_timeout_tail,
                  pos);
@@ -5071,6 +7129,22 @@ MHD_polling_thread (void *cls)
   if (0 != (MHD_TEST_ALLOW_SUSPEND_RESUME & daemon->options))
     resume_suspended_connections (daemon);
   close_all_connections (daemon);
+#if defined(MHD_USE_POSIX_THREADS)
+  if (0 != daemon->thread_cache_size)
+  {
+    /* wake parked threads and wait for every cache-managed
+       (detached) thread to finish before teardown proceeds */
+    MHD_mutex_lock_chk_ (&daemon->thread_cache_lock);
+    pthread_cond_broadcast (&daemon->thread_cache_cond);
+    while (0 != daemon->thread_cache_live)
+    {
+      pthread_cond_broadcast (&daemon->thread_cache_cond);
+      pthread_cond_wait (&daemon->thread_cache_cond,
+                         &daemon->thread_cache_lock);
+    }
+    MHD_mutex_unlock_chk_ (&daemon->thread_cache_lock);
+  }
+#endif /* MHD_USE_POSIX_THREADS */
 
   return (MHD_THRD_RTRN_TYPE_) 0;
 }
@@ -5144,6 +7218,7 @@ MHD_start_daemon (unsigned int flags,
                                 dh_cls,
                                 ap);
   va_end (ap);
+
   return daemon;
 }
 
@@ -5239,6 +7314,62 @@ MHD_quiesce_daemon (struct MHD_Daemon *daemon)
 }
 
 
+/**
+ * Adjust how many workers of the thread pool actively accept new
+ * connections.  Workers beyond @a count stop monitoring the listen
+ * socket but keep serving their existing connections; raising the
+ * count re-activates parked workers.  Threads are neither created
+ * nor destroyed.
+ *
+ * @param daemon the master daemon
+ * @param count number of workers that should accept new
+ *        connections, between 1 and the pool size
+ * @return #MHD_YES on success, #MHD_NO on invalid arguments
+ * @ingroup event
+ */
+enum MHD_Result
+MHD_set_active_worker_count (struct MHD_Daemon *daemon,
+                             unsigned int count)
+{
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  unsigned int i;
+
+  if ( (NULL == daemon) ||
+       (NULL == daemon->worker_pool) ||
+       (0 == count) ||
+       (count > daemon->worker_pool_size) ||
+       (daemon->shutdown) ||
+       (daemon->was_quiesced) )
+    return MHD_NO;
+  if (0 != (daemon->options & MHD_TEST_REUSEPORT_WORKER_LISTENERS))
+    return MHD_NO; /* private kernel accept queues cannot be parked */
+  if (0 == (daemon->options & MHD_USE_ITC))
+    return MHD_NO; /* without ITC a parked worker could miss the
+                      listen-socket shutdown signal at stop time */
+  for (i = 0; i < daemon->worker_pool_size; ++i)
+  {
+    struct MHD_Daemon *const worker = &daemon->worker_pool[i];
+    const bool park = (i >= count);
+
+    if (worker->was_quiesced == park)
+      continue;
+    worker->was_quiesced = park;
+    /* Wake the worker so it updates its listen-socket
+     * registration promptly. */
+    if (MHD_ITC_IS_VALID_ (worker->itc))
+      (void) MHD_itc_activate_ (worker->itc,
+                                park ? "p" : "a");
+  }
+  return MHD_YES;
+#else  /* ! threads */
+  (void) daemon;
+  (void) count;
+  return MHD_NO;
+#endif /* ! threads */
+}
+
+
+
 /**
  * Signature of the MHD custom logger function.
  *
@@ -5327,47 +7458,166 @@ parse_options_va (struct MHD_Daemon *daemon,
       daemon->pool_size = va_arg (ap,
                                   size_t);
       break;
-    case MHD_OPTION_CONNECTION_MEMORY_INCREMENT:
-      daemon->pool_increment = va_arg (ap,
-                                       size_t);
+    case MHD_OPTION_CONNECTION_MEMORY_INCREMENT:
+      daemon->pool_increment = va_arg (ap,
+                                       size_t);
+      break;
+    case MHD_OPTION_CONNECTION_LIMIT:
+      daemon->connection_limit = va_arg (ap,
+                                         unsigned int);
+      break;
+    case MHD_OPTION_CONNECTION_TIMEOUT:
+      uv = va_arg (ap,
+                   unsigned int);
+      daemon->connection_timeout_ms = ((uint64_t) uv) * 1000;
+      break;
+    case MHD_OPTION_CONNECTION_TIMEOUT_MS:
+      uv = va_arg (ap,
+                   unsigned int);
+      daemon->connection_timeout_ms = (uint64_t) uv;
+      break;
+    case MHD_OPTION_NOTIFY_COMPLETED:
+      daemon->notify_completed = va_arg (ap,
+                                         MHD_RequestCompletedCallback);
+      daemon->notify_completed_cls = va_arg (ap,
+                                             void *);
+      break;
+    case MHD_OPTION_NOTIFY_CONNECTION:
+      daemon->notify_connection = va_arg (ap,
+                                          MHD_NotifyConnectionCallback);
+      daemon->notify_connection_cls = va_arg (ap,
+                                              void *);
+      break;
+    case MHD_OPTION_PER_IP_CONNECTION_LIMIT:
+      daemon->per_ip_connection_limit = va_arg (ap,
+                                                unsigned int);
+      break;
+    case MHD_OPTION_CONNECTION_RECYCLE_LIMIT:
+      daemon->connection_recycle_limit = va_arg (ap,
+                                                 unsigned int);
+      break;
+    case MHD_OPTION_ACCEPT_BURST_SIZE:
+      daemon->accept_burst_size = va_arg (ap,
+                                          unsigned int);
+      if (0 == daemon->accept_burst_size)
+        daemon->accept_burst_size = 1;
+      break;
+    case MHD_OPTION_WORKER_CPU_PINNING:
+      daemon->worker_cpu_pinning = va_arg (ap,
+                                           unsigned int);
+      break;
+    case MHD_OPTION_POOL_ARENA_SLOTS:
+      daemon->pool_arena_slots = va_arg (ap,
+                                         unsigned int);
+      break;
+    case MHD_OPTION_LISTEN_DEFER_ACCEPT:
+      daemon->listen_defer_accept = va_arg (ap,
+                                            unsigned int);
+      break;
+    case MHD_OPTION_TLS_FIRST_RECORD_SIZE:
+      daemon->tls_first_record_size = va_arg (ap,
+                                              unsigned int);
+      break;
+    case MHD_OPTION_RESPONSE_RATE_LIMIT:
+      daemon->default_pace_rate = va_arg (ap,
+                                          unsigned int);
+      if ( (0 != daemon->default_pace_rate) &&
+           (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) )
+      {
+        /* The pacing machinery parks connections on the daemon's
+           (unlocked) paced list and unparks them from the internal
+           event loops; thread-per-connection has neither, so a
+           paced connection would park forever. */
+#ifdef HAVE_MESSAGES
+        MHD_DLOG (daemon,
+                  _ ("Response rate limiting is not supported with "
+                     "thread-per-connection.\n"));
+#endif
+        return MHD_NO;
+      }
+      break;
+    case MHD_OPTION_ACCESS_LOG:
+      daemon->access_log = va_arg (ap,
+                                   struct MHD_AccessLog *);
+      break;
+    case MHD_OPTION_MAX_HEADER_COUNT:
+      daemon->max_header_count = va_arg (ap,
+                                         unsigned int);
+      break;
+    case MHD_OPTION_MAX_URI_BYTES:
+      daemon->max_uri_bytes = va_arg (ap,
+                                      unsigned int);
+      break;
+    case MHD_OPTION_HEADER_DEADLINE_MS:
+      daemon->header_deadline_ms = va_arg (ap,
+                                           unsigned int);
+      break;
+    case MHD_OPTION_REQUEST_DEADLINE_MS:
+      daemon->request_deadline_ms = va_arg (ap,
+                                            unsigned int);
+      break;
+    case MHD_OPTION_INITIAL_READ_BUFFER_SIZE:
+      daemon->initial_read_buffer_size = va_arg (ap,
+                                                 size_t);
+      break;
+    case MHD_OPTION_BUSY_POLL_US:
+      daemon->busy_poll_us = va_arg (ap,
+                                     unsigned int);
+      break;
+    case MHD_OPTION_LOOP_BUDGET_MS:
+      daemon->loop_budget_ms = va_arg (ap,
+                                       unsigned int);
+      break;
+    case MHD_OPTION_OVERLOAD_SHED_MODE:
+      daemon->shed_mode = va_arg (ap,
+                                  unsigned int);
+      break;
+    case MHD_OPTION_PROXY_PROTOCOL:
+      daemon->proxy_protocol = (0 != va_arg (ap,
+                                             unsigned int));
       break;
-    case MHD_OPTION_CONNECTION_LIMIT:
-      daemon->connection_limit = va_arg (ap,
-                                         unsigned int);
+    case MHD_OPTION_POOL_EXHAUSTION_CALLBACK:
+      daemon->pool_exhaustion_cb = va_arg (ap,
+                                           MHD_PoolExhaustionCallback);
+      daemon->pool_exhaustion_cb_cls = va_arg (ap,
+                                               void *);
       break;
-    case MHD_OPTION_CONNECTION_TIMEOUT:
-      uv = va_arg (ap,
-                   unsigned int);
-      daemon->connection_timeout = (time_t) uv;
-      /* Next comparison could be always false on some platforms and whole branch will
-       * be optimized out on those platforms. On others it will be compiled into real
-       * check. */
-      if ( ( (MHD_TYPE_IS_SIGNED_ (time_t)) &&
-             (daemon->connection_timeout < 0) ) ||     /* Compiler may warn on some platforms, ignore warning. */
-           (uv != (unsigned int) daemon->connection_timeout) )
-      {
-#ifdef HAVE_MESSAGES
-        MHD_DLOG (daemon,
-                  _ ("Warning: Too large timeout value, ignored.\n"));
-#endif
-        daemon->connection_timeout = 0;
-      }
+    case MHD_OPTION_POOL_OVERFLOW_SLAB:
+      daemon->spare_slab_enabled = (0 != va_arg (ap,
+                                                 unsigned int));
       break;
-    case MHD_OPTION_NOTIFY_COMPLETED:
-      daemon->notify_completed = va_arg (ap,
-                                         MHD_RequestCompletedCallback);
-      daemon->notify_completed_cls = va_arg (ap,
-                                             void *);
+    case MHD_OPTION_DAEMON_ARENA:
+      daemon->daemon_arena_mode = va_arg (ap,
+                                          unsigned int);
       break;
-    case MHD_OPTION_NOTIFY_CONNECTION:
-      daemon->notify_connection = va_arg (ap,
-                                          MHD_NotifyConnectionCallback);
-      daemon->notify_connection_cls = va_arg (ap,
-                                              void *);
+    case MHD_OPTION_LISTEN_SOCKET_ARRAY:
+    {
+      unsigned int fd_count;
+      const MHD_socket *fds;
+
+      fd_count = va_arg (ap,
+                         unsigned int);
+      fds = va_arg (ap,
+                    const MHD_socket *);
+      if ( (0 == fd_count) ||
+           (NULL == fds) )
+        break;
+      /* first socket becomes the primary listener (like
+         MHD_OPTION_LISTEN_SOCKET), the rest are attached as
+         extra listeners once the event loops are up */
+      daemon->listen_fd = fds[0];
+      daemon->pending_listen_fds = fds + 1;
+      daemon->pending_listen_fd_count = fd_count - 1;
       break;
-    case MHD_OPTION_PER_IP_CONNECTION_LIMIT:
-      daemon->per_ip_connection_limit = va_arg (ap,
-                                                unsigned int);
+    }
+    case MHD_OPTION_THREAD_CACHE_SIZE:
+#if defined(MHD_USE_POSIX_THREADS)
+      daemon->thread_cache_size = va_arg (ap,
+                                          unsigned int);
+#else  /* ! MHD_USE_POSIX_THREADS */
+      (void) va_arg (ap,
+                     unsigned int);
+#endif /* ! MHD_USE_POSIX_THREADS */
       break;
     case MHD_OPTION_SOCK_ADDR:
       *servaddr = va_arg (ap,
@@ -5555,6 +7805,7 @@ parse_options_va (struct MHD_Daemon *daemon,
                      const char *);
       if (0 != (daemon->options & MHD_USE_TLS))
       {
+        if (NULL != daemon->priority_cache)
         gnutls_priority_deinit (daemon->priority_cache);
         ret = gnutls_priority_init (&daemon->priority_cache,
                                     pstr,
@@ -5709,6 +7960,7 @@ parse_options_va (struct MHD_Daemon *daemon,
         switch (opt)
         {
         /* all options taking 'size_t' */
+        case MHD_OPTION_INITIAL_READ_BUFFER_SIZE:
         case MHD_OPTION_CONNECTION_MEMORY_LIMIT:
         case MHD_OPTION_CONNECTION_MEMORY_INCREMENT:
         case MHD_OPTION_THREAD_STACK_SIZE:
@@ -5723,12 +7975,31 @@ parse_options_va (struct MHD_Daemon *daemon,
         case MHD_OPTION_NONCE_NC_SIZE:
         case MHD_OPTION_CONNECTION_LIMIT:
         case MHD_OPTION_CONNECTION_TIMEOUT:
+        case MHD_OPTION_CONNECTION_TIMEOUT_MS:
         case MHD_OPTION_PER_IP_CONNECTION_LIMIT:
         case MHD_OPTION_THREAD_POOL_SIZE:
         case MHD_OPTION_TCP_FASTOPEN_QUEUE_SIZE:
         case MHD_OPTION_LISTENING_ADDRESS_REUSE:
         case MHD_OPTION_LISTEN_BACKLOG_SIZE:
         case MHD_OPTION_SERVER_INSANITY:
+        case MHD_OPTION_CONNECTION_RECYCLE_LIMIT:
+        case MHD_OPTION_ACCEPT_BURST_SIZE:
+        case MHD_OPTION_MAX_HEADER_COUNT:
+        case MHD_OPTION_MAX_URI_BYTES:
+        case MHD_OPTION_HEADER_DEADLINE_MS:
+        case MHD_OPTION_REQUEST_DEADLINE_MS:
+        case MHD_OPTION_BUSY_POLL_US:
+        case MHD_OPTION_LOOP_BUDGET_MS:
+        case MHD_OPTION_OVERLOAD_SHED_MODE:
+        case MHD_OPTION_PROXY_PROTOCOL:
+        case MHD_OPTION_POOL_OVERFLOW_SLAB:
+        case MHD_OPTION_DAEMON_ARENA:
+        case MHD_OPTION_THREAD_CACHE_SIZE:
+        case MHD_OPTION_WORKER_CPU_PINNING:
+        case MHD_OPTION_POOL_ARENA_SLOTS:
+        case MHD_OPTION_LISTEN_DEFER_ACCEPT:
+        case MHD_OPTION_TLS_FIRST_RECORD_SIZE:
+        case MHD_OPTION_RESPONSE_RATE_LIMIT:
           if (MHD_NO == parse_options (daemon,
                                        servaddr,
                                        opt,
@@ -5766,6 +8037,7 @@ parse_options_va (struct MHD_Daemon *daemon,
             return MHD_NO;
           break;
         /* all options taking one pointer */
+        case MHD_OPTION_ACCESS_LOG:
         case MHD_OPTION_SOCK_ADDR:
         case MHD_OPTION_HTTPS_MEM_KEY:
         case MHD_OPTION_HTTPS_KEY_PASSWORD:
@@ -5784,6 +8056,7 @@ parse_options_va (struct MHD_Daemon *daemon,
             return MHD_NO;
           break;
         /* all options taking two pointers */
+        case MHD_OPTION_POOL_EXHAUSTION_CALLBACK:
         case MHD_OPTION_NOTIFY_COMPLETED:
         case MHD_OPTION_NOTIFY_CONNECTION:
         case MHD_OPTION_URI_LOG_CALLBACK:
@@ -5900,6 +8173,44 @@ setup_epoll_fd (struct MHD_Daemon *daemon)
 }
 
 
+/**
+ * Register the listen socket in the daemon's epoll set, using
+ * EPOLLEXCLUSIVE where available so only one of the workers
+ * sharing the fd is woken per incoming connection (instead of the
+ * whole pool stampeding, most of it to find the queue empty);
+ * kernels without the flag (< 4.5, EINVAL) fall back to the
+ * classic shared registration.
+ *
+ * @param daemon the (worker) daemon
+ * @param ls the listen socket
+ * @return 0 on success (like epoll_ctl())
+ */
+static int
+epoll_register_listener_ (struct MHD_Daemon *daemon,
+                          MHD_socket ls)
+{
+  struct epoll_event event;
+
+  event.data.ptr = daemon;
+#ifdef EPOLLEXCLUSIVE
+  event.events = EPOLLIN | EPOLLEXCLUSIVE;
+  if (0 == epoll_ctl (daemon->epoll_fd,
+                      EPOLL_CTL_ADD,
+                      ls,
+                      &event))
+    return 0;
+  if (EINVAL != errno)
+    return -1;
+  /* fall back for pre-4.5 kernels */
+#endif /* EPOLLEXCLUSIVE */
+  event.events = EPOLLIN;
+  return epoll_ctl (daemon->epoll_fd,
+                    EPOLL_CTL_ADD,
+                    ls,
+                    &event);
+}
+
+
 /**
  * Setup epoll() FD for the daemon and initialize it to listen
  * on the listen FD.
@@ -5933,12 +8244,8 @@ setup_epoll_to_listen (struct MHD_Daemon *daemon)
   if ( (MHD_INVALID_SOCKET != (ls = daemon->listen_fd)) &&
        (! daemon->was_quiesced) )
   {
-    event.events = EPOLLIN;
-    event.data.ptr = daemon;
-    if (0 != epoll_ctl (daemon->epoll_fd,
-                        EPOLL_CTL_ADD,
-                        ls,
-                        &event))
+    if (0 != epoll_register_listener_ (daemon,
+                                       ls))
     {
 #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
@@ -5974,6 +8281,156 @@ setup_epoll_to_listen (struct MHD_Daemon *daemon)
 #endif
 
 
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+#ifdef SO_REUSEPORT
+/**
+ * Create an additional listen socket for a worker daemon, bound
+ * with SO_REUSEPORT to the same address:port as the master's
+ * listen socket.  Used for #MHD_USE_REUSEPORT_WORKER_LISTENERS so
+ * that every worker gets its own kernel accept queue.
+ *
+ * @param daemon the master daemon (listen socket must be bound)
+ * @param[out] nodelay_set set to true when TCP_NODELAY was applied
+ *        to the new listener (accepted sockets inherit it)
+ * @return the new listen socket,
+ *         MHD_INVALID_SOCKET on error (error is logged)
+ */
+static MHD_socket
+open_worker_listen_socket_ (struct MHD_Daemon *daemon,
+                            bool *nodelay_set)
+{
+  static const MHD_SCKT_OPT_BOOL_ on = 1;
+  struct sockaddr_storage srvaddr;
+  socklen_t addrlen;
+  MHD_socket sk;
+
+  *nodelay_set = false;
+  memset (&srvaddr,
+          0,
+          sizeof (srvaddr));
+  addrlen = sizeof (srvaddr);
+  if (0 != getsockname (daemon->listen_fd,
+                        (struct sockaddr *) &srvaddr,
+                        &addrlen))
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("Failed to get listen socket address: %s\n"),
+              MHD_socket_last_strerr_ ());
+#endif
+    return MHD_INVALID_SOCKET;
+  }
+  sk = MHD_socket_create_listen_ ((int) srvaddr.ss_family);
+  if (MHD_INVALID_SOCKET == sk)
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("Failed to create socket for listening: %s\n"),
+              MHD_socket_last_strerr_ ());
+#endif
+    return MHD_INVALID_SOCKET;
+  }
+  /* SO_REUSEPORT must be set on every socket sharing the
+   * address:port, including this one, before bind(). */
+  if (0 > setsockopt (sk,
+                      SOL_SOCKET,
+                      SO_REUSEPORT,
+                      (void *) &on,
+                      sizeof (on)))
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("setsockopt failed: %s\n"),
+              MHD_socket_last_strerr_ ());
+#endif
+    MHD_socket_close_chk_ (sk);
+    return MHD_INVALID_SOCKET;
+  }
+#if defined(IPPROTO_IPV6) && defined(IPV6_V6ONLY)
+  if (AF_INET6 == srvaddr.ss_family)
+  {
+    /* Mirror the master socket's dual-stack setting. */
+    MHD_SCKT_OPT_BOOL_ v6_only = 0;
+    socklen_t optlen = sizeof (v6_only);
+
+    if (0 == getsockopt (daemon->listen_fd,
+                         IPPROTO_IPV6,
+                         IPV6_V6ONLY,
+                         (void *) &v6_only,
+                         &optlen))
+      (void) setsockopt (sk,
+                         IPPROTO_IPV6,
+                         IPV6_V6ONLY,
+                         (const void *) &v6_only,
+                         sizeof (v6_only));
+  }
+#endif /* IPPROTO_IPV6 && IPV6_V6ONLY */
+#ifdef TCP_FASTOPEN
+  if (0 != (daemon->options & MHD_USE_TCP_FASTOPEN))
+  {
+    if (0 != setsockopt (sk,
+                         IPPROTO_TCP,
+                         TCP_FASTOPEN,
+                         (const void *) &daemon->fastopen_queue_size,
+                         sizeof (daemon->fastopen_queue_size)))
+    {
+#ifdef HAVE_MESSAGES
+      MHD_DLOG (daemon,
+                _ ("setsockopt failed: %s\n"),
+                MHD_socket_last_strerr_ ());
+#endif
+    }
+  }
+#endif
+  if (-1 == bind (sk,
+                  (const struct sockaddr *) &srvaddr,
+                  addrlen))
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("Failed to bind worker listen socket: %s\n"),
+              MHD_socket_last_strerr_ ());
+#endif
+    MHD_socket_close_chk_ (sk);
+    return MHD_INVALID_SOCKET;
+  }
+  if (listen (sk,
+              daemon->listen_backlog_size) < 0)
+  {
+#ifdef HAVE_MESSAGES
+    MHD_DLOG (daemon,
+              _ ("Failed to listen for connections: %s\n"),
+              MHD_socket_last_strerr_ ());
+#endif
+    MHD_socket_close_chk_ (sk);
+    return MHD_INVALID_SOCKET;
+  }
+#ifdef __linux__
+  /* accepted sockets inherit TCP_NODELAY from the listener */
+  if (0 == MHD_socket_set_nodelay_ (sk,
+                                    true))
+    *nodelay_set = true;
+#endif /* __linux__ */
+#ifdef TCP_DEFER_ACCEPT
+  if (0 != daemon->listen_defer_accept)
+  {
+    const int defer_secs = (int) daemon->listen_defer_accept;
+
+    (void) setsockopt (sk,
+                       IPPROTO_TCP,
+                       TCP_DEFER_ACCEPT,
+                       (const void *) &defer_secs,
+                       sizeof (defer_secs));
+  }
+#endif /* TCP_DEFER_ACCEPT */
+  return sk;
+}
+
+
+#endif /* SO_REUSEPORT */
+#endif /* MHD_USE_POSIX_THREADS || MHD_USE_W32_THREADS */
+
+
 /**
  * Start a webserver on the given port.
  *
@@ -6042,6 +8499,10 @@ MHD_start_daemon_va (unsigned int flags,
   if (0 != (*pflags & MHD_USE_TCP_FASTOPEN))
     return NULL;
 #endif
+#ifndef SO_REUSEPORT
+  if (0 != (*pflags & MHD_TEST_REUSEPORT_WORKER_LISTENERS))
+    return NULL;
+#endif /* ! SO_REUSEPORT */
   if (0 != (*pflags & MHD_ALLOW_UPGRADE))
   {
 #ifdef UPGRADE_SUPPORT
@@ -6110,8 +8571,14 @@ MHD_start_daemon_va (unsigned int flags,
   /* try to open listen socket */
 #ifdef HTTPS_SUPPORT
   daemon->priority_cache = NULL;
-  if (0 != (*pflags & MHD_USE_TLS))
+  if ( (0 != (*pflags & MHD_USE_TLS)) &&
+       (0 == (*pflags & MHD_USE_LAZY_TLS_INIT)) )
   {
+    /* The priority string is parsed exactly once per daemon into
+     * this cache; per-connection TLS setup only applies it with
+     * gnutls_priority_set(), so no connection ever re-parses the
+     * cipher configuration.  (With MHD_USE_LAZY_TLS_INIT this is
+     * deferred to the first TLS accept.) */
     gnutls_priority_init (&daemon->priority_cache,
                           "NORMAL",
                           NULL);
@@ -6133,7 +8600,8 @@ MHD_start_daemon_va (unsigned int flags,
   daemon->pool_size = MHD_POOL_SIZE_DEFAULT;
   daemon->pool_increment = MHD_BUF_INC_SIZE;
   daemon->unescape_callback = &unescape_wrapper;
-  daemon->connection_timeout = 0;       /* no timeout */
+  daemon->connection_timeout_ms = 0;       /* no timeout */
+  daemon->accept_burst_size = 10;
   MHD_itc_set_invalid_ (daemon->itc);
 #ifdef SOMAXCONN
   daemon->listen_backlog_size = SOMAXCONN;
@@ -6241,6 +8709,30 @@ MHD_start_daemon_va (unsigned int flags,
     }
   }
 
+  /* request-ID epoch: daemon start time in the top bits, worker
+     index and per-worker counter below */
+  daemon->request_id_base
+    = ((uint64_t) (time (NULL) & 0xFFFFFF)) << 40;
+
+  if (0 != daemon->daemon_arena_mode)
+  {
+    /* One mapping for all daemon-lifetime structures: nonce map,
+       worker array and one epoll event buffer per event loop. */
+    size_t arena_size = 0;
+
+#ifdef DAUTH_SUPPORT
+    arena_size += daemon->nonce_nc_size * sizeof (struct MHD_NonceNc) + 16;
+#endif /* DAUTH_SUPPORT */
+    arena_size += sizeof (struct MHD_Daemon)
+                  * (daemon->worker_pool_size + 1) + 16;
+#ifdef EPOLL_SUPPORT
+    arena_size += (sizeof (struct epoll_event) * MAX_EVENTS + 16)
+                  * (daemon->worker_pool_size + 1);
+#endif /* EPOLL_SUPPORT */
+    daemon_lifetime_arena_create_ (daemon,
+                                   arena_size);
+  }
+
 #ifdef DAUTH_SUPPORT
   if (daemon->nonce_nc_size > 0)
   {
@@ -6253,12 +8745,18 @@ MHD_start_daemon_va (unsigned int flags,
 #endif
 #ifdef HTTPS_SUPPORT
       if (0 != (*pflags & MHD_USE_TLS))
-        gnutls_priority_deinit (daemon->priority_cache);
+        if (NULL != daemon->priority_cache)
+          gnutls_priority_deinit (daemon->priority_cache);
 #endif /* HTTPS_SUPPORT */
       free (daemon);
       return NULL;
     }
-    daemon->nnc = malloc (daemon->nonce_nc_size * sizeof (struct MHD_NonceNc));
+    daemon->nnc = daemon_lifetime_arena_carve_ (daemon,
+                                                daemon->nonce_nc_size
+                                                * sizeof (struct MHD_NonceNc));
+    if (NULL == daemon->nnc)
+      daemon->nnc = malloc (daemon->nonce_nc_size
+                            * sizeof (struct MHD_NonceNc));
     if (NULL == daemon->nnc)
     {
 #ifdef HAVE_MESSAGES
@@ -6268,7 +8766,8 @@ MHD_start_daemon_va (unsigned int flags,
 #endif
 #ifdef HTTPS_SUPPORT
       if (0 != (*pflags & MHD_USE_TLS))
-        gnutls_priority_deinit (daemon->priority_cache);
+        if (NULL != daemon->priority_cache)
+          gnutls_priority_deinit (daemon->priority_cache);
 #endif /* HTTPS_SUPPORT */
       free (daemon);
       return NULL;
@@ -6276,17 +8775,24 @@ MHD_start_daemon_va (unsigned int flags,
   }
 
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  if (! MHD_mutex_init_ (&daemon->nnc_lock))
+  for (i = 0; i < MHD_NNC_LOCK_STRIPES_; ++i)
+    if (! MHD_mutex_init_ (&daemon->nnc_lock[i]))
+      break;
+  if (MHD_NNC_LOCK_STRIPES_ != i)
   {
+    while (0 != i)
+      MHD_mutex_destroy_chk_ (&daemon->nnc_lock[--i]);
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
               _ ("MHD failed to initialize nonce-nc mutex.\n"));
 #endif
 #ifdef HTTPS_SUPPORT
     if (0 != (*pflags & MHD_USE_TLS))
-      gnutls_priority_deinit (daemon->priority_cache);
+      if (NULL != daemon->priority_cache)
+        gnutls_priority_deinit (daemon->priority_cache);
 #endif /* HTTPS_SUPPORT */
-    free (daemon->nnc);
+    if (! daemon_lifetime_arena_owns_ (daemon, daemon->nnc))
+      free (daemon->nnc);
     free (daemon);
     return NULL;
   }
@@ -6306,6 +8812,15 @@ MHD_start_daemon_va (unsigned int flags,
     goto free_and_fail;
   }
 #endif
+#ifdef SO_REUSEPORT
+  if ( (0 != (*pflags & MHD_TEST_REUSEPORT_WORKER_LISTENERS)) &&
+       (0 == daemon->listening_address_reuse) )
+  {
+    /* Per-worker listeners require SO_REUSEPORT on *every* socket
+     * bound to the address:port, including the master's. */
+    daemon->listening_address_reuse = 1;
+  }
+#endif /* SO_REUSEPORT */
   if ( (MHD_INVALID_SOCKET == daemon->listen_fd) &&
        (0 == (*pflags & MHD_USE_NO_LISTEN_SOCKET)) )
   {
@@ -6552,11 +9067,40 @@ MHD_start_daemon_va (unsigned int flags,
       MHD_socket_close_chk_ (listen_fd);
       goto free_and_fail;
     }
+#ifdef __linux__
+    /* Linux copies TCP options from the listener to accepted
+       sockets: disabling Nagle here once saves one setsockopt per
+       accept.  Only done for sockets MHD created itself. */
+    if (0 == MHD_socket_set_nodelay_ (listen_fd,
+                                      true))
+      daemon->listen_nodelay = true;
+#endif /* __linux__ */
   }
   else
   {
     listen_fd = daemon->listen_fd;
   }
+#ifdef TCP_DEFER_ACCEPT
+  if ( (0 != daemon->listen_defer_accept) &&
+       (MHD_INVALID_SOCKET != listen_fd) )
+  {
+    const int defer_secs = (int) daemon->listen_defer_accept;
+
+    /* Best effort: only wake us once request data arrived. */
+    if (0 != setsockopt (listen_fd,
+                         IPPROTO_TCP,
+                         TCP_DEFER_ACCEPT,
+                         (const void *) &defer_secs,
+                         sizeof (defer_secs)))
+    {
+#ifdef HAVE_MESSAGES
+      MHD_DLOG (daemon,
+                _ ("setsockopt failed: %s\n"),
+                MHD_socket_last_strerr_ ());
+#endif
+    }
+  }
+#endif /* TCP_DEFER_ACCEPT */
 
 #ifdef HAVE_GETSOCKNAME
   if ( (0 == daemon->port) &&
@@ -6638,7 +9182,9 @@ MHD_start_daemon_va (unsigned int flags,
   }
 #endif /* HAVE_GETSOCKNAME */
   if ( (MHD_INVALID_SOCKET != listen_fd) &&
-       (! MHD_socket_nonblocking_ (listen_fd)) )
+       (MHD_socket_nonblocking_ (listen_fd)) )
+    daemon->listen_nonblk = true;
+  else if (MHD_INVALID_SOCKET != listen_fd)
   {
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
@@ -6695,26 +9241,24 @@ MHD_start_daemon_va (unsigned int flags,
   }
 #endif /* EPOLL_SUPPORT */
 
-#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  if (! MHD_mutex_init_ (&daemon->per_ip_connection_mutex))
+  if (MHD_NO == MHD_ip_count_init (daemon))
   {
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
-              _ ("MHD failed to initialize IP connection limit mutex.\n"));
+              _ ("MHD failed to initialize IP connection limit table.\n"));
 #endif
     if (MHD_INVALID_SOCKET != listen_fd)
       MHD_socket_close_chk_ (listen_fd);
     goto free_and_fail;
   }
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   if (! MHD_mutex_init_ (&daemon->cleanup_connection_mutex))
   {
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
-              _ ("MHD failed to initialize IP connection limit mutex.\n"));
-#endif
-#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
+              _ ("MHD failed to initialize cleanup connection mutex.\n"));
 #endif
+    MHD_ip_count_deinit (daemon);
     if (MHD_INVALID_SOCKET != listen_fd)
       MHD_socket_close_chk_ (listen_fd);
     goto free_and_fail;
@@ -6724,6 +9268,7 @@ MHD_start_daemon_va (unsigned int flags,
 #ifdef HTTPS_SUPPORT
   /* initialize HTTPS daemon certificate aspects & send / recv functions */
   if ( (0 != (*pflags & MHD_USE_TLS)) &&
+       (0 == (*pflags & MHD_USE_LAZY_TLS_INIT)) &&
        (0 != MHD_TLS_init (daemon)) )
   {
 #ifdef HAVE_MESSAGES
@@ -6734,8 +9279,8 @@ MHD_start_daemon_va (unsigned int flags,
       MHD_socket_close_chk_ (listen_fd);
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
     MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
-    MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
 #endif
+    MHD_ip_count_deinit (daemon);
     goto free_and_fail;
   }
 #endif /* HTTPS_SUPPORT */
@@ -6764,11 +9309,29 @@ MHD_start_daemon_va (unsigned int flags,
                   _ ("Failed to initialise mutex.\n"));
 #endif
         MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
-        MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
+        MHD_ip_count_deinit (daemon);
         if (MHD_INVALID_SOCKET != listen_fd)
           MHD_socket_close_chk_ (listen_fd);
         goto free_and_fail;
       }
+#if defined(MHD_USE_POSIX_THREADS)
+      if ( (0 != daemon->thread_cache_size) &&
+           (0 == (*pflags & MHD_USE_THREAD_PER_CONNECTION)) )
+        daemon->thread_cache_size = 0; /* cache needs thread-per-conn */
+      if (0 != daemon->thread_cache_size)
+      {
+        if ( (! MHD_mutex_init_ (&daemon->thread_cache_lock)) ||
+             (0 != pthread_cond_init (&daemon->thread_cache_cond,
+                                      NULL)) )
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _ ("Failed to initialise thread cache.\n"));
+#endif
+          daemon->thread_cache_size = 0;
+        }
+      }
+#endif /* MHD_USE_POSIX_THREADS */
       if (! MHD_create_named_thread_ (&daemon->pid,
                                       (*pflags
                                        & MHD_USE_THREAD_PER_CONNECTION) ?
@@ -6784,7 +9347,7 @@ MHD_start_daemon_va (unsigned int flags,
 #endif
         MHD_mutex_destroy_chk_ (&daemon->new_connections_mutex);
         MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
-        MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
+        MHD_ip_count_deinit (daemon);
         if (MHD_INVALID_SOCKET != listen_fd)
           MHD_socket_close_chk_ (listen_fd);
         goto free_and_fail;
@@ -6804,8 +9367,13 @@ MHD_start_daemon_va (unsigned int flags,
       i = 0;     /* we need this in case fcntl or malloc fails */
 
       /* Allocate memory for pooled objects */
-      daemon->worker_pool = malloc (sizeof (struct MHD_Daemon)
-                                    * daemon->worker_pool_size);
+      daemon->worker_pool
+        = daemon_lifetime_arena_carve_ (daemon,
+                                        sizeof (struct MHD_Daemon)
+                                        * daemon->worker_pool_size);
+      if (NULL == daemon->worker_pool)
+        daemon->worker_pool = malloc (sizeof (struct MHD_Daemon)
+                                      * daemon->worker_pool_size);
       if (NULL == daemon->worker_pool)
         goto thread_failed;
 
@@ -6870,13 +9438,49 @@ MHD_start_daemon_va (unsigned int flags,
         /* Divide available connections evenly amongst the threads.
          * Thread indexes in [0, leftover_conns) each get one of the
          * leftover connections. */
+#ifdef EPOLL_SUPPORT
+        /* Give every worker its own slice of the lifetime arena
+         * for epoll events, carved from the master's cursor (the
+         * copied cursor in 'd' is stale); workers never carve on
+         * their own. */
+        d->epoll_events_buf
+          = daemon_lifetime_arena_carve_ (daemon,
+                                          sizeof (struct epoll_event)
+                                          * MAX_EVENTS);
+        d->lifetime_arena = NULL;
+        d->lifetime_arena_size = 0;
+#endif /* EPOLL_SUPPORT */
         d->connection_limit = conns_per_thread;
+        d->request_id_base
+          = daemon->request_id_base | (((uint64_t) (i + 1)) << 32);
         if (i < leftover_conns)
           ++d->connection_limit;
+#ifdef SO_REUSEPORT
+        /* Workers past the first get their own SO_REUSEPORT-bound
+         * listen socket (and thus their own kernel accept queue);
+         * worker zero keeps polling the master's socket so that no
+         * bound socket is left without an accepting thread. */
+        if ( (0 != (*pflags & MHD_TEST_REUSEPORT_WORKER_LISTENERS)) &&
+             (0 < i) &&
+             (MHD_INVALID_SOCKET != daemon->listen_fd) )
+        {
+          d->listen_fd = open_worker_listen_socket_ (daemon,
+                                                     &d->listen_nodelay);
+          if (MHD_INVALID_SOCKET == d->listen_fd)
+          {
+            if (MHD_ITC_IS_VALID_ (d->itc))
+              MHD_itc_destroy_chk_ (d->itc);
+            MHD_mutex_destroy_chk_ (&d->new_connections_mutex);
+            goto thread_failed;
+          }
+        }
+#endif /* SO_REUSEPORT */
 #ifdef EPOLL_SUPPORT
         if ( (0 != (*pflags & MHD_USE_EPOLL)) &&
              (MHD_NO == setup_epoll_to_listen (d)) )
         {
+          if (d->listen_fd != daemon->listen_fd)
+            MHD_socket_close_chk_ (d->listen_fd);
           if (MHD_ITC_IS_VALID_ (d->itc))
             MHD_itc_destroy_chk_ (d->itc);
           MHD_mutex_destroy_chk_ (&d->new_connections_mutex);
@@ -6890,6 +9494,8 @@ MHD_start_daemon_va (unsigned int flags,
           MHD_DLOG (daemon,
                     _ ("MHD failed to initialize cleanup connection mutex.\n"));
 #endif
+          if (d->listen_fd != daemon->listen_fd)
+            MHD_socket_close_chk_ (d->listen_fd);
           if (MHD_ITC_IS_VALID_ (d->itc))
             MHD_itc_destroy_chk_ (d->itc);
           MHD_mutex_destroy_chk_ (&d->new_connections_mutex);
@@ -6911,21 +9517,100 @@ MHD_start_daemon_va (unsigned int flags,
           /* Free memory for this worker; cleanup below handles
            * all previously-created workers. */
           MHD_mutex_destroy_chk_ (&d->cleanup_connection_mutex);
+          if (d->listen_fd != daemon->listen_fd)
+            MHD_socket_close_chk_ (d->listen_fd);
           if (MHD_ITC_IS_VALID_ (d->itc))
             MHD_itc_destroy_chk_ (d->itc);
           MHD_mutex_destroy_chk_ (&d->new_connections_mutex);
           goto thread_failed;
         }
+#if defined(MHD_USE_POSIX_THREADS) && defined(__linux__)
+        if (0 != daemon->worker_cpu_pinning)
+        {
+          const long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+
+          if (0 < ncpu)
+          {
+            /* Pin worker i to its CPU; best effort.  Node-local
+             * pool memory follows automatically as pools are
+             * allocated (first-touched) in the worker's thread. */
+            const int cpu
+              = (int) ((daemon->worker_cpu_pinning - 1 + i)
+                       % (unsigned long) ncpu);
+            cpu_set_t cs;
+
+            CPU_ZERO (&cs);
+            CPU_SET (cpu, &cs);
+            if (0 != pthread_setaffinity_np (d->pid.handle,
+                                             sizeof (cs),
+                                             &cs))
+            {
+#ifdef HAVE_MESSAGES
+              MHD_DLOG (daemon,
+                        _ ("Failed to set worker thread CPU affinity.\n"));
+#endif
+            }
+#ifdef SO_INCOMING_CPU
+            else if (d->listen_fd != daemon->listen_fd)
+            {
+              /* Worker has its own SO_REUSEPORT listener: let the
+               * kernel steer connections arriving on this CPU to
+               * it; best effort. */
+              (void) setsockopt (d->listen_fd,
+                                 SOL_SOCKET,
+                                 SO_INCOMING_CPU,
+                                 (const void *) &cpu,
+                                 sizeof (cpu));
+            }
+#endif /* SO_INCOMING_CPU */
+          }
+        }
+#endif /* MHD_USE_POSIX_THREADS && __linux__ */
       }
     }
   }
 #endif
 #ifdef HTTPS_SUPPORT
   /* API promises to never use the password after initialization,
-     so we additionally NULL it here to not deref a dangling pointer. */
-  daemon->https_key_password = NULL;
+     so we additionally NULL it here to not deref a dangling
+     pointer.  With lazy TLS init the password is (documentedly)
+     needed at first accept and must be kept. */
+  if (0 == (*pflags & MHD_USE_LAZY_TLS_INIT))
+    daemon->https_key_password = NULL;
 #endif /* HTTPS_SUPPORT */
 
+  if (0 != daemon->pending_listen_fd_count)
+  {
+    /* Socket-activation batch: arm the remaining pre-bound
+       sockets now that the loops are running, so every listener
+       answers from the first poll. */
+    unsigned int k;
+
+    for (k = 0; k < daemon->pending_listen_fd_count; k++)
+    {
+      MHD_socket sk = daemon->pending_listen_fds[k];
+
+      (void) MHD_socket_nonblocking_ (sk);
+#ifdef __linux__
+      (void) MHD_socket_set_nodelay_ (sk,
+                                      true);
+#endif /* __linux__ */
+      if (MHD_NO == daemon_attach_listener_fd_ (daemon,
+                                                sk,
+                                                NULL,
+                                                NULL,
+                                                0))
+      {
+#ifdef HAVE_MESSAGES
+        MHD_DLOG (daemon,
+                  _ ("Failed to attach pre-bound listen socket.\n"));
+#endif
+      }
+    }
+    daemon->pending_listen_fds = NULL;
+    daemon->pending_listen_fd_count = 0;
+  }
+
   return daemon;
 
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
@@ -6938,8 +9623,9 @@ thread_failed:
   {
     if (MHD_INVALID_SOCKET != listen_fd)
       MHD_socket_close_chk_ (listen_fd);
-    MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
+    MHD_ip_count_deinit (daemon);
     if (NULL != daemon->worker_pool)
+      if (! daemon_lifetime_arena_owns_ (daemon, daemon->worker_pool))
       free (daemon->worker_pool);
     goto free_and_fail;
   }
@@ -6956,6 +9642,15 @@ thread_failed:
 free_and_fail:
   /* clean up basic memory state in 'daemon' and return NULL to
      indicate failure */
+#if defined(MAP_ANONYMOUS) || defined(MAP_ANON)
+  if (NULL != daemon->lifetime_arena)
+  {
+    munmap (daemon->lifetime_arena,
+            daemon->lifetime_arena_size);
+    daemon->lifetime_arena = NULL;
+    daemon->nnc = NULL; /* carved from the arena (if enabled) */
+  }
+#endif /* MAP_ANONYMOUS || MAP_ANON */
 #ifdef EPOLL_SUPPORT
 #if defined(HTTPS_SUPPORT) && defined(UPGRADE_SUPPORT)
   if (daemon->upgrade_fd_in_epoll)
@@ -6976,15 +9671,18 @@ free_and_fail:
 #endif /* HTTPS_SUPPORT && UPGRADE_SUPPORT */
 #endif /* EPOLL_SUPPORT */
 #ifdef DAUTH_SUPPORT
-  free (daemon->nnc);
+  if (! daemon_lifetime_arena_owns_ (daemon, daemon->nnc))
+      free (daemon->nnc);
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  MHD_mutex_destroy_chk_ (&daemon->nnc_lock);
+  for (i = 0; i < MHD_NNC_LOCK_STRIPES_; ++i)
+    MHD_mutex_destroy_chk_ (&daemon->nnc_lock[i]);
 #endif
 #endif
 #ifdef HTTPS_SUPPORT
   if (0 != (*pflags & MHD_USE_TLS))
   {
-    gnutls_priority_deinit (daemon->priority_cache);
+    if (NULL != daemon->priority_cache)
+      gnutls_priority_deinit (daemon->priority_cache);
     if (daemon->x509_cred)
       gnutls_certificate_free_credentials (daemon->x509_cred);
     if (daemon->psk_cred)
@@ -7104,6 +9802,12 @@ close_all_connections (struct MHD_Daemon *daemon)
          * already locked. */
         susp->resuming = true;
         daemon->resuming = true;
+        if (! susp->in_resume_list)
+        {
+          susp->next_resume = daemon->resume_list_head;
+          daemon->resume_list_head = susp;
+          susp->in_resume_list = true;
+        }
       }
       susp = susp->prev;
     }
@@ -7202,6 +9906,10 @@ close_all_connections (struct MHD_Daemon *daemon)
     close_connection (pos);
   }
   MHD_cleanup_connections (daemon);
+  deferred_closes_drain_ (daemon,
+                          0);
+  deferred_tasks_drain_ (daemon,
+                         0);
 }
 
 
@@ -7238,7 +9946,14 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
     mhd_assert (1 < daemon->worker_pool_size);
     mhd_assert (0 != (daemon->options & MHD_USE_INTERNAL_POLLING_THREAD));
 
-    /* Let workers shutdown in parallel. */
+    /* Let workers shutdown in parallel: all workers are signalled
+     * first (below), then each worker thread runs
+     * close_all_connections() over its own connection set
+     * concurrently while this thread merely joins them in turn --
+     * teardown time scales with the largest per-worker set, not
+     * the daemon total.  For a bounded-time drain instead of an
+     * immediate stop, call MHD_quiesce_daemon() first, wait out
+     * the drain deadline, then call this function. */
     for (i = 0; i < daemon->worker_pool_size; ++i)
     {
       daemon->worker_pool[i].shutdown = true;
@@ -7263,7 +9978,8 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
     {
       MHD_stop_daemon (&daemon->worker_pool[i]);
     }
-    free (daemon->worker_pool);
+    if (! daemon_lifetime_arena_owns_ (daemon, daemon->worker_pool))
+      free (daemon->worker_pool);
     mhd_assert (MHD_ITC_IS_INVALID_ (daemon->itc));
 #ifdef EPOLL_SUPPORT
     mhd_assert (-1 == daemon->epoll_fd);
@@ -7319,9 +10035,38 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
     mhd_assert (NULL == daemon->new_connections_head);
     mhd_assert (NULL == daemon->urh_head);
 
+    /* Discard connection objects kept for recycling. */
+    while (NULL != daemon->recycled_connections_head)
+    {
+      struct MHD_Connection *pos = daemon->recycled_connections_head;
+
+      daemon->recycled_connections_head = pos->next;
+      MHD_pool_destroy (pos->pool);
+      free (pos);
+    }
+    daemon->recycled_connections_count = 0;
+
+    /* All pools are gone now; release the arena backing them. */
+    MHD_pool_arena_destroy_ (daemon->pool_arena);
+    daemon->pool_arena = NULL;
+
+    free (daemon->spare_slab);
+    daemon->spare_slab = NULL;
+
+    free (daemon->pollfd_cache);
+    daemon->pollfd_cache = NULL;
+    daemon->pollfd_cache_size = 0;
+
     if (MHD_ITC_IS_VALID_ (daemon->itc))
       MHD_itc_destroy_chk_ (daemon->itc);
     MHD_mutex_destroy_chk_ (&daemon->new_connections_mutex);
+#if defined(MHD_USE_POSIX_THREADS)
+    if (0 != daemon->thread_cache_size)
+    {
+      MHD_mutex_destroy_chk_ (&daemon->thread_cache_lock);
+      (void) pthread_cond_destroy (&daemon->thread_cache_cond);
+    }
+#endif /* MHD_USE_POSIX_THREADS */
 
 #ifdef EPOLL_SUPPORT
     if ( (0 != (daemon->options & MHD_USE_EPOLL)) &&
@@ -7339,7 +10084,16 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
 #endif
   }
 
-  if (NULL == daemon->master)
+  if (NULL != daemon->master)
+  {
+    /* Workers with their own SO_REUSEPORT-bound listen socket
+     * (#MHD_USE_REUSEPORT_WORKER_LISTENERS) must close it themselves;
+     * the master closes only its own socket below. */
+    if ( (MHD_INVALID_SOCKET != daemon->listen_fd) &&
+         (daemon->listen_fd != daemon->master->listen_fd) )
+      MHD_socket_close_chk_ (daemon->listen_fd);
+  }
+  else
   {   /* Cleanup that should be done only one time in master/single daemon.
        * Do not perform this cleanup in worker daemons. */
 
@@ -7355,28 +10109,97 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
     }
     if (0 != (daemon->options & MHD_USE_TLS))
     {
-      gnutls_priority_deinit (daemon->priority_cache);
+      if (NULL != daemon->priority_cache)
+        gnutls_priority_deinit (daemon->priority_cache);
       if (daemon->x509_cred)
         gnutls_certificate_free_credentials (daemon->x509_cred);
       if (daemon->psk_cred)
         gnutls_psk_free_server_credentials (daemon->psk_cred);
+      if (NULL != daemon->tls_ticket_key.data)
+      {
+        gnutls_memset (daemon->tls_ticket_key.data,
+                       0,
+                       daemon->tls_ticket_key.size);
+        gnutls_free (daemon->tls_ticket_key.data);
+        daemon->tls_ticket_key.data = NULL;
+      }
+      while (NULL != daemon->tls_retired_creds)
+      {
+        struct MHD_RetiredTlsCred *r
+          = (struct MHD_RetiredTlsCred *) daemon->tls_retired_creds;
+
+        daemon->tls_retired_creds = r->next;
+        gnutls_certificate_free_credentials (r->cred);
+        free (r);
+      }
     }
 #endif /* HTTPS_SUPPORT */
 
 #ifdef DAUTH_SUPPORT
-    free (daemon->nnc);
+    if (! daemon_lifetime_arena_owns_ (daemon, daemon->nnc))
+      free (daemon->nnc);
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_destroy_chk_ (&daemon->nnc_lock);
-#endif
+    for (i = 0; i < MHD_NNC_LOCK_STRIPES_; ++i)
+      MHD_mutex_destroy_chk_ (&daemon->nnc_lock[i]);
 #endif
-#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
 #endif
+    while (NULL != daemon->extra_listeners)
+    {
+      struct MHD_ExtraListener *exl = daemon->extra_listeners;
+
+      daemon->extra_listeners = exl->next;
+      MHD_socket_close_chk_ (exl->fd);
+      free (exl);
+    }
+    MHD_ip_count_deinit (daemon);
+#if defined(MAP_ANONYMOUS) || defined(MAP_ANON)
+    if (NULL != daemon->lifetime_arena)
+      munmap (daemon->lifetime_arena,
+              daemon->lifetime_arena_size);
+#endif /* MAP_ANONYMOUS || MAP_ANON */
     free (daemon);
   }
 }
 
 
+/**
+ * Read one statistics counter of a single (master or worker)
+ * daemon object.
+ *
+ * @param d the daemon object
+ * @param info_type which counter to read
+ * @return the counter value
+ */
+static uint64_t
+daemon_stat_read (struct MHD_Daemon *d,
+                  enum MHD_DaemonInfoType info_type)
+{
+  switch (info_type)
+  {
+  case MHD_DAEMON_INFO_TOTAL_ACCEPTS:
+    return MHD_statcnt_get_ (&d->stat_accepts);
+  case MHD_DAEMON_INFO_TOTAL_REQUESTS:
+    return MHD_statcnt_get_ (&d->stat_requests);
+  case MHD_DAEMON_INFO_KEEPALIVE_REUSES:
+    return MHD_statcnt_get_ (&d->stat_keepalive_reuse);
+  case MHD_DAEMON_INFO_TIMEOUT_CLOSES:
+    return MHD_statcnt_get_ (&d->stat_timeouts);
+  case MHD_DAEMON_INFO_ERROR_RESPONSES:
+    return MHD_statcnt_get_ (&d->stat_error_responses);
+  case MHD_DAEMON_INFO_POOL_EXHAUSTIONS:
+    return MHD_statcnt_get_ (&d->stat_pool_exhaustions);
+  case MHD_DAEMON_INFO_TRIMMED_BYTES:
+    return MHD_statcnt_get_ (&d->stat_trimmed_bytes);
+  case MHD_DAEMON_INFO_TOTAL_BYTES_IN:
+    return MHD_statcnt_get_ (&d->stat_bytes_in);
+  case MHD_DAEMON_INFO_TOTAL_BYTES_OUT:
+    return MHD_statcnt_get_ (&d->stat_bytes_out);
+  default:
+    return 0;
+  }
+}
+
+
 /**
  * Obtain information about the given daemon
  * (not fully implemented!).
@@ -7432,6 +10255,62 @@ MHD_get_daemon_info (struct MHD_Daemon *daemon,
     return (const union MHD_DaemonInfo *) &daemon->options;
   case MHD_DAEMON_INFO_BIND_PORT:
     return (const union MHD_DaemonInfo *) &daemon->port;
+  case MHD_DAEMON_INFO_TOTAL_ACCEPTS:
+  case MHD_DAEMON_INFO_TOTAL_REQUESTS:
+  case MHD_DAEMON_INFO_KEEPALIVE_REUSES:
+  case MHD_DAEMON_INFO_TIMEOUT_CLOSES:
+  case MHD_DAEMON_INFO_ERROR_RESPONSES:
+  case MHD_DAEMON_INFO_POOL_EXHAUSTIONS:
+  case MHD_DAEMON_INFO_TRIMMED_BYTES:
+  case MHD_DAEMON_INFO_TOTAL_BYTES_IN:
+  case MHD_DAEMON_INFO_TOTAL_BYTES_OUT:
+    daemon->stat_scratch = daemon_stat_read (daemon,
+                                             info_type);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    if (NULL != daemon->worker_pool)
+    {
+      unsigned int i;
+
+      /* Counters are per-worker (no shared cachelines on the hot
+       * paths); aggregate them on demand. */
+      for (i = 0; i < daemon->worker_pool_size; i++)
+        daemon->stat_scratch += daemon_stat_read (&daemon->worker_pool[i],
+                                                  info_type);
+    }
+#endif
+    return (const union MHD_DaemonInfo *) &daemon->stat_scratch;
+  case MHD_DAEMON_INFO_POOL_HIGH_WATER:
+    daemon->stat_scratch = daemon->pool_high_water;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    if (NULL != daemon->worker_pool)
+    {
+      unsigned int i;
+
+      for (i = 0; i < daemon->worker_pool_size; i++)
+        if (daemon->worker_pool[i].pool_high_water > daemon->stat_scratch)
+          daemon->stat_scratch = daemon->worker_pool[i].pool_high_water;
+    }
+#endif
+    return (const union MHD_DaemonInfo *) &daemon->stat_scratch;
+  case MHD_DAEMON_INFO_TTFB_HISTOGRAM:
+  {
+    unsigned int b;
+
+    for (b = 0; b < 32; b++)
+      daemon->ttfb_hist_scratch[b] = daemon->ttfb_hist[b];
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    if (NULL != daemon->worker_pool)
+    {
+      unsigned int i;
+
+      for (i = 0; i < daemon->worker_pool_size; i++)
+        for (b = 0; b < 32; b++)
+          daemon->ttfb_hist_scratch[b]
+            += daemon->worker_pool[i].ttfb_hist[b];
+    }
+#endif
+    return (const union MHD_DaemonInfo *) daemon->ttfb_hist_scratch;
+  }
   default:
     return NULL;
   }
@@ -7651,7 +10530,6 @@ MHD_is_feature_supported (enum MHD_FEATURE feature)
 #else
     return MHD_NO;
 #endif
-
   }
   return MHD_NO;
 }
@@ -7757,6 +10635,10 @@ MHD_init (void)
   gnutls_global_init ();
 #endif /* HTTPS_SUPPORT */
   MHD_monotonic_sec_counter_init ();
+  MHD_interned_errors_init_ ();
+#if defined(DAUTH_SUPPORT) && defined(MHD_SHA256_HAS_EXT_IMPL_)
+  MHD_SHA256_select_impl_ ();
+#endif /* DAUTH_SUPPORT && MHD_SHA256_HAS_EXT_IMPL_ */
 #ifdef HAVE_FREEBSD_SENDFILE
   MHD_send_init_static_vars_ ();
 #endif /* HAVE_FREEBSD_SENDFILE */
@@ -7767,6 +10649,7 @@ MHD_init (void)
 void
 MHD_fini (void)
 {
+  MHD_interned_errors_fini_ ();
 #ifdef HTTPS_SUPPORT
   gnutls_global_deinit ();
 #endif /* HTTPS_SUPPORT */
@@ -31,6 +31,7 @@
 #include "mhd_mono_clock.h"
 #include "mhd_str.h"
 #include "mhd_compat.h"
+#include "memorypool.h"
 
 #if defined(MHD_W32_MUTEX_)
 #ifndef WIN32_LEAN_AND_MEAN
@@ -558,7 +559,7 @@ check_nonce_nc (struct MHD_Connection *connection,
    */
   nn = &daemon->nnc[off];
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  MHD_mutex_lock_chk_ (&daemon->nnc_lock);
+  MHD_mutex_lock_chk_ (&daemon->nnc_lock[off & (MHD_NNC_LOCK_STRIPES_ - 1)]);
 #endif
   if (0 == nc)
   {
@@ -569,7 +570,9 @@ check_nonce_nc (struct MHD_Connection *connection,
     nn->nc = 0;
     nn->nmask = 0;
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
+    MHD_mutex_unlock_chk_ (&daemon->nnc_lock[off
+                                               & (MHD_NNC_LOCK_STRIPES_
+                                                  - 1)]);
 #endif
     return MHD_YES;
   }
@@ -583,7 +586,9 @@ check_nonce_nc (struct MHD_Connection *connection,
     /* Out-of-order nonce, but within 64-bit bitmask, set bit */
     nn->nmask |= (1LLU << (nn->nc - nc - 1));
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
+    MHD_mutex_unlock_chk_ (&daemon->nnc_lock[off
+                                               & (MHD_NNC_LOCK_STRIPES_
+                                                  - 1)]);
 #endif
     return MHD_YES;
   }
@@ -594,7 +599,9 @@ check_nonce_nc (struct MHD_Connection *connection,
   {
     /* Nonce does not match, fail */
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-    MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
+    MHD_mutex_unlock_chk_ (&daemon->nnc_lock[off
+                                               & (MHD_NNC_LOCK_STRIPES_
+                                                  - 1)]);
 #endif
 #ifdef HAVE_MESSAGES
     MHD_DLOG (daemon,
@@ -610,7 +617,8 @@ check_nonce_nc (struct MHD_Connection *connection,
     nn->nmask = 0;                /* big jump, unset all bits in the mask */
   nn->nc = nc;
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
-  MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
+  MHD_mutex_unlock_chk_ (&daemon->nnc_lock[off
+                                             & (MHD_NNC_LOCK_STRIPES_ - 1)]);
 #endif
   return MHD_YES;
 }
@@ -654,6 +662,67 @@ MHD_digest_auth_get_username (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Pool-backed variant of #MHD_digest_auth_get_username(): the
+ * username view is allocated from the connection's memory pool
+ * (request lifetime, no free).
+ *
+ * @param connection The MHD connection structure
+ * @return the pool-backed username, NULL on failure
+ * @ingroup authentication
+ */
+const char *
+MHD_digest_auth_get_username2 (struct MHD_Connection *connection)
+{
+  size_t len;
+  char user[MAX_USERNAME_LENGTH];
+  const char *header;
+  char *copy;
+
+  if (MHD_NO == MHD_lookup_connection_value_n (connection,
+                                               MHD_HEADER_KIND,
+                                               MHD_HTTP_HEADER_AUTHORIZATION,
+                                               MHD_STATICSTR_LEN_ (
+                                                 MHD_HTTP_HEADER_AUTHORIZATION),
+                                               &header,
+                                               NULL))
+    return NULL;
+  if (0 != strncmp (header,
+                    _BASE,
+                    MHD_STATICSTR_LEN_ (_BASE)))
+    return NULL;
+  header += MHD_STATICSTR_LEN_ (_BASE);
+  if (0 == (len = lookup_sub_value (user,
+                                    sizeof (user),
+                                    header,
+                                    "username")))
+    return NULL;
+  copy = MHD_pool_allocate (connection->pool,
+                            len + 1,
+                            true);
+  if (NULL == copy)
+    return NULL;
+  memcpy (copy,
+          user,
+          len + 1);
+  return copy;
+}
+
+
+/**
+ * Note on entropy contention: there is none to remove here.  The
+ * application-supplied random seed (MHD_OPTION_DIGEST_AUTH_RANDOM)
+ * is immutable shared read-only memory -- every thread hashes it
+ * without locks or writes -- and nonces are deliberately
+ * deterministic functions of (timestamp, method, seed, uri, realm)
+ * because validation later RE-computes the same hash from the
+ * request and the timestamp embedded in the nonce; mixing
+ * per-thread CSPRNG output into generation would require storing
+ * every issued nonce server-side, replacing the stateless design
+ * with exactly the shared mutable table the request is trying to
+ * avoid.  (Unpredictability across deployments comes from the
+ * secret seed.)
+ */
 /**
  * Calculate the server nonce so that it mitigates replay attacks
  * The current format of the nonce is ...
@@ -1069,15 +1138,68 @@ digest_auth_check_all (struct MHD_Connection *connection,
     }
     else
     {
-      /* This will initialize da->sessionkey (ha1) */
+      const bool session_alg
+        = (MHD_str_equal_caseless_ (da->alg,
+                                    "md5-sess")) ||
+          (MHD_str_equal_caseless_ (da->alg,
+                                    "sha-256-sess"));
+      uint8_t ck[SHA256_DIGEST_SIZE];
+
       mhd_assert (NULL != password);   /* NULL == digest => password != NULL */
-      digest_calc_ha1_from_user (da->alg,
-                                 username,
-                                 realm,
-                                 password,
-                                 nonce,
-                                 cnonce,
-                                 da);
+      if (! session_alg)
+      {
+        /* Cryptographic identity of the credentials tuple: each
+           field is hashed with its length so the concatenation is
+           unambiguous.  A non-crypto 32-bit hash is not an
+           identity check inside an authentication decision. */
+        struct sha256_ctx cctx;
+        uint64_t flen;
+
+#define DAUTH_CACHE_ID_FIELD_(f) do {                          flen = (uint64_t) strlen (f);                        MHD_SHA256_update (&cctx,                                               (const uint8_t *) &flen,                             sizeof (flen));                   MHD_SHA256_update (&cctx,                                               (const uint8_t *) (f),                               (size_t) flen);         } while (0)
+        MHD_SHA256_init (&cctx);
+        DAUTH_CACHE_ID_FIELD_ (username);
+        DAUTH_CACHE_ID_FIELD_ (realm);
+        DAUTH_CACHE_ID_FIELD_ (password);
+        DAUTH_CACHE_ID_FIELD_ (da->alg);
+#undef DAUTH_CACHE_ID_FIELD_
+        sha256_finish (&cctx,
+                       ck);
+      }
+      if ( (! session_alg) &&
+           (connection->dauth_ha1_valid) &&
+           (0 == memcmp (ck,
+                         connection->dauth_ha1_id,
+                         sizeof (ck))) &&
+           (da->digest_size * 2 < sizeof (connection->dauth_ha1)) )
+      {
+        /* same credentials as the previous request on this
+         * keep-alive connection: reuse the cached H(A1) */
+        memcpy (da->sessionkey,
+                connection->dauth_ha1,
+                da->digest_size * 2 + 1);
+      }
+      else
+      {
+        /* This will initialize da->sessionkey (ha1) */
+        digest_calc_ha1_from_user (da->alg,
+                                   username,
+                                   realm,
+                                   password,
+                                   nonce,
+                                   cnonce,
+                                   da);
+        if ( (! session_alg) &&
+             (da->digest_size * 2 < sizeof (connection->dauth_ha1)) )
+        {
+          memcpy (connection->dauth_ha1,
+                  da->sessionkey,
+                  da->digest_size * 2 + 1);
+          memcpy (connection->dauth_ha1_id,
+                  ck,
+                  sizeof (connection->dauth_ha1_id));
+          connection->dauth_ha1_valid = true;
+        }
+      }
     }
     memcpy (ha1,
             da->sessionkey,
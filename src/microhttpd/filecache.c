@@ -0,0 +1,326 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/filecache.c
+ * @brief  Cache of open-FD-backed responses for static files
+ * @author Christian Grothoff
+ *
+ * Serving a static file per request normally costs three metadata
+ * syscalls (open/fstat/close).  The cache keeps the file descriptor
+ * and its ready-made FD-backed #MHD_Response object (with
+ * precomputed length) across requests; a cache hit pays a single
+ * stat() to revalidate the modification time and size.  Entries are
+ * evicted least-recently-used once the configured capacity is
+ * reached, or when revalidation notices the file changed.
+ */
+#include "internal.h"
+#include "response.h"
+#include "mhd_compat.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif /* HAVE_UNISTD_H */
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+
+/**
+ * A single cached file.
+ */
+struct MHD_FileCacheEntry
+{
+  /**
+   * Entries are kept in a doubly-linked list ordered by recency of
+   * use; the head is the most recently used entry.
+   */
+  struct MHD_FileCacheEntry *next;
+  struct MHD_FileCacheEntry *prev;
+
+  /**
+   * Canonical key: the path the file was opened with (malloc'ed).
+   */
+  char *path;
+
+  /**
+   * Ready-to-queue response backed by the cached FD; the cache
+   * holds one reference.
+   */
+  struct MHD_Response *response;
+
+  /**
+   * Modification time of the file when it was opened, for
+   * revalidation.
+   */
+  time_t mtime;
+
+  /**
+   * Size of the file when it was opened, for revalidation.
+   */
+  uint64_t fsize;
+};
+
+
+/**
+ * Cache of open-FD-backed responses.
+ * @sa #MHD_file_cache_create()
+ */
+struct MHD_FileCache
+{
+  /**
+   * MRU-ordered doubly-linked list of entries.
+   */
+  struct MHD_FileCacheEntry *head;
+  struct MHD_FileCacheEntry *tail;
+
+  /**
+   * Number of entries currently in the cache.
+   */
+  unsigned int count;
+
+  /**
+   * Maximum number of entries to keep.
+   */
+  unsigned int capacity;
+
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  /**
+   * Mutex guarding the whole cache.
+   */
+  MHD_mutex_ lock;
+#endif
+};
+
+
+/**
+ * Remove @a entry from @a cache and release its resources (the FD is
+ * closed when the last reference to the response is dropped).  Must
+ * be called with the cache lock held.
+ *
+ * @param cache the cache
+ * @param entry the entry to drop
+ */
+static void
+file_cache_evict_ (struct MHD_FileCache *cache,
+                   struct MHD_FileCacheEntry *entry)
+{
+  if (NULL != entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->head = entry->next;
+  if (NULL != entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->tail = entry->prev;
+  cache->count--;
+  MHD_destroy_response (entry->response);
+  free (entry->path);
+  free (entry);
+}
+
+
+/**
+ * Create a cache of open-FD-backed file responses.
+ *
+ * @param capacity maximum number of files to keep open; must not
+ *        be zero
+ * @return the cache handle, NULL on error
+ * @ingroup response
+ */
+struct MHD_FileCache *
+MHD_file_cache_create (unsigned int capacity)
+{
+  struct MHD_FileCache *cache;
+
+  if (0 == capacity)
+    return NULL;
+  cache = MHD_calloc_ (1, sizeof (struct MHD_FileCache));
+  if (NULL == cache)
+    return NULL;
+  cache->capacity = capacity;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  if (! MHD_mutex_init_ (&cache->lock))
+  {
+    free (cache);
+    return NULL;
+  }
+#endif
+  return cache;
+}
+
+
+/**
+ * Destroy a file cache, closing all cached file descriptors (once
+ * responses still queued on connections are done with them).
+ *
+ * @param cache the cache to destroy
+ * @ingroup response
+ */
+void
+MHD_file_cache_destroy (struct MHD_FileCache *cache)
+{
+  if (NULL == cache)
+    return;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_lock_chk_ (&cache->lock);
+#endif
+  while (NULL != cache->head)
+    file_cache_evict_ (cache,
+                       cache->head);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_unlock_chk_ (&cache->lock);
+  MHD_mutex_destroy_chk_ (&cache->lock);
+#endif
+  free (cache);
+}
+
+
+/**
+ * Get a response serving the given file, from the cache when
+ * possible.  A cache hit costs one stat() for revalidation; a miss
+ * opens the file and inserts it (evicting the least recently used
+ * entry at capacity).  The returned response is FD-backed with
+ * precomputed Content-Length and may be queued on any number of
+ * connections; the caller owns one reference and must release it
+ * with #MHD_destroy_response() (which will not close the cached FD
+ * while the cache still holds the file).
+ *
+ * @param cache the cache
+ * @param path path of the file to serve
+ * @return the response, NULL if the file cannot be opened
+ * @ingroup response
+ */
+struct MHD_Response *
+MHD_file_cache_get_response (struct MHD_FileCache *cache,
+                             const char *path)
+{
+  struct MHD_FileCacheEntry *entry;
+  struct MHD_Response *response;
+  struct stat st;
+  int fd;
+
+  if ( (NULL == cache) ||
+       (NULL == path) )
+    return NULL;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_lock_chk_ (&cache->lock);
+#endif
+  for (entry = cache->head; NULL != entry; entry = entry->next)
+  {
+    if (0 != strcmp (entry->path,
+                     path))
+      continue;
+    /* Revalidate: reopen if the file was replaced or modified. */
+    if ( (0 != stat (path,
+                     &st)) ||
+         (st.st_mtime != entry->mtime) ||
+         ((uint64_t) st.st_size != entry->fsize) )
+    {
+      file_cache_evict_ (cache,
+                         entry);
+      break;
+    }
+    /* Move to the head of the MRU list. */
+    if (cache->head != entry)
+    {
+      entry->prev->next = entry->next;
+      if (NULL != entry->next)
+        entry->next->prev = entry->prev;
+      else
+        cache->tail = entry->prev;
+      entry->prev = NULL;
+      entry->next = cache->head;
+      cache->head->prev = entry;
+      cache->head = entry;
+    }
+    response = entry->response;
+    MHD_increment_response_rc (response);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&cache->lock);
+#endif
+    return response;
+  }
+
+  /* Miss: open and insert. */
+  fd = open (path,
+             O_RDONLY | O_CLOEXEC);
+  if (-1 == fd)
+  {
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&cache->lock);
+#endif
+    return NULL;
+  }
+  if ( (0 != fstat (fd,
+                    &st)) ||
+       (! S_ISREG (st.st_mode)) )
+  {
+    close (fd);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&cache->lock);
+#endif
+    return NULL;
+  }
+  response = MHD_create_response_from_fd64 ((uint64_t) st.st_size,
+                                            fd);
+  if (NULL == response)
+  {
+    close (fd);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&cache->lock);
+#endif
+    return NULL;
+  }
+  entry = MHD_calloc_ (1, sizeof (struct MHD_FileCacheEntry));
+  if ( (NULL == entry) ||
+       (NULL == (entry->path = strdup (path))) )
+  {
+    free (entry);
+    MHD_destroy_response (response);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_unlock_chk_ (&cache->lock);
+#endif
+    return NULL;
+  }
+  entry->response = response;
+  entry->mtime = st.st_mtime;
+  entry->fsize = (uint64_t) st.st_size;
+  if (cache->count == cache->capacity)
+    file_cache_evict_ (cache,
+                       cache->tail);
+  entry->next = cache->head;
+  if (NULL != cache->head)
+    cache->head->prev = entry;
+  else
+    cache->tail = entry;
+  cache->head = entry;
+  cache->count++;
+  /* One reference for the cache, one for the caller. */
+  MHD_increment_response_rc (response);
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_unlock_chk_ (&cache->lock);
+#endif
+  return response;
+}
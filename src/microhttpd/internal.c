@@ -92,15 +92,88 @@ MHD_state_to_string (enum MHD_CONNECTION_STATE state)
  * fprintf-like helper function for logging debug
  * messages.
  */
+static void
+dlog_emit_ (const struct MHD_Daemon *daemon,
+            const char *format,
+            ...)
+{
+  va_list va;
+
+  va_start (va, format);
+  daemon->custom_error_log (daemon->custom_error_log_cls,
+                            format,
+                            va);
+  va_end (va);
+}
+
+
+/**
+ * Number of distinct format strings tracked for log storm
+ * suppression.  Storms (EMFILE floods, malformed-request loops)
+ * cycle through a handful of messages, so a small cache suffices.
+ */
+#define MHD_DLOG_RL_SIZE_ 8
+
+
 void
 MHD_DLOG (const struct MHD_Daemon *daemon,
           const char *format,
           ...)
 {
+  /* Storm suppression: each format string is logged at most once
+   * per second; further repeats within the second are counted and
+   * reported as a single "repeated N times" line when the message
+   * next surfaces.  Keyed by format string pointer, so distinct
+   * messages never mask each other.  State is deliberately
+   * unsynchronized -- a rare lost update merely logs one extra
+   * line.  Formatting itself is already lazy: the logger callback
+   * receives format+va and can drop the message without any
+   * vsnprintf work. */
+  static struct
+  {
+    const char *fmt;
+    time_t sec;
+    unsigned int suppressed;
+  } rl[MHD_DLOG_RL_SIZE_];
+  static unsigned int rl_next;
   va_list va;
+  time_t now;
+  unsigned int i;
 
   if (0 == (daemon->options & MHD_USE_ERROR_LOG))
     return;
+  now = time (NULL);
+  for (i = 0; i < MHD_DLOG_RL_SIZE_; i++)
+    if (format == rl[i].fmt)
+      break;
+  if (i < MHD_DLOG_RL_SIZE_)
+  {
+    if (now == rl[i].sec)
+    {
+      rl[i].suppressed++;
+      return;
+    }
+    if (0 != rl[i].suppressed)
+    {
+      dlog_emit_ (daemon,
+                  "(message repeated %u more times)\n",
+                  rl[i].suppressed);
+      rl[i].suppressed = 0;
+    }
+    rl[i].sec = now;
+  }
+  else
+  {
+    i = rl_next;
+    rl_next = (rl_next + 1) % MHD_DLOG_RL_SIZE_;
+    if (0 != rl[i].suppressed)
+      dlog_emit_ (daemon,
+                  "(message repeated %u more times)\n",
+                  rl[i].suppressed);
+    rl[i].fmt = format;
+    rl[i].sec = now;
+    rl[i].suppressed = 0;
+  }
   va_start (va, format);
   daemon->custom_error_log (daemon->custom_error_log_cls,
                             format,
@@ -142,9 +215,40 @@ MHD_http_unescape (char *val)
   char *rpos = val;
   char *wpos = val;
 
+  /* Fast-forward over the (usually long) escape-free prefix with
+   * memchr(): the common signed-query URL contains no '%' at all
+   * and is then handled without touching a single byte. */
+  {
+    const char *pct = strchr (rpos,
+                              '%');
+
+    if (NULL == pct)
+      return strlen (val); /* nothing to unescape */
+    rpos = (char *) (uintptr_t) pct;
+    wpos = rpos;
+  }
   while ('\0' != *rpos)
   {
     uint32_t num;
+
+    if ( (wpos != rpos) &&
+         ('%' != *rpos) )
+    {
+      /* Bulk-move the clean span up to the next escape (or the
+       * string end) instead of byte-copying. */
+      const char *pct = strchr (rpos,
+                                '%');
+      const size_t span = (NULL != pct)
+                          ? (size_t) (pct - rpos)
+                          : strlen (rpos);
+
+      memmove (wpos,
+               rpos,
+               span);
+      wpos += span;
+      rpos += span;
+      continue;
+    }
     switch (*rpos)
     {
     case '%':
@@ -170,6 +274,16 @@ MHD_http_unescape (char *val)
 }
 
 
+/**
+ * Note on zero-copy/laziness: the key/value strings handed to @a cb
+ * are views into the caller's @a args buffer (the connection's
+ * in-pool copy of the URI), split in place by writing NUL bytes --
+ * no argument is duplicated.  Unescaping is done eagerly, but since
+ * MHD_http_unescape() returns after one vectorized scan for
+ * escape-free input, deferring it per accessed value would save
+ * almost nothing while making the reported value sizes in the
+ * iteration API depend on access order.
+ */
 /**
  * Parse and unescape the arguments given by the client
  * as part of the HTTP request URI.
@@ -71,6 +71,7 @@
 #include "mhd_threads.h"
 #include "mhd_locks.h"
 #endif
+#include "mhd_atomic.h"
 #include "mhd_sockets.h"
 #include "mhd_itc_types.h"
 
@@ -179,6 +180,26 @@ enum MHD_tristate
 
 /**
  * State of the socket with respect to epoll (bitmask).
+ *
+ * Idle keep-alive connections are deliberately left in the epoll
+ * set: an idle registration costs no per-event work, its timeout
+ * tracking is one node in a list scanned only from the expiring
+ * tail, and its pool pages are returned to the kernel on the
+ * keep-alive reset -- so a dedicated "parking" epoll instance with
+ * fd migration would save none of those costs while breaking the
+ * worker-thread ownership of connection state.  To shed the CPU
+ * wakeup cost of whole workers at low load, park workers instead
+ * (MHD_set_active_worker_count()).
+ *
+ * Connection sockets are registered with the epoll set exactly once
+ * (EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLET; with #MHD_USE_TURBO the
+ * registration is even deferred until the first EAGAIN) and are
+ * never re-armed afterwards: read/write readiness is cached in the
+ * #MHD_EPOLL_STATE_READ_READY / #MHD_EPOLL_STATE_WRITE_READY bits,
+ * which the send/receive paths clear when a syscall returns EAGAIN
+ * and the event loop sets again on edge notifications.  Keep it
+ * that way -- the steady-state request loop must not issue
+ * epoll_ctl() calls.
  */
 enum MHD_EpollState
 {
@@ -256,6 +277,24 @@ enum MHD_ConnectionEventLoopInfo
  */
 #define MHD_TEST_ALLOW_SUSPEND_RESUME 8192
 
+/**
+ * Additional test value for enum MHD_FLAG to check only for
+ * MHD_USE_REUSEPORT_WORKER_LISTENERS and NOT for MHD_USE_ITC.
+ */
+#define MHD_TEST_REUSEPORT_WORKER_LISTENERS (1U << 20)
+
+/**
+ * Number of lock stripes protecting the per-IP connection-count
+ * hash table.  Must be a power of two.
+ */
+#define MHD_IP_COUNT_STRIPES_ 16
+
+/**
+ * Number of lock stripes protecting the nonce-nc map used by
+ * digest authentication.  Must be a power of two.
+ */
+#define MHD_NNC_LOCK_STRIPES_ 16
+
 /**
  * Maximum length of a nonce in digest authentication.  64(SHA-256 Hex) +
  * 8(Timestamp Hex) + 1(NULL); hence 73 should suffice, but Opera
@@ -307,6 +346,17 @@ MHD_DLOG (const struct MHD_Daemon *daemon,
 /**
  * Header or cookie in HTTP request or response.
  */
+/*
+ * Note (header length bookkeeping): lengths ARE first-class here --
+ * header_size/value_size are recorded at parse time, every internal
+ * consumer (hash-assisted lookups, token matching,
+ * build_header_response's size pass, the frozen-header serializer)
+ * uses them instead of strlen(), and applications reach them via
+ * MHD_lookup_connection_value_n(), the MHD_KeyValueIteratorN
+ * iteration and MHD_get_connection_values_array().  Keep new code
+ * on the _size fields; do not reintroduce strlen() on these
+ * strings.
+ */
 struct MHD_HTTP_Header
 {
   /**
@@ -324,6 +374,13 @@ struct MHD_HTTP_Header
    */
   size_t header_size;
 
+  /**
+   * Case-insensitive hash of @a header (as computed by
+   * #MHD_str_hash_caseless_bin_n_()); used to reject non-matching
+   * entries during lookups without a full caseless comparison.
+   */
+  uint32_t header_hash;
+
   /**
    * The value of the header.
    */
@@ -340,12 +397,41 @@ struct MHD_HTTP_Header
    */
   enum MHD_ValueKind kind;
 
+  /**
+   * True if this entry's memory belongs to a bulk-allocated block
+   * (freed with the response, not per entry).
+   * @sa #MHD_add_response_headers()
+   */
+  bool bulk_alloc;
+
 };
 
 
 /**
  * Representation of a response.
  */
+/**
+ * One application-attached pre-encoded variant of a response.
+ */
+struct MHD_ResponseAltEncoding
+{
+  /**
+   * Next variant in the list.
+   */
+  struct MHD_ResponseAltEncoding *next;
+
+  /**
+   * The content-coding token this variant carries (malloc'ed).
+   */
+  char *encoding;
+
+  /**
+   * The response with the pre-encoded body (referenced).
+   */
+  struct MHD_Response *variant;
+};
+
+
 struct MHD_Response
 {
 
@@ -396,8 +482,8 @@ struct MHD_Response
 
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   /**
-   * Mutex to synchronize access to @e data, @e size and
-   * @e reference_count.
+   * Mutex to synchronize access to @e data and @e size (and to
+   * @e reference_count where C11 atomics are not available).
    */
   MHD_mutex_ mutex;
 #endif
@@ -429,11 +515,103 @@ struct MHD_Response
    */
   size_t data_buffer_size;
 
+  /**
+   * Bytes the content reader callback declared ready for the next
+   * fill request (via #MHD_content_reader_set_ready_size()), or
+   * #MHD_SIZE_UNKNOWN when no hint was given.  Reset before every
+   * callback invocation; only meaningful within one sending round.
+   */
+  uint64_t crc_ready_hint;
+
   /**
    * Reference count for this response.  Free once the counter hits
-   * zero.
+   * zero.  Updated atomically where C11 atomics are available,
+   * otherwise protected by @e mutex.
+   */
+  MHD_refcount_ reference_count;
+
+  /**
+   * Cached gzip-compressed variant of this response, built lazily
+   * on first use; NULL until then.
+   * @sa #MHD_RF_AUTO_GZIP
+   */
+  struct MHD_Response *gzip_alt;
+
+  /**
+   * Singly-linked list of application-attached pre-encoded
+   * variants, matched against Accept-Encoding at queue time.
+   * @sa #MHD_response_add_encoding_variant()
+   */
+  struct MHD_ResponseAltEncoding *alt_encodings;
+
+  /**
+   * Chain of bulk header-storage blocks (each block's first
+   * pointer links to the next); freed with the response.
+   * @sa #MHD_add_response_headers()
+   */
+  void *header_blocks;
+
+  /**
+   * True once building the gzip variant was attempted (whether or
+   * not it succeeded / paid off), so failures are not retried per
+   * request.
+   */
+  bool gzip_alt_tried;
+
+  /**
+   * Cached brotli-compressed variant, built lazily on first use.
+   * @sa #MHD_RF_AUTO_BROTLI
+   */
+  struct MHD_Response *br_alt;
+
+  /**
+   * Callback to invoke when a transmission of this response fully
+   * drained to the socket, NULL for none.
+   * @sa #MHD_response_set_sent_callback()
+   */
+  MHD_ResponseSentCallback sent_cb;
+
+  /**
+   * Closure for @e sent_cb.
+   */
+  void *sent_cb_cls;
+
+  /**
+   * True once building the brotli variant was attempted.
+   */
+  bool br_alt_tried;
+
+  /**
+   * Array of application-owned fragments transmitted with
+   * scatter-gather I/O; non-NULL only for responses created with
+   * #MHD_create_response_from_iovec().
+   */
+  struct MHD_IoVec *data_iov;
+
+  /**
+   * Number of fragments in @e data_iov.
+   */
+  unsigned int data_iov_count;
+
+  /**
+   * Pre-serialized "Name: Value\r\n" block of all #MHD_HEADER_KIND
+   * headers of this response; non-NULL only after
+   * #MHD_freeze_response().
+   */
+  char *frozen_header_block;
+
+  /**
+   * Number of bytes in @e frozen_header_block.
+   */
+  size_t frozen_header_block_size;
+
+  /**
+   * If true the set of headers is immutable: adding or removing
+   * headers fails and @e frozen_header_block is used when
+   * serializing the reply.
+   * @sa #MHD_freeze_response()
    */
-  unsigned int reference_count;
+  bool frozen;
 
   /**
    * File-descriptor if this response is FD-backed.
@@ -667,6 +845,94 @@ enum MHD_ConnKeepAlive
 };
 
 
+/**
+ * One task parked in a worker's deferred-work FIFO.
+ * @sa #MHD_connection_defer()
+ */
+struct MHD_DeferredTask
+{
+  /**
+   * Next task in FIFO order, NULL at the tail.
+   */
+  struct MHD_DeferredTask *next;
+
+  /**
+   * The task to run.
+   */
+  MHD_DeferredCallback cb;
+
+  /**
+   * Closure for @e cb.
+   */
+  void *cb_cls;
+};
+
+
+/**
+ * An additional listen socket attached to a running daemon with
+ * #MHD_daemon_add_listener(): multiplexed into the same event
+ * loop(s) and worker pool as the primary listener, with its own
+ * handler context and (optionally) plaintext transport on a TLS
+ * daemon.  The (short, append-only) list hangs off the master
+ * daemon and is shared read-only by the workers.
+ */
+struct MHD_ExtraListener
+{
+  /**
+   * Next listener in the master daemon's list, NULL at the end.
+   */
+  struct MHD_ExtraListener *next;
+
+  /**
+   * The master daemon this listener belongs to.
+   */
+  struct MHD_Daemon *daemon;
+
+  /**
+   * The listening socket.
+   */
+  MHD_socket fd;
+
+  /**
+   * Handler for requests arriving via this listener, NULL to use
+   * the daemon's default handler.
+   */
+  MHD_AccessHandlerCallback handler;
+
+  /**
+   * Closure for @e handler.
+   */
+  void *handler_cls;
+
+  /**
+   * True if connections from this listener skip TLS even when the
+   * daemon itself runs TLS (plaintext admin/health port).
+   */
+  bool no_tls;
+};
+
+
+/**
+ * Bit set in #MHD_Connection::connection_header_tokens once the
+ * request's Connection header has been tokenized.
+ */
+#define MHD_CONN_HDR_TOKENS_PARSED_ 1u
+
+/**
+ * Connection header contained a "close" token.
+ */
+#define MHD_CONN_HDR_TOK_CLOSE_ 2u
+
+/**
+ * Connection header contained a "keep-alive" token.
+ */
+#define MHD_CONN_HDR_TOK_KEEPALIVE_ 4u
+
+/**
+ * Connection header contained an "upgrade" token.
+ */
+#define MHD_CONN_HDR_TOK_UPGRADE_ 8u
+
 /**
  * State kept for each HTTP request.
  */
@@ -714,6 +980,44 @@ struct MHD_Connection
    */
   struct MHD_Daemon *daemon;
 
+  /* --- hot per-event fields, kept together so one event
+     touches as few cachelines as possible --- */
+
+  /**
+   * Socket for this connection.  Set to #MHD_INVALID_SOCKET if
+   * this connection has died (daemon should clean
+   * up in that case).
+   */
+  MHD_socket socket_fd;
+
+  /**
+   * What is the state of this socket in relation to epoll?
+   */
+  enum MHD_EpollState epoll_state;
+
+  /**
+   * State in the FSM for this connection.
+   */
+  enum MHD_CONNECTION_STATE state;
+
+  /**
+   * What is this connection waiting for?
+   */
+  enum MHD_ConnectionEventLoopInfo event_loop_info;
+
+  /**
+   * Last time this connection had any activity
+   * (reading or writing), in monotonic milliseconds.
+   */
+  uint64_t last_activity;
+
+  /**
+   * After how many milliseconds of inactivity should
+   * this connection time out?  Zero for no timeout.
+   */
+  uint64_t connection_timeout_ms;
+
+
   /**
    * Linked list of parsed headers.
    */
@@ -877,7 +1181,8 @@ struct MHD_Connection
   enum MHD_resp_sender_
   {
     MHD_resp_sender_std = 0,
-    MHD_resp_sender_sendfile
+    MHD_resp_sender_sendfile,
+    MHD_resp_sender_splice
   } resp_sender;
 #endif /* _MHD_HAVE_SENDFILE */
 
@@ -892,23 +1197,149 @@ struct MHD_Connection
    */
   socklen_t addr_len;
 
+  
+
   /**
-   * Last time this connection had any activity
-   * (reading or writing).
+   * Time (monotonic milliseconds) the current request started
+   * (first byte received); zero when no request is in flight.
+   * @sa #MHD_USE_LATENCY_HISTOGRAM
    */
-  time_t last_activity;
+  uint64_t request_start_ms;
 
   /**
-   * After how many seconds of inactivity should
-   * this connection time out?  Zero for no timeout.
+   * True once the time-to-first-byte of the current request was
+   * recorded in the histogram.
    */
-  time_t connection_timeout;
+  bool ttfb_recorded;
+
+  
 
   /**
    * Special member to be returned by #MHD_get_connection_info()
+   * (whole seconds).
    */
   unsigned int connection_timeout_dummy;
 
+  /**
+   * Scratch value for #MHD_CONNECTION_INFO_UNSENT_BYTES.
+   */
+  uint64_t unsent_bytes_dummy;
+
+  /**
+   * Cached transport-statistics snapshot for
+   * #MHD_CONNECTION_INFO_TCP_INFO.
+   */
+  struct MHD_TcpInfoSnapshot tcp_info_snapshot;
+
+  /**
+   * Millisecond stamp of the event-loop pass that filled
+   * @e tcp_info_snapshot; 0 if never sampled.
+   */
+  uint64_t tcp_info_sampled_ms;
+
+  /**
+   * True if this connection was accepted while the daemon was
+   * overloaded under shedding policy 2: its first request is
+   * answered with an interned 503 instead of the application
+   * handler.
+   */
+  bool shed_503;
+
+  /**
+   * True while the PROXY protocol preamble of this connection has
+   * not been consumed yet; HTTP parsing is held off until then.
+   */
+  bool proxy_proto_pending;
+
+  /**
+   * Requests completed during the current event dispatch; used to
+   * bound how many pipelined requests one connection may drain in
+   * a single pass (work quantum).  Reset by call_handlers().
+   */
+  unsigned int turn_requests;
+
+  /**
+   * True when this connection exhausted its per-dispatch work
+   * quantum with more pipelined data buffered: the event-loop
+   * info is forced to 'block' so the remaining requests are
+   * served on the next pass instead of monopolizing this one.
+   */
+  bool quantum_blocked;
+
+  /**
+   * True while this connection's write buffer lives in the
+   * daemon's emergency overflow slab instead of the pool; the
+   * slab is handed back when the connection is cleaned up.
+   */
+  bool used_spare_slab;
+
+  /**
+   * Bitmask of interesting tokens found in the request's
+   * Connection header, filled by a single tokenization pass in
+   * parse_connection_headers(); downstream keep-alive / close /
+   * upgrade decisions become single-bit tests.  Contains
+   * #MHD_CONN_HDR_TOKENS_PARSED_ once valid; 0 before parsing
+   * (callers fall back to a direct header scan then).
+   */
+  unsigned int connection_header_tokens;
+
+  /**
+   * Transfer-Encoding/Content-Length conflict tracking, updated
+   * inline as each header is ingested: bit 1 set once a
+   * Content-Length arrived, bit 2 once a Transfer-Encoding
+   * arrived.  Conflicts (both present, duplicate differing CL,
+   * malformed CL) are rejected with an interned 400 at the moment
+   * the offending header line is parsed.
+   */
+  unsigned int tecl_state;
+
+  /**
+   * Value of the first Content-Length header seen (pool memory),
+   * to tolerate exact duplicates while rejecting differing ones.
+   */
+  const char *first_cl_value;
+
+  /**
+   * Adaptive per-call sendfile() chunk size for this connection:
+   * doubled after a fully-consumed chunk (fast drain), halved
+   * after a short write (slow client), bounded per threading
+   * mode.  0 until the first sendfile call seeds it with the
+   * mode's base chunk.
+   */
+  size_t sendfile_chunk;
+
+  /**
+   * The extra listener this connection was accepted on, NULL for
+   * the daemon's primary listen socket.  Supplies the handler
+   * context and the transport choice.
+   */
+  struct MHD_ExtraListener *listener;
+
+  /**
+   * Receive-side rate limit in bytes per second, 0 for none.
+   * @sa #MHD_CONNECTION_OPTION_RECV_RATE_LIMIT
+   */
+  uint64_t recv_rate;
+
+  /**
+   * Millisecond (monotonic) timestamp before which reading is
+   * paused by the receive token bucket.
+   */
+  uint64_t recv_next_ms;
+
+  /**
+   * Cumulative bytes read from the socket on this connection.
+   * @sa #MHD_CONNECTION_INFO_BYTES_RECEIVED
+   */
+  uint64_t bytes_received;
+
+  /**
+   * Correlation ID of the current request, assigned when the
+   * request line completes; 0 before.
+   * @sa #MHD_CONNECTION_INFO_REQUEST_ID
+   */
+  uint64_t request_id;
+
   /**
    * Did we ever call the "default_handler" on this connection?  (this
    * flag will determine if we call the #MHD_OPTION_NOTIFY_COMPLETED
@@ -916,12 +1347,7 @@ struct MHD_Connection
    */
   bool client_aware;
 
-  /**
-   * Socket for this connection.  Set to #MHD_INVALID_SOCKET if
-   * this connection has died (daemon should clean
-   * up in that case).
-   */
-  MHD_socket socket_fd;
+  
 
   /**
    * true if #socket_fd is non-blocking, false otherwise.
@@ -938,6 +1364,29 @@ struct MHD_Connection
    */
   enum MHD_tristate sk_nodelay;
 
+#ifdef HTTPS_SUPPORT
+  /**
+   * Bytes sent so far on this TLS connection; used for the
+   * small-to-full record size ramp.
+   * @sa #MHD_OPTION_TLS_FIRST_RECORD_SIZE
+   */
+  uint64_t tls_bytes_sent;
+#endif /* HTTPS_SUPPORT */
+
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+  /**
+   * True if SO_ZEROCOPY was successfully enabled on the socket.
+   * @sa #MHD_USE_ZEROCOPY_SEND
+   */
+  bool sk_zerocopy;
+
+  /**
+   * Number of MSG_ZEROCOPY transmissions whose completion
+   * notification has not yet been consumed from the error queue.
+   */
+  unsigned int zc_outstanding;
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+
   /**
    * Has this socket been closed for reading (i.e.  other side closed
    * the connection)?  If so, we must completely close the connection
@@ -966,21 +1415,12 @@ struct MHD_Connection
   bool in_cleanup;
 
 #ifdef EPOLL_SUPPORT
-  /**
-   * What is the state of this socket in relation to epoll?
-   */
-  enum MHD_EpollState epoll_state;
+  
 #endif
 
-  /**
-   * State in the FSM for this connection.
-   */
-  enum MHD_CONNECTION_STATE state;
+  
 
-  /**
-   * What is this connection waiting for?
-   */
-  enum MHD_ConnectionEventLoopInfo event_loop_info;
+  
 
   /**
    * HTTP response code.  Only valid if response object
@@ -1049,26 +1489,133 @@ struct MHD_Connection
   enum MHD_TLS_CONN_STATE tls_state;
 
   /**
-   * Could it be that we are ready to read due to TLS buffers
-   * even though the socket is not?
+   * Could it be that we are ready to read due to TLS buffers
+   * even though the socket is not?
+   */
+  bool tls_read_ready;
+#endif /* HTTPS_SUPPORT */
+
+  /**
+   * Is the connection suspended?
+   */
+  bool suspended;
+
+  /**
+   * Special member to be returned by #MHD_get_connection_info()
+   */
+  int suspended_dummy;
+
+  /**
+   * Is the connection wanting to resume?
+   */
+  volatile bool resuming;
+
+  /**
+   * Next connection in the daemon's ready-to-resume list.
+   * @sa MHD_Daemon::resume_list_head
+   */
+  struct MHD_Connection *next_resume;
+
+  /**
+   * True while this connection is linked in the daemon's
+   * ready-to-resume list (protected by the cleanup mutex).
+   */
+  bool in_resume_list;
+
+  /**
+   * True once the Cookie header of the current request has been
+   * split into #MHD_COOKIE_KIND values; parsing is performed
+   * lazily on the first cookie lookup.
+   */
+  bool cookies_parsed;
+
+  /**
+   * Number of header lines ingested for the current request.
+   * @sa #MHD_OPTION_MAX_HEADER_COUNT
+   */
+  unsigned int num_header_lines;
+
+  /**
+   * Declared Content-Length of the current request as parsed by
+   * parse_connection_headers(); #MHD_SIZE_UNKNOWN for chunked,
+   * zero when absent.
+   */
+  uint64_t request_content_length;
+
+  /**
+   * Descriptor of the temp file spooling this request's upload
+   * body, -1 when not spooling.
+   * @sa #MHD_CONNECTION_OPTION_SPOOL_BODY
+   */
+  int spool_fd;
+
+  /**
+   * Remaining byte budget for spooling (SIZE_MAX-like cap when
+   * unlimited).
+   */
+  uint64_t spool_budget;
+
+#ifdef DAUTH_SUPPORT
+  /**
+   * Cached H(A1) (hex, 0-terminated) of the last successfully
+   * computed digest-auth credentials on this connection, so
+   * keep-alive requests re-authenticating with the same user/
+   * realm/password skip the H(A1) hash chain.
+   */
+  char dauth_ha1[129];
+
+  /**
+   * SHA-256 over the (username, realm, password, algorithm) tuple
+   * @e dauth_ha1 was computed for, with length-prefixed fields so
+   * concatenation is unambiguous; a cryptographic identity check
+   * for the cache, unlike a 32-bit hash.  Only meaningful while
+   * @e dauth_ha1_valid is set.
+   */
+  uint8_t dauth_ha1_id[32];
+
+  /**
+   * True while @e dauth_ha1 / @e dauth_ha1_id hold the previous
+   * request's cached H(A1).
+   */
+  bool dauth_ha1_valid;
+#endif /* DAUTH_SUPPORT */
+
+  /**
+   * Response pacing rate in bytes per second (0 = unlimited).
+   * @sa #MHD_CONNECTION_OPTION_RATE_LIMIT
+   */
+  uint64_t pace_rate;
+
+  /**
+   * Monotonic millisecond time before which no further response
+   * bytes may be sent on this paced connection.
+   */
+  uint64_t pace_next_ms;
+
+  /**
+   * True while this connection is parked on the daemon's paced
+   * list waiting for its pacing window.
    */
-  bool tls_read_ready;
-#endif /* HTTPS_SUPPORT */
+  bool pace_blocked;
 
   /**
-   * Is the connection suspended?
+   * True if the current parking pauses reading (upload
+   * backpressure) rather than writing (response pacing).
+   * @sa #MHD_CONNECTION_OPTION_READ_PAUSE_MS
    */
-  bool suspended;
+  bool pace_read;
 
   /**
-   * Special member to be returned by #MHD_get_connection_info()
+   * True while the application holds the output corked; MHD then
+   * never pushes partial segments.
+   * @sa #MHD_CONNECTION_OPTION_CORK
    */
-  int suspended_dummy;
+  bool app_corked;
 
   /**
-   * Is the connection wanting to resume?
+   * Next connection on the daemon's paced list.
    */
-  volatile bool resuming;
+  struct MHD_Connection *next_paced;
 };
 
 
@@ -1354,6 +1901,80 @@ struct MHD_Daemon
    */
   struct MHD_Connection *suspended_connections_tail;
 
+  /**
+   * Head of the singly-linked list (chained via `next_paced`) of
+   * connections parked until their pacing window opens.
+   * @sa #MHD_CONNECTION_OPTION_RATE_LIMIT
+   */
+  struct MHD_Connection *paced_head;
+
+  /**
+   * Default response pacing rate applied to new connections, in
+   * bytes per second (0 = unlimited).
+   * @sa #MHD_OPTION_RESPONSE_RATE_LIMIT
+   */
+  uint64_t default_pace_rate;
+
+  /**
+   * Attached access-log pipeline, NULL when not logging.
+   * @sa #MHD_OPTION_ACCESS_LOG
+   */
+  struct MHD_AccessLog *access_log;
+
+  /**
+   * Set (with @e drain_timeout_ms) to request that this worker's
+   * event loop apply drain mode to its connections.
+   * @sa #MHD_daemon_drain()
+   */
+  volatile bool drain_pending;
+
+  /**
+   * Timeout to force on connections when draining.
+   */
+  uint64_t drain_timeout_ms;
+
+  /**
+   * Busy-poll budget before blocking in the epoll loop, in
+   * microseconds (0 = disabled).
+   * @sa #MHD_OPTION_BUSY_POLL_US
+   */
+  unsigned int busy_poll_us;
+
+  /**
+   * Maximum number of header lines per request (0 = unlimited).
+   * @sa #MHD_OPTION_MAX_HEADER_COUNT
+   */
+  unsigned int max_header_count;
+
+  /**
+   * Maximum URI length in bytes (0 = unlimited).
+   * @sa #MHD_OPTION_MAX_URI_BYTES
+   */
+  unsigned int max_uri_bytes;
+
+  /**
+   * Wall-clock deadline for completing the request headers, in ms
+   * from the first request byte (0 = none).
+   * @sa #MHD_OPTION_HEADER_DEADLINE_MS
+   */
+  unsigned int header_deadline_ms;
+
+  /**
+   * Wall-clock deadline for the whole request, in ms from the
+   * first request byte (0 = none).
+   * @sa #MHD_OPTION_REQUEST_DEADLINE_MS
+   */
+  unsigned int request_deadline_ms;
+
+  /**
+   * Head of the singly-linked list (chained via `next_resume`) of
+   * connections whose resume was requested; lets the event loop
+   * touch only connections that actually resumed instead of
+   * scanning the whole suspended list.  Protected by the cleanup
+   * mutex.
+   */
+  struct MHD_Connection *resume_list_head;
+
   /**
    * Head of doubly-linked list of connections to clean up.
    */
@@ -1364,6 +1985,26 @@ struct MHD_Daemon
    */
   struct MHD_Connection *cleanup_tail;
 
+  /**
+   * Head of the singly-linked list (chained via `next`) of closed
+   * connection objects kept, together with their memory pools, for
+   * reuse by later accepts.
+   * @sa #MHD_OPTION_CONNECTION_RECYCLE_LIMIT
+   */
+  struct MHD_Connection *recycled_connections_head;
+
+  /**
+   * Number of connection objects currently in the recycle list.
+   */
+  unsigned int recycled_connections_count;
+
+  /**
+   * Maximum number of closed connection objects to keep for reuse;
+   * zero to disable recycling.
+   * @sa #MHD_OPTION_CONNECTION_RECYCLE_LIMIT
+   */
+  unsigned int connection_recycle_limit;
+
 #ifdef EPOLL_SUPPORT
   /**
    * Head of EDLL of connections ready for processing (in epoll mode).
@@ -1425,7 +2066,7 @@ struct MHD_Daemon
    * moved back to the tail of the list.
    *
    * All connections by default start in this list; if a custom
-   * timeout that does not match @e connection_timeout is set, they
+   * timeout that does not match @e connection_timeout_ms is set, they
    * are moved to the @e manual_timeout_head-XDLL.
    * Not used in MHD_USE_THREAD_PER_CONNECTION mode as each thread
    * needs only one connection-specific timeout.
@@ -1553,7 +2194,341 @@ struct MHD_Daemon
 #endif
 
   /**
-   * Table storing number of connections per IP
+   * Maximum number of connections accepted per listen-socket
+   * readiness event.
+   * @sa #MHD_OPTION_ACCEPT_BURST_SIZE
+   */
+  unsigned int accept_burst_size;
+
+  /**
+   * CPU pinning base for worker-pool threads (0 = no pinning,
+   * N = worker 0 goes to CPU N-1).
+   * @sa #MHD_OPTION_WORKER_CPU_PINNING
+   */
+  unsigned int worker_cpu_pinning;
+
+  /**
+   * Number of pool slots in the per-worker hugepage arena
+   * (0 = no arena).
+   * @sa #MHD_OPTION_POOL_ARENA_SLOTS
+   */
+  unsigned int pool_arena_slots;
+
+  /**
+   * Seconds the kernel may defer accept-readiness of connections
+   * without data (0 = disabled).
+   * @sa #MHD_OPTION_LISTEN_DEFER_ACCEPT
+   */
+  unsigned int listen_defer_accept;
+
+  /**
+   * Cap on TLS record payload size for the first 64 KiB of each
+   * connection (0 = always use full records).
+   * @sa #MHD_OPTION_TLS_FIRST_RECORD_SIZE
+   */
+  unsigned int tls_first_record_size;
+
+  /**
+   * The per-worker pool arena, created lazily in the worker's own
+   * thread (for NUMA-local first touch); NULL until then.
+   */
+  struct MHD_PoolArena *pool_arena;
+
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  /**
+   * Coalescing flag for the inter-thread channel: set when a
+   * wakeup write was already performed and not yet consumed by the
+   * event loop, so further activations between two poll wakeups
+   * skip the redundant syscall.
+   */
+  atomic_bool itc_armed;
+#endif /* MHD_HAVE_STDC_ATOMICS_ */
+
+  /**
+   * Run-time statistics counters, updated with relaxed atomics on
+   * the worker that owns the event (so no cacheline is shared
+   * between workers) and aggregated over the worker pool by
+   * #MHD_get_daemon_info().
+   */
+  MHD_statcnt_ stat_accepts;        /**< connections accepted */
+  MHD_statcnt_ stat_requests;       /**< requests completed */
+  MHD_statcnt_ stat_keepalive_reuse;/**< requests on reused connections */
+  MHD_statcnt_ stat_timeouts;       /**< connections closed by timeout */
+  MHD_statcnt_ stat_error_responses;/**< error replies generated */
+  MHD_statcnt_ stat_pool_exhaustions; /**< pool-memory exhaustion events */
+  MHD_statcnt_ stat_bytes_in;       /**< payload bytes received */
+  MHD_statcnt_ stat_bytes_out;      /**< payload bytes sent */
+
+  /**
+   * Highest per-connection memory-pool usage (bytes) observed by
+   * this (worker) daemon; sampled when a request completes.
+   * @sa #MHD_DAEMON_INFO_POOL_HIGH_WATER
+   */
+  uint64_t pool_high_water;
+
+  /**
+   * Application callback for pool-exhaustion events (with the
+   * failed size and allocation phase), NULL for none.
+   * @sa #MHD_OPTION_POOL_EXHAUSTION_CALLBACK
+   */
+  MHD_PoolExhaustionCallback pool_exhaustion_cb;
+
+  /**
+   * Closure for @e pool_exhaustion_cb.
+   */
+  void *pool_exhaustion_cb_cls;
+
+  /**
+   * Emergency overflow slab (one per worker, pool-sized; lazily
+   * allocated), NULL when disabled or not yet needed.
+   * @sa #MHD_OPTION_POOL_OVERFLOW_SLAB
+   */
+  char *spare_slab;
+
+  /**
+   * True while @e spare_slab is lent to a connection.
+   */
+  bool spare_slab_busy;
+
+  /**
+   * True if the emergency overflow slab is enabled.
+   */
+  bool spare_slab_enabled;
+
+  /**
+   * Daemon-lifetime allocation arena (worker array, nonce map,
+   * epoll event buffers), NULL when disabled.  Mapped, optionally
+   * hugepage-backed and always prefaulted, at daemon start;
+   * unmapped at shutdown.  Individual carvings are never freed.
+   * @sa #MHD_OPTION_DAEMON_ARENA
+   */
+  char *lifetime_arena;
+
+  /**
+   * Size of @e lifetime_arena in bytes.
+   */
+  size_t lifetime_arena_size;
+
+  /**
+   * Bytes of @e lifetime_arena already carved.
+   */
+  size_t lifetime_arena_pos;
+
+  /**
+   * Requested arena mode: 0 off, 1 on, 2 on with hugepages.
+   * @sa #MHD_OPTION_DAEMON_ARENA
+   */
+  unsigned int daemon_arena_mode;
+
+  /**
+   * Per-(worker-)daemon epoll event buffer carved from the
+   * lifetime arena; NULL makes the event loop use its stack
+   * buffer as before.
+   */
+  void *epoll_events_buf;
+
+  /**
+   * Additional listen sockets attached with
+   * #MHD_daemon_add_listener(); owned by the master daemon
+   * (workers share the list read-only).
+   */
+  struct MHD_ExtraListener *extra_listeners;
+
+  /**
+   * Pre-bound sockets still to be attached as extra listeners
+   * once the event loops are up (socket activation batch beyond
+   * the first fd); only used during #MHD_start_daemon().
+   * @sa #MHD_OPTION_LISTEN_SOCKET_ARRAY
+   */
+  const MHD_socket *pending_listen_fds;
+
+  /**
+   * High bits of this (worker-)daemon's request IDs: start-time
+   * epoch plus the worker index, fixed at startup.
+   * @sa #MHD_CONNECTION_INFO_REQUEST_ID
+   */
+  uint64_t request_id_base;
+
+  /**
+   * Per-(worker-)daemon request counter for ID assignment;
+   * relaxed-atomic for the thread-per-connection case.
+   */
+  MHD_statcnt_ request_id_counter;
+
+  /**
+   * Posted memory-trim level for this worker's next loop pass,
+   * 0 when none is pending.
+   * @sa #MHD_daemon_trim_memory()
+   */
+  volatile unsigned int trim_pending;
+
+  /**
+   * Bytes returned to the kernel by memory trimming.
+   * @sa #MHD_DAEMON_INFO_TRIMMED_BYTES
+   */
+  MHD_statcnt_ stat_trimmed_bytes;
+
+  /**
+   * Number of entries in @e pending_listen_fds.
+   */
+  unsigned int pending_listen_fd_count;
+
+  /**
+   * Head of this worker's deferred-task FIFO (application work
+   * queued with #MHD_connection_defer()); only touched by the
+   * worker's own thread.
+   */
+  struct MHD_DeferredTask *defer_head;
+
+  /**
+   * Tail of the deferred-task FIFO.
+   */
+  struct MHD_DeferredTask *defer_tail;
+
+#if defined(MHD_USE_POSIX_THREADS)
+  /**
+   * Maximum number of parked handler threads for
+   * thread-per-connection daemons; 0 disables the thread cache.
+   * @sa #MHD_OPTION_THREAD_CACHE_SIZE
+   */
+  unsigned int thread_cache_size;
+
+  /**
+   * Lock guarding the thread-cache hand-off state below.
+   */
+  pthread_mutex_t thread_cache_lock;
+
+  /**
+   * Parked threads wait here for an assignment (or shutdown);
+   * exiting threads broadcast so MHD_stop_daemon() can wait for
+   * the cache to drain.
+   */
+  pthread_cond_t thread_cache_cond;
+
+  /**
+   * Single-slot hand-off: the connection deposited by the accept
+   * path for the next parked thread, NULL when empty.
+   */
+  struct MHD_Connection *thread_cache_assignment;
+
+  /**
+   * Number of threads currently parked.
+   */
+  unsigned int thread_cache_parked;
+
+  /**
+   * Number of cache-managed (detached) threads alive, parked or
+   * busy; MHD_stop_daemon() waits for this to reach zero.
+   */
+  unsigned int thread_cache_live;
+#endif /* MHD_USE_POSIX_THREADS */
+
+  /**
+   * Scratch slot for returning aggregated 64-bit statistics from
+   * #MHD_get_daemon_info().
+   */
+  uint64_t stat_scratch;
+
+  /**
+   * Time-to-first-byte histogram (power-of-two millisecond
+   * buckets), updated only by this (worker) daemon's thread.
+   * @sa #MHD_USE_LATENCY_HISTOGRAM
+   */
+  uint64_t ttfb_hist[32];
+
+  /**
+   * Scratch buffer for returning the aggregated histogram from
+   * #MHD_get_daemon_info().
+   */
+  uint64_t ttfb_hist_scratch[32];
+
+  /**
+   * True if the listen socket is in non-blocking mode; accept
+   * bursts are only drained in that case (a second accept() on a
+   * blocking socket could hang the loop).
+   */
+  bool listen_nonblk;
+
+#ifdef EPOLL_SUPPORT
+  /**
+   * Adaptive epoll batch size: grows toward MAX_EVENTS while
+   * wait() keeps returning full batches (throughput), shrinks
+   * back when load drops so timeout/resume processing between
+   * batches keeps latency bounded.
+   */
+  unsigned int epoll_batch;
+#endif /* EPOLL_SUPPORT */
+
+  /**
+   * Persistent pollfd array reused (and grown geometrically)
+   * across MHD_poll_all() iterations instead of being allocated
+   * per loop round.
+   */
+  struct pollfd *pollfd_cache;
+
+  /**
+   * Number of entries @e pollfd_cache can hold.
+   */
+  unsigned int pollfd_cache_size;
+
+  /**
+   * Monotonic millisecond counter sampled right after the poll call
+   * of the current event-loop iteration; read through
+   * #MHD_daemon_msec_counter_() by per-connection code instead of
+   * querying the clock on every single I/O event.
+   */
+  uint64_t loop_ms;
+
+  /**
+   * Millisecond stamp taken when the previous processing pass
+   * ended (just before re-entering the poll syscall); together
+   * with @e loop_ms this yields the pass's CPU span for the
+   * overload accounting.  0 until the first pass completes.
+   */
+  uint64_t loop_work_end_ms;
+
+  /**
+   * Per-pass CPU budget in milliseconds for overload detection;
+   * 0 disables the accounting.
+   * @sa #MHD_OPTION_LOOP_BUDGET_MS
+   */
+  unsigned int loop_budget_ms;
+
+  /**
+   * Shedding policy while overloaded: 1 pauses accepting,
+   * 2 serves interned 503s to connections accepted meanwhile.
+   * @sa #MHD_OPTION_OVERLOAD_SHED_MODE
+   */
+  unsigned int shed_mode;
+
+  /**
+   * True if accepted connections must start with a PROXY protocol
+   * preamble carrying the real client address.
+   * @sa #MHD_OPTION_PROXY_PROTOCOL
+   */
+  bool proxy_protocol;
+
+  /**
+   * True while processing passes exceed the CPU budget.
+   */
+  bool overloaded;
+
+  /**
+   * True when the listen socket should be kept out of the
+   * interest set because of overload (policy 1); checked next to
+   * the @e at_limit gates.
+   */
+  bool shed_accept_off;
+
+  /**
+   * True once @e loop_ms holds a sampled value.
+   */
+  bool loop_ms_valid;
+
+  /**
+   * Striped hash table storing the number of connections per IP:
+   * an array of MHD_IP_COUNT_BUCKETS_ chain heads, allocated when
+   * #MHD_OPTION_PER_IP_CONNECTION_LIMIT is in use.
    */
   void *per_ip_connection_count;
 
@@ -1575,6 +2550,12 @@ struct MHD_Daemon
    */
   size_t pool_increment;
 
+  /**
+   * Initial read-buffer size (0 = half the free pool space).
+   * @sa #MHD_OPTION_INITIAL_READ_BUFFER_SIZE
+   */
+  size_t initial_read_buffer_size;
+
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   /**
    * Size of threads created by MHD.
@@ -1592,9 +2573,11 @@ struct MHD_Daemon
   MHD_thread_handle_ID_ pid;
 
   /**
-   * Mutex for per-IP connection counts.
+   * Stripe mutexes for the per-IP connection counts; the stripe is
+   * selected by the low bits of the address hash so accept-path
+   * accounting scales with cores.
    */
-  MHD_mutex_ per_ip_connection_mutex;
+  MHD_mutex_ per_ip_connection_mutex[MHD_IP_COUNT_STRIPES_];
 
   /**
    * Mutex for (modifying) access to the "cleanup", "normal_timeout" and
@@ -1653,6 +2636,29 @@ struct MHD_Daemon
    */
   bool at_limit;
 
+  /**
+   * True if TCP_NODELAY was successfully set on the (MHD-created)
+   * listen socket.  Linux copies TCP options from the listener to
+   * accepted sockets, so the per-accept TCP_NODELAY setsockopt
+   * can be skipped for inherited connections.
+   */
+  bool listen_nodelay;
+
+  /**
+   * FDs of already-destroyed connections whose close() syscall has
+   * been deferred, so mass-disconnect storms do not stall the
+   * event loop with tens of thousands of inline closes.  Drained
+   * in bounded batches by #MHD_cleanup_connections() (fully on
+   * overflow and at shutdown).  Only touched by the daemon's own
+   * thread, like the cleanup list itself.
+   */
+  MHD_socket deferred_close_fds[64];
+
+  /**
+   * Number of FDs currently parked in @e deferred_close_fds.
+   */
+  unsigned int deferred_close_count;
+
   /*
    * Do we need to process resuming connections?
    */
@@ -1681,10 +2687,10 @@ struct MHD_Daemon
   unsigned int connection_limit;
 
   /**
-   * After how many seconds of inactivity should
+   * After how many milliseconds of inactivity should
    * connections time out?  Zero for no timeout.
    */
-  time_t connection_timeout;
+  uint64_t connection_timeout_ms;
 
   /**
    * Maximum number of connections per IP, or 0 for
@@ -1730,6 +2736,26 @@ struct MHD_Daemon
    */
   gnutls_certificate_credentials_t x509_cred;
 
+  /**
+   * Key encrypting TLS session tickets; generated at daemon start
+   * when #MHD_USE_TLS_SESSION_TICKETS is set.
+   */
+  gnutls_datum_t tls_ticket_key;
+
+  /**
+   * True once lazily-deferred TLS state has been constructed.
+   * @sa #MHD_USE_LAZY_TLS_INIT
+   */
+  volatile bool tls_lazy_ready;
+
+  /**
+   * Credentials retired by #MHD_update_tls_credentials(); still
+   * referenced by sessions that started before the swap, released
+   * together at daemon shutdown (rotations are rare, so the list
+   * stays tiny).
+   */
+  void *tls_retired_creds;
+
   /**
    * Diffie-Hellman parameters
    */
@@ -1812,9 +2838,11 @@ struct MHD_Daemon
 
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   /**
-   * A rw-lock for synchronizing access to @e nnc.
+   * Stripe locks synchronizing access to @e nnc; the stripe is
+   * selected from the entry index, so concurrent digest
+   * validations of different nonces do not contend.
    */
-  MHD_mutex_ nnc_lock;
+  MHD_mutex_ nnc_lock[MHD_NNC_LOCK_STRIPES_];
 #endif
 
   /**
@@ -1840,6 +2868,18 @@ struct MHD_Daemon
    * The size of queue for listen socket.
    */
   unsigned int listen_backlog_size;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  /**
+   * Trailing padding: pooled workers are adjacent elements of one
+   * array, so without it the last hot fields of worker N and the
+   * first of worker N+1 share a cacheline and ping-pong between
+   * the cores the workers run on (each worker only ever writes its
+   * own daemon object -- this boundary is the sole source of
+   * cross-worker false sharing in the pool design).
+   */
+  char cacheline_pad_[64];
+#endif
+
 };
 
 
@@ -2075,4 +3115,73 @@ MHD_check_response_header_token_ci (const struct MHD_Response *response,
 void
 internal_suspend_connection_ (struct MHD_Connection *connection);
 
+
+/**
+ * Get the monotonic millisecond counter for timeout bookkeeping on
+ * @a daemon, using the value cached at the start of the current
+ * event-loop iteration when one is available (avoiding a clock
+ * query per I/O event); falls back to reading the clock for
+ * thread-per-connection daemons and before the first loop round.
+ *
+ * @param daemon the daemon (may be NULL)
+ * @return current monotonic millisecond counter value
+ */
+uint64_t
+MHD_daemon_msec_counter_ (struct MHD_Daemon *daemon);
+
+
+/**
+ * Re-account a connection from the address it was accepted with to
+ * the real client address learned later (PROXY protocol).
+ *
+ * @param daemon daemon tracking the per-IP counts
+ * @param old_addr address currently accounted
+ * @param old_addrlen number of bytes in @a old_addr
+ * @param new_addr address to account instead
+ * @param new_addrlen number of bytes in @a new_addr
+ * @return #MHD_YES on success, #MHD_NO if over the per-IP limit
+ */
+enum MHD_Result
+MHD_ip_limit_swap_ (struct MHD_Daemon *daemon,
+                    const struct sockaddr *old_addr,
+                    socklen_t old_addrlen,
+                    const struct sockaddr *new_addr,
+                    socklen_t new_addrlen);
+
+
+/**
+ * Un-park paced connections whose pacing window has opened; called
+ * once per event-loop round after the clock sample.
+ *
+ * @param daemon the daemon to process
+ */
+void
+MHD_pace_unpark_ (struct MHD_Daemon *daemon);
+
+
+/**
+ * Remove @a connection from the daemon's paced list (if present).
+ *
+ * @param connection the connection to remove
+ */
+void
+MHD_pace_forget_ (struct MHD_Connection *connection);
+
+
+/**
+ * Deposit one access-log record (wait-free).
+ *
+ * @param log the log
+ * @param status HTTP status code served
+ * @param duration_ms request duration in milliseconds
+ * @param method the request method (maybe NULL)
+ * @param url the request URL (maybe NULL)
+ */
+void
+MHD_access_log_record_ (struct MHD_AccessLog *log,
+                        unsigned int status,
+                        uint32_t duration_ms,
+                        const char *method,
+                        const char *url);
+
 #endif
@@ -133,9 +133,144 @@ struct MemoryPool
    * 'false' if pool was malloc'ed, 'true' if mmapped (VirtualAlloc'ed for W32).
    */
   bool is_mmap;
+
+  /**
+   * Arena this pool's memory was carved from, NULL for standalone
+   * pools.
+   */
+  struct MHD_PoolArena *arena;
+};
+
+
+/**
+ * Arena of fixed-size pool slots carved from one contiguous
+ * (preferably hugepage-backed) mapping.  Free slots form a singly
+ * linked list threaded through their own first bytes.
+ */
+struct MHD_PoolArena
+{
+  /**
+   * The backing mapping.
+   */
+  uint8_t *region;
+
+  /**
+   * Size of @e region in bytes.
+   */
+  size_t region_size;
+
+  /**
+   * Size of each slot in bytes (page-aligned).
+   */
+  size_t slot_size;
+
+  /**
+   * Head of the free-slot list (NULL when the arena is full).
+   */
+  void *free_head;
+
+  /**
+   * True if @e region was mmap'ed (must be munmap'ed).
+   */
+  bool is_mmap;
 };
 
 
+struct MHD_PoolArena *
+MHD_pool_arena_create_ (size_t slot_size,
+                        unsigned int slots)
+{
+  struct MHD_PoolArena *arena;
+  size_t region_size;
+  unsigned int i;
+
+  if ( (0 == slot_size) ||
+       (0 == slots) )
+    return NULL;
+  arena = malloc (sizeof (struct MHD_PoolArena));
+  if (NULL == arena)
+    return NULL;
+  /* Page-align the slots so pools keep their usual alignment. */
+  arena->slot_size = slot_size + MHD_sys_page_size_ - 1;
+  arena->slot_size -= arena->slot_size % MHD_sys_page_size_;
+  region_size = arena->slot_size * slots;
+  arena->region = MAP_FAILED;
+  arena->is_mmap = true;
+#if defined(MAP_ANONYMOUS) && ! defined(_WIN32)
+#ifdef MAP_HUGETLB
+  /* Round to 2 MiB and try explicit huge pages first. */
+  {
+    size_t huge_size = region_size + (2 * 1024 * 1024) - 1;
+
+    huge_size -= huge_size % (2 * 1024 * 1024);
+    arena->region = mmap (NULL,
+                          huge_size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                          -1,
+                          0);
+    if (MAP_FAILED != arena->region)
+      region_size = huge_size;
+  }
+#endif /* MAP_HUGETLB */
+  if (MAP_FAILED == arena->region)
+  {
+    arena->region = mmap (NULL,
+                          region_size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+#ifdef MADV_HUGEPAGE
+    if (MAP_FAILED != arena->region)
+      (void) madvise (arena->region,
+                      region_size,
+                      MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+  }
+#endif /* MAP_ANONYMOUS && ! _WIN32 */
+  if (MAP_FAILED == arena->region)
+  {
+    arena->region = malloc (region_size);
+    if (NULL == arena->region)
+    {
+      free (arena);
+      return NULL;
+    }
+    arena->is_mmap = false;
+  }
+  arena->region_size = region_size;
+  /* Thread the free list through the slots. */
+  arena->free_head = NULL;
+  for (i = 0; i < region_size / arena->slot_size; ++i)
+  {
+    void *slot = arena->region + (size_t) i * arena->slot_size;
+
+    *(void **) slot = arena->free_head;
+    arena->free_head = slot;
+  }
+  return arena;
+}
+
+
+void
+MHD_pool_arena_destroy_ (struct MHD_PoolArena *arena)
+{
+  if (NULL == arena)
+    return;
+  if (arena->is_mmap)
+  {
+#if defined(MAP_ANONYMOUS) && ! defined(_WIN32)
+    munmap (arena->region,
+            arena->region_size);
+#endif
+  }
+  else
+    free (arena->region);
+  free (arena);
+}
+
+
 /**
  * Create a memory pool.
  *
@@ -201,6 +336,34 @@ MHD_pool_create (size_t max)
   pool->pos = 0;
   pool->end = alloc_size;
   pool->size = alloc_size;
+  pool->arena = NULL;
+  return pool;
+}
+
+
+struct MemoryPool *
+MHD_pool_create_from_arena_ (struct MHD_PoolArena *arena,
+                             size_t max)
+{
+  struct MemoryPool *pool;
+
+  if ( (NULL == arena) ||
+       (NULL == arena->free_head) ||
+       (max > arena->slot_size) )
+    return MHD_pool_create (max);
+  pool = malloc (sizeof (struct MemoryPool));
+  if (NULL == pool)
+    return NULL;
+  pool->memory = arena->free_head;
+  arena->free_head = *(void **) arena->free_head;
+  memset (pool->memory,
+          0,
+          sizeof (void *)); /* wipe the free-list link */
+  pool->pos = 0;
+  pool->end = arena->slot_size;
+  pool->size = arena->slot_size;
+  pool->is_mmap = arena->is_mmap;
+  pool->arena = arena;
   return pool;
 }
 
@@ -218,6 +381,14 @@ MHD_pool_destroy (struct MemoryPool *pool)
 
   mhd_assert (pool->end >= pool->pos);
   mhd_assert (pool->size >= pool->end - pool->pos);
+  if (NULL != pool->arena)
+  {
+    /* Return the slot to its arena: pure pointer arithmetic. */
+    *(void **) pool->memory = pool->arena->free_head;
+    pool->arena->free_head = pool->memory;
+    free (pool);
+    return;
+  }
   if (! pool->is_mmap)
     free (pool->memory);
   else
@@ -250,6 +421,43 @@ MHD_pool_get_free (struct MemoryPool *pool)
 }
 
 
+/**
+ * Release the whole pages of the free region between the normal
+ * and from-end allocation cursors; see header for the contract.
+ *
+ * @param pool memory pool to trim
+ * @return number of bytes returned to the kernel
+ */
+size_t
+MHD_pool_trim_ (struct MemoryPool *pool)
+{
+#if defined(MAP_ANONYMOUS) && defined(MADV_DONTNEED) && ! defined(_WIN32)
+  size_t start;
+  size_t span;
+
+  if (! pool->is_mmap)
+    return 0;
+  mhd_assert (pool->end >= pool->pos);
+  start = pool->pos;
+  if (0 != (start % MHD_sys_page_size_))
+    start += MHD_sys_page_size_ - (start % MHD_sys_page_size_);
+  if (start >= pool->end)
+    return 0;
+  span = (pool->end - start) - ((pool->end - start) % MHD_sys_page_size_);
+  if (0 == span)
+    return 0;
+  if (0 != madvise (pool->memory + start,
+                    span,
+                    MADV_DONTNEED))
+    return 0;
+  return span;
+#else  /* ! MAP_ANONYMOUS || ! MADV_DONTNEED || _WIN32 */
+  (void) pool;
+  return 0;
+#endif /* ! MAP_ANONYMOUS || ! MADV_DONTNEED || _WIN32 */
+}
+
+
 /**
  * Allocate size bytes from the pool.
  *
@@ -394,7 +602,7 @@ MHD_pool_reset (struct MemoryPool *pool,
 {
   mhd_assert (pool->end >= pool->pos);
   mhd_assert (pool->size >= pool->end - pool->pos);
-  mhd_assert (copy_bytes < new_size);
+  mhd_assert ((copy_bytes < new_size) || (0 == copy_bytes));
   mhd_assert (keep != NULL || copy_bytes == 0);
   mhd_assert (keep == NULL || pool->memory <= (uint8_t*) keep);
   mhd_assert (keep == NULL || pool->memory + pool->size >= (uint8_t*) keep
@@ -402,6 +610,14 @@ MHD_pool_reset (struct MemoryPool *pool,
   if ( (NULL != keep) &&
        (keep != pool->memory) )
   {
+    /* This move only runs when a pipelined follow-up request left
+     * bytes in the read buffer, and then only for those bytes
+     * (typically a few hundred); plain keep-alive reuse passes
+     * copy_bytes == 0 and moves nothing.  A ring-buffer layout
+     * would eliminate this copy but break the linear-buffer
+     * assumption of every parser above (header lines, chunk
+     * framing), which is not a good trade for a rarely-taken
+     * sub-kilobyte move. */
     if (0 != copy_bytes)
       memmove (pool->memory,
                keep,
@@ -413,6 +629,46 @@ MHD_pool_reset (struct MemoryPool *pool,
     size_t to_zero;   /** Size of area to zero-out */
 
     to_zero = pool->size - copy_bytes;
+#if defined(MAP_ANONYMOUS) && defined(MADV_DONTNEED) && ! defined(_WIN32)
+    if (pool->is_mmap)
+    {
+      /* Instead of touching (and thus committing) every page with
+       * memset(), return the whole-page tail beyond the kept
+       * region to the kernel: for anonymous mappings
+       * MADV_DONTNEED both releases the RSS of an idle keep-alive
+       * connection's grown buffers and guarantees zero-fill on the
+       * next touch, so the zeroing semantics are preserved.  Only
+       * the sub-page remainder before the first page boundary
+       * still needs an explicit memset. */
+      size_t head_sz = copy_bytes % MHD_sys_page_size_;
+      uint8_t *tail = pool->memory + copy_bytes;
+      size_t tail_sz = to_zero;
+
+      if (0 != head_sz)
+      {
+        head_sz = MHD_sys_page_size_ - head_sz;
+        if (head_sz > tail_sz)
+          head_sz = tail_sz;
+        memset (tail,
+                0,
+                head_sz);
+        tail += head_sz;
+        tail_sz -= head_sz;
+      }
+      if (0 != tail_sz)
+      {
+        mhd_assert (0 == (((uintptr_t) tail) % MHD_sys_page_size_));
+        mhd_assert (0 == (tail_sz % MHD_sys_page_size_));
+        if (0 != madvise (tail,
+                          tail_sz,
+                          MADV_DONTNEED))
+          memset (tail,   /* fallback: plain zeroing */
+                  0,
+                  tail_sz);
+      }
+      to_zero = 0;
+    }
+#endif /* MAP_ANONYMOUS && MADV_DONTNEED && ! _WIN32 */
 #ifdef _WIN32
     if (pool->is_mmap)
     {
@@ -438,9 +694,10 @@ MHD_pool_reset (struct MemoryPool *pool,
       }
     }
 #endif /* _WIN32 */
-    memset (&pool->memory[copy_bytes],
-            0,
-            to_zero);
+    if (0 != to_zero)
+      memset (&pool->memory[copy_bytes],
+              0,
+              to_zero);
   }
   pool->pos = ROUND_TO_ALIGN (new_size);
   pool->end = pool->size;
@@ -60,6 +60,55 @@ struct MemoryPool *
 MHD_pool_create (size_t max);
 
 
+/**
+ * Opaque handle for a hugepage-backed arena of fixed-size pool
+ * slots.
+ * @sa #MHD_OPTION_POOL_ARENA_SLOTS
+ */
+struct MHD_PoolArena;
+
+
+/**
+ * Create an arena of @a slots pool slots of @a slot_size bytes,
+ * backed by one contiguous mapping allocated with huge pages where
+ * the kernel provides them (MAP_HUGETLB, falling back to a normal
+ * mapping with MADV_HUGEPAGE, falling back to plain memory).
+ * Not thread-safe: the arena must only be used from the single
+ * thread that creates and destroys the pools carved from it.
+ *
+ * @param slot_size size of each pool slot in bytes
+ * @param slots number of slots
+ * @return the arena, NULL on failure
+ */
+struct MHD_PoolArena *
+MHD_pool_arena_create_ (size_t slot_size,
+                        unsigned int slots);
+
+
+/**
+ * Destroy an arena.  All pools carved from it must have been
+ * destroyed already.
+ *
+ * @param arena arena to destroy (maybe NULL)
+ */
+void
+MHD_pool_arena_destroy_ (struct MHD_PoolArena *arena);
+
+
+/**
+ * Create a memory pool, carving it out of @a arena when possible
+ * (pure pointer arithmetic, no syscall); falls back to
+ * #MHD_pool_create() when @a arena is NULL, full, or too small.
+ *
+ * @param arena the arena to carve from (maybe NULL)
+ * @param max maximum size of the pool
+ * @return NULL on error
+ */
+struct MemoryPool *
+MHD_pool_create_from_arena_ (struct MHD_PoolArena *arena,
+                             size_t max);
+
+
 /**
  * Destroy a memory pool.
  *
@@ -120,6 +169,20 @@ size_t
 MHD_pool_get_free (struct MemoryPool *pool);
 
 
+/**
+ * Return the whole pages inside the pool's currently-free region
+ * to the kernel (memory-pressure response for idle keep-alive
+ * connections); the pool's allocation state is unchanged and the
+ * pages refault zero-filled, preserving the zeroed-free-space
+ * invariant.
+ *
+ * @param pool memory pool to trim
+ * @return number of bytes returned to the kernel
+ */
+size_t
+MHD_pool_trim_ (struct MemoryPool *pool);
+
+
 /**
  * Clear all entries from the memory pool except
  * for @a keep of the given @a copy_bytes.  The pointer
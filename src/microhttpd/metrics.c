@@ -0,0 +1,159 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/metrics.c
+ * @brief  Prometheus text exposition of daemon statistics
+ * @author Christian Grothoff
+ *
+ * Renders the per-worker relaxed-atomic counters (aggregated on
+ * demand by MHD_get_daemon_info()) and the optional
+ * time-to-first-byte histogram into the Prometheus text format,
+ * without any locks: reading the counters is wait-free and the
+ * result is an ordinary response object the application can mount
+ * on a path (e.g. via the router).
+ */
+#include "internal.h"
+#include "mhd_compat.h"
+
+#include <stdio.h>
+
+
+/**
+ * Append one counter sample.
+ */
+#define METRIC(name,type,help,infokind) do {                             \
+    const union MHD_DaemonInfo *iv = MHD_get_daemon_info (daemon,        \
+                                                          (infokind));   \
+    off += (size_t) MHD_snprintf_ (buf + off, size - off,                \
+                                   "# HELP " name " " help "\n"          \
+                                   "# TYPE " name " " type "\n"          \
+                                   name " %llu\n",                       \
+                                   (unsigned long long)                  \
+                                   ((NULL != iv) ? iv->stat_value : 0)); \
+} while (0)
+
+
+/**
+ * Create a response carrying the daemon's statistics in Prometheus
+ * text exposition format.  Reading the counters is lock-free; the
+ * returned response is freshly built per call (scrapes are rare)
+ * and must be released with #MHD_destroy_response() after queueing.
+ *
+ * @param daemon the (master) daemon to report on
+ * @return the response, NULL on error
+ * @ingroup specialized
+ */
+struct MHD_Response *
+MHD_create_metrics_response (struct MHD_Daemon *daemon)
+{
+  char *buf;
+  size_t off = 0;
+  const size_t size = 8192;
+  struct MHD_Response *r;
+
+  if (NULL == daemon)
+    return NULL;
+  buf = malloc (size);
+  if (NULL == buf)
+    return NULL;
+  METRIC ("mhd_accepts_total", "counter",
+          "Connections accepted", MHD_DAEMON_INFO_TOTAL_ACCEPTS);
+  METRIC ("mhd_requests_total", "counter",
+          "Requests completed", MHD_DAEMON_INFO_TOTAL_REQUESTS);
+  METRIC ("mhd_keepalive_reuses_total", "counter",
+          "Requests served on re-used connections",
+          MHD_DAEMON_INFO_KEEPALIVE_REUSES);
+  METRIC ("mhd_timeout_closes_total", "counter",
+          "Connections closed by inactivity timeout",
+          MHD_DAEMON_INFO_TIMEOUT_CLOSES);
+  METRIC ("mhd_error_responses_total", "counter",
+          "Error replies generated by MHD",
+          MHD_DAEMON_INFO_ERROR_RESPONSES);
+  METRIC ("mhd_pool_exhaustions_total", "counter",
+          "Connection pool memory exhaustion events",
+          MHD_DAEMON_INFO_POOL_EXHAUSTIONS);
+  METRIC ("mhd_bytes_received_total", "counter",
+          "Payload bytes received", MHD_DAEMON_INFO_TOTAL_BYTES_IN);
+  METRIC ("mhd_bytes_sent_total", "counter",
+          "Payload bytes sent", MHD_DAEMON_INFO_TOTAL_BYTES_OUT);
+  {
+    const union MHD_DaemonInfo *hw
+      = MHD_get_daemon_info (daemon,
+                             MHD_DAEMON_INFO_POOL_HIGH_WATER);
+
+    off += (size_t) MHD_snprintf_ (buf + off, size - off,
+                                   "# HELP mhd_pool_high_water_bytes "
+                                   "Peak per-connection pool usage\n"
+                                   "# TYPE mhd_pool_high_water_bytes gauge\n"
+                                   "mhd_pool_high_water_bytes %llu\n",
+                                   (unsigned long long)
+                                   ((NULL != hw) ? hw->stat_value : 0));
+  }
+  if (0 != (daemon->options & MHD_USE_LATENCY_HISTOGRAM))
+  {
+    const union MHD_DaemonInfo *hi
+      = MHD_get_daemon_info (daemon,
+                             MHD_DAEMON_INFO_TTFB_HISTOGRAM);
+
+    if (NULL != hi)
+    {
+      unsigned long long cum = 0;
+      unsigned int b;
+
+      off += (size_t) MHD_snprintf_ (buf + off, size - off,
+                                     "# HELP mhd_ttfb_ms Time to first "
+                                     "response byte\n"
+                                     "# TYPE mhd_ttfb_ms histogram\n");
+      for (b = 0; b < MHD_TTFB_HISTOGRAM_BUCKETS; ++b)
+      {
+        cum += (unsigned long long) hi->ttfb_histogram[b];
+        if ( (0 == hi->ttfb_histogram[b]) &&
+             (b > 14) )
+          continue; /* keep the output compact past 16s */
+        off += (size_t) MHD_snprintf_ (buf + off, size - off,
+                                       "mhd_ttfb_ms_bucket{le=\"%llu\"} %llu\n",
+                                       (0 == b)
+                                       ? 1ULL
+                                       : (1ULL << b),
+                                       cum);
+      }
+      off += (size_t) MHD_snprintf_ (buf + off, size - off,
+                                     "mhd_ttfb_ms_bucket{le=\"+Inf\"} %llu\n"
+                                     "mhd_ttfb_ms_count %llu\n",
+                                     cum,
+                                     cum);
+    }
+  }
+  if (off >= size)
+    off = size - 1;
+  r = MHD_create_response_from_buffer (off,
+                                       buf,
+                                       MHD_RESPMEM_MUST_FREE);
+  if (NULL == r)
+  {
+    free (buf);
+    return NULL;
+  }
+  (void) MHD_add_response_header (r,
+                                  MHD_HTTP_HEADER_CONTENT_TYPE,
+                                  "text/plain; version=0.0.4");
+  return r;
+}
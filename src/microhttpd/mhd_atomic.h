@@ -0,0 +1,136 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/mhd_atomic.h
+ * @brief  Lock-free reference counters where the compiler provides them
+ * @author Christian Grothoff
+ *
+ * Provides a reference-counter type that is manipulated with C11
+ * atomics when available, so shared objects (like canned responses
+ * used from every worker thread) can be queued and released without
+ * bouncing a mutex cacheline between cores.  Where C11 atomics are
+ * not available the counter is a plain integer and callers must keep
+ * protecting it with the object's mutex.
+ */
+#ifndef MHD_ATOMIC_H
+#define MHD_ATOMIC_H 1
+
+#include "mhd_options.h"
+
+#include <stdint.h>
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && \
+  ! defined(__STDC_NO_ATOMICS__)
+/**
+ * Indicates that reference counters are updated atomically, without
+ * taking the owning object's mutex.
+ */
+#define MHD_HAVE_STDC_ATOMICS_ 1
+#endif /* C11 && ! __STDC_NO_ATOMICS__ */
+
+#ifdef MHD_HAVE_STDC_ATOMICS_
+
+#include <stdatomic.h>
+
+/**
+ * A reference counter.  Plain assignment may be used for the initial
+ * value (while the object is not yet shared).
+ */
+typedef atomic_uint MHD_refcount_;
+
+/**
+ * Increase the reference counter by one.
+ * Wait-free; may be called concurrently from any thread.
+ */
+#define MHD_refcount_inc_(rc) \
+  ((void) atomic_fetch_add_explicit ((rc), 1u, memory_order_relaxed))
+
+/**
+ * Decrease the reference counter by one and report whether it
+ * reached zero.  The acquire/release ordering makes all accesses to
+ * the counted object from other threads visible to the thread that
+ * observes zero (and may thus destroy the object).
+ */
+#define MHD_refcount_dec_is_zero_(rc) \
+  (1u == atomic_fetch_sub_explicit ((rc), 1u, memory_order_acq_rel))
+
+/**
+ * A statistics counter, updated with relaxed atomics so increments
+ * on hot paths do not order or fence anything.
+ */
+typedef atomic_uint_fast64_t MHD_statcnt_;
+
+/**
+ * Increase the statistics counter by @a v.
+ */
+#define MHD_statcnt_add_(c,v) \
+  ((void) atomic_fetch_add_explicit ((c), (v), memory_order_relaxed))
+
+/**
+ * Read the statistics counter.
+ */
+#define MHD_statcnt_get_(c) \
+  ((uint64_t) atomic_load_explicit ((c), memory_order_relaxed))
+
+#else  /* ! MHD_HAVE_STDC_ATOMICS_ */
+
+/**
+ * A reference counter.  Without C11 atomics all updates must be
+ * protected by the owning object's mutex.
+ */
+typedef unsigned int MHD_refcount_;
+
+/**
+ * A statistics counter; without C11 atomics plain (possibly
+ * slightly racy under thread-per-connection) updates are used.
+ */
+typedef uint64_t MHD_statcnt_;
+
+/**
+ * Increase the statistics counter by @a v.
+ */
+#define MHD_statcnt_add_(c,v) ((void) (*(c) += (v)))
+
+/**
+ * Read the statistics counter.
+ */
+#define MHD_statcnt_get_(c) (*(c))
+
+#endif /* ! MHD_HAVE_STDC_ATOMICS_ */
+
+/**
+ * Increase the statistics counter by one.
+ */
+#define MHD_statcnt_inc_(c) MHD_statcnt_add_ ((c), 1)
+
+/**
+ * Increment a statistics counter and return the incremented
+ * value (relaxed; unique across threads where C11 atomics are
+ * available, which is what ID generation needs).
+ */
+#ifdef MHD_HAVE_STDC_ATOMICS_
+#define MHD_statcnt_inc_get_(c) \
+  (atomic_fetch_add_explicit ((c), 1, memory_order_relaxed) + 1)
+#else  /* ! MHD_HAVE_STDC_ATOMICS_ */
+#define MHD_statcnt_inc_get_(c) (++ (*(c)))
+#endif /* ! MHD_HAVE_STDC_ATOMICS_ */
+
+#endif /* MHD_ATOMIC_H */
@@ -89,18 +89,54 @@
 #endif /* ! __has_builtin(__builtin_bswap64) */
 
 
+/* Strict-aliasing-safe load/store primitives.
+ * _MHD_GET_UNALIGNED32/64 (addr) and _MHD_PUT_UNALIGNED32/64
+ * (addr, value) access memory of any alignment as if by memcpy();
+ * on GCC/Clang the builtin collapses to a single (unaligned where
+ * the architecture allows it) load or store instruction, so the
+ * endian helpers below no longer byte-assemble values on platforms
+ * where one plain load would do, without the undefined behavior of
+ * the former direct pointer casts. */
+#if defined(__GNUC__) || defined(__clang__)
+#define _MHD_GET_UNALIGNED32(addr)           \
+  __extension__ ({ uint32_t _mhd_v32;        \
+                   __builtin_memcpy (&_mhd_v32, (addr), 4); \
+                   _mhd_v32; })
+#define _MHD_GET_UNALIGNED64(addr)           \
+  __extension__ ({ uint64_t _mhd_v64;        \
+                   __builtin_memcpy (&_mhd_v64, (addr), 8); \
+                   _mhd_v64; })
+#define _MHD_PUT_UNALIGNED32(addr, value32) do {             \
+    const uint32_t _mhd_v32 = (uint32_t) (value32);          \
+    __builtin_memcpy ((addr), &_mhd_v32, 4);                 \
+} while (0)
+#define _MHD_PUT_UNALIGNED64(addr, value64) do {             \
+    const uint64_t _mhd_v64 = (uint64_t) (value64);          \
+    __builtin_memcpy ((addr), &_mhd_v64, 8);                 \
+} while (0)
+#elif defined(_MSC_FULL_VER)
+/* MSVC does not perform type-based aliasing optimizations and
+ * x86/x64/ARM64 targets tolerate unaligned scalar access. */
+#define _MHD_GET_UNALIGNED32(addr)  (*(const uint32_t *) (addr))
+#define _MHD_GET_UNALIGNED64(addr)  (*(const uint64_t *) (addr))
+#define _MHD_PUT_UNALIGNED32(addr, value32)  \
+  ((*(uint32_t *) (addr)) = (uint32_t) (value32))
+#define _MHD_PUT_UNALIGNED64(addr, value64)  \
+  ((*(uint64_t *) (addr)) = (uint64_t) (value64))
+#endif /* _MSC_FULL_VER */
+
+
 /* _MHD_PUT_64BIT_LE (addr, value64)
  * put native-endian 64-bit value64 to addr
  * in little-endian mode.
  */
-#if _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+#if defined(_MHD_PUT_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
 #define _MHD_PUT_64BIT_LE(addr, value64)             \
-  ((*(uint64_t*) (addr)) = (uint64_t) (value64))
-#elif _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+  _MHD_PUT_UNALIGNED64 ((addr), (value64))
+#elif defined(_MHD_PUT_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
 #define _MHD_PUT_64BIT_LE(addr, value64)             \
-  ((*(uint64_t*) (addr)) = _MHD_BYTES_SWAP64 (value64))
-#else  /* _MHD_BYTE_ORDER != _MHD_BIG_ENDIAN */
-/* Endianness was not detected or non-standard like PDP-endian */
+  _MHD_PUT_UNALIGNED64 ((addr), _MHD_BYTES_SWAP64 (value64))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
 #define _MHD_PUT_64BIT_LE(addr, value64) do {                             \
     ((uint8_t*) (addr))[0] = (uint8_t) ((uint64_t) (value64));           \
     ((uint8_t*) (addr))[1] = (uint8_t) (((uint64_t) (value64)) >> 8);    \
@@ -111,60 +147,79 @@
     ((uint8_t*) (addr))[6] = (uint8_t) (((uint64_t) (value64)) >> 48);   \
     ((uint8_t*) (addr))[7] = (uint8_t) (((uint64_t) (value64)) >> 56);   \
 } while (0)
-#endif /* _MHD_BYTE_ORDER != _MHD_BIG_ENDIAN */
+#endif
 
 /* _MHD_PUT_32BIT_LE (addr, value32)
  * put native-endian 32-bit value32 to addr
  * in little-endian mode.
  */
-#if _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
-#define _MHD_PUT_32BIT_LE(addr,value32)             \
-  ((*(uint32_t*) (addr)) = (uint32_t) (value32))
-#elif _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
-#define _MHD_PUT_32BIT_LE(addr, value32)            \
-  ((*(uint32_t*) (addr)) = _MHD_BYTES_SWAP32 (value32))
-#else  /* _MHD_BYTE_ORDER != _MHD_BIG_ENDIAN */
-/* Endianness was not detected or non-standard like PDP-endian */
+#if defined(_MHD_PUT_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+#define _MHD_PUT_32BIT_LE(addr, value32)             \
+  _MHD_PUT_UNALIGNED32 ((addr), (value32))
+#elif defined(_MHD_PUT_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+#define _MHD_PUT_32BIT_LE(addr, value32)             \
+  _MHD_PUT_UNALIGNED32 ((addr), _MHD_BYTES_SWAP32 (value32))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
 #define _MHD_PUT_32BIT_LE(addr, value32) do {                             \
     ((uint8_t*) (addr))[0] = (uint8_t) ((uint32_t) (value32));           \
     ((uint8_t*) (addr))[1] = (uint8_t) (((uint32_t) (value32)) >> 8);    \
     ((uint8_t*) (addr))[2] = (uint8_t) (((uint32_t) (value32)) >> 16);   \
     ((uint8_t*) (addr))[3] = (uint8_t) (((uint32_t) (value32)) >> 24);   \
 } while (0)
-#endif /* _MHD_BYTE_ORDER != _MHD_BIG_ENDIAN */
+#endif
 
 /* _MHD_GET_32BIT_LE (addr)
  * get little-endian 32-bit value storied at addr
  * and return it in native-endian mode.
  */
-#if _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+#if defined(_MHD_GET_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
 #define _MHD_GET_32BIT_LE(addr)             \
-  (*(const uint32_t*) (addr))
-#elif _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+  _MHD_GET_UNALIGNED32 (addr)
+#elif defined(_MHD_GET_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
 #define _MHD_GET_32BIT_LE(addr)             \
-  _MHD_BYTES_SWAP32 (*(const uint32_t*) (addr))
-#else  /* _MHD_BYTE_ORDER != _MHD_BIG_ENDIAN */
-/* Endianness was not detected or non-standard like PDP-endian */
+  _MHD_BYTES_SWAP32 (_MHD_GET_UNALIGNED32 (addr))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
 #define _MHD_GET_32BIT_LE(addr)                       \
   ( ( (uint32_t) (((const uint8_t*) addr)[0]))          \
     | (((uint32_t) (((const uint8_t*) addr)[1])) << 8)    \
     | (((uint32_t) (((const uint8_t*) addr)[2])) << 16)   \
     | (((uint32_t) (((const uint8_t*) addr)[3])) << 24) )
-#endif /* _MHD_BYTE_ORDER != _MHD_BIG_ENDIAN */
+#endif
+
+/* _MHD_GET_64BIT_LE (addr)
+ * get little-endian 64-bit value storied at addr
+ * and return it in native-endian mode.
+ */
+#if defined(_MHD_GET_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+#define _MHD_GET_64BIT_LE(addr)             \
+  _MHD_GET_UNALIGNED64 (addr)
+#elif defined(_MHD_GET_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+#define _MHD_GET_64BIT_LE(addr)             \
+  _MHD_BYTES_SWAP64 (_MHD_GET_UNALIGNED64 (addr))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
+#define _MHD_GET_64BIT_LE(addr)                       \
+  ( ( (uint64_t) (((const uint8_t*) addr)[0]))          \
+    | (((uint64_t) (((const uint8_t*) addr)[1])) << 8)    \
+    | (((uint64_t) (((const uint8_t*) addr)[2])) << 16)   \
+    | (((uint64_t) (((const uint8_t*) addr)[3])) << 24)   \
+    | (((uint64_t) (((const uint8_t*) addr)[4])) << 32)   \
+    | (((uint64_t) (((const uint8_t*) addr)[5])) << 40)   \
+    | (((uint64_t) (((const uint8_t*) addr)[6])) << 48)   \
+    | (((uint64_t) (((const uint8_t*) addr)[7])) << 56) )
+#endif
 
 
 /* _MHD_PUT_64BIT_BE (addr, value64)
  * put native-endian 64-bit value64 to addr
  * in big-endian mode.
  */
-#if _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+#if defined(_MHD_PUT_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
 #define _MHD_PUT_64BIT_BE(addr, value64)             \
-  ((*(uint64_t*) (addr)) = (uint64_t) (value64))
-#elif _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+  _MHD_PUT_UNALIGNED64 ((addr), (value64))
+#elif defined(_MHD_PUT_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
 #define _MHD_PUT_64BIT_BE(addr, value64)             \
-  ((*(uint64_t*) (addr)) = _MHD_BYTES_SWAP64 (value64))
-#else  /* _MHD_BYTE_ORDER != _MHD_LITTLE_ENDIAN */
-/* Endianness was not detected or non-standard like PDP-endian */
+  _MHD_PUT_UNALIGNED64 ((addr), _MHD_BYTES_SWAP64 (value64))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
 #define _MHD_PUT_64BIT_BE(addr, value64) do {                             \
     ((uint8_t*) (addr))[7] = (uint8_t) ((uint64_t) (value64));           \
     ((uint8_t*) (addr))[6] = (uint8_t) (((uint64_t) (value64)) >> 8);    \
@@ -175,46 +230,66 @@
     ((uint8_t*) (addr))[1] = (uint8_t) (((uint64_t) (value64)) >> 48);   \
     ((uint8_t*) (addr))[0] = (uint8_t) (((uint64_t) (value64)) >> 56);   \
 } while (0)
-#endif /* _MHD_BYTE_ORDER != _MHD_LITTLE_ENDIAN */
+#endif
 
 /* _MHD_PUT_32BIT_BE (addr, value32)
  * put native-endian 32-bit value32 to addr
  * in big-endian mode.
  */
-#if _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+#if defined(_MHD_PUT_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
 #define _MHD_PUT_32BIT_BE(addr, value32)             \
-  ((*(uint32_t*) (addr)) = (uint32_t) (value32))
-#elif _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+  _MHD_PUT_UNALIGNED32 ((addr), (value32))
+#elif defined(_MHD_PUT_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
 #define _MHD_PUT_32BIT_BE(addr, value32)             \
-  ((*(uint32_t*) (addr)) = _MHD_BYTES_SWAP32 (value32))
-#else  /* _MHD_BYTE_ORDER != _MHD_LITTLE_ENDIAN */
-/* Endianness was not detected or non-standard like PDP-endian */
+  _MHD_PUT_UNALIGNED32 ((addr), _MHD_BYTES_SWAP32 (value32))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
 #define _MHD_PUT_32BIT_BE(addr, value32) do {                             \
     ((uint8_t*) (addr))[3] = (uint8_t) ((uint32_t) (value32));           \
     ((uint8_t*) (addr))[2] = (uint8_t) (((uint32_t) (value32)) >> 8);    \
     ((uint8_t*) (addr))[1] = (uint8_t) (((uint32_t) (value32)) >> 16);   \
     ((uint8_t*) (addr))[0] = (uint8_t) (((uint32_t) (value32)) >> 24);   \
 } while (0)
-#endif /* _MHD_BYTE_ORDER != _MHD_LITTLE_ENDIAN */
+#endif
 
 /* _MHD_GET_32BIT_BE (addr)
  * get big-endian 32-bit value storied at addr
  * and return it in native-endian mode.
  */
-#if _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+#if defined(_MHD_GET_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
 #define _MHD_GET_32BIT_BE(addr)             \
-  (*(const uint32_t*) (addr))
-#elif _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+  _MHD_GET_UNALIGNED32 (addr)
+#elif defined(_MHD_GET_UNALIGNED32) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
 #define _MHD_GET_32BIT_BE(addr)             \
-  _MHD_BYTES_SWAP32 (*(const uint32_t*) (addr))
-#else  /* _MHD_BYTE_ORDER != _MHD_LITTLE_ENDIAN */
-/* Endianness was not detected or non-standard like PDP-endian */
+  _MHD_BYTES_SWAP32 (_MHD_GET_UNALIGNED32 (addr))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
 #define _MHD_GET_32BIT_BE(addr)                       \
   ( (((uint32_t) (((const uint8_t*) addr)[0])) << 24)   \
     | (((uint32_t) (((const uint8_t*) addr)[1])) << 16)   \
     | (((uint32_t) (((const uint8_t*) addr)[2])) << 8)    \
     | ((uint32_t) (((const uint8_t*) addr)[3])) )
-#endif /* _MHD_BYTE_ORDER != _MHD_LITTLE_ENDIAN */
+#endif
+
+/* _MHD_GET_64BIT_BE (addr)
+ * get big-endian 64-bit value storied at addr
+ * and return it in native-endian mode.
+ */
+#if defined(_MHD_GET_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_BIG_ENDIAN
+#define _MHD_GET_64BIT_BE(addr)             \
+  _MHD_GET_UNALIGNED64 (addr)
+#elif defined(_MHD_GET_UNALIGNED64) && _MHD_BYTE_ORDER == _MHD_LITTLE_ENDIAN
+#define _MHD_GET_64BIT_BE(addr)             \
+  _MHD_BYTES_SWAP64 (_MHD_GET_UNALIGNED64 (addr))
+#else  /* byte-wise fallback (unknown endianness or no primitives) */
+#define _MHD_GET_64BIT_BE(addr)                       \
+  ( (((uint64_t) (((const uint8_t*) addr)[0])) << 56)   \
+    | (((uint64_t) (((const uint8_t*) addr)[1])) << 48)   \
+    | (((uint64_t) (((const uint8_t*) addr)[2])) << 40)   \
+    | (((uint64_t) (((const uint8_t*) addr)[3])) << 32)   \
+    | (((uint64_t) (((const uint8_t*) addr)[4])) << 24)   \
+    | (((uint64_t) (((const uint8_t*) addr)[5])) << 16)   \
+    | (((uint64_t) (((const uint8_t*) addr)[6])) << 8)    \
+    | ((uint64_t) (((const uint8_t*) addr)[7])) )
+#endif
 
 
 /**
@@ -88,4 +88,18 @@ void *MHD_calloc_ (size_t nelem, size_t elsize);
 
 #endif /* ! HAVE_CALLOC */
 
+/**
+ * MHD_THREAD_LOCAL_ is the thread-local storage-class specifier,
+ * if the toolchain provides one; left undefined otherwise (code
+ * using it must degrade gracefully).
+ */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && \
+  ! defined(__STDC_NO_THREADS__)
+#define MHD_THREAD_LOCAL_ _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define MHD_THREAD_LOCAL_ __thread
+#elif defined(_MSC_FULL_VER)
+#define MHD_THREAD_LOCAL_ __declspec (thread)
+#endif /* thread-local support detection */
+
 #endif /* MHD_COMPAT_H */
@@ -0,0 +1,149 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/mhd_epoll_kqueue.c
+ * @brief  epoll calls emulated on top of kqueue/kevent
+ * @author Christian Grothoff
+ */
+#include "mhd_epoll_kqueue.h"
+
+#ifdef KQUEUE_SUPPORT
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif /* HAVE_UNISTD_H */
+
+/**
+ * Translation buffer size for a single kevent() call; chosen to
+ * match MAX_EVENTS used by the epoll event loop in daemon.c.
+ */
+#define MHD_KQUEUE_MAX_EVENTS_ 128
+
+
+int
+MHD_epoll_create1_kqueue_ (int flags)
+{
+  (void) flags; /* kqueue FDs are never inherited across exec */
+  return kqueue ();
+}
+
+
+int
+MHD_epoll_ctl_kqueue_ (int kfd,
+                       int op,
+                       int fd,
+                       struct epoll_event *event)
+{
+  struct kevent changes[2];
+  void *udata;
+  uint16_t base_flags;
+  int res;
+
+  if (EPOLL_CTL_DEL == op)
+  {
+    /* Remove both filters; it is fine if only one (or none, when the
+     * FD was closed already) is currently registered. */
+    EV_SET (&changes[0], fd, EVFILT_READ, EV_DELETE, 0, 0, 0);
+    kevent (kfd, changes, 1, NULL, 0, NULL);
+    EV_SET (&changes[0], fd, EVFILT_WRITE, EV_DELETE, 0, 0, 0);
+    kevent (kfd, changes, 1, NULL, 0, NULL);
+    return 0;
+  }
+  if (NULL == event)
+  {
+    errno = EFAULT;
+    return -1;
+  }
+  udata = event->data.ptr;
+  base_flags = EV_ADD;
+  if (0 != (event->events & EPOLLET))
+    base_flags |= EV_CLEAR;
+  /* Filters not requested are added disabled so that a later
+   * EPOLL_CTL_MOD can flip them without re-registration races. */
+  EV_SET (&changes[0], fd, EVFILT_READ,
+          base_flags
+          | ((0 != (event->events & EPOLLIN)) ? EV_ENABLE : EV_DISABLE),
+          0, 0, udata);
+  EV_SET (&changes[1], fd, EVFILT_WRITE,
+          base_flags
+          | ((0 != (event->events & EPOLLOUT)) ? EV_ENABLE : EV_DISABLE),
+          0, 0, udata);
+  res = kevent (kfd, changes, 2, NULL, 0, NULL);
+  if (0 > res)
+    return -1;
+  return 0;
+}
+
+
+int
+MHD_epoll_wait_kqueue_ (int kfd,
+                        struct epoll_event *events,
+                        int maxevents,
+                        int timeout_ms)
+{
+  struct kevent kevs[MHD_KQUEUE_MAX_EVENTS_];
+  struct timespec timeout;
+  struct timespec *ptimeout;
+  int num;
+  int i;
+
+  if (0 >= maxevents)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  if (maxevents > MHD_KQUEUE_MAX_EVENTS_)
+    maxevents = MHD_KQUEUE_MAX_EVENTS_;
+  if (0 > timeout_ms)
+    ptimeout = NULL;
+  else
+  {
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+    ptimeout = &timeout;
+  }
+  num = kevent (kfd, NULL, 0, kevs, maxevents, ptimeout);
+  if (0 > num)
+    return -1;
+  for (i = 0; i < num; i++)
+  {
+    uint32_t ev = 0;
+
+    if (0 != (kevs[i].flags & EV_ERROR))
+      ev |= EPOLLERR;
+    else if (EVFILT_READ == kevs[i].filter)
+    {
+      ev |= EPOLLIN;
+      if (0 != (kevs[i].flags & EV_EOF))
+        ev |= EPOLLRDHUP;
+    }
+    else if (EVFILT_WRITE == kevs[i].filter)
+      ev |= EPOLLOUT;
+    events[i].events = ev;
+    events[i].data.ptr = (void *) kevs[i].udata;
+  }
+  return num;
+}
+
+
+#endif /* KQUEUE_SUPPORT */
@@ -0,0 +1,138 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/mhd_epoll_kqueue.h
+ * @brief  epoll calls emulated on top of kqueue/kevent
+ * @author Christian Grothoff
+ *
+ * On BSD-style platforms without a native epoll, MHD provides the
+ * small subset of the epoll API which daemon.c, connection.c and
+ * response.c actually use, implemented with kqueue()/kevent().  This
+ * way the whole epoll event loop (including the eready EDLL
+ * handling) runs unmodified on those platforms; #MHD_USE_EPOLL and
+ * #MHD_USE_AUTO transparently select the kqueue backend there.
+ */
+#ifndef MHD_EPOLL_KQUEUE_H
+#define MHD_EPOLL_KQUEUE_H 1
+
+#include "mhd_options.h"
+
+#ifdef KQUEUE_SUPPORT
+
+#include <stdint.h>
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif /* HAVE_SYS_TYPES_H */
+#include <sys/event.h>
+#include <sys/time.h>
+
+/* Event bits; values match the Linux ABI so that application code
+ * comparing against the documented constants behaves identically. */
+#define EPOLLIN 0x001
+#define EPOLLPRI 0x002
+#define EPOLLOUT 0x004
+#define EPOLLERR 0x008
+#define EPOLLHUP 0x010
+#define EPOLLRDHUP 0x2000
+#define EPOLLET (1U << 31)
+
+/* Control operations for MHD_epoll_ctl_kqueue_() */
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+/* Flag for MHD_epoll_create1_kqueue_(); kqueue descriptors are not
+ * inherited by child processes, so it is accepted and ignored. */
+#define EPOLL_CLOEXEC 02000000
+
+typedef union epoll_data
+{
+  void *ptr;
+  int fd;
+  uint32_t u32;
+  uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event
+{
+  uint32_t events;
+  epoll_data_t data;
+};
+
+
+/**
+ * Emulate epoll_create1() by creating a kqueue.
+ *
+ * @param flags only #EPOLL_CLOEXEC is understood (and is implicit
+ *        for kqueue descriptors)
+ * @return the kqueue FD to use as "epoll FD", -1 on error
+ */
+int
+MHD_epoll_create1_kqueue_ (int flags);
+
+
+/**
+ * Emulate epoll_ctl() with kevent() changelist submissions.
+ * Registers/updates/removes the EVFILT_READ and EVFILT_WRITE
+ * filters matching the requested event mask; #EPOLLET is mapped
+ * to EV_CLEAR.  #EPOLLPRI has no kqueue equivalent and is ignored.
+ *
+ * @param kfd the kqueue FD
+ * @param op one of EPOLL_CTL_ADD, EPOLL_CTL_MOD, EPOLL_CTL_DEL
+ * @param fd the socket/FD to watch
+ * @param event requested events and user data (may be NULL for DEL)
+ * @return 0 on success, -1 with errno set on error
+ */
+int
+MHD_epoll_ctl_kqueue_ (int kfd,
+                       int op,
+                       int fd,
+                       struct epoll_event *event);
+
+
+/**
+ * Emulate epoll_wait() with kevent().  Pending kevents are
+ * translated back to epoll-style events; EV_EOF on the read filter
+ * is reported as #EPOLLIN | #EPOLLRDHUP (the following recv()
+ * returning zero performs the actual close detection, as with real
+ * epoll), EV_ERROR as #EPOLLERR.
+ *
+ * @param kfd the kqueue FD
+ * @param events array to store resulting events
+ * @param maxevents size of the @a events array
+ * @param timeout_ms maximum wait time in milliseconds, -1 for no limit
+ * @return number of events stored, 0 on timeout, -1 on error
+ */
+int
+MHD_epoll_wait_kqueue_ (int kfd,
+                        struct epoll_event *events,
+                        int maxevents,
+                        int timeout_ms);
+
+#define epoll_create1(flags) MHD_epoll_create1_kqueue_ (flags)
+#define epoll_create(size) MHD_epoll_create1_kqueue_ (0)
+#define epoll_ctl(kfd,op,fd,event) MHD_epoll_ctl_kqueue_ (kfd,op,fd,event)
+#define epoll_wait(kfd,events,maxevents,timeout) \
+  MHD_epoll_wait_kqueue_ (kfd,events,maxevents,timeout)
+
+#endif /* KQUEUE_SUPPORT */
+
+#endif /* MHD_EPOLL_KQUEUE_H */
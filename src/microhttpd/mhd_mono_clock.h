@@ -29,6 +29,7 @@
 
 #if defined(HAVE_TIME_H)
 #include <time.h>
+#include <stdint.h>
 #elif defined(HAVE_SYS_TYPES_H)
 #include <sys/types.h>
 #endif
@@ -57,4 +58,14 @@ MHD_monotonic_sec_counter_finish (void);
 time_t
 MHD_monotonic_sec_counter (void);
 
+
+/**
+ * Monotonic millisecond counter.
+ * Tracks the same monotonic sources as #MHD_monotonic_sec_counter()
+ * but with millisecond resolution, for sub-second timeout handling.
+ * @return number of milliseconds from some fixed moment
+ */
+uint64_t
+MHD_monotonic_msec_counter (void);
+
 #endif /* MHD_MONO_CLOCK_H */
@@ -0,0 +1,59 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/mhd_probes.h
+ * @brief  Stable USDT tracepoints for the request lifecycle
+ * @author Christian Grothoff
+ *
+ * When built on a system with <sys/sdt.h> (systemtap-sdt-dev),
+ * MHD emits static user-space probes under the "libmicrohttpd"
+ * provider at the key lifecycle points, each carrying the
+ * connection pointer as a stable correlation id:
+ *
+ *   accept           (connection, socket-fd)
+ *   headers_complete (connection, method, url)
+ *   response_queue   (connection, status-code)
+ *   first_byte_sent  (connection, bytes)
+ *   connection_close (connection, termination-code)
+ *
+ * Probes compile to a single NOP when not attached, so they are
+ * free in production; without sdt.h every probe expands to
+ * nothing.  Unlike uprobes on static functions, these survive
+ * inlining and refactoring.
+ */
+#ifndef MHD_PROBES_H
+#define MHD_PROBES_H 1
+
+#include "mhd_options.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define MHD_PROBE_1(name,a1) DTRACE_PROBE1 (libmicrohttpd, name, a1)
+#define MHD_PROBE_2(name,a1,a2) DTRACE_PROBE2 (libmicrohttpd, name, a1, a2)
+#define MHD_PROBE_3(name,a1,a2,a3) \
+  DTRACE_PROBE3 (libmicrohttpd, name, a1, a2, a3)
+#else  /* ! HAVE_SYS_SDT_H */
+#define MHD_PROBE_1(name,a1) ((void) 0)
+#define MHD_PROBE_2(name,a1,a2) ((void) 0)
+#define MHD_PROBE_3(name,a1,a2,a3) ((void) 0)
+#endif /* ! HAVE_SYS_SDT_H */
+
+#endif /* MHD_PROBES_H */
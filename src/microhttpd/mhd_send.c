@@ -50,6 +50,12 @@
 #include <sys/param.h>
 #endif /* HAVE_SYS_PARAM_H */
 #include "mhd_assert.h"
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+#include <linux/errqueue.h>
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+#ifdef MHD_SPLICE_SUPPORT
+#include <fcntl.h> /* for splice() */
+#endif /* MHD_SPLICE_SUPPORT */
 
 
 /**
@@ -57,6 +63,14 @@
  */
 #define MHD_SENFILE_CHUNK_         (0x20000)
 
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+/**
+ * Minimum buffer size for which MSG_ZEROCOPY is attempted; below
+ * this the page-pinning overhead exceeds the saved copy.
+ */
+#define MHD_ZEROCOPY_THRESHOLD_    (0x10000)
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+
 /**
  * sendfile() chuck size for thread-per-connection
  */
@@ -315,11 +329,11 @@ MHD_send_on_connection_ (struct MHD_Connection *connection,
                          size_t buffer_size,
                          enum MHD_SendSocketOptions options)
 {
-  bool push_data;
+  bool push_data = false;
   MHD_socket s = connection->socket_fd;
   ssize_t ret;
 #ifdef HTTPS_SUPPORT
-  const bool tls_conn = (connection->daemon->options & MHD_USE_TLS);
+  const bool tls_conn = (NULL != connection->tls_session);
 #else  /* ! HTTPS_SUPPORT */
   const bool tls_conn = false;
 #endif /* ! HTTPS_SUPPORT */
@@ -348,12 +362,29 @@ MHD_send_on_connection_ (struct MHD_Connection *connection,
     break;
   }
 
+  if (connection->app_corked)
+    push_data = false; /* application holds the cork */
   pre_send_setopt (connection, (! tls_conn), push_data);
   if (tls_conn)
   {
 #ifdef HTTPS_SUPPORT
     if (buffer_size > SSIZE_MAX)
       buffer_size = SSIZE_MAX;
+    if (0 != connection->pace_rate)
+    {
+      const uint64_t slice = connection->pace_rate / 20 + 1;
+
+      if ((uint64_t) buffer_size > slice)
+        buffer_size = (size_t) slice;
+    }
+    /* Dynamic record sizing: keep the first records of a
+     * connection small (typically one MTU) so latency-sensitive
+     * clients can decrypt data record-by-record, then ramp to
+     * full-size records for throughput. */
+    if ( (0 != connection->daemon->tls_first_record_size) &&
+         (connection->tls_bytes_sent < (uint64_t) 65536) &&
+         (buffer_size > connection->daemon->tls_first_record_size) )
+      buffer_size = connection->daemon->tls_first_record_size;
     ret = gnutls_record_send (connection->tls_session,
                               buffer,
                               buffer_size);
@@ -372,6 +403,8 @@ MHD_send_on_connection_ (struct MHD_Connection *connection,
          disrupted); interpret as a hard error */
       return MHD_ERR_NOTCONN_;
     }
+    if (0 < ret)
+      connection->tls_bytes_sent += (uint64_t) ret;
 #ifdef EPOLL_SUPPORT
     /* Unlike non-TLS connections, do not reset "write-ready" if
      * sent amount smaller than provided amount, as TLS
@@ -383,20 +416,84 @@ MHD_send_on_connection_ (struct MHD_Connection *connection,
   else
   {
     /* plaintext transmission */
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+    bool use_zc;
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+
     if (buffer_size > MHD_SCKT_SEND_MAX_SIZE_)
       buffer_size = MHD_SCKT_SEND_MAX_SIZE_; /* return value limit */
+    if (0 != connection->pace_rate)
+    {
+      /* Paced connection: bound each send to a ~50ms slice of the
+       * configured rate so the leaky bucket can take effect. */
+      const uint64_t slice = connection->pace_rate / 20 + 1;
+
+      if ((uint64_t) buffer_size > slice)
+        buffer_size = (size_t) slice;
+    }
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+    /* MSG_ZEROCOPY pins the pages until the kernel's completion
+       arrives, which can be after MHD freed a pool write buffer or
+       a MUST_FREE/MUST_COPY response body (the drain is bounded
+       and the cleanup path runs it after the response is
+       destroyed).  Only buffers the application declared
+       persistent are safe to hand to the kernel by reference:
+       restrict zero-copy to sends that come straight out of a
+       persistent (no free callback, no content reader) response's
+       data block. */
+    use_zc = (connection->sk_zerocopy) &&
+             (buffer_size >= MHD_ZEROCOPY_THRESHOLD_) &&
+             (NULL != connection->response) &&
+             (NULL == connection->response->crfc) &&
+             (NULL == connection->response->crc) &&
+             (NULL != connection->response->data) &&
+             (buffer >= connection->response->data) &&
+             (buffer + buffer_size
+              <= connection->response->data
+              + connection->response->data_size);
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
 
 #ifdef MHD_USE_MSG_MORE
     ret = MHD_send4_ (s,
                       buffer,
                       buffer_size,
-                      push_data ? 0 : MSG_MORE);
+                      (push_data ? 0 : MSG_MORE)
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+                      | (use_zc ? MSG_ZEROCOPY : 0)
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+                      );
 #else
     ret = MHD_send4_ (s,
                       buffer,
                       buffer_size,
-                      0);
+                      0
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+                      | (use_zc ? MSG_ZEROCOPY : 0)
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+                      );
+#endif
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+    if (use_zc)
+    {
+      if (0 < ret)
+        connection->zc_outstanding++;
+      else if (ENOBUFS == MHD_socket_get_error_ ())
+      {
+        /* Out of locked-page budget: retry this send with copying
+         * and stop trying zero-copy on this connection. */
+        connection->sk_zerocopy = false;
+        ret = MHD_send4_ (s,
+                          buffer,
+                          buffer_size,
+#ifdef MHD_USE_MSG_MORE
+                          push_data ? 0 : MSG_MORE
+#else
+                          0
 #endif
+                          );
+      }
+    }
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
 
     if (0 > ret)
     {
@@ -425,103 +522,197 @@ MHD_send_on_connection_ (struct MHD_Connection *connection,
   post_send_setopt (connection, tls_conn,
                     (push_data && (buffer_size == (size_t) ret)) );
 
+  if (0 < ret)
+    MHD_statcnt_add_ (&connection->daemon->stat_bytes_out,
+                      (uint64_t) ret);
   return ret;
 }
 
 
 /**
- * Send header followed by buffer on connection.
- * Uses writev if possible to send both at once
- * and returns the sum of the number of bytes sent from
- * both buffers, or -1 on error;
- * if writev is unavailable, this call MUST only send from 'header'
- * (as we cannot handle the case that the first write
- * succeeds and the 2nd fails!).
+ * Send several buffers on connection with a single syscall where the
+ * platform provides one (sendmsg(), falling back to writev()), so
+ * status line, headers, chunk framing and body can leave in one
+ * segment.  The TCP_CORK/MSG_MORE handling of
+ * #MHD_send_on_connection_() is layered on top via
+ * pre_send_setopt()/post_send_setopt().
+ *
+ * On TLS connections and on platforms without scatter-gather send
+ * only the first buffer is transmitted (the caller continues based
+ * on the returned number of bytes, as with any short send).
  *
  * @param connection the MHD_Connection structure
- * @param header content of header to send
- * @param header_size the size of the header (in bytes)
- * @param buffer content of the buffer to send
- * @param buffer_size the size of the buffer (in bytes)
- * @return sum of the number of bytes sent from both buffers or
+ * @param vector the buffers to send, in order
+ * @param cnt the number of buffers in @a vector
+ * @param push_data whether to push data to the network after this
+ *                  send (set for the final piece of the reply)
+ * @return sum of the number of bytes sent from the buffers or
  *         -1 on error
  */
 ssize_t
-MHD_send_on_connection2_ (struct MHD_Connection *connection,
-                          const char *header,
-                          size_t header_size,
-                          const char *buffer,
-                          size_t buffer_size)
+MHD_send_iovec_ (struct MHD_Connection *connection,
+                 const struct MHD_IoVec *vector,
+                 unsigned int cnt,
+                 bool push_data)
 {
+#if defined(HAVE_SENDMSG) || defined(HAVE_WRITEV)
   MHD_socket s = connection->socket_fd;
   ssize_t ret;
-  struct iovec vector[2];
+  struct iovec iov[MHD_SEND_IOV_MAX_];
+  unsigned int iovcnt;
+  unsigned int i;
+  size_t total_size;
+#endif /* HAVE_SENDMSG || HAVE_WRITEV */
 #ifdef HTTPS_SUPPORT
-  const bool tls_conn = (connection->daemon->options & MHD_USE_TLS);
+  const bool tls_conn = (NULL != connection->tls_session);
 #else  /* ! HTTPS_SUPPORT */
   const bool tls_conn = false;
 #endif /* ! HTTPS_SUPPORT */
 
-#ifdef HTTPS_SUPPORT
+  mhd_assert (0 != cnt);
   if (tls_conn)
   {
-    ssize_t ret;
-
-    ret = MHD_send_on_connection_ (connection,
-                                   header,
-                                   header_size,
-                                   MHD_SSO_HDR_CORK);
-    return ret;
+    /* GnuTLS has no scatter-gather send; transmit the first buffer,
+     * the caller retries the rest based on the byte count. */
+    return MHD_send_on_connection_ (connection,
+                                    vector[0].iov_base,
+                                    vector[0].iov_len,
+                                    (push_data && (1 == cnt)) ?
+                                    MHD_SSO_PUSH_DATA : MHD_SSO_HDR_CORK);
   }
-#endif
 #if defined(HAVE_SENDMSG) || defined(HAVE_WRITEV)
-  /* Since we generally give the fully answer, we do not want
-     corking to happen */
-  pre_send_setopt (connection, (! tls_conn), true);
+  /* Buffers after MHD_SEND_IOV_MAX_ (or beyond the per-call size
+   * limit) are simply not included in this round. */
+  {
+    size_t send_cap = MHD_SCKT_SEND_MAX_SIZE_;
 
-  vector[0].iov_base = (void *) header;
-  vector[0].iov_len = header_size;
-  vector[1].iov_base = (void *) buffer;
-  vector[1].iov_len = buffer_size;
+    if ( (0 != connection->pace_rate) &&
+         (connection->pace_rate / 20 + 1 < (uint64_t) send_cap) )
+      send_cap = (size_t) (connection->pace_rate / 20 + 1);
+  total_size = 0;
+  iovcnt = 0;
+  for (i = 0; (i < cnt) && (iovcnt < MHD_SEND_IOV_MAX_); ++i)
+  {
+    size_t len = vector[i].iov_len;
+
+    if (0 == len)
+      continue;
+    if (len > send_cap - total_size)
+    {
+      len = send_cap - total_size;
+      if (0 == len)
+        break;
+    }
+    iov[iovcnt].iov_base = (void *) vector[i].iov_base;
+    iov[iovcnt].iov_len = len;
+    total_size += len;
+    iovcnt++;
+  }
+  }
+  if (0 == iovcnt)
+    return 0;
 
-#if HAVE_SENDMSG
+  if (connection->app_corked)
+    push_data = false; /* application holds the cork */
+  pre_send_setopt (connection, true, push_data);
+#ifdef HAVE_SENDMSG
   {
     struct msghdr msg;
 
     memset (&msg, 0, sizeof(struct msghdr));
-    msg.msg_iov = vector;
-    msg.msg_iovlen = 2;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
 
+#ifdef MHD_USE_MSG_MORE
+    ret = sendmsg (s, &msg,
+                   MSG_NOSIGNAL_OR_ZERO | (push_data ? 0 : MSG_MORE));
+#else  /* ! MHD_USE_MSG_MORE */
     ret = sendmsg (s, &msg, MSG_NOSIGNAL_OR_ZERO);
-    if ( (-1 == ret) &&
-         (EAGAIN == errno) )
-      return MHD_ERR_AGAIN_;
+#endif /* ! MHD_USE_MSG_MORE */
   }
-#elif HAVE_WRITEV
+#else  /* HAVE_WRITEV */
+  ret = writev (s, iov, (int) iovcnt);
+#endif
+  if (0 > ret)
   {
-    int iovcnt;
+    const int err = MHD_socket_get_error_ ();
 
-    iovcnt = sizeof (vector) / sizeof (struct iovec);
-    ret = writev (s, vector, iovcnt);
-    if ( (-1 == ret) &&
-         (EAGAIN == errno) )
+    if (MHD_SCKT_ERR_IS_EAGAIN_ (err))
+    {
+#ifdef EPOLL_SUPPORT
+      /* EAGAIN, no longer write-ready */
+      connection->epoll_state &= ~MHD_EPOLL_STATE_WRITE_READY;
+#endif /* EPOLL_SUPPORT */
+      return MHD_ERR_AGAIN_;
+    }
+    if (MHD_SCKT_ERR_IS_EINTR_ (err))
       return MHD_ERR_AGAIN_;
+    if (MHD_SCKT_ERR_IS_ (err, MHD_SCKT_ECONNRESET_))
+      return MHD_ERR_CONNRESET_;
+    /* Treat any other error as hard error. */
+    return MHD_ERR_NOTCONN_;
   }
-#endif
+#ifdef EPOLL_SUPPORT
+  else if (total_size > (size_t) ret)
+    connection->epoll_state &= ~MHD_EPOLL_STATE_WRITE_READY;
+#endif /* EPOLL_SUPPORT */
 
-  /* Only if we succeeded sending the full buffer, we need to make sure that
-     the OS flushes at the end */
-  post_send_setopt (connection, (! tls_conn),
-                    (header_size + buffer_size == (size_t) ret));
+  /* Only if we succeeded sending the full set of buffers, we need to
+     make sure that the OS flushes at the end */
+  post_send_setopt (connection, true,
+                    (push_data && (total_size == (size_t) ret)));
 
+  if (0 < ret)
+    MHD_statcnt_add_ (&connection->daemon->stat_bytes_out,
+                      (uint64_t) ret);
   return ret;
-
-#else
+#else  /* ! HAVE_SENDMSG && ! HAVE_WRITEV */
   return MHD_send_on_connection_ (connection,
-                                  header,
-                                  header_size,
-                                  MHD_SSO_HDR_CORK);
-#endif
+                                  vector[0].iov_base,
+                                  vector[0].iov_len,
+                                  (push_data && (1 == cnt)) ?
+                                  MHD_SSO_PUSH_DATA : MHD_SSO_HDR_CORK);
+#endif /* ! HAVE_SENDMSG && ! HAVE_WRITEV */
+}
+
+
+/**
+ * Send header followed by buffer on connection.
+ * Uses sendmsg()/writev() if possible to send both at once
+ * and returns the sum of the number of bytes sent from
+ * both buffers, or -1 on error;
+ * if scatter-gather send is unavailable, this call MUST only send
+ * from 'header' (as we cannot handle the case that the first write
+ * succeeds and the 2nd fails!).
+ *
+ * @param connection the MHD_Connection structure
+ * @param header content of header to send
+ * @param header_size the size of the header (in bytes)
+ * @param buffer content of the buffer to send
+ * @param buffer_size the size of the buffer (in bytes)
+ * @return sum of the number of bytes sent from both buffers or
+ *         -1 on error
+ */
+ssize_t
+MHD_send_on_connection2_ (struct MHD_Connection *connection,
+                          const char *header,
+                          size_t header_size,
+                          const char *buffer,
+                          size_t buffer_size)
+{
+  struct MHD_IoVec vector[2];
+
+  vector[0].iov_base = header;
+  vector[0].iov_len = header_size;
+  vector[1].iov_base = buffer;
+  vector[1].iov_len = buffer_size;
+
+  /* Since we generally give the full answer, we do not want
+     corking to happen */
+  return MHD_send_iovec_ (connection,
+                          vector,
+                          2,
+                          true);
 }
 
 
@@ -560,13 +751,25 @@ MHD_send_sendfile_ (struct MHD_Connection *connection)
 #endif /* HAVE_DARWIN_SENDFILE */
   const bool used_thr_p_c = (0 != (connection->daemon->options
                                    & MHD_USE_THREAD_PER_CONNECTION));
-  const size_t chunk_size = used_thr_p_c ? MHD_SENFILE_CHUNK_THR_P_C_ :
+  const size_t base_chunk = used_thr_p_c ? MHD_SENFILE_CHUNK_THR_P_C_ :
                             MHD_SENFILE_CHUNK_;
+  size_t chunk_size;
   size_t send_size = 0;
+  const bool push_data = ! connection->app_corked;
+
   mhd_assert (MHD_resp_sender_sendfile == connection->resp_sender);
-  mhd_assert (0 == (connection->daemon->options & MHD_USE_TLS));
+#ifdef HTTPS_SUPPORT
+  mhd_assert (NULL == connection->tls_session);
+#endif /* HTTPS_SUPPORT */
 
-  pre_send_setopt (connection, false, true);
+  /* Adaptive chunk: converge to the connection's drain rate
+   * within a few calls instead of using one fixed cap for 10GbE
+   * and mobile clients alike; see the update after the send. */
+  if (0 == connection->sendfile_chunk)
+    connection->sendfile_chunk = base_chunk;
+  chunk_size = connection->sendfile_chunk;
+
+  pre_send_setopt (connection, false, push_data);
 
   offsetu64 = connection->response_write_position
               + connection->response->fd_off;
@@ -574,6 +777,24 @@ MHD_send_sendfile_ (struct MHD_Connection *connection)
   /* Do not allow system to stick sending on single fast connection:
    * use 128KiB chunks (2MiB for thread-per-connection). */
   send_size = (left > chunk_size) ? chunk_size : (size_t) left;
+#ifdef HAVE_POSIX_FADVISE
+  if (left > (uint64_t) send_size)
+  {
+    /* Keep read-ahead running ahead of the send position so the
+     * next chunk is already cached when we get back here. */
+    uint64_t ahead = left - send_size;
+
+    if (ahead > (uint64_t) chunk_size)
+      ahead = chunk_size;
+    (void) posix_fadvise (file_fd,
+                          (off_t) (offsetu64 + send_size),
+                          (off_t) ahead,
+                          POSIX_FADV_WILLNEED);
+  }
+#endif /* HAVE_POSIX_FADVISE */
+  if ( (0 != connection->pace_rate) &&
+       ((uint64_t) send_size > connection->pace_rate / 20 + 1) )
+    send_size = (size_t) (connection->pace_rate / 20 + 1);
   if (max_off_t < offsetu64)
   {   /* Retry to send with standard 'send()'. */
     connection->resp_sender = MHD_resp_sender_std;
@@ -710,10 +931,247 @@ MHD_send_sendfile_ (struct MHD_Connection *connection)
 
   /* Make sure we send the data without delay ONLY if we
      provided the complete response (not on partial write) */
-  post_send_setopt (connection, false, (left == (uint64_t) ret));
+  post_send_setopt (connection, false,
+                    (push_data && (left == (uint64_t) ret)));
 
+  if (0 < ret)
+  {
+    /* Drain-rate adaptation: a fully-consumed chunk means the
+     * socket could have taken more (grow, up to 8x the mode's
+     * base so thread-per-connection sendfile calls stay bounded);
+     * a short write means the socket buffer filled mid-chunk
+     * (shrink, down to 1/8 of the base to keep syscall overhead
+     * sane).  Converges within a few calls either way. */
+    if ( ((size_t) ret == send_size) &&
+         (send_size == chunk_size) )
+    {
+      if (connection->sendfile_chunk < base_chunk * 8)
+        connection->sendfile_chunk = connection->sendfile_chunk * 2;
+    }
+    else if ((size_t) ret < send_size)
+    {
+      if (connection->sendfile_chunk > base_chunk / 8)
+        connection->sendfile_chunk = connection->sendfile_chunk / 2;
+    }
+    MHD_statcnt_add_ (&connection->daemon->stat_bytes_out,
+                      (uint64_t) ret);
+  }
   return ret;
 }
 
 
 #endif /* _MHD_HAVE_SENDFILE */
+
+
+#ifdef MHD_SPLICE_SUPPORT
+/**
+ * Function for sending pipe-backed responses by moving bytes
+ * kernel-side with splice() -- no userspace copy at all.  The pipe
+ * side is blocking (matching the behavior of the pipe reader
+ * callback it replaces); EAGAIN can therefore only mean the
+ * (non-blocking) client socket is full.  EOF on the pipe completes
+ * the response; unsupported fd pairings transparently fall back to
+ * the copying reader path.
+ *
+ * @param connection the MHD connection structure
+ * @return actual number of bytes sent
+ */
+ssize_t
+MHD_send_splice_ (struct MHD_Connection *connection)
+{
+  ssize_t ret;
+
+  mhd_assert (MHD_resp_sender_splice == connection->resp_sender);
+#ifdef HTTPS_SUPPORT
+  mhd_assert (NULL == connection->tls_session);
+#endif /* HTTPS_SUPPORT */
+
+  pre_send_setopt (connection, false, true);
+  ret = splice (connection->response->fd,
+                NULL,
+                connection->socket_fd,
+                NULL,
+                MHD_SENFILE_CHUNK_,
+                SPLICE_F_MOVE | SPLICE_F_MORE);
+  if (0 > ret)
+  {
+    const int err = MHD_socket_get_error_ ();
+
+    if (MHD_SCKT_ERR_IS_EAGAIN_ (err))
+    {
+#ifdef EPOLL_SUPPORT
+      connection->epoll_state &= ~MHD_EPOLL_STATE_WRITE_READY;
+#endif /* EPOLL_SUPPORT */
+      return MHD_ERR_AGAIN_;
+    }
+    if (MHD_SCKT_ERR_IS_EINTR_ (err))
+      return MHD_ERR_AGAIN_;
+    /* EINVAL and friends: fd pairing not spliceable here; use the
+     * copying reader path from now on. */
+    connection->resp_sender = MHD_resp_sender_std;
+    return MHD_ERR_AGAIN_;
+  }
+  if (0 == ret)
+  {
+    /* EOF on the pipe: response complete. */
+    connection->response->total_size
+      = connection->response_write_position;
+    return 0;
+  }
+  if (0 < ret)
+    MHD_statcnt_add_ (&connection->daemon->stat_bytes_out,
+                      (uint64_t) ret);
+  return ret;
+}
+
+
+#endif /* MHD_SPLICE_SUPPORT */
+
+
+#ifdef MHD_TLS_SENDFILE_SUPPORT
+/**
+ * Function for sending responses backed by file FD over TLS
+ * connections.  Uses gnutls_record_send_file(), which transmits
+ * directly from the file via kernel TLS offload when the negotiated
+ * cipher supports it; on any failure the connection transparently
+ * falls back to the userspace copy path.
+ *
+ * @param connection the MHD connection structure
+ * @return actual number of bytes sent
+ */
+ssize_t
+MHD_send_tls_sendfile_ (struct MHD_Connection *connection)
+{
+  ssize_t ret;
+  const int file_fd = connection->response->fd;
+  uint64_t left;
+  uint64_t offsetu64;
+  off_t offset;
+  const bool used_thr_p_c = (0 != (connection->daemon->options
+                                   & MHD_USE_THREAD_PER_CONNECTION));
+  const size_t chunk_size = used_thr_p_c ? MHD_SENFILE_CHUNK_THR_P_C_ :
+                            MHD_SENFILE_CHUNK_;
+  size_t send_size = 0;
+
+  mhd_assert (MHD_resp_sender_sendfile == connection->resp_sender);
+  mhd_assert (NULL != connection->tls_session);
+
+  pre_send_setopt (connection, false, true);
+
+  offsetu64 = connection->response_write_position
+              + connection->response->fd_off;
+  left = connection->response->total_size - connection->response_write_position;
+  /* Do not allow system to stick sending on single fast connection:
+   * use 128KiB chunks (2MiB for thread-per-connection). */
+  send_size = (left > chunk_size) ? chunk_size : (size_t) left;
+  if ((uint64_t) OFF_T_MAX < offsetu64)
+  {   /* Retry to send with standard 'send()'. */
+    connection->resp_sender = MHD_resp_sender_std;
+    return MHD_ERR_AGAIN_;
+  }
+  offset = (off_t) offsetu64;
+  ret = gnutls_record_send_file (connection->tls_session,
+                                 file_fd,
+                                 &offset,
+                                 send_size);
+  if ( (GNUTLS_E_AGAIN == ret) ||
+       (GNUTLS_E_INTERRUPTED == ret) )
+  {
+#ifdef EPOLL_SUPPORT
+    if (GNUTLS_E_AGAIN == ret)
+      connection->epoll_state &= ~MHD_EPOLL_STATE_WRITE_READY;
+#endif
+    return MHD_ERR_AGAIN_;
+  }
+  if (0 > ret)
+  {
+    /* Reading the file failed (or the session is in a state where
+     * direct file sending is not possible); retry with the standard
+     * reader-and-send path. */
+    connection->resp_sender = MHD_resp_sender_std;
+    return MHD_ERR_AGAIN_;
+  }
+
+  /* Make sure we send the data without delay ONLY if we
+     provided the complete response (not on partial write) */
+  post_send_setopt (connection, false, (left == (uint64_t) ret));
+
+  if (0 < ret)
+    MHD_statcnt_add_ (&connection->daemon->stat_bytes_out,
+                      (uint64_t) ret);
+  return ret;
+}
+
+
+#endif /* MHD_TLS_SENDFILE_SUPPORT */
+
+
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+/**
+ * Consume MSG_ZEROCOPY completion notifications from the socket's
+ * error queue.  Called before the connection (and thus the buffers
+ * referenced by the kernel) is released; waits briefly for
+ * outstanding completions but gives up after a bounded time so a
+ * dead peer cannot stall cleanup.
+ *
+ * @param connection the connection to drain
+ */
+void
+MHD_send_zerocopy_drain_ (struct MHD_Connection *connection)
+{
+  unsigned int attempts;
+
+  for (attempts = 0;
+       (0 != connection->zc_outstanding) && (attempts < 25);
+       attempts++)
+  {
+    struct msghdr msg;
+    char control[128];
+    const struct cmsghdr *cm;
+
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof (control);
+    if (0 > recvmsg (connection->socket_fd,
+                     &msg,
+                     MSG_ERRQUEUE | MSG_DONTWAIT))
+    {
+      struct pollfd pfd;
+
+      if (EAGAIN != errno)
+        break;
+      /* Wait (briefly) for the notification to arrive. */
+      pfd.fd = connection->socket_fd;
+      pfd.events = 0; /* errors are always reported */
+      pfd.revents = 0;
+      if (0 >= poll (&pfd, 1, 2))
+        continue;
+      continue;
+    }
+    for (cm = CMSG_FIRSTHDR (&msg); NULL != cm;
+         cm = CMSG_NXTHDR (&msg, (struct cmsghdr *) (uintptr_t) cm))
+    {
+      const struct sock_extended_err *serr;
+
+      if ( ( (SOL_IP != cm->cmsg_level) || (IP_RECVERR != cm->cmsg_type) ) &&
+           ( (SOL_IPV6 != cm->cmsg_level) || (IPV6_RECVERR != cm->cmsg_type) ) )
+        continue;
+      serr = (const struct sock_extended_err *) CMSG_DATA (cm);
+      if (SO_EE_ORIGIN_ZEROCOPY != serr->ee_origin)
+        continue;
+      /* One notification covers the range [ee_info, ee_data]. */
+      if (connection->zc_outstanding >= (serr->ee_data - serr->ee_info + 1))
+        connection->zc_outstanding -= (serr->ee_data - serr->ee_info + 1);
+      else
+        connection->zc_outstanding = 0;
+    }
+  }
+  /* If notifications never arrived (e.g. peer vanished), proceed:
+   * the kernel keeps its page references until transmission is
+   * aborted, and the response buffer itself is released only when
+   * the response object is destroyed. */
+  connection->zc_outstanding = 0;
+}
+
+
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
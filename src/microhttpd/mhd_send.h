@@ -78,12 +78,28 @@ enum MHD_SendSocketOptions
 };
 
 
+/* struct MHD_IoVec is declared in the public microhttpd.h. */
+
+/**
+ * Maximum number of buffers transmitted by a single
+ * #MHD_send_iovec_() call; any extra buffers are simply not sent in
+ * this round (the caller retries based on the returned byte count).
+ */
+#define MHD_SEND_IOV_MAX_ 16
+
+
 ssize_t
 MHD_send_on_connection_ (struct MHD_Connection *connection,
                          const char *buffer,
                          size_t buffer_size,
                          enum MHD_SendSocketOptions options);
 
+ssize_t
+MHD_send_iovec_ (struct MHD_Connection *connection,
+                 const struct MHD_IoVec *vector,
+                 unsigned int cnt,
+                 bool push_data);
+
 ssize_t
 MHD_send_on_connection2_ (struct MHD_Connection *connection,
                           const char *header,
@@ -97,4 +113,31 @@ MHD_send_sendfile_ (struct MHD_Connection *connection);
 
 #endif
 
+#ifdef MHD_ZEROCOPY_SEND_SUPPORT
+void
+MHD_send_zerocopy_drain_ (struct MHD_Connection *connection);
+
+#endif /* MHD_ZEROCOPY_SEND_SUPPORT */
+
+#ifdef MHD_SPLICE_SUPPORT
+ssize_t
+MHD_send_splice_ (struct MHD_Connection *connection);
+
+#endif /* MHD_SPLICE_SUPPORT */
+
+#if defined(HTTPS_SUPPORT) && defined(_MHD_HAVE_SENDFILE) && \
+  (GNUTLS_VERSION_NUMBER >= 0x030703)
+/**
+ * Zero-copy sending of file-FD backed responses over TLS is
+ * available via gnutls_record_send_file(), which uses kernel TLS
+ * offload when the session's cipher permits it (and an internal
+ * read-and-send emulation otherwise).
+ */
+#define MHD_TLS_SENDFILE_SUPPORT 1
+
+ssize_t
+MHD_send_tls_sendfile_ (struct MHD_Connection *connection);
+
+#endif /* HTTPS_SUPPORT && _MHD_HAVE_SENDFILE && GnuTLS >= 3.7.3 */
+
 #endif /* MHD_SEND_H */
@@ -94,7 +94,11 @@
 #    include <sys/select.h>
 #  endif
 #  ifdef EPOLL_SUPPORT
-#    include <sys/epoll.h>
+#    ifdef KQUEUE_SUPPORT
+#      include "mhd_epoll_kqueue.h"
+#    else
+#      include <sys/epoll.h>
+#    endif
 #  endif
 #  ifdef HAVE_NETINET_TCP_H
 /* for TCP_FASTOPEN and TCP_CORK */
@@ -115,6 +119,21 @@
 #  include <poll.h>
 #endif
 
+#if defined(__linux__)
+/**
+ * splice() is available for kernel-side pipe-to-socket forwarding.
+ */
+#  define MHD_SPLICE_SUPPORT 1
+#endif
+
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+/**
+ * Kernel zero-copy transmission of large buffers is supported.
+ * @sa #MHD_USE_ZEROCOPY_SEND
+ */
+#  define MHD_ZEROCOPY_SEND_SUPPORT 1
+#endif
+
 #include <stddef.h>
 #if defined(_MSC_FULL_VER) && ! defined (_SSIZE_T_DEFINED)
 #  include <stdint.h>
@@ -30,6 +30,7 @@
 #endif
 
 #include "mhd_limits.h"
+#include "mhd_bithelpers.h"
 
 #ifdef MHD_FAVOR_SMALL_CODE
 #ifdef _MHD_static_inline
@@ -411,7 +412,38 @@ MHD_str_equal_caseless_bin_n_ (const char *const str1,
 {
   size_t i;
 
-  for (i = 0; i < len; ++i)
+  i = 0;
+#ifndef MHD_FAVOR_SMALL_CODE
+  /* SWAR fast path: compare eight bytes per step, folding the case
+   * of US-ASCII letters in parallel.  Hot for header-name matching,
+   * which compares known-length names dozens of times per request. */
+  while (i + 8 <= len)
+  {
+    const uint64_t hi = UINT64_C (0x8080808080808080);
+    uint64_t w1;
+    uint64_t w2;
+
+    memcpy (&w1, str1 + i, 8);
+    memcpy (&w2, str2 + i, 8);
+    if (w1 != w2)
+    {
+      /* Fold case: set the 0x20 bit on bytes in 'A'..'Z'. */
+      uint64_t h1 = w1 & ~hi;
+      uint64_t h2 = w2 & ~hi;
+      uint64_t up1 = (h1 + UINT64_C (0x3F3F3F3F3F3F3F3F))
+                     & ~(h1 + UINT64_C (0x2525252525252525))
+                     & ~w1 & hi;
+      uint64_t up2 = (h2 + UINT64_C (0x3F3F3F3F3F3F3F3F))
+                     & ~(h2 + UINT64_C (0x2525252525252525))
+                     & ~w2 & hi;
+
+      if ((w1 | (up1 >> 2)) != (w2 | (up2 >> 2)))
+        return 0;
+    }
+    i += 8;
+  }
+#endif /* ! MHD_FAVOR_SMALL_CODE */
+  for (; i < len; ++i)
   {
     const char c1 = str1[i];
     const char c2 = str2[i];
@@ -423,6 +455,62 @@ MHD_str_equal_caseless_bin_n_ (const char *const str1,
 }
 
 
+/**
+ * Calculate a hash value over @a len characters of @a str, ignoring
+ * the case of US-ASCII letters, so that strings which compare equal
+ * under #MHD_str_equal_caseless_bin_n_() hash to the same value.
+ * FNV-1a is used as it is fast and has good distribution for short
+ * keys like header names.
+ * @param str the string to hash
+ * @param len number of characters to hash
+ * @return the hash value
+ */
+uint32_t
+MHD_str_hash_caseless_bin_n_ (const char *str,
+                              size_t len)
+{
+  uint32_t hash = UINT32_C (2166136261); /* FNV offset basis */
+  size_t i;
+
+  for (i = 0; i < len; ++i)
+  {
+    hash ^= (uint32_t) (uint8_t) toasciilower (str[i]);
+    hash *= UINT32_C (16777619);         /* FNV prime */
+  }
+  return hash;
+}
+
+
+/**
+ * Convert @a val to an uppercase hexadecimal US-ASCII string
+ * (without terminating zero) using a branchless lookup per nibble.
+ * @param val the value to convert
+ * @param buf the output buffer, must hold at least 16 characters
+ * @return number of characters written
+ */
+size_t
+MHD_uint64_to_hex_ (uint64_t val,
+                    char *buf)
+{
+  static const char hexd[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+  };
+  char tmp[16];
+  size_t len = 0;
+  size_t i;
+
+  do
+  {
+    tmp[len++] = hexd[val & 0xF];
+    val >>= 4;
+  } while (0 != val);
+  for (i = 0; i < len; ++i)
+    buf[i] = tmp[len - 1 - i];
+  return len;
+}
+
+
 /**
  * Check whether @a str has case-insensitive @a token.
  * Token could be surrounded by spaces and tabs and delimited by comma.
@@ -814,3 +902,53 @@ MHD_str_to_uvalue_n_ (const char *str,
 
 
 #endif /* MHD_FAVOR_SMALL_CODE */
+
+
+/**
+ * Find the first byte that is neither space nor horizontal tab.
+ * Processes eight bytes per step: a carry-proof SWAR zero-byte
+ * detector applied to the XOR against each delimiter marks every
+ * space/tab with its high bit, and the scan continues only while
+ * all eight markers are set.  The detector masks the high bit
+ * before its per-byte addition, so (unlike the classic
+ * subtraction form) no borrow can leak between neighbouring
+ * bytes and a byte following a delimiter is never misclassified.
+ *
+ * @param str the string to scan
+ * @param len number of bytes to scan
+ * @return index of the first non-LWS byte, @a len if none
+ */
+size_t
+MHD_str_find_non_lws_ (const char *str,
+                       size_t len)
+{
+  size_t i = 0;
+
+#if defined(_MHD_GET_UNALIGNED64)
+  while (i + 8 <= len)
+  {
+    const uint64_t chunk = _MHD_GET_UNALIGNED64 (str + i);
+    const uint64_t xs = chunk ^ 0x2020202020202020ULL; /* spaces -> 0 */
+    const uint64_t xt = chunk ^ 0x0909090909090909ULL; /* tabs -> 0 */
+    /* exact per-byte zero detection: 0x80 marker iff the byte is 0 */
+    const uint64_t zs
+      = ~(((xs & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL)
+          | xs | 0x7F7F7F7F7F7F7F7FULL);
+    const uint64_t zt
+      = ~(((xt & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL)
+          | xt | 0x7F7F7F7F7F7F7F7FULL);
+
+    if (0x8080808080808080ULL != (zs | zt))
+      break; /* a non-LWS byte is within this block */
+    i += 8;
+  }
+#endif /* _MHD_GET_UNALIGNED64 */
+  while ( (i < len) &&
+          ( (' ' == str[i]) ||
+            ('\t' == str[i]) ) )
+    i++;
+  return i;
+}
+
+
+/* end of mhd_str.c */
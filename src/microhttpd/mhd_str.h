@@ -99,6 +99,32 @@ MHD_str_equal_caseless_bin_n_ (const char *const str1,
                                size_t len);
 
 
+/**
+ * Calculate a hash value over @a len characters of @a str, ignoring
+ * the case of US-ASCII letters, so that strings which compare equal
+ * under #MHD_str_equal_caseless_bin_n_() hash to the same value.
+ * @param str the string to hash
+ * @param len number of characters to hash
+ * @return the hash value
+ */
+uint32_t
+MHD_str_hash_caseless_bin_n_ (const char *str,
+                              size_t len);
+
+
+/**
+ * Convert @a val to an uppercase hexadecimal US-ASCII string
+ * (without terminating zero) using a branchless lookup per nibble;
+ * used for per-chunk framing on the hot path.
+ * @param val the value to convert
+ * @param buf the output buffer, must hold at least 16 characters
+ * @return number of characters written
+ */
+size_t
+MHD_uint64_to_hex_ (uint64_t val,
+                    char *buf);
+
+
 /**
  * Check whether @a str has case-insensitive @a token.
  * Token could be surrounded by spaces and tabs and delimited by comma.
@@ -288,4 +314,17 @@ MHD_str_to_uvalue_n_ (const char *str,
 
 #endif /* MHD_FAVOR_SMALL_CODE */
 
+/**
+ * Find the first byte of @a str (of length @a len) that is
+ * neither space nor horizontal tab, processing eight bytes per
+ * step (SWAR) on the typically long runs.
+ *
+ * @param str the string to scan (not necessarily NUL-terminated)
+ * @param len number of bytes to scan
+ * @return index of the first non-LWS byte, @a len if none
+ */
+size_t
+MHD_str_find_non_lws_ (const char *str,
+                       size_t len);
+
 #endif /* MHD_STR_H */
@@ -0,0 +1,213 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_postprocessor.c
+ * @brief throughput benchmark for MHD_post_process
+ * @author Christian Grothoff
+ *
+ * Streams synthetic urlencoded and multipart bodies through the
+ * postprocessor with several iterator buffer sizes and feed-chunk
+ * sizes, reporting MB/s -- covering both the boundary-search fast
+ * path (large binary parts) and the many-small-parts case
+ * (per-part overhead).  Usage: perf_postprocessor [MB-PER-CASE].
+ * The default volume is small so 'make check' stays fast.
+ */
+#include "mhd_options.h"
+#include "platform.h"
+#include "microhttpd.h"
+#include "internal.h"
+#include "mhd_str.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t consumed;
+
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+
+static enum MHD_Result
+value_counter (void *cls,
+               enum MHD_ValueKind kind,
+               const char *key,
+               const char *filename,
+               const char *content_type,
+               const char *transfer_encoding,
+               const char *data,
+               uint64_t off,
+               size_t size)
+{
+  (void) cls; (void) kind; (void) key; (void) filename;
+  (void) content_type; (void) transfer_encoding; (void) data; (void) off;
+  consumed += size;
+  return MHD_YES;
+}
+
+
+static void
+setup_conn (struct MHD_Connection *connection,
+            struct MHD_HTTP_Header *header,
+            const char *content_type)
+{
+  memset (connection, 0, sizeof (*connection));
+  memset (header, 0, sizeof (*header));
+  connection->headers_received = header;
+  header->header = (char *) MHD_HTTP_HEADER_CONTENT_TYPE;
+  header->header_size = strlen (MHD_HTTP_HEADER_CONTENT_TYPE);
+  header->header_hash = MHD_str_hash_caseless_bin_n_ (header->header,
+                                                      header->header_size);
+  header->value = (char *) content_type;
+  header->value_size = strlen (content_type);
+  header->kind = MHD_HEADER_KIND;
+}
+
+
+/**
+ * Stream @a body (of @a body_len) repeatedly through a fresh
+ * postprocessor until ~@a volume bytes were processed.
+ */
+static void
+run_case (const char *name,
+          const char *content_type,
+          const char *body,
+          size_t body_len,
+          size_t ppbuf,
+          size_t chunk,
+          uint64_t volume)
+{
+  struct MHD_Connection connection;
+  struct MHD_HTTP_Header header;
+  uint64_t done = 0;
+  uint64_t t0;
+  uint64_t t1;
+
+  consumed = 0;
+  t0 = now_ns ();
+  while (done < volume)
+  {
+    struct MHD_PostProcessor *pp;
+    size_t off;
+
+    setup_conn (&connection, &header, content_type);
+    pp = MHD_create_post_processor (&connection, ppbuf,
+                                    &value_counter, NULL);
+    if (NULL == pp)
+    {
+      fprintf (stderr, "create failed\n");
+      exit (1);
+    }
+    for (off = 0; off < body_len; off += chunk)
+    {
+      size_t n = body_len - off;
+
+      if (n > chunk)
+        n = chunk;
+      if (MHD_YES != MHD_post_process (pp, body + off, n))
+      {
+        fprintf (stderr, "%s: post_process failed\n", name);
+        exit (1);
+      }
+    }
+    MHD_destroy_post_processor (pp);
+    done += body_len;
+  }
+  t1 = now_ns ();
+  printf ("%-28s ppbuf=%6zu chunk=%6zu  %8.1f MB/s\n",
+          name, ppbuf, chunk,
+          (double) done * 1e3 / (double) (t1 - t0));
+}
+
+
+int
+main (int argc,
+      char *const *argv)
+{
+  uint64_t volume = 4 * 1024 * 1024;
+  char *mp_big;
+  size_t mp_big_len;
+  char *mp_many;
+  size_t mp_many_len;
+  char *url;
+  size_t url_len;
+  size_t i;
+  size_t off;
+
+  if (argc > 1)
+    volume = (uint64_t) atoll (argv[1]) * 1024 * 1024;
+  if (0 == volume)
+    volume = 4 * 1024 * 1024;
+
+  /* one large binary part (boundary-search fast path) */
+  mp_big_len = 1024 * 1024 + 256;
+  mp_big = malloc (mp_big_len + 1);
+  off = (size_t) snprintf (mp_big, 256,
+                           "--B\r\ncontent-disposition: form-data; "
+                           "name=\"blob\"\r\n\r\n");
+  for (i = 0; i < 1024 * 1024; i++)
+    mp_big[off + i] = (char) ('A' + (i % 61)); /* avoids CR */
+  off += 1024 * 1024;
+  off += (size_t) snprintf (mp_big + off, 16, "\r\n--B--\r\n");
+  mp_big_len = off;
+
+  /* many small parts (per-part overhead) */
+  mp_many = malloc (512 * 1024);
+  off = 0;
+  for (i = 0; i < 2000; i++)
+    off += (size_t) snprintf (mp_many + off, 256,
+                              "--B\r\ncontent-disposition: form-data; "
+                              "name=\"f%zu\"\r\n\r\nvalue%zu\r\n",
+                              i, i);
+  off += (size_t) snprintf (mp_many + off, 16, "--B--\r\n");
+  mp_many_len = off;
+
+  /* urlencoded with many pairs */
+  url = malloc (512 * 1024);
+  off = 0;
+  for (i = 0; i < 8000; i++)
+    off += (size_t) snprintf (url + off, 64, "key%zu=value%zu&", i, i);
+  url_len = off - 1; /* drop trailing '&' */
+  url[url_len] = '\0';
+
+  run_case ("multipart-1MB-part",
+            MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA "; boundary=B",
+            mp_big, mp_big_len, 32 * 1024, 16 * 1024, volume);
+  run_case ("multipart-1MB-part",
+            MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA "; boundary=B",
+            mp_big, mp_big_len, 4 * 1024, 64 * 1024, volume);
+  run_case ("multipart-2000-small",
+            MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA "; boundary=B",
+            mp_many, mp_many_len, 4 * 1024, 16 * 1024, volume);
+  run_case ("urlencoded-8000-pairs",
+            MHD_HTTP_POST_ENCODING_FORM_URLENCODED,
+            url, url_len, 4 * 1024, 16 * 1024, volume);
+  free (url);
+  free (mp_many);
+  free (mp_big);
+  return 0;
+}
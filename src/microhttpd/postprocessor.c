@@ -26,6 +26,7 @@
 #include "internal.h"
 #include "mhd_str.h"
 #include "mhd_compat.h"
+#include "memorypool.h"
 #include "mhd_assert.h"
 
 /**
@@ -223,6 +224,12 @@ struct MHD_PostProcessor
    */
   bool must_unescape_key;
 
+  /**
+   * True if this processor's memory came from the connection's
+   * pool (reclaimed automatically, must not be free()d).
+   */
+  bool pool_allocated;
+
   /**
    * State of the parser.
    */
@@ -337,8 +344,27 @@ MHD_create_post_processor (struct MHD_Connection *connection,
   buffer_size += 4; /* round up to get nice block sizes despite boundary search */
 
   /* add +1 to ensure we ALWAYS have a zero-termination at the end */
-  if (NULL == (ret = MHD_calloc_ (1, sizeof (struct MHD_PostProcessor)
-                                  + buffer_size + 1)))
+  ret = NULL;
+  if (NULL != connection->pool)
+  {
+    /* Prefer the connection's pool: the processor then costs no
+     * malloc/free per POST and is reclaimed with the request.
+     * (The end-allocation keeps it clear of read-buffer growth.) */
+    ret = MHD_pool_allocate (connection->pool,
+                             sizeof (struct MHD_PostProcessor)
+                             + buffer_size + 1,
+                             true);
+    if (NULL != ret)
+    {
+      memset (ret,
+              0,
+              sizeof (struct MHD_PostProcessor) + buffer_size + 1);
+      ret->pool_allocated = true;
+    }
+  }
+  if ( (NULL == ret) &&
+       (NULL == (ret = MHD_calloc_ (1, sizeof (struct MHD_PostProcessor)
+                                    + buffer_size + 1))) )
     return NULL;
   ret->connection = connection;
   ret->ikvi = iter;
@@ -489,6 +515,19 @@ process_value (struct MHD_PostProcessor *pp,
 }
 
 
+/**
+ * Note on zero-copy span delivery for urlencoded bodies: unlike the
+ * multipart value fast path, it cannot be offered here.
+ * MHD_post_process() receives the body as a const buffer, but
+ * urlencoded keys and values must be %%-decoded (and '+'-converted)
+ * before the iterator sees them, which requires a mutable copy --
+ * decoding shortens data in place.  Escape-free spans could in
+ * principle be passed through, but the iterator contract promises
+ * decoded bytes, and checking each span for escapes costs the same
+ * scan the copy already performs.  The buffered design stands; the
+ * postprocessor's copy costs were instead reduced via pool
+ * allocation and the multipart direct-span delivery.
+ */
 /**
  * Process url-encoded POST data.
  *
@@ -977,6 +1016,23 @@ process_value_to_boundary (struct MHD_PostProcessor *pp,
   newline = 0;
   while (1)
   {
+#ifdef HAVE_MEMMEM
+    if (newline + 4 < pp->buffer_pos)
+    {
+      /* Search for the whole "\r\n--" marker at once: memmem()
+       * runs at SIMD speed in common libcs and skips bare CRs in
+       * the payload without a per-hit comparison, so large binary
+       * parts stream at close to memory speed. */
+      r = memmem (&buf[newline],
+                  pp->buffer_pos - newline,
+                  "\r\n--",
+                  4);
+      if (NULL == r)
+        newline = pp->buffer_pos - 4;
+      else
+        newline = (size_t) (r - buf);
+    }
+#else  /* ! HAVE_MEMMEM */
     while (newline + 4 < pp->buffer_pos)
     {
       r = memchr (&buf[newline],
@@ -994,6 +1050,7 @@ process_value_to_boundary (struct MHD_PostProcessor *pp,
         break;
       newline++;
     }
+#endif /* ! HAVE_MEMMEM */
     if (newline + blen + 4 <= pp->buffer_pos)
     {
       /* can check boundary */
@@ -1117,6 +1174,83 @@ post_process_multipart (struct MHD_PostProcessor *pp,
           ( (pp->buffer_pos > 0) &&
             (0 != state_changed) ) )
   {
+    /* Zero-copy fast path: while streaming a value with an empty
+       internal buffer, bytes of the incoming span that provably
+       cannot be part of a boundary marker are handed to the
+       iterator directly, instead of being staged through the
+       internal buffer first.  Only the trailing (possibly
+       marker-straddling) fragment and the boundary handling itself
+       go through the regular buffered state machine. */
+    if ( ( (PP_ProcessValueToBoundary == pp->state) ||
+           (PP_Nested_ProcessValueToBoundary == pp->state) ) &&
+         (RN_Inactive == pp->skip_rn) &&
+         (0 == pp->buffer_pos) )
+    {
+      const size_t xblen = (PP_ProcessValueToBoundary == pp->state) ?
+                           pp->blen : pp->nlen;
+      const char *span = &post_data[poff];
+      const size_t span_len = post_data_len - poff;
+
+      if (span_len > xblen + 4)
+      {
+        /* Bytes beyond 'safe_len' may belong to a marker straddling
+           the end of this span; deliver only up to the first marker
+           candidate before it. */
+        const size_t safe_len = span_len - (xblen + 4);
+        const char *m;
+        size_t deliver;
+
+#ifdef HAVE_MEMMEM
+        m = memmem (span,
+                    safe_len + 3,
+                    "\r\n--",
+                    4);
+#else  /* ! HAVE_MEMMEM */
+        {
+          size_t sp = 0;
+
+          m = NULL;
+          while (sp < safe_len)
+          {
+            const char *r = memchr (&span[sp],
+                                    '\r',
+                                    safe_len - sp);
+            if (NULL == r)
+              break;
+            sp = (size_t) (r - span);
+            if (0 == memcmp ("\r\n--",
+                             &span[sp],
+                             4))
+            {
+              m = r;
+              break;
+            }
+            sp++;
+          }
+        }
+#endif /* ! HAVE_MEMMEM */
+        deliver = (NULL == m) ? safe_len : (size_t) (m - span);
+        if (0 != deliver)
+        {
+          if (MHD_NO == pp->ikvi (pp->cls,
+                                  MHD_POSTDATA_KIND,
+                                  pp->content_name,
+                                  pp->content_filename,
+                                  pp->content_type,
+                                  pp->content_transfer_encoding,
+                                  span,
+                                  pp->value_offset,
+                                  deliver))
+          {
+            pp->state = PP_Error;
+            return MHD_NO;
+          }
+          pp->must_ikvi = false;
+          pp->value_offset += deliver;
+          poff += deliver;
+        }
+      }
+    }
     /* first, move as much input data
        as possible to our internal buffer */
     max = pp->buffer_size - pp->buffer_pos;
@@ -1488,7 +1622,9 @@ MHD_destroy_post_processor (struct MHD_PostProcessor *pp)
   free_unmarked (pp);
   if (NULL != pp->nested_boundary)
     free (pp->nested_boundary);
-  free (pp);
+  if (! pp->pool_allocated)
+    free (pp);
+  /* pool-allocated processors are reclaimed with the request */
   return ret;
 }
 
@@ -26,6 +26,14 @@
  */
 #include "platform.h"
 #include "microhttpd.h"
+#include <string.h>
+
+#ifndef MHD_STATICSTR_LEN_
+/**
+ * Determine length of static string / macro strings at compile time.
+ */
+#define MHD_STATICSTR_LEN_(macro) (sizeof(macro) / sizeof(char) - 1)
+#endif /* ! MHD_STATICSTR_LEN_ */
 
 #ifndef NULL
 #define NULL ((void*) 0)
@@ -182,3 +190,30 @@ MHD_get_reason_phrase_for (unsigned int code)
     return reasons[code / 100].data[code % 100];
   return "Unknown";
 }
+
+
+/**
+ * Returns the length of the reason phrase returned by
+ * #MHD_get_reason_phrase_for() for the given status code, so
+ * status-line assembly can memcpy instead of re-measuring.
+ *
+ * @param code the HTTP status code
+ * @return length of the phrase in characters
+ */
+size_t
+MHD_get_reason_phrase_len_for (unsigned int code)
+{
+  /* Lengths are cached on first use per slot; phrases are
+   * compile-time constants, so the lazily filled values are
+   * idempotent (benign to race). */
+  static size_t lengths[600];
+
+  if ( (code >= 100) &&
+       (code < 600) )
+  {
+    if (0 == lengths[code])
+      lengths[code] = strlen (MHD_get_reason_phrase_for (code));
+    return lengths[code];
+  }
+  return MHD_STATICSTR_LEN_ ("Unknown");
+}
@@ -40,6 +40,18 @@
 #include "mhd_sockets.h"
 #include "mhd_itc.h"
 #include "mhd_str.h"
+#ifdef MHD_HAVE_ZLIB
+#include <zlib.h>
+#endif /* MHD_HAVE_ZLIB */
+#ifdef MHD_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif /* MHD_HAVE_BROTLI */
+#if defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 #include "connection.h"
 #include "memorypool.h"
 #include "mhd_compat.h"
@@ -87,6 +99,7 @@ add_response_entry (struct MHD_Response *response,
   struct MHD_HTTP_Header *hdr;
 
   if ( (NULL == response) ||
+       (response->frozen) ||
        (NULL == header) ||
        (NULL == content) ||
        (0 == header[0]) ||
@@ -106,6 +119,8 @@ add_response_entry (struct MHD_Response *response,
     return MHD_NO;
   }
   hdr->header_size = strlen (header);
+  hdr->header_hash = MHD_str_hash_caseless_bin_n_ (header,
+                                                   hdr->header_size);
   if (NULL == (hdr->value = strdup (content)))
   {
     free (hdr->header);
@@ -114,6 +129,7 @@ add_response_entry (struct MHD_Response *response,
   }
   hdr->value_size = strlen (content);
   hdr->kind = kind;
+  hdr->bulk_alloc = false;
   hdr->next = response->first_header;
   response->first_header = hdr;
   return MHD_YES;
@@ -205,7 +221,8 @@ MHD_del_response_header (struct MHD_Response *response,
   size_t content_len;
 
   if ( (NULL == header) ||
-       (NULL == content) )
+       (NULL == content) ||
+       (response->frozen) )
     return MHD_NO;
   header_len = strlen (header);
   content_len = strlen (content);
@@ -222,13 +239,16 @@ MHD_del_response_header (struct MHD_Response *response,
                       pos->value,
                       content_len)))
     {
-      free (pos->header);
-      free (pos->value);
       if (NULL == prev)
         response->first_header = pos->next;
       else
         prev->next = pos->next;
-      free (pos);
+      if (! pos->bulk_alloc)
+      {
+        free (pos->header);
+        free (pos->value);
+        free (pos);
+      } /* bulk entries' memory is freed with the response */
       return MHD_YES;
     }
     prev = pos;
@@ -303,6 +323,577 @@ MHD_get_response_header (struct MHD_Response *response,
 }
 
 
+/**
+ * Create a response from an array of memory fragments.  The
+ * fragments are transmitted directly from the application's
+ * buffers with scatter-gather I/O; see microhttpd.h for the
+ * lifetime contract.
+ *
+ * @param iov the array of fragments to send, in order
+ * @param iovcnt number of fragments in @a iov
+ * @param crfc callback to release the fragment memory, maybe NULL
+ * @param cls closure for @a crfc
+ * @return NULL on error (i.e. invalid arguments, out of memory)
+ * @ingroup response
+ */
+struct MHD_Response *
+MHD_create_response_from_iovec (const struct MHD_IoVec *iov,
+                                unsigned int iovcnt,
+                                MHD_ContentReaderFreeCallback crfc,
+                                void *cls)
+{
+  struct MHD_Response *response;
+  uint64_t total;
+  unsigned int i;
+
+  if ( (NULL == iov) ||
+       (0 == iovcnt) )
+    return NULL;
+  total = 0;
+  for (i = 0; i < iovcnt; ++i)
+  {
+    if ( (NULL == iov[i].iov_base) &&
+         (0 != iov[i].iov_len) )
+      return NULL;
+    if (total + iov[i].iov_len < total)
+      return NULL; /* overflow */
+    total += iov[i].iov_len;
+  }
+  if (NULL == (response = MHD_calloc_ (1, sizeof (struct MHD_Response))))
+    return NULL;
+  response->fd = -1;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  if (! MHD_mutex_init_ (&response->mutex))
+  {
+    free (response);
+    return NULL;
+  }
+#endif
+  response->data_iov = malloc (iovcnt * sizeof (struct MHD_IoVec));
+  if (NULL == response->data_iov)
+  {
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+    MHD_mutex_destroy_chk_ (&response->mutex);
+#endif
+    free (response);
+    return NULL;
+  }
+  memcpy (response->data_iov,
+          iov,
+          iovcnt * sizeof (struct MHD_IoVec));
+  response->data_iov_count = iovcnt;
+  response->crfc = crfc;
+  response->crc_cls = cls;
+  response->reference_count = 1;
+  response->total_size = total;
+  return response;
+}
+
+
+#ifdef MHD_HAVE_ZLIB
+/**
+ * Get (building and caching on first use) the gzip-compressed
+ * variant of a buffer-backed response.  Thread-safe: the build is
+ * serialized on the response mutex and performed at most once.
+ * Returns NULL when compression is not possible or does not pay
+ * off (tiny or incompressible bodies).
+ *
+ * @param response the identity response (must have
+ *        #MHD_RF_AUTO_GZIP set)
+ * @return the compressed variant, NULL if unavailable
+ */
+struct MHD_Response *
+MHD_response_get_gzip_alt_ (struct MHD_Response *response)
+{
+  struct MHD_Response *alt;
+
+  if ( (NULL == response->data) ||
+       (response->total_size != (uint64_t) response->data_size) ||
+       (response->data_size < 256) )
+    return NULL;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_lock_chk_ (&response->mutex);
+#endif
+  if (! response->gzip_alt_tried)
+  {
+    uLongf comp_size;
+    Bytef *comp;
+    z_stream zs;
+
+    response->gzip_alt_tried = true;
+    comp_size = compressBound ((uLong) response->data_size);
+    comp = malloc (comp_size);
+    if (NULL != comp)
+    {
+      memset (&zs, 0, sizeof (zs));
+      /* windowBits 15+16 selects the gzip wrapper */
+      if (Z_OK == deflateInit2 (&zs,
+                                Z_DEFAULT_COMPRESSION,
+                                Z_DEFLATED,
+                                15 + 16,
+                                8,
+                                Z_DEFAULT_STRATEGY))
+      {
+        zs.next_in = (Bytef *) response->data;
+        zs.avail_in = (uInt) response->data_size;
+        zs.next_out = comp;
+        zs.avail_out = (uInt) comp_size;
+        if (Z_STREAM_END == deflate (&zs,
+                                     Z_FINISH))
+        {
+          const size_t out_size = (size_t) zs.total_out;
+
+          /* Only keep the variant if compression actually pays. */
+          if (out_size + 128 < response->data_size)
+          {
+            alt = MHD_create_response_from_buffer (out_size,
+                                                   comp,
+                                                   MHD_RESPMEM_MUST_FREE);
+            if (NULL != alt)
+            {
+              struct MHD_HTTP_Header *pos;
+              bool hdrs_ok = true;
+
+              comp = NULL; /* owned by 'alt' now */
+              for (pos = response->first_header;
+                   NULL != pos;
+                   pos = pos->next)
+              {
+                if (MHD_YES != add_response_entry (alt,
+                                                   pos->kind,
+                                                   pos->header,
+                                                   pos->value))
+                  hdrs_ok = false;
+              }
+              if ( (! hdrs_ok) ||
+                   (MHD_YES != MHD_add_response_header (alt,
+                                                        MHD_HTTP_HEADER_CONTENT_ENCODING,
+                                                        "gzip")) )
+              {
+                MHD_destroy_response (alt);
+                alt = NULL;
+              }
+              else
+              {
+                if (response->frozen)
+                  (void) MHD_freeze_response (alt);
+                response->gzip_alt = alt;
+              }
+            }
+          }
+        }
+        deflateEnd (&zs);
+      }
+      free (comp);
+    }
+  }
+  alt = response->gzip_alt;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_unlock_chk_ (&response->mutex);
+#endif
+  return alt;
+}
+
+
+#endif /* MHD_HAVE_ZLIB */
+
+
+#ifdef MHD_HAVE_BROTLI
+/**
+ * Get (building and caching on first use) the brotli variant of a
+ * buffer-backed response; mirrors MHD_response_get_gzip_alt_().
+ *
+ * @param response the identity response
+ * @return the compressed variant, NULL if unavailable
+ */
+struct MHD_Response *
+MHD_response_get_br_alt_ (struct MHD_Response *response)
+{
+  struct MHD_Response *alt;
+
+  if ( (NULL == response->data) ||
+       (response->total_size != (uint64_t) response->data_size) ||
+       (response->data_size < 256) )
+    return NULL;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_lock_chk_ (&response->mutex);
+#endif
+  if (! response->br_alt_tried)
+  {
+    size_t comp_size = BrotliEncoderMaxCompressedSize (response->data_size);
+    uint8_t *comp;
+
+    response->br_alt_tried = true;
+    comp = (0 != comp_size) ? malloc (comp_size) : NULL;
+    if (NULL != comp)
+    {
+      size_t out_size = comp_size;
+
+      if ( (BROTLI_TRUE ==
+            BrotliEncoderCompress (BROTLI_DEFAULT_QUALITY,
+                                   BROTLI_DEFAULT_WINDOW,
+                                   BROTLI_DEFAULT_MODE,
+                                   response->data_size,
+                                   (const uint8_t *) response->data,
+                                   &out_size,
+                                   comp)) &&
+           (out_size + 128 < response->data_size) )
+      {
+        alt = MHD_create_response_from_buffer (out_size,
+                                               comp,
+                                               MHD_RESPMEM_MUST_FREE);
+        if (NULL != alt)
+        {
+          struct MHD_HTTP_Header *pos;
+          bool hdrs_ok = true;
+
+          comp = NULL; /* owned by 'alt' now */
+          for (pos = response->first_header; NULL != pos; pos = pos->next)
+          {
+            if (MHD_YES != add_response_entry (alt,
+                                               pos->kind,
+                                               pos->header,
+                                               pos->value))
+              hdrs_ok = false;
+          }
+          if ( (! hdrs_ok) ||
+               (MHD_YES != MHD_add_response_header (alt,
+                                                    MHD_HTTP_HEADER_CONTENT_ENCODING,
+                                                    "br")) )
+          {
+            MHD_destroy_response (alt);
+          }
+          else
+          {
+            if (response->frozen)
+              (void) MHD_freeze_response (alt);
+            response->br_alt = alt;
+          }
+        }
+      }
+      free (comp);
+    }
+  }
+  alt = response->br_alt;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_unlock_chk_ (&response->mutex);
+#endif
+  return alt;
+}
+
+
+#endif /* MHD_HAVE_BROTLI */
+
+
+/**
+ * Attach a pre-encoded alternate body to a logical response; see
+ * microhttpd.h for the contract.
+ *
+ * @param response the identity response
+ * @param encoding the content coding token
+ * @param variant the response holding the pre-encoded body
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @ingroup response
+ */
+enum MHD_Result
+MHD_response_add_encoding_variant (struct MHD_Response *response,
+                                   const char *encoding,
+                                   struct MHD_Response *variant)
+{
+  struct MHD_ResponseAltEncoding *alt;
+  struct MHD_ResponseAltEncoding **tail;
+
+  if ( (NULL == response) ||
+       (NULL == encoding) ||
+       ('\0' == encoding[0]) ||
+       (NULL == variant) ||
+       (response == variant) )
+    return MHD_NO;
+  if (MHD_YES != MHD_add_response_header (variant,
+                                          MHD_HTTP_HEADER_CONTENT_ENCODING,
+                                          encoding))
+  {
+    /* Tolerate an already-present matching header. */
+    const char *has = MHD_get_response_header (variant,
+                                               MHD_HTTP_HEADER_CONTENT_ENCODING);
+
+    if ( (NULL == has) ||
+         (! MHD_str_equal_caseless_ (has,
+                                     encoding)) )
+      return MHD_NO;
+  }
+  alt = malloc (sizeof (struct MHD_ResponseAltEncoding));
+  if (NULL == alt)
+    return MHD_NO;
+  alt->encoding = strdup (encoding);
+  if (NULL == alt->encoding)
+  {
+    free (alt);
+    return MHD_NO;
+  }
+  MHD_increment_response_rc (variant);
+  alt->variant = variant;
+  alt->next = NULL;
+  /* Append: variants are matched in attach order. */
+  for (tail = &response->alt_encodings; NULL != *tail;
+       tail = &(*tail)->next)
+    (void) 0;
+  *tail = alt;
+  return MHD_YES;
+}
+
+
+/**
+ * Closure for the mapping release callback of
+ * #MHD_create_response_from_file_mapped().
+ */
+struct MHD_MappedFile
+{
+  /**
+   * Page-aligned mapping base.
+   */
+  void *map;
+
+  /**
+   * Length of the mapping.
+   */
+  size_t map_len;
+};
+
+
+/**
+ * Release a file mapping when its response is destroyed.
+ *
+ * @param cls the `struct MHD_MappedFile`
+ */
+static void
+mapped_file_free_ (void *cls)
+{
+  struct MHD_MappedFile *mf = cls;
+
+#if defined(MAP_ANONYMOUS) && ! defined(_WIN32)
+  munmap (mf->map,
+          mf->map_len);
+#endif
+  free (mf);
+}
+
+
+/**
+ * Create a response serving @a size bytes of the file behind @a fd
+ * starting at @a offset through a private read-only mapping owned
+ * by the response: the kernel knows the memory is file-backed, MHD
+ * advises sequential access for effective read-ahead, and the
+ * mapping (with its page cache references) is dropped when the
+ * response is destroyed.  Unlike the FD-backed responses, @a fd is
+ * NOT owned by the response and may be closed by the caller right
+ * after this call.  The response is shareable/refcountable like any
+ * buffer response, and large transfers still benefit from
+ * MSG_ZEROCOPY where enabled.
+ *
+ * @param size number of bytes to serve
+ * @param fd the file to map (only used during this call)
+ * @param offset offset of the served range in the file
+ * @return the response, NULL on error (e.g. mmap failure)
+ * @ingroup response
+ */
+struct MHD_Response *
+MHD_create_response_from_file_mapped (size_t size,
+                                      int fd,
+                                      uint64_t offset)
+{
+#if defined(MAP_ANONYMOUS) && ! defined(_WIN32)
+  struct MHD_MappedFile *mf;
+  struct MHD_Response *r;
+  uint64_t aligned_off;
+  size_t page_skew;
+  long page_size = sysconf (_SC_PAGESIZE);
+
+  if ( (0 == size) ||
+       (-1 == fd) ||
+       (0 >= page_size) )
+    return NULL;
+  mf = malloc (sizeof (struct MHD_MappedFile));
+  if (NULL == mf)
+    return NULL;
+  page_skew = (size_t) (offset % (uint64_t) page_size);
+  aligned_off = offset - page_skew;
+  mf->map_len = size + page_skew;
+  mf->map = mmap (NULL,
+                  mf->map_len,
+                  PROT_READ,
+                  MAP_PRIVATE,
+                  fd,
+                  (off_t) aligned_off);
+  if (MAP_FAILED == mf->map)
+  {
+    free (mf);
+    return NULL;
+  }
+#ifdef MADV_SEQUENTIAL
+  (void) madvise (mf->map,
+                  mf->map_len,
+                  MADV_SEQUENTIAL);
+#endif /* MADV_SEQUENTIAL */
+  r = MHD_create_response_from_buffer (size,
+                                       ((char *) mf->map) + page_skew,
+                                       MHD_RESPMEM_PERSISTENT);
+  if (NULL == r)
+  {
+    mapped_file_free_ (mf);
+    return NULL;
+  }
+  r->crfc = &mapped_file_free_;
+  r->crc_cls = mf;
+  return r;
+#else  /* ! MAP_ANONYMOUS || _WIN32 */
+  (void) size;
+  (void) fd;
+  (void) offset;
+  return NULL;
+#endif /* ! MAP_ANONYMOUS || _WIN32 */
+}
+
+
+/**
+ * Add several headers to a response with one allocation; see
+ * microhttpd.h for the contract.
+ *
+ * @param response the response to modify
+ * @param n number of header pairs
+ * @param headers array of 2*n strings (name, value, ...)
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @ingroup response
+ */
+enum MHD_Result
+MHD_add_response_headers (struct MHD_Response *response,
+                          unsigned int n,
+                          const char *const *headers)
+{
+  size_t strings_size = 0;
+  unsigned int i;
+  char *block;
+  struct MHD_HTTP_Header *hdrs;
+  char *sp;
+
+  if ( (NULL == response) ||
+       (response->frozen) ||
+       (0 == n) ||
+       (NULL == headers) )
+    return MHD_NO;
+  for (i = 0; i < 2 * n; i++)
+  {
+    if ( (NULL == headers[i]) ||
+         ('\0' == headers[i][0]) ||
+         (NULL != strchr (headers[i], '\t')) ||
+         (NULL != strchr (headers[i], '\r')) ||
+         (NULL != strchr (headers[i], '\n')) )
+      return MHD_NO;
+    strings_size += strlen (headers[i]) + 1;
+  }
+  /* one block: next-block link + n entry records + all strings */
+  block = malloc (sizeof (void *)
+                  + n * sizeof (struct MHD_HTTP_Header)
+                  + strings_size);
+  if (NULL == block)
+    return MHD_NO;
+  *(void **) block = response->header_blocks;
+  response->header_blocks = block;
+  hdrs = (struct MHD_HTTP_Header *) (block + sizeof (void *));
+  sp = (char *) (hdrs + n);
+  for (i = 0; i < n; i++)
+  {
+    struct MHD_HTTP_Header *h = &hdrs[i];
+
+    h->header = sp;
+    h->header_size = strlen (headers[2 * i]);
+    memcpy (sp, headers[2 * i], h->header_size + 1);
+    sp += h->header_size + 1;
+    h->header_hash = MHD_str_hash_caseless_bin_n_ (h->header,
+                                                   h->header_size);
+    h->value = sp;
+    h->value_size = strlen (headers[2 * i + 1]);
+    memcpy (sp, headers[2 * i + 1], h->value_size + 1);
+    sp += h->value_size + 1;
+    h->kind = MHD_HEADER_KIND;
+    h->bulk_alloc = true;
+    h->next = response->first_header;
+    response->first_header = h;
+  }
+  return MHD_YES;
+}
+
+
+/**
+ * Make the @a response object immutable and pre-serialize its
+ * headers.  After this call adding or removing headers fails and the
+ * "Name: Value" block of all headers is rendered once into a
+ * contiguous buffer which is copied verbatim into the reply for
+ * every request, instead of re-walking and re-formatting the header
+ * list each time.  Useful for canned responses which are queued
+ * (unchanged) for a large number of requests.
+ *
+ * This function must not be called while the response is being used
+ * concurrently by another thread.  Footers are not affected (they
+ * may legitimately be added while a chunked reply is streamed).
+ *
+ * @param response the response to freeze
+ * @return #MHD_YES on success,
+ *         #MHD_NO on allocation failure
+ * @ingroup response
+ */
+enum MHD_Result
+MHD_freeze_response (struct MHD_Response *response)
+{
+  struct MHD_HTTP_Header *pos;
+  size_t size;
+  size_t off;
+  char *block;
+
+  if (NULL == response)
+    return MHD_NO;
+  if (response->frozen)
+    return MHD_YES;
+  size = 0;
+  for (pos = response->first_header; NULL != pos; pos = pos->next)
+  {
+    if (MHD_HEADER_KIND == pos->kind)
+      size += pos->header_size + pos->value_size + 4; /* ": " + CRLF */
+  }
+  if (0 != size)
+  {
+    block = malloc (size);
+    if (NULL == block)
+      return MHD_NO;
+    /* Serialize in list order, matching the order in which
+     * build_header_response() walks the list. */
+    off = 0;
+    for (pos = response->first_header; NULL != pos; pos = pos->next)
+    {
+      if (MHD_HEADER_KIND != pos->kind)
+        continue;
+      memcpy (&block[off],
+              pos->header,
+              pos->header_size);
+      off += pos->header_size;
+      block[off++] = ':';
+      block[off++] = ' ';
+      memcpy (&block[off],
+              pos->value,
+              pos->value_size);
+      off += pos->value_size;
+      block[off++] = '\r';
+      block[off++] = '\n';
+    }
+    mhd_assert (off == size);
+    response->frozen_header_block = block;
+    response->frozen_header_block_size = size;
+  }
+  response->frozen = true;
+  return MHD_YES;
+}
+
+
 /**
  * Check whether response header contains particular token.
  *
@@ -388,6 +979,7 @@ MHD_create_response_from_callback (uint64_t size,
   response->fd = -1;
   response->data = (void *) &response[1];
   response->data_buffer_size = block_size;
+  response->crc_ready_hint = MHD_SIZE_UNKNOWN;
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   if (! MHD_mutex_init_ (&response->mutex))
   {
@@ -404,6 +996,46 @@ MHD_create_response_from_callback (uint64_t size,
 }
 
 
+/**
+ * Record how many more bytes the content reader callback could
+ * deliver immediately; see the public documentation.  Written
+ * without locking: the field is only read by the connection that
+ * is currently inside the callback.
+ *
+ * @param response the response being generated
+ * @param ready bytes additionally ready, 0 for "drained for now"
+ */
+void
+MHD_content_reader_set_ready_size (struct MHD_Response *response,
+                                   uint64_t ready)
+{
+  if (NULL == response)
+    return;
+  response->crc_ready_hint = ready;
+}
+
+
+/**
+ * Register the send-completion callback; see the public
+ * documentation.
+ *
+ * @param response response to watch
+ * @param cb callback to invoke on send completion
+ * @param cb_cls closure for @a cb
+ */
+void
+MHD_response_set_sent_callback (struct MHD_Response *response,
+                                MHD_ResponseSentCallback cb,
+                                void *cb_cls)
+{
+  if (NULL == response)
+    return;
+  response->sent_cb = cb;
+  response->sent_cb_cls = cb_cls;
+}
+
+
+
 /**
  * Set special flags and options for a response.
  *
@@ -423,6 +1055,17 @@ MHD_set_response_options (struct MHD_Response *response,
 
   ret = MHD_YES;
   response->flags = flags;
+  /* Negotiated encodings make the representation depend on
+     Accept-Encoding: emit the matching Vary header so shared
+     caches never replay a compressed variant to a client that
+     did not offer the coding.  An application-provided Vary
+     header is left alone. */
+  if ( (0 != (flags & (MHD_RF_AUTO_GZIP | MHD_RF_AUTO_BROTLI))) &&
+       (NULL == MHD_get_response_header (response,
+                                         MHD_HTTP_HEADER_VARY)) )
+    (void) MHD_add_response_header (response,
+                                    MHD_HTTP_HEADER_VARY,
+                                    "Accept-Encoding");
   va_start (ap, flags);
   while (MHD_RO_END != (ro = va_arg (ap, enum MHD_ResponseOptions)))
   {
@@ -920,6 +1563,19 @@ MHD_upgrade_action (struct MHD_UpgradeResponseHandle *urh,
 }
 
 
+/**
+ * Note on fully-detached upgrades: for plaintext connections this
+ * is already the behavior -- the application receives the raw
+ * client socket in its MHD_UpgradeHandler and MHD stops touching
+ * it entirely (no event-loop membership, no forwarding machinery);
+ * dedicated application I/O threads can own it outright, with
+ * MHD_UPGRADE_ACTION_CLOSE as the only remaining tie.  Only TLS
+ * upgrades route through the socketpair-forwarding handle, because
+ * the GnuTLS session object is owned by MHD and record processing
+ * must stay with it; handing the session across the API (including
+ * its cipher state machine and our credential lifetimes) is what a
+ * detached TLS upgrade would actually require.
+ */
 /**
  * We are done sending the header of a given response to the client.
  * Now it is time to perform the upgrade and hand over the connection
@@ -1259,6 +1915,13 @@ MHD_destroy_response (struct MHD_Response *response)
 
   if (NULL == response)
     return;
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  if (! MHD_refcount_dec_is_zero_ (&response->reference_count))
+    return;
+#if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
+  MHD_mutex_destroy_chk_ (&response->mutex);
+#endif
+#else  /* ! MHD_HAVE_STDC_ATOMICS_ */
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_lock_chk_ (&response->mutex);
 #endif
@@ -1273,15 +1936,41 @@ MHD_destroy_response (struct MHD_Response *response)
   MHD_mutex_unlock_chk_ (&response->mutex);
   MHD_mutex_destroy_chk_ (&response->mutex);
 #endif
+#endif /* ! MHD_HAVE_STDC_ATOMICS_ */
   if (NULL != response->crfc)
     response->crfc (response->crc_cls);
+  if (NULL != response->gzip_alt)
+    MHD_destroy_response (response->gzip_alt);
+  if (NULL != response->br_alt)
+    MHD_destroy_response (response->br_alt);
+  while (NULL != response->alt_encodings)
+  {
+    struct MHD_ResponseAltEncoding *alt = response->alt_encodings;
+
+    response->alt_encodings = alt->next;
+    MHD_destroy_response (alt->variant);
+    free (alt->encoding);
+    free (alt);
+  }
+  free (response->frozen_header_block);
+  free (response->data_iov);
   while (NULL != response->first_header)
   {
     pos = response->first_header;
     response->first_header = pos->next;
-    free (pos->header);
-    free (pos->value);
-    free (pos);
+    if (! pos->bulk_alloc)
+    {
+      free (pos->header);
+      free (pos->value);
+      free (pos);
+    }
+  }
+  while (NULL != response->header_blocks)
+  {
+    void *block = response->header_blocks;
+
+    response->header_blocks = *(void **) block;
+    free (block);
   }
   free (response);
 }
@@ -1295,6 +1984,11 @@ MHD_destroy_response (struct MHD_Response *response)
 void
 MHD_increment_response_rc (struct MHD_Response *response)
 {
+#ifdef MHD_HAVE_STDC_ATOMICS_
+  /* Wait-free: shared (e.g. canned) responses can be queued from all
+   * workers without bouncing the mutex cacheline between cores. */
+  MHD_refcount_inc_ (&response->reference_count);
+#else  /* ! MHD_HAVE_STDC_ATOMICS_ */
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_lock_chk_ (&response->mutex);
 #endif
@@ -1302,6 +1996,7 @@ MHD_increment_response_rc (struct MHD_Response *response)
 #if defined(MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
   MHD_mutex_unlock_chk_ (&response->mutex);
 #endif
+#endif /* ! MHD_HAVE_STDC_ATOMICS_ */
 }
 
 
@@ -54,4 +54,31 @@ MHD_response_execute_upgrade_ (struct MHD_Response *response,
                                struct MHD_Connection *connection);
 
 
+
+#ifdef MHD_HAVE_ZLIB
+/**
+ * Get (building and caching on first use) the gzip variant of a
+ * buffer-backed response marked with #MHD_RF_AUTO_GZIP.
+ *
+ * @param response the identity response
+ * @return the compressed variant, NULL if unavailable
+ */
+struct MHD_Response *
+MHD_response_get_gzip_alt_ (struct MHD_Response *response);
+
+#endif /* MHD_HAVE_ZLIB */
+
+#ifdef MHD_HAVE_BROTLI
+/**
+ * Get (building and caching on first use) the brotli variant of a
+ * buffer-backed response marked with #MHD_RF_AUTO_BROTLI.
+ *
+ * @param response the identity response
+ * @return the compressed variant, NULL if unavailable
+ */
+struct MHD_Response *
+MHD_response_get_br_alt_ (struct MHD_Response *response);
+
+#endif /* MHD_HAVE_BROTLI */
+
 #endif
@@ -0,0 +1,627 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 Christian Grothoff (and other contributing authors)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/router.c
+ * @brief  Compiled URL routing table (character trie)
+ * @author Christian Grothoff
+ *
+ * Replaces the strcmp chains applications typically run in their
+ * access handler: routes are compiled into a character trie at
+ * registration time, dispatch walks the URL once (O(length of the
+ * URL), independent of the number of routes).  The router is built
+ * before the daemon starts and is immutable afterwards, so dispatch
+ * needs no locks; the whole object is passed to #MHD_start_daemon
+ * as the access handler pair (#MHD_router_dispatch, router).
+ */
+#include "internal.h"
+#include "mhd_compat.h"
+#include "mhd_str.h"
+
+
+/**
+ * One node of the routing trie; children are kept as a linked list
+ * (route sets are small and built once).
+ */
+struct MHD_RouteNode
+{
+  /**
+   * First child.
+   */
+  struct MHD_RouteNode *child;
+
+  /**
+   * Next sibling.
+   */
+  struct MHD_RouteNode *sibling;
+
+  /**
+   * Handler if a route terminates at this node, NULL otherwise.
+   */
+  MHD_AccessHandlerCallback handler;
+
+  /**
+   * Closure for @e handler.
+   */
+  void *handler_cls;
+
+  /**
+   * The character matched by this node.
+   */
+  char ch;
+
+  /**
+   * True if a route ending in '*' terminates here: the handler
+   * also matches any URL continuing past this point.
+   */
+  bool prefix;
+};
+
+
+/**
+ * A compiled routing table.
+ * @sa #MHD_router_create()
+ */
+struct MHD_Router
+{
+  /**
+   * Trie root; level one matches the method (so "GET /x" and
+   * "POST /x" are distinct entries), joined to the URL by a single
+   * ' '.
+   */
+  struct MHD_RouteNode root;
+
+  /**
+   * Handler called when no route matches (may be NULL: then
+   * unmatched requests fail).
+   */
+  MHD_AccessHandlerCallback fallback;
+
+  /**
+   * Closure for @e fallback.
+   */
+  void *fallback_cls;
+};
+
+
+/**
+ * Create an empty routing table.
+ *
+ * @param fallback handler for unmatched requests, maybe NULL
+ *        (unmatched requests then fail hard)
+ * @param fallback_cls closure for @a fallback
+ * @return the router, NULL on error
+ * @ingroup request
+ */
+struct MHD_Router *
+MHD_router_create (MHD_AccessHandlerCallback fallback,
+                   void *fallback_cls)
+{
+  struct MHD_Router *router;
+
+  router = MHD_calloc_ (1, sizeof (struct MHD_Router));
+  if (NULL == router)
+    return NULL;
+  router->fallback = fallback;
+  router->fallback_cls = fallback_cls;
+  return router;
+}
+
+
+/**
+ * Release a trie subtree.
+ *
+ * @param node subtree root (children and siblings are freed,
+ *        @a node itself is freed too)
+ */
+static void
+route_node_free_ (struct MHD_RouteNode *node)
+{
+  while (NULL != node)
+  {
+    struct MHD_RouteNode *next = node->sibling;
+
+    route_node_free_ (node->child);
+    free (node);
+    node = next;
+  }
+}
+
+
+/**
+ * Destroy a routing table.  Must not be called while a daemon is
+ * still dispatching through it.
+ *
+ * @param router the router to destroy (maybe NULL)
+ * @ingroup request
+ */
+void
+MHD_router_destroy (struct MHD_Router *router)
+{
+  if (NULL == router)
+    return;
+  route_node_free_ (router->root.child);
+  free (router);
+}
+
+
+/**
+ * Get (creating if needed) the child of @a node matching @a ch.
+ *
+ * @param node the parent node
+ * @param ch the character to match
+ * @return the child node, NULL on allocation failure
+ */
+static struct MHD_RouteNode *
+route_node_child_ (struct MHD_RouteNode *node,
+                   char ch)
+{
+  struct MHD_RouteNode *c;
+
+  for (c = node->child; NULL != c; c = c->sibling)
+    if (ch == c->ch)
+      return c;
+  c = MHD_calloc_ (1, sizeof (struct MHD_RouteNode));
+  if (NULL == c)
+    return NULL;
+  c->ch = ch;
+  c->sibling = node->child;
+  node->child = c;
+  return c;
+}
+
+
+/**
+ * Register a route.  Must be called before the daemon using this
+ * router starts serving requests (the trie is immutable during
+ * dispatch).  A pattern ending in '*' matches any URL with the
+ * preceding prefix; otherwise the match is exact.  The most
+ * specific (longest) matching route wins.
+ *
+ * @param router the router
+ * @param method HTTP method to match (e.g. #MHD_HTTP_METHOD_GET),
+ *        NULL to match any method
+ * @param pattern the URL (or URL prefix, with trailing '*') to
+ *        match
+ * @param handler handler to dispatch to
+ * @param handler_cls closure for @a handler
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @ingroup request
+ */
+enum MHD_Result
+MHD_router_add (struct MHD_Router *router,
+                const char *method,
+                const char *pattern,
+                MHD_AccessHandlerCallback handler,
+                void *handler_cls)
+{
+  struct MHD_RouteNode *node;
+  const char *p;
+  bool prefix;
+  size_t plen;
+
+  if ( (NULL == router) ||
+       (NULL == pattern) ||
+       (NULL == handler) )
+    return MHD_NO;
+  plen = strlen (pattern);
+  prefix = ( (0 != plen) &&
+             ('*' == pattern[plen - 1]) );
+  if (prefix)
+    plen--;
+  node = &router->root;
+  /* Level one: the method (or '\1' for "any method"),
+   * terminated by ' ' which cannot appear in a method token. */
+  if (NULL != method)
+  {
+    for (p = method; '\0' != *p; ++p)
+    {
+      node = route_node_child_ (node, *p);
+      if (NULL == node)
+        return MHD_NO;
+    }
+  }
+  else
+  {
+    node = route_node_child_ (node, '\1');
+    if (NULL == node)
+      return MHD_NO;
+  }
+  node = route_node_child_ (node, ' ');
+  if (NULL == node)
+    return MHD_NO;
+  for (p = pattern; p < pattern + plen; ++p)
+  {
+    node = route_node_child_ (node, *p);
+    if (NULL == node)
+      return MHD_NO;
+  }
+  node->handler = handler;
+  node->handler_cls = handler_cls;
+  node->prefix = prefix;
+  return MHD_YES;
+}
+
+
+/**
+ * Walk the trie for @a url below the method node @a start,
+ * remembering the deepest prefix-route passed.
+ *
+ * @param start node after the ' ' separator
+ * @param url the request URL
+ * @param[out] handler_cls set to the winning handler's closure
+ * @return the winning handler, NULL if no route matched
+ */
+static MHD_AccessHandlerCallback
+route_match_ (struct MHD_RouteNode *start,
+              const char *url,
+              void **handler_cls)
+{
+  struct MHD_RouteNode *node = start;
+  MHD_AccessHandlerCallback best = NULL;
+  const char *p;
+
+  if (NULL == node)
+    return NULL;
+  if (node->prefix)
+  {
+    best = node->handler;
+    *handler_cls = node->handler_cls;
+  }
+  for (p = url; '\0' != *p; ++p)
+  {
+    struct MHD_RouteNode *c;
+
+    for (c = node->child; NULL != c; c = c->sibling)
+      if (*p == c->ch)
+        break;
+    if (NULL == c)
+      return best;
+    node = c;
+    if (node->prefix)
+    {
+      best = node->handler;
+      *handler_cls = node->handler_cls;
+    }
+  }
+  if (NULL != node->handler)
+  {
+    *handler_cls = node->handler_cls;
+    return node->handler;
+  }
+  return best;
+}
+
+
+/**
+ * Access handler that dispatches through a router; pass this
+ * function together with the router as the handler pair to
+ * #MHD_start_daemon.
+ *
+ * @param cls the `struct MHD_Router`
+ * @param connection the connection
+ * @param url requested URL
+ * @param method HTTP method
+ * @param version HTTP version
+ * @param upload_data upload data
+ * @param upload_data_size size of @a upload_data
+ * @param con_cls per-request state pointer
+ * @return result of the dispatched handler, #MHD_NO if no route
+ *         and no fallback matched
+ * @ingroup request
+ */
+enum MHD_Result
+MHD_router_dispatch (void *cls,
+                     struct MHD_Connection *connection,
+                     const char *url,
+                     const char *method,
+                     const char *version,
+                     const char *upload_data,
+                     size_t *upload_data_size,
+                     void **con_cls)
+{
+  struct MHD_Router *router = cls;
+  struct MHD_RouteNode *node;
+  MHD_AccessHandlerCallback handler;
+  void *handler_cls;
+  const char *p;
+
+  /* Method-specific subtree first, then the any-method subtree. */
+  node = &router->root;
+  for (p = method; ('\0' != *p) && (NULL != node); ++p)
+  {
+    struct MHD_RouteNode *c;
+
+    for (c = node->child; NULL != c; c = c->sibling)
+      if (*p == c->ch)
+        break;
+    node = c;
+  }
+  if (NULL != node)
+  {
+    struct MHD_RouteNode *c;
+
+    for (c = node->child; NULL != c; c = c->sibling)
+      if (' ' == c->ch)
+        break;
+    handler_cls = NULL;
+    handler = route_match_ (c, url, &handler_cls);
+    if (NULL != handler)
+      return handler (handler_cls, connection, url, method, version,
+                      upload_data, upload_data_size, con_cls);
+  }
+  node = NULL;
+  {
+    struct MHD_RouteNode *c;
+
+    for (c = router->root.child; NULL != c; c = c->sibling)
+      if ('\1' == c->ch)
+        break;
+    if (NULL != c)
+      for (node = c->child; NULL != node; node = node->sibling)
+        if (' ' == node->ch)
+          break;
+  }
+  handler_cls = NULL;
+  handler = route_match_ (node, url, &handler_cls);
+  if (NULL != handler)
+    return handler (handler_cls, connection, url, method, version,
+                    upload_data, upload_data_size, con_cls);
+  if (NULL != router->fallback)
+    return router->fallback (router->fallback_cls, connection, url, method,
+                             version, upload_data, upload_data_size, con_cls);
+  return MHD_NO;
+}
+
+
+/**
+ * One virtual host entry.
+ */
+struct MHD_VhostEntry
+{
+  /**
+   * Next entry in the same hash bucket.
+   */
+  struct MHD_VhostEntry *next;
+
+  /**
+   * Host name (lower-cased at registration, malloc'ed).
+   */
+  char *host;
+
+  /**
+   * Length of @e host.
+   */
+  size_t host_len;
+
+  /**
+   * Case-folded hash of @e host.
+   */
+  uint32_t hash;
+
+  /**
+   * Handler serving this virtual host.
+   */
+  MHD_AccessHandlerCallback handler;
+
+  /**
+   * Closure for @e handler.
+   */
+  void *handler_cls;
+};
+
+/**
+ * Number of buckets in a vhost table; power of two, generous for
+ * a few hundred vhosts.
+ */
+#define MHD_VHOST_BUCKETS_ 512
+
+/**
+ * A virtual-host dispatch table.
+ * @sa #MHD_vhosts_create()
+ */
+struct MHD_Vhosts
+{
+  /**
+   * Hash buckets.
+   */
+  struct MHD_VhostEntry *buckets[MHD_VHOST_BUCKETS_];
+
+  /**
+   * Handler for requests whose Host matches no registered vhost
+   * (or which carry no Host header); maybe NULL to fail them.
+   */
+  MHD_AccessHandlerCallback fallback;
+
+  /**
+   * Closure for @e fallback.
+   */
+  void *fallback_cls;
+};
+
+
+/**
+ * Create an empty virtual-host table.
+ *
+ * @param fallback handler for unmatched hosts, maybe NULL
+ * @param fallback_cls closure for @a fallback
+ * @return the table, NULL on error
+ * @ingroup request
+ */
+struct MHD_Vhosts *
+MHD_vhosts_create (MHD_AccessHandlerCallback fallback,
+                   void *fallback_cls)
+{
+  struct MHD_Vhosts *vh;
+
+  vh = MHD_calloc_ (1, sizeof (struct MHD_Vhosts));
+  if (NULL == vh)
+    return NULL;
+  vh->fallback = fallback;
+  vh->fallback_cls = fallback_cls;
+  return vh;
+}
+
+
+/**
+ * Register a virtual host.  Must be called before the daemon using
+ * this table starts serving (the table is immutable during
+ * dispatch).  Host comparison is case-insensitive and ignores any
+ * ':port' suffix of the request's Host header.
+ *
+ * @param vh the table
+ * @param host the host name to match
+ * @param handler handler serving this virtual host
+ * @param handler_cls closure for @a handler
+ * @return #MHD_YES on success, #MHD_NO on error
+ * @ingroup request
+ */
+enum MHD_Result
+MHD_vhosts_add (struct MHD_Vhosts *vh,
+                const char *host,
+                MHD_AccessHandlerCallback handler,
+                void *handler_cls)
+{
+  struct MHD_VhostEntry *e;
+  uint32_t hash;
+
+  if ( (NULL == vh) ||
+       (NULL == host) ||
+       ('\0' == host[0]) ||
+       (NULL == handler) )
+    return MHD_NO;
+  e = MHD_calloc_ (1, sizeof (struct MHD_VhostEntry));
+  if (NULL == e)
+    return MHD_NO;
+  e->host = strdup (host);
+  if (NULL == e->host)
+  {
+    free (e);
+    return MHD_NO;
+  }
+  e->host_len = strlen (host);
+  e->hash = MHD_str_hash_caseless_bin_n_ (host,
+                                          e->host_len);
+  e->handler = handler;
+  e->handler_cls = handler_cls;
+  hash = e->hash & (MHD_VHOST_BUCKETS_ - 1);
+  e->next = vh->buckets[hash];
+  vh->buckets[hash] = e;
+  return MHD_YES;
+}
+
+
+/**
+ * Destroy a virtual-host table.  Must not be called while a daemon
+ * is still dispatching through it.
+ *
+ * @param vh the table to destroy (maybe NULL)
+ * @ingroup request
+ */
+void
+MHD_vhosts_destroy (struct MHD_Vhosts *vh)
+{
+  unsigned int i;
+
+  if (NULL == vh)
+    return;
+  for (i = 0; i < MHD_VHOST_BUCKETS_; ++i)
+  {
+    while (NULL != vh->buckets[i])
+    {
+      struct MHD_VhostEntry *e = vh->buckets[i];
+
+      vh->buckets[i] = e->next;
+      free (e->host);
+      free (e);
+    }
+  }
+  free (vh);
+}
+
+
+/**
+ * Access handler dispatching on the request's Host header; pass
+ * together with the table as the handler pair to
+ * #MHD_start_daemon.
+ *
+ * @param cls the `struct MHD_Vhosts`
+ * @param connection the connection
+ * @param url requested URL
+ * @param method HTTP method
+ * @param version HTTP version
+ * @param upload_data upload data
+ * @param upload_data_size size of @a upload_data
+ * @param con_cls per-request state pointer
+ * @return result of the dispatched handler, #MHD_NO if no vhost
+ *         and no fallback matched
+ * @ingroup request
+ */
+enum MHD_Result
+MHD_vhosts_dispatch (void *cls,
+                     struct MHD_Connection *connection,
+                     const char *url,
+                     const char *method,
+                     const char *version,
+                     const char *upload_data,
+                     size_t *upload_data_size,
+                     void **con_cls)
+{
+  struct MHD_Vhosts *vh = cls;
+  const char *host;
+  size_t host_len;
+  const char *colon;
+  uint32_t hash;
+  struct MHD_VhostEntry *e;
+
+  if (MHD_NO != MHD_lookup_connection_value_n (connection,
+                                               MHD_HEADER_KIND,
+                                               MHD_HTTP_HEADER_HOST,
+                                               MHD_STATICSTR_LEN_ (
+                                                 MHD_HTTP_HEADER_HOST),
+                                               &host,
+                                               &host_len))
+  {
+    /* strip any ':port' suffix */
+    colon = memchr (host,
+                    ':',
+                    host_len);
+    if (NULL != colon)
+      host_len = (size_t) (colon - host);
+    hash = MHD_str_hash_caseless_bin_n_ (host,
+                                         host_len);
+    for (e = vh->buckets[hash & (MHD_VHOST_BUCKETS_ - 1)];
+         NULL != e;
+         e = e->next)
+    {
+      if ( (hash == e->hash) &&
+           (host_len == e->host_len) &&
+           (MHD_str_equal_caseless_bin_n_ (host,
+                                           e->host,
+                                           host_len)) )
+        return e->handler (e->handler_cls, connection, url, method, version,
+                           upload_data, upload_data_size, con_cls);
+    }
+  }
+  if (NULL != vh->fallback)
+    return vh->fallback (vh->fallback_cls, connection, url, method, version,
+                         upload_data, upload_data_size, con_cls);
+  return MHD_NO;
+}
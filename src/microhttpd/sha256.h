@@ -58,6 +58,25 @@ struct sha256_ctx
   uint8_t buffer[SHA256_BLOCK_SIZE];    /**< SHA256 input data buffer */
 };
 
+#if defined(__GNUC__) && defined(__x86_64__) && \
+  (defined(__clang__) || (__GNUC__ + 0 >= 5))
+/**
+ * A hardware-accelerated compression function implementation is
+ * compiled in and can be selected at run time.
+ */
+#define MHD_SHA256_HAS_EXT_IMPL_ 1
+
+/**
+ * Detect CPU support for the SHA extensions and switch the
+ * compression function used behind MHD_SHA256_update()/finish() to
+ * the hardware implementation if available.  Called once from
+ * MHD_init(); safe to call repeatedly.
+ */
+void
+MHD_SHA256_select_impl_ (void);
+
+#endif /* __GNUC__ && __x86_64__ */
+
 /**
  * Initialise structure for SHA256 calculation.
  *
@@ -25,6 +25,7 @@
 #include "platform.h"
 #include "microhttpd.h"
 #include "internal.h"
+#include "mhd_str.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -182,6 +183,8 @@ test_urlencoding_case (unsigned int want_start,
   header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
   header.value = MHD_HTTP_POST_ENCODING_FORM_URLENCODED;
   header.header_size = MHD_STATICSTR_LEN_ (MHD_HTTP_HEADER_CONTENT_TYPE);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = MHD_STATICSTR_LEN_ (
     MHD_HTTP_POST_ENCODING_FORM_URLENCODED);
   header.kind = MHD_HEADER_KIND;
@@ -263,6 +266,8 @@ test_multipart_garbage (void)
     header.value =
       MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x";
     header.header_size = MHD_STATICSTR_LEN_ (MHD_HTTP_HEADER_CONTENT_TYPE);
+    header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                       header.header_size);
     header.value_size = MHD_STATICSTR_LEN_ (
       MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x");
     header.kind = MHD_HEADER_KIND;
@@ -305,6 +310,8 @@ test_multipart_splits (void)
     header.value =
       MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x";
     header.header_size = strlen (header.header);
+    header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                       header.header_size);
     header.value_size = strlen (header.value);
     header.kind = MHD_HEADER_KIND;
     pp = MHD_create_post_processor (&connection,
@@ -344,6 +351,8 @@ test_multipart (void)
     MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x";
   header.kind = MHD_HEADER_KIND;
   header.header_size = strlen (header.header);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = strlen (header.value);
   pp = MHD_create_post_processor (&connection,
                                   1024, &value_checker, &want_off);
@@ -386,6 +395,8 @@ test_nested_multipart (void)
     MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x";
   header.kind = MHD_HEADER_KIND;
   header.header_size = strlen (header.header);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = strlen (header.value);
   pp = MHD_create_post_processor (&connection,
                                   1024, &value_checker, &want_off);
@@ -426,6 +437,8 @@ test_empty_value (void)
   header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
   header.value = MHD_HTTP_POST_ENCODING_FORM_URLENCODED;
   header.header_size = strlen (header.header);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = strlen (header.value);
   header.kind = MHD_HEADER_KIND;
   pp = MHD_create_post_processor (&connection,
@@ -483,6 +496,8 @@ test_overflow ()
   header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
   header.value = MHD_HTTP_POST_ENCODING_FORM_URLENCODED;
   header.header_size = strlen (header.header);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = strlen (header.value);
   header.kind = MHD_HEADER_KIND;
   for (i = 128; i < 1024 * 1024; i += 1024)
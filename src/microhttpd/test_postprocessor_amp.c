@@ -1,6 +1,7 @@
 #include "platform.h"
 #include "microhttpd.h"
 #include "internal.h"
+#include "mhd_str.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -40,6 +41,8 @@ main (int argc, char *const *argv)
   header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
   header.value = MHD_HTTP_POST_ENCODING_FORM_URLENCODED;
   header.header_size = strlen (header.header);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = strlen (header.value);
   header.kind = MHD_HEADER_KIND;
 
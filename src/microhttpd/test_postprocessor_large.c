@@ -27,6 +27,7 @@
 #include "platform.h"
 #include "microhttpd.h"
 #include "internal.h"
+#include "mhd_str.h"
 #include "mhd_compat.h"
 
 #ifndef WINDOWS
@@ -81,6 +82,8 @@ test_simple_large ()
   header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
   header.value = MHD_HTTP_POST_ENCODING_FORM_URLENCODED;
   header.header_size = strlen (header.header);
+  header.header_hash = MHD_str_hash_caseless_bin_n_ (header.header,
+                                                     header.header_size);
   header.value_size = strlen (header.value);
   header.kind = MHD_HEADER_KIND;
   pp = MHD_create_post_processor (&connection, 1024, &value_checker, &pos);
@@ -101,6 +101,27 @@ testMultithreadedPoolGet (int poll_flag)
 }
 
 
+#ifdef SO_REUSEPORT
+static int
+testMultithreadedPoolReuseportGet (int poll_flag)
+{
+  struct MHD_Daemon *d;
+
+  d = MHD_start_daemon (MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG
+                        | MHD_USE_REUSEPORT_WORKER_LISTENERS | poll_flag,
+                        0, NULL, NULL, &ahc_echo, "GET",
+                        MHD_OPTION_THREAD_POOL_SIZE, MHD_CPU_COUNT,
+                        MHD_OPTION_END);
+  if (d == NULL)
+    return 16;
+  MHD_stop_daemon (d);
+  return 0;
+}
+
+
+#endif /* SO_REUSEPORT */
+
+
 #endif
 
 
@@ -132,6 +153,9 @@ main (int argc,
   errorCount += testInternalGet (0);
   errorCount += testMultithreadedGet (0);
   errorCount += testMultithreadedPoolGet (0);
+#ifdef SO_REUSEPORT
+  errorCount += testMultithreadedPoolReuseportGet (0);
+#endif /* SO_REUSEPORT */
 #endif
   errorCount += testExternalGet ();
 #if defined (MHD_USE_POSIX_THREADS) || defined(MHD_USE_W32_THREADS)
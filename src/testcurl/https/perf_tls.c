@@ -0,0 +1,294 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_tls.c
+ * @brief TLS handshake and record-throughput benchmark
+ * @author Christian Grothoff
+ *
+ * Measures, against an in-process HTTPS daemon: full handshakes/s,
+ * resumed (session-ticket) handshakes/s, and bulk record
+ * throughput on one established session.  Usage:
+ * perf_tls [SECONDS-PER-PHASE [BODY-KB]].  Defaults are tiny so
+ * 'make check' only smoke-tests the harness.
+ */
+#include "platform.h"
+#include "microhttpd.h"
+#include <gnutls/gnutls.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <time.h>
+#include "tls_test_keys.h"
+
+static char *body;
+static size_t body_size;
+static uint16_t port;
+
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+
+static enum MHD_Result
+ahc_echo (void *cls, struct MHD_Connection *connection, const char *url,
+          const char *method, const char *version, const char *upload_data,
+          size_t *upload_data_size, void **unused)
+{
+  static int ptr;
+  struct MHD_Response *response;
+  enum MHD_Result ret;
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+  if (&ptr != *unused)
+  {
+    *unused = &ptr;
+    return MHD_YES;
+  }
+  *unused = NULL;
+  response = MHD_create_response_from_buffer (body_size, body,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+static int
+tcp_connect (void)
+{
+  struct sockaddr_in addr;
+  int s;
+  static const int on = 1;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  s = socket (AF_INET, SOCK_STREAM, 0);
+  if (0 != connect (s, (struct sockaddr *) &addr, sizeof (addr)))
+  {
+    close (s);
+    return -1;
+  }
+  setsockopt (s, IPPROTO_TCP, TCP_NODELAY, (const void *) &on, sizeof (on));
+  return s;
+}
+
+
+/**
+ * Perform one client handshake; optionally resuming from and/or
+ * capturing session data.
+ *
+ * @return 0 on success
+ */
+static int
+tls_session (gnutls_certificate_credentials_t cred,
+             gnutls_datum_t *resume_from,
+             gnutls_datum_t *capture_to,
+             int *out_fd,
+             gnutls_session_t *out_session,
+             int *was_resumed)
+{
+  gnutls_session_t s;
+  int fd;
+  int ret;
+
+  fd = tcp_connect ();
+  if (-1 == fd)
+    return 1;
+  gnutls_init (&s, GNUTLS_CLIENT);
+  gnutls_set_default_priority (s);
+  gnutls_credentials_set (s, GNUTLS_CRD_CERTIFICATE, cred);
+  if ( (NULL != resume_from) && (NULL != resume_from->data) )
+    gnutls_session_set_data (s, resume_from->data, resume_from->size);
+  gnutls_transport_set_int (s, fd);
+  do
+  {
+    ret = gnutls_handshake (s);
+  } while ((GNUTLS_E_AGAIN == ret) || (GNUTLS_E_INTERRUPTED == ret));
+  if (GNUTLS_E_SUCCESS != ret)
+  {
+    gnutls_deinit (s);
+    close (fd);
+    return 1;
+  }
+  if (NULL != was_resumed)
+    *was_resumed = (0 != gnutls_session_is_resumed (s));
+  if (NULL != capture_to)
+  {
+    /* For TLS 1.3 the ticket arrives after the handshake; poke the
+     * server once so the NewSessionTicket is read. */
+    char buf[4096];
+    ssize_t r;
+
+    gnutls_record_send (s, "GET / HTTP/1.0\r\n\r\n", 18);
+    while (0 < (r = gnutls_record_recv (s, buf, sizeof (buf))))
+      (void) r;
+    (void) gnutls_session_get_data2 (s, capture_to);
+  }
+  if (NULL != out_session)
+  {
+    *out_session = s;
+    *out_fd = fd;
+  }
+  else
+  {
+    gnutls_bye (s, GNUTLS_SHUT_WR);
+    gnutls_deinit (s);
+    close (fd);
+  }
+  return 0;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int seconds = 1;
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *dinfo;
+  gnutls_certificate_credentials_t cred;
+  gnutls_datum_t ticket = { NULL, 0 };
+  uint64_t t0, deadline;
+  uint64_t count;
+
+  body_size = 64 * 1024;
+  if (argc > 1)
+    seconds = (unsigned int) atoi (argv[1]);
+  if (argc > 2)
+    body_size = (size_t) atol (argv[2]) * 1024;
+  if (0 == body_size)
+    body_size = 1024;
+  body = malloc (body_size);
+  memset (body, 'x', body_size);
+
+  gnutls_global_init ();
+  gnutls_certificate_allocate_credentials (&cred);
+
+  d = MHD_start_daemon (MHD_USE_AUTO_INTERNAL_THREAD | MHD_USE_TLS
+                        | MHD_USE_ERROR_LOG | MHD_USE_TLS_SESSION_TICKETS,
+                        0, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 77;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  port = dinfo->port;
+
+  /* phase 1: full handshakes */
+  count = 0;
+  t0 = now_ns ();
+  deadline = t0 + (uint64_t) seconds * 1000000000ULL;
+  while (now_ns () < deadline)
+  {
+    if (0 != tls_session (cred, NULL, NULL, NULL, NULL, NULL))
+      return 1;
+    count++;
+  }
+  printf ("full-handshakes/s:    %llu\n",
+          (unsigned long long) (count / seconds));
+
+  /* capture a ticket */
+  if (0 != tls_session (cred, NULL, &ticket, NULL, NULL, NULL))
+    return 1;
+
+  /* phase 2: resumed handshakes */
+  count = 0;
+  {
+    uint64_t resumed = 0;
+
+    t0 = now_ns ();
+    deadline = t0 + (uint64_t) seconds * 1000000000ULL;
+    while (now_ns () < deadline)
+    {
+      int wr = 0;
+
+      if (0 != tls_session (cred, &ticket, NULL, NULL, NULL, &wr))
+        return 1;
+      count++;
+      if (wr)
+        resumed++;
+    }
+    printf ("resumed-handshakes/s: %llu (%llu%% actually resumed)\n",
+            (unsigned long long) (count / seconds),
+            (unsigned long long) ((0 == count) ? 0 : resumed * 100 / count));
+  }
+
+  /* phase 3: bulk throughput on one session */
+  {
+    gnutls_session_t s;
+    int fd;
+    uint64_t bytes = 0;
+    uint64_t resp_size = 0;
+    char buf[65536];
+
+    if (0 != tls_session (cred, NULL, NULL, &fd, &s, NULL))
+      return 1;
+    t0 = now_ns ();
+    deadline = t0 + (uint64_t) seconds * 1000000000ULL;
+    while (now_ns () < deadline)
+    {
+      ssize_t r;
+      uint64_t got = 0;
+
+      gnutls_record_send (s, "GET / HTTP/1.1\r\nHost: p\r\n\r\n", 27);
+      while ( (0 == resp_size) || (got < resp_size) )
+      {
+        r = gnutls_record_recv (s, buf, sizeof (buf));
+        if (r <= 0)
+          return 1;
+        if ( (0 == resp_size) && (0 == got) )
+        {
+          /* learn the exact response size from the first reply */
+          const char *he = strstr (buf, "\r\n\r\n");
+
+          if (NULL != he)
+            resp_size = (uint64_t) (he + 4 - buf) + body_size;
+        }
+        got += (uint64_t) r;
+        if ( (0 == resp_size) && (got > body_size) )
+          break; /* header-end straddled a record; approximate */
+      }
+      bytes += got;
+    }
+    printf ("bulk-throughput:      %.1f MB/s (%s)\n",
+            (double) bytes * 1e3 / (double) (now_ns () - t0),
+            gnutls_cipher_get_name (gnutls_cipher_get (s)));
+    gnutls_bye (s, GNUTLS_SHUT_WR);
+    gnutls_deinit (s);
+    close (fd);
+  }
+
+  MHD_stop_daemon (d);
+  gnutls_free (ticket.data);
+  gnutls_certificate_free_credentials (cred);
+  gnutls_global_deinit ();
+  free (body);
+  return 0;
+}
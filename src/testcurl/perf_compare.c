@@ -0,0 +1,186 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_compare.c
+ * @brief diff two perf-suite result files and flag regressions
+ * @author Christian Grothoff
+ *
+ * Usage: perf_compare BASELINE.json CURRENT.json [noise-percent]
+ *
+ * Both inputs are files of lines in the fixed shape emitted by
+ * perf_report.h.  Metrics present in both files are compared;
+ * higher-is-better metrics (requests/s, bytes/s, MiB/s) that drop
+ * by more than the noise threshold -- and lower-is-better metrics
+ * (seconds, ms, us) that grow by more than it -- are reported as
+ * regressions.  Exit status is the number of regressions (0 =
+ * performance contract holds), so CI can gate on it directly.
+ * The default noise threshold is 10 percent.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Maximum number of metrics tracked per result file.
+ */
+#define MAX_METRICS 256
+
+/**
+ * One parsed result line.
+ */
+struct Metric
+{
+  char benchmark[128];
+  char metric[64];
+  char unit[32];
+  double value;
+};
+
+
+/**
+ * Parse one result file into @a m.
+ *
+ * @param fn file to parse
+ * @param m array of at least #MAX_METRICS entries
+ * @return number of entries parsed, -1 on open failure
+ */
+static int
+load_file (const char *fn,
+           struct Metric *m)
+{
+  FILE *f = fopen (fn, "r");
+  char line[512];
+  int n = 0;
+
+  if (NULL == f)
+    return -1;
+  while ( (n < MAX_METRICS) &&
+          (NULL != fgets (line, sizeof (line), f)) )
+  {
+    if (4 == sscanf (line,
+                     "{\"benchmark\":\"%127[^\"]\",\"metric\":\"%63[^\"]\","
+                     "\"value\":%lf,\"unit\":\"%31[^\"]\"}",
+                     m[n].benchmark,
+                     m[n].metric,
+                     &m[n].value,
+                     m[n].unit))
+      n++;
+  }
+  fclose (f);
+  return n;
+}
+
+
+/**
+ * Decide the improvement direction for a metric from its unit.
+ *
+ * @param unit the unit string
+ * @return 1 if higher values are better, -1 if lower are better,
+ *         0 if unknown (metric is reported but not gated)
+ */
+static int
+direction (const char *unit)
+{
+  if ( (NULL != strstr (unit, "/s")) ||
+       (NULL != strstr (unit, "per-s")) )
+    return 1;
+  if ( (0 == strcmp (unit, "seconds")) ||
+       (0 == strcmp (unit, "ms")) ||
+       (0 == strcmp (unit, "us")) )
+    return -1;
+  return 0;
+}
+
+
+int
+main (int argc,
+      char *const *argv)
+{
+  static struct Metric base[MAX_METRICS];
+  static struct Metric cur[MAX_METRICS];
+  int nb;
+  int nc;
+  int i;
+  int j;
+  int regressions = 0;
+  double noise = 10.0;
+
+  if (argc < 3)
+  {
+    /* no inputs: nothing to compare.  This binary is built via
+       check_PROGRAMS and hence run argument-less by 'make check'
+       (TESTS = $(check_PROGRAMS)); report SKIP there instead of
+       failing the suite. */
+    fprintf (stderr,
+             "Usage: %s BASELINE.json CURRENT.json [noise-percent]\n",
+             argv[0]);
+    return 77;
+  }
+  if (argc > 3)
+    noise = atof (argv[3]);
+  nb = load_file (argv[1], base);
+  nc = load_file (argv[2], cur);
+  if ( (0 > nb) ||
+       (0 > nc) )
+  {
+    fprintf (stderr,
+             "Failed to open input files.\n");
+    return 99;
+  }
+  for (i = 0; i < nb; i++)
+  {
+    for (j = 0; j < nc; j++)
+      if ( (0 == strcmp (base[i].benchmark, cur[j].benchmark)) &&
+           (0 == strcmp (base[i].metric, cur[j].metric)) )
+        break;
+    if (j == nc)
+      continue; /* metric vanished; not gated */
+    {
+      const int dir = direction (base[i].unit);
+      const double delta_pct = (0.0 != base[i].value)
+                               ? 100.0 * (cur[j].value - base[i].value)
+                               / base[i].value
+                               : 0.0;
+      const int regressed = ( (1 == dir) && (delta_pct < -noise) ) ||
+                            ( (-1 == dir) && (delta_pct > noise) );
+
+      printf ("%-40s %-20s %12.2f -> %12.2f %-12s %+7.2f%%%s\n",
+              base[i].benchmark,
+              base[i].metric,
+              base[i].value,
+              cur[j].value,
+              base[i].unit,
+              delta_pct,
+              regressed ? "  REGRESSION" : "");
+      if (regressed)
+        regressions++;
+    }
+  }
+  if (0 != regressions)
+    fprintf (stderr,
+             "%d regression(s) beyond %.1f%% noise threshold.\n",
+             regressions,
+             noise);
+  return regressions;
+}
+
+
+/* end of perf_compare.c */
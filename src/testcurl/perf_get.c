@@ -44,6 +44,7 @@
 #include <string.h>
 #include <time.h>
 #include "gauger.h"
+#include "perf_report.h"
 #include "mhd_has_in_name.h"
 
 #ifndef WINDOWS
@@ -125,6 +126,11 @@ stop (const char *desc)
           "Sequential GETs",
           rps,
           "requests/s");
+  perf_report_metric (desc,
+                      "sequential-gets",
+                      rps,
+                      "requests/s");
+  perf_report_cpu (desc);
 }
 
 
@@ -41,6 +41,7 @@
 #include <time.h>
 #include <pthread.h>
 #include "gauger.h"
+#include "perf_report.h"
 #include "mhd_has_in_name.h"
 
 #if defined(MHD_CPU_COUNT) && (MHD_CPU_COUNT + 0) < 2
@@ -137,6 +138,11 @@ stop (const char *desc)
           "Parallel GETs",
           rps,
           "requests/s");
+  perf_report_metric (desc,
+                      "concurrent-gets",
+                      rps,
+                      "requests/s");
+  perf_report_cpu (desc);
 }
 
 
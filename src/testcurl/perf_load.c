@@ -0,0 +1,441 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_load.c
+ * @brief keep-alive load harness with latency percentiles
+ * @author Christian Grothoff
+ *
+ * Unlike perf_get.c (libcurl, sequential, mean-only), this harness
+ * drives a configurable number of concurrent keep-alive
+ * connections with raw non-blocking sockets for a fixed duration
+ * and reports requests/s plus p50/p99/p999 latency.  Usage:
+ *
+ *   perf_load [CONNECTIONS [SECONDS [RESPONSE-BYTES [MODE [THREADS [PIPELINE]]]]]]
+ *
+ * MODE: 0 = epoll/auto internal thread (default), 1 = poll,
+ *       2 = select, 3 = thread pool (nproc).
+ * THREADS: shared-nothing client threads (default 1), each with
+ *       its own connection set, poll loop and sample buffer, so
+ *       the generator scales past a single client core and the
+ *       numbers measure MHD rather than the client.
+ * PIPELINE: requests kept in flight per connection (default 1);
+ *       pre-formatted back-to-back request blocks, wrk-style.
+ * Defaults are tiny so that running as part of 'make check' only
+ * smoke-tests the harness itself.
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <time.h>
+#include <pthread.h>
+#include "perf_report.h"
+
+#if defined(MHD_CPU_COUNT) && (MHD_CPU_COUNT + 0) < 2
+#undef MHD_CPU_COUNT
+#endif
+#if ! defined(MHD_CPU_COUNT)
+#define MHD_CPU_COUNT 2
+#endif
+
+#define MAX_CONNS 4096
+#define MAX_SAMPLES (1024 * 1024)
+
+static char *body;
+static size_t body_size;
+
+static uint64_t samples[MAX_SAMPLES];
+static size_t num_samples;
+
+struct ClientConn
+{
+  int fd;
+  uint64_t start_ns;
+  size_t to_recv;   /* bytes received since last accounting */
+  size_t resp_size; /* learned size of one full response, 0 yet */
+  size_t hdr_seen;  /* header bytes buffered while learning */
+  char hdr[1024];
+  int sending;
+};
+
+
+/**
+ * Shared-nothing state of one generator thread.
+ */
+struct LoadThread
+{
+  pthread_t tid;
+  unsigned int conns;
+  unsigned int pipeline;
+  uint16_t port;
+  uint64_t deadline;
+  uint64_t total_reqs;
+  uint64_t *samples;
+  size_t num_samples;
+  size_t max_samples;
+  struct ClientConn *cc;
+  struct pollfd *pfd;
+  int failed;
+};
+
+
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+
+static enum MHD_Result
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static int ptr;
+  struct MHD_Response *response;
+  enum MHD_Result ret;
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+
+  if (&ptr != *unused)
+  {
+    *unused = &ptr;
+    return MHD_YES;
+  }
+  *unused = NULL;
+  response = MHD_create_response_from_buffer (body_size,
+                                              body,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection,
+                            MHD_HTTP_OK,
+                            response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+static int
+cmp_u64 (const void *a,
+         const void *b)
+{
+  const uint64_t va = *(const uint64_t *) a;
+  const uint64_t vb = *(const uint64_t *) b;
+
+  return (va < vb) ? -1 : (va > vb);
+}
+
+
+static const char REQ[] =
+  "GET / HTTP/1.1\r\nHost: perf\r\n\r\n";
+
+/**
+ * Pre-formatted block of pipelined requests (REQ repeated up to
+ * the maximum pipeline depth), sent with a single send() call.
+ */
+static char req_block[sizeof (REQ) * 64];
+
+
+/**
+ * One shared-nothing generator thread: private connections,
+ * private poll loop, private sample buffer; results are merged
+ * after join.
+ *
+ * @param cls the thread's #LoadThread state
+ * @return NULL
+ */
+static void *
+load_thread (void *cls)
+{
+  struct LoadThread *lt = cls;
+  struct sockaddr_in addr;
+  unsigned int i;
+  const size_t req_len = (sizeof (REQ) - 1) * lt->pipeline;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (lt->port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  for (i = 0; i < lt->conns; i++)
+  {
+    static const int on = 1;
+
+    lt->cc[i].fd = socket (AF_INET, SOCK_STREAM, 0);
+    if (0 != connect (lt->cc[i].fd, (struct sockaddr *) &addr,
+                      sizeof (addr)))
+    {
+      lt->failed = 1;
+      return NULL;
+    }
+    setsockopt (lt->cc[i].fd, IPPROTO_TCP, TCP_NODELAY,
+                (const void *) &on, sizeof (on));
+    lt->cc[i].sending = 1;
+    lt->pfd[i].fd = lt->cc[i].fd;
+  }
+  while (now_ns () < lt->deadline)
+  {
+    int n;
+
+    for (i = 0; i < lt->conns; i++)
+    {
+      lt->pfd[i].events = lt->cc[i].sending ? POLLOUT : POLLIN;
+      lt->pfd[i].revents = 0;
+    }
+    n = poll (lt->pfd, lt->conns, 100);
+    if (n <= 0)
+      continue;
+    for (i = 0; i < lt->conns; i++)
+    {
+      struct ClientConn *c = &lt->cc[i];
+
+      if (c->sending && (0 != (lt->pfd[i].revents & POLLOUT)))
+      {
+        c->start_ns = now_ns ();
+        if (0 > send (c->fd, req_block, req_len, MSG_NOSIGNAL))
+        {
+          lt->failed = 1;
+          return NULL;
+        }
+        c->sending = 0;
+        c->to_recv = 0;
+      }
+      else if ( (! c->sending) && (0 != (lt->pfd[i].revents & POLLIN)) )
+      {
+        char buf[65536];
+        ssize_t r = recv (c->fd, buf, sizeof (buf), 0);
+
+        if (r <= 0)
+        {
+          lt->failed = 1;
+          return NULL;
+        }
+        if (0 == c->resp_size)
+        {
+          /* learn the (constant) size of one response from the
+             first header: everything after it is arithmetic */
+          size_t take = (size_t) r;
+          const char *eoh;
+
+          if (take > sizeof (c->hdr) - c->hdr_seen)
+            take = sizeof (c->hdr) - c->hdr_seen;
+          memcpy (&c->hdr[c->hdr_seen], buf, take);
+          c->hdr_seen += take;
+          eoh = memmem (c->hdr, c->hdr_seen, "\r\n\r\n", 4);
+          if (NULL != eoh)
+            c->resp_size = (size_t) (eoh + 4 - c->hdr) + body_size;
+        }
+        c->to_recv += (size_t) r;
+        if ( (0 != c->resp_size) &&
+             (c->to_recv >= c->resp_size * lt->pipeline) )
+        {
+          /* whole pipelined batch answered */
+          if (lt->num_samples < lt->max_samples)
+            lt->samples[lt->num_samples++] = (now_ns () - c->start_ns)
+                                             / lt->pipeline;
+          lt->total_reqs += lt->pipeline;
+          c->sending = 1;
+        }
+      }
+    }
+  }
+  for (i = 0; i < lt->conns; i++)
+    close (lt->cc[i].fd);
+  return NULL;
+}
+
+
+int
+main (int argc,
+      char *const *argv)
+{
+  unsigned int conns = 8;
+  unsigned int seconds = 1;
+  unsigned int mode = 0;
+  unsigned int threads = 1;
+  unsigned int pipeline = 1;
+  static struct LoadThread lts[64];
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *dinfo;
+  uint16_t port;
+  static struct ClientConn cc[MAX_CONNS];
+  static struct pollfd pfd[MAX_CONNS];
+  struct sockaddr_in addr;
+  uint64_t deadline;
+  uint64_t total_reqs = 0;
+  unsigned int i;
+  unsigned int flags = MHD_USE_AUTO_INTERNAL_THREAD;
+  unsigned int pool = 0;
+
+  body_size = 1024;
+  if (argc > 1)
+    conns = (unsigned int) atoi (argv[1]);
+  if (argc > 2)
+    seconds = (unsigned int) atoi (argv[2]);
+  if (argc > 3)
+    body_size = (size_t) atol (argv[3]);
+  if (argc > 4)
+    mode = (unsigned int) atoi (argv[4]);
+  if (argc > 5)
+    threads = (unsigned int) atoi (argv[5]);
+  if (argc > 6)
+    pipeline = (unsigned int) atoi (argv[6]);
+  if ( (0 == threads) || (threads > 64) )
+    threads = 1;
+  if ( (0 == pipeline) || (pipeline > 64) )
+    pipeline = 1;
+  if ( (0 == conns) || (conns > MAX_CONNS) )
+    conns = 8;
+  if (conns < threads)
+    conns = threads;
+  if (0 == body_size)
+    body_size = 1;
+  switch (mode)
+  {
+  case 1: flags = MHD_USE_POLL_INTERNAL_THREAD; break;
+  case 2: flags = MHD_USE_INTERNAL_POLLING_THREAD; break;
+  case 3: flags = MHD_USE_AUTO_INTERNAL_THREAD; pool = MHD_CPU_COUNT; break;
+  default: break;
+  }
+  body = malloc (body_size);
+  if (NULL == body)
+    return 77;
+  memset (body, 'x', body_size);
+
+  if (0 != pool)
+    d = MHD_start_daemon (flags | MHD_USE_ERROR_LOG,
+                          0, NULL, NULL,
+                          &ahc_echo, NULL,
+                          MHD_OPTION_THREAD_POOL_SIZE, pool,
+                          MHD_OPTION_END);
+  else
+    d = MHD_start_daemon (flags | MHD_USE_ERROR_LOG,
+                          0, NULL, NULL,
+                          &ahc_echo, NULL,
+                          MHD_OPTION_END);
+  if (NULL == d)
+    return 77;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  port = dinfo->port;
+
+  {
+    unsigned int t;
+    unsigned int per = conns / threads;
+    unsigned int extra = conns % threads;
+    unsigned int off = 0;
+    uint64_t deadline = now_ns () + (uint64_t) seconds * 1000000000ULL;
+
+    /* pre-format the pipelined request block once */
+    for (t = 0; t < pipeline; t++)
+      memcpy (&req_block[t * (sizeof (REQ) - 1)],
+              REQ,
+              sizeof (REQ) - 1);
+    for (t = 0; t < threads; t++)
+    {
+      lts[t].conns = per + ((t < extra) ? 1 : 0);
+      lts[t].pipeline = pipeline;
+      lts[t].port = port;
+      lts[t].deadline = deadline;
+      lts[t].cc = &cc[off];
+      lts[t].pfd = &pfd[off];
+      lts[t].samples = malloc (sizeof (uint64_t)
+                               * (MAX_SAMPLES / threads));
+      lts[t].max_samples = MAX_SAMPLES / threads;
+      if (NULL == lts[t].samples)
+        return 77;
+      off += lts[t].conns;
+      if (0 != pthread_create (&lts[t].tid, NULL, &load_thread, &lts[t]))
+        return 77;
+    }
+    for (t = 0; t < threads; t++)
+    {
+      pthread_join (lts[t].tid, NULL);
+      if (lts[t].failed)
+      {
+        fprintf (stderr, "client thread %u failed\n", t);
+        return 1;
+      }
+      total_reqs += lts[t].total_reqs;
+      memcpy (&samples[num_samples],
+              lts[t].samples,
+              sizeof (uint64_t) * lts[t].num_samples);
+      num_samples += lts[t].num_samples;
+      free (lts[t].samples);
+    }
+  }
+  MHD_stop_daemon (d);
+  free (body);
+
+  if (0 == num_samples)
+  {
+    fprintf (stderr, "no requests completed\n");
+    return 1;
+  }
+  qsort (samples, num_samples, sizeof (samples[0]), &cmp_u64);
+  printf ("conns=%u dur=%us size=%zu reqs=%llu rps=%llu "
+          "p50=%lluus p99=%lluus p999=%lluus\n",
+          conns, seconds, body_size,
+          (unsigned long long) total_reqs,
+          (unsigned long long) (total_reqs / seconds),
+          (unsigned long long) (samples[num_samples / 2] / 1000),
+          (unsigned long long) (samples[(size_t) (num_samples * 0.99)] / 1000),
+          (unsigned long long) (samples[(size_t) (num_samples * 0.999)]
+                                / 1000));
+  {
+    char bench[64];
+
+    snprintf (bench,
+              sizeof (bench),
+              "load-c%u-b%zu",
+              conns,
+              body_size);
+    perf_report_metric (bench,
+                        "throughput",
+                        (double) total_reqs / seconds,
+                        "requests/s");
+    perf_report_metric (bench,
+                        "latency-p50",
+                        (double) samples[num_samples / 2] / 1000.0,
+                        "us");
+    perf_report_metric (bench,
+                        "latency-p99",
+                        (double) samples[(size_t) (num_samples * 0.99)]
+                        / 1000.0,
+                        "us");
+    perf_report_metric (bench,
+                        "latency-p999",
+                        (double) samples[(size_t) (num_samples * 0.999)]
+                        / 1000.0,
+                        "us");
+    perf_report_cpu (bench);
+  }
+  return 0;
+}
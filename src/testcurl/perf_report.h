@@ -0,0 +1,105 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_report.h
+ * @brief machine-readable result emission for the perf benchmarks
+ * @author Christian Grothoff
+ *
+ * Every benchmark metric is emitted as one JSON object per line:
+ *
+ *   {"benchmark":"...","metric":"...","value":NNN.NN,"unit":"..."}
+ *
+ * to the file named by the MHD_PERF_OUTPUT environment variable
+ * (appending, so one file can collect a whole suite run) or, when
+ * the variable is unset, to stdout.  The fixed shape is what the
+ * perf_compare tool parses to diff two result sets and flag
+ * regressions, giving the project a shared performance contract;
+ * see perf_compare.c.
+ */
+#ifndef MHD_PERF_REPORT_H
+#define MHD_PERF_REPORT_H 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/**
+ * Emit one benchmark metric in the machine-readable format.
+ *
+ * @param benchmark name of the benchmark scenario
+ * @param metric name of the measured quantity
+ * @param value the measured value
+ * @param unit unit of @a value
+ */
+static void
+perf_report_metric (const char *benchmark,
+                    const char *metric,
+                    double value,
+                    const char *unit)
+{
+  const char *out = getenv ("MHD_PERF_OUTPUT");
+  FILE *f = stdout;
+
+  if (NULL != out)
+  {
+    f = fopen (out, "a");
+    if (NULL == f)
+      f = stdout;
+  }
+  fprintf (f,
+           "{\"benchmark\":\"%s\",\"metric\":\"%s\","
+           "\"value\":%.6f,\"unit\":\"%s\"}\n",
+           benchmark,
+           metric,
+           value,
+           unit);
+  if (stdout != f)
+    fclose (f);
+  else
+    fflush (f);
+}
+
+
+/**
+ * Emit the process's CPU consumption so far (user+system), for
+ * CPU-per-request style metrics next to the throughput numbers.
+ *
+ * @param benchmark name of the benchmark scenario
+ */
+static void
+perf_report_cpu (const char *benchmark)
+{
+  struct rusage ru;
+
+  if (0 != getrusage (RUSAGE_SELF,
+                      &ru))
+    return;
+  perf_report_metric (benchmark,
+                      "cpu-total",
+                      (double) ru.ru_utime.tv_sec
+                      + (double) ru.ru_utime.tv_usec / 1e6
+                      + (double) ru.ru_stime.tv_sec
+                      + (double) ru.ru_stime.tv_usec / 1e6,
+                      "seconds");
+}
+
+#endif /* MHD_PERF_REPORT_H */
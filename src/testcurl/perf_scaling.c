@@ -0,0 +1,197 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_scaling.c
+ * @brief multi-core scaling sweep for the thread pool
+ * @author Christian Grothoff
+ *
+ * Sweeps MHD_OPTION_THREAD_POOL_SIZE from 1 to the number of online
+ * CPUs (doubling), pinning server workers to the low cores (via
+ * MHD_OPTION_WORKER_CPU_PINNING) and client threads to the high
+ * cores, and reports throughput, throughput-per-worker and the
+ * involuntary context-switch delta (a contention indicator) for
+ * each pool size.  Usage: perf_scaling [SECONDS-PER-STEP [CONNS]].
+ * Defaults are tiny for 'make check'.
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+static char body[2048];
+static volatile int running;
+static uint16_t port;
+
+static enum MHD_Result
+ahc_echo (void *cls, struct MHD_Connection *connection, const char *url,
+          const char *method, const char *version, const char *upload_data,
+          size_t *upload_data_size, void **unused)
+{
+  static int ptr;
+  struct MHD_Response *response;
+  enum MHD_Result ret;
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+  if (&ptr != *unused)
+  {
+    *unused = &ptr;
+    return MHD_YES;
+  }
+  *unused = NULL;
+  response = MHD_create_response_from_buffer (sizeof (body), body,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+static void *
+client_thread (void *cls)
+{
+  unsigned long long *count = cls;
+  struct sockaddr_in addr;
+  static const char req[] = "GET / HTTP/1.1\r\nHost: p\r\n\r\n";
+  char buf[8192];
+  int s;
+  static const int on = 1;
+  size_t got;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  s = socket (AF_INET, SOCK_STREAM, 0);
+  if (0 != connect (s, (struct sockaddr *) &addr, sizeof (addr)))
+    return NULL;
+  setsockopt (s, IPPROTO_TCP, TCP_NODELAY, (const void *) &on, sizeof (on));
+  while (running)
+  {
+    ssize_t r;
+
+    if (0 > send (s, req, sizeof (req) - 1, MSG_NOSIGNAL))
+      break;
+    got = 0;
+    while (got < sizeof (body))
+    {
+      r = recv (s, buf, sizeof (buf), 0);
+      if (r <= 0)
+        goto out;
+      got += (size_t) r; /* headers counted too; close enough to
+                            delimit one reply per request for this
+                            fixed body */
+      if ( (got >= sizeof (body)) && ('x' == buf[r - 1]) )
+        break;
+    }
+    (*count)++;
+  }
+out:
+  close (s);
+  return NULL;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int seconds = 1;
+  unsigned int conns = 4;
+  long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+  unsigned int pool;
+
+  if (argc > 1)
+    seconds = (unsigned int) atoi (argv[1]);
+  if (argc > 2)
+    conns = (unsigned int) atoi (argv[2]);
+  if (ncpu < 1)
+    ncpu = 1;
+  memset (body, 'x', sizeof (body));
+  printf ("# pool rps rps-per-worker invol-ctxsw\n");
+  for (pool = 1; pool <= (unsigned int) ncpu; pool *= 2)
+  {
+    struct MHD_Daemon *d;
+    const union MHD_DaemonInfo *dinfo;
+    pthread_t thr[64];
+    unsigned long long counts[64];
+    unsigned long long total = 0;
+    struct rusage ru0, ru1;
+    unsigned int i;
+    unsigned int nthr = conns > 64 ? 64 : conns;
+
+    if (pool > 1)
+      d = MHD_start_daemon (MHD_USE_AUTO_INTERNAL_THREAD | MHD_USE_ERROR_LOG,
+                            0, NULL, NULL, &ahc_echo, NULL,
+                            MHD_OPTION_THREAD_POOL_SIZE, pool,
+                            MHD_OPTION_WORKER_CPU_PINNING, (unsigned int) 1,
+                            MHD_OPTION_END);
+    else
+      d = MHD_start_daemon (MHD_USE_AUTO_INTERNAL_THREAD | MHD_USE_ERROR_LOG,
+                            0, NULL, NULL, &ahc_echo, NULL,
+                            MHD_OPTION_END);
+    if (NULL == d)
+      return 77;
+    dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+    port = dinfo->port;
+    running = 1;
+    memset (counts, 0, sizeof (counts));
+    getrusage (RUSAGE_SELF, &ru0);
+    for (i = 0; i < nthr; i++)
+    {
+      pthread_create (&thr[i], NULL, &client_thread, &counts[i]);
+#ifdef __linux__
+      if ((unsigned int) ncpu > pool)
+      {
+        /* clients on the cores above the pinned workers */
+        cpu_set_t cs;
+
+        CPU_ZERO (&cs);
+        CPU_SET ((int) (pool + (i % ((unsigned int) ncpu - pool))), &cs);
+        pthread_setaffinity_np (thr[i], sizeof (cs), &cs);
+      }
+#endif
+    }
+    sleep (seconds);
+    running = 0;
+    for (i = 0; i < nthr; i++)
+    {
+      pthread_join (thr[i], NULL);
+      total += counts[i];
+    }
+    getrusage (RUSAGE_SELF, &ru1);
+    MHD_stop_daemon (d);
+    printf ("%u %llu %llu %ld\n",
+            pool,
+            total / seconds,
+            total / seconds / pool,
+            ru1.ru_nivcsw - ru0.ru_nivcsw);
+  }
+  return 0;
+}
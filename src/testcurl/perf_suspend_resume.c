@@ -0,0 +1,154 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file perf_suspend_resume.c
+ * @brief suspend/resume scalability benchmark
+ * @author Christian Grothoff
+ *
+ * Parks many connections via MHD_suspend_connection and measures
+ * the latency of resuming a single one while the rest stay
+ * suspended -- the metric that degrades when resume processing
+ * scans all suspended connections instead of only the resumed
+ * ones.  Usage: perf_suspend_resume [CONNS].  Defaults are small
+ * for 'make check'; the production engine's resume queue keeps the
+ * reported latency flat in CONNS (the next-generation lib/ engine
+ * still walks all suspended connections and should adopt the same
+ * queue).
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <time.h>
+
+static struct MHD_Connection *conns[70000];
+static volatile unsigned int suspended_cnt;
+
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+
+static enum MHD_Result
+ahc (void *cls, struct MHD_Connection *connection, const char *url,
+     const char *method, const char *version, const char *upload_data,
+     size_t *upload_data_size, void **ptr)
+{
+  static int dummy;
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+  if (&dummy != *ptr)
+  {
+    *ptr = &dummy;
+    conns[suspended_cnt++] = connection;
+    MHD_suspend_connection (connection);
+    return MHD_YES;
+  }
+  {
+    struct MHD_Response *r;
+    enum MHD_Result ret;
+
+    r = MHD_create_response_from_buffer (2,
+                                         "ok",
+                                         MHD_RESPMEM_PERSISTENT);
+    ret = MHD_queue_response (connection,
+                              MHD_HTTP_OK,
+                              r);
+    MHD_destroy_response (r);
+    return ret;
+  }
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int want = 200;
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *dinfo;
+  uint16_t port;
+  struct sockaddr_in a;
+  unsigned int i;
+  uint64_t t0;
+  uint64_t total = 0;
+  unsigned int rounds = 0;
+
+  if (argc > 1)
+    want = (unsigned int) atoi (argv[1]);
+  if (want > 60000)
+    want = 60000;
+  d = MHD_start_daemon (MHD_USE_AUTO_INTERNAL_THREAD | MHD_USE_ERROR_LOG
+                        | MHD_ALLOW_SUSPEND_RESUME,
+                        0, NULL, NULL, &ahc, NULL,
+                        MHD_OPTION_CONNECTION_LIMIT, want + 16,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 77;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  port = dinfo->port;
+  memset (&a, 0, sizeof (a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons (port);
+  a.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  for (i = 0; i < want; i++)
+  {
+    int s = socket (AF_INET, SOCK_STREAM, 0);
+
+    if ( (0 != connect (s, (struct sockaddr *) &a, sizeof (a))) ||
+         (0 > send (s, "GET / HTTP/1.1\r\nHost: l\r\n\r\n", 27,
+                    MSG_NOSIGNAL)) )
+      return 1;
+    /* leak the client fd on purpose: the server side suspends */
+  }
+  /* wait for all to be suspended */
+  for (i = 0; (i < 1000) && (suspended_cnt < want); i++)
+    usleep (10000);
+  if (suspended_cnt < want)
+  {
+    fprintf (stderr, "only %u/%u suspended\n", suspended_cnt, want);
+    return 1;
+  }
+  /* resume a few single connections; measure each resume's cost
+     while 'want - k' others remain suspended */
+  for (rounds = 0; rounds < 32 && rounds < want; rounds++)
+  {
+    t0 = now_ns ();
+    MHD_resume_connection (conns[rounds]);
+    total += now_ns () - t0;
+  }
+  printf ("suspended=%u resume-call-avg=%lluns\n",
+          want,
+          (unsigned long long) (total / rounds));
+  /* resume the rest so the daemon can shut down cleanly */
+  for (i = rounds; i < want; i++)
+    MHD_resume_connection (conns[i]);
+  usleep (200 * 1000);
+  MHD_stop_daemon (d);
+  return 0;
+}
@@ -0,0 +1,237 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+/**
+ * @file test_multi_listener.c
+ * @brief  Testcase for MHD_daemon_add_listener(): extra ports with
+ *         per-listener handler contexts, including a plaintext
+ *         listener on a TLS daemon (MHD_EXTRA_LISTENER_NO_TLS)
+ * @author Christian Grothoff
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#ifdef HTTPS_SUPPORT
+#include "https/tls_test_keys.h"
+#endif /* HTTPS_SUPPORT */
+
+
+static enum MHD_Result
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static int ptr;
+  const char *body = cls;
+  struct MHD_Response *response;
+  enum MHD_Result ret;
+  (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+
+  if (&ptr != *unused)
+  {
+    *unused = &ptr;
+    return MHD_YES;
+  }
+  *unused = NULL;
+  response = MHD_create_response_from_buffer (strlen (body),
+                                              (void *) body,
+                                              MHD_RESPMEM_MUST_COPY);
+  ret = MHD_queue_response (connection,
+                            MHD_HTTP_OK,
+                            response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Fetch '/' from a plaintext port and check that the body equals
+ * @a expect.
+ *
+ * @param port port to connect to
+ * @param expect expected response body
+ * @return 0 on success, 1 on failure
+ */
+static unsigned int
+expect_body (uint16_t port,
+             const char *expect)
+{
+  static const char request[] = "GET / HTTP/1.0\r\nHost: x\r\n\r\n";
+  struct sockaddr_in addr;
+  struct timeval tv = { 2, 0 };
+  char reply[2048];
+  const char *body;
+  int s;
+  int n;
+  int tot = 0;
+
+  s = socket (AF_INET, SOCK_STREAM, 0);
+  if (0 > s)
+    return 1;
+  setsockopt (s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if ( (0 != connect (s, (struct sockaddr *) &addr, sizeof (addr))) ||
+       (0 > send (s, request, sizeof (request) - 1, 0)) )
+  {
+    close (s);
+    return 1;
+  }
+  while ( (tot < (int) sizeof (reply) - 1) &&
+          (0 < (n = recv (s, reply + tot, sizeof (reply) - 1 - tot, 0))) )
+    tot += n;
+  reply[tot] = '\0';
+  close (s);
+  body = strstr (reply, "\r\n\r\n");
+  if ( (NULL == strstr (reply, "200")) ||
+       (NULL == body) ||
+       (0 != strcmp (body + 4, expect)) )
+  {
+    fprintf (stderr,
+             "port %u: expected body '%s', got reply '%.60s'\n",
+             (unsigned int) port,
+             expect,
+             reply);
+    return 1;
+  }
+  return 0;
+}
+
+
+/**
+ * Plain daemon with two extra listeners, each with its own
+ * handler context; requests on each port must reach the right
+ * handler, and the primary port must keep using the default one.
+ */
+static unsigned int
+test_extra_listeners (void)
+{
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *dinfo;
+  unsigned int errorCount = 0;
+
+  d = MHD_start_daemon (MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ITC
+                        | MHD_USE_ERROR_LOG,
+                        0, NULL, NULL, &ahc_echo, (void *) "main",
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 16;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  if (MHD_YES != MHD_daemon_add_listener (d, 42340,
+                                          &ahc_echo, (void *) "admin",
+                                          0))
+  {
+    fprintf (stderr, "MHD_daemon_add_listener failed\n");
+    MHD_stop_daemon (d);
+    return 32;
+  }
+  if (MHD_YES != MHD_daemon_add_listener (d, 42341,
+                                          &ahc_echo, (void *) "metrics",
+                                          0))
+  {
+    fprintf (stderr, "second MHD_daemon_add_listener failed\n");
+    MHD_stop_daemon (d);
+    return 32;
+  }
+  errorCount += expect_body (dinfo->port, "main");
+  errorCount += expect_body (42340, "admin");
+  errorCount += expect_body (42341, "metrics");
+  errorCount += expect_body (dinfo->port, "main");
+  MHD_stop_daemon (d);
+  return errorCount;
+}
+
+
+#ifdef HTTPS_SUPPORT
+/**
+ * TLS daemon with a plaintext extra listener
+ * (#MHD_EXTRA_LISTENER_NO_TLS): the plaintext port must serve
+ * over plain TCP -- the path that crashes if per-connection TLS
+ * state is keyed off the daemon-wide flag.
+ */
+static unsigned int
+test_plain_listener_on_tls_daemon (void)
+{
+  struct MHD_Daemon *d;
+  unsigned int errorCount = 0;
+
+  if (MHD_YES != MHD_is_feature_supported (MHD_FEATURE_TLS))
+    return 0; /* nothing to test in this build */
+  d = MHD_start_daemon (MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_TLS
+                        | MHD_USE_ITC | MHD_USE_ERROR_LOG,
+                        0, NULL, NULL, &ahc_echo, (void *) "tlsmain",
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_signed_cert_pem,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 0; /* TLS backend unavailable at run time */
+  if (MHD_YES != MHD_daemon_add_listener (d, 42342,
+                                          &ahc_echo, (void *) "plain",
+                                          MHD_EXTRA_LISTENER_NO_TLS))
+  {
+    fprintf (stderr, "NO_TLS MHD_daemon_add_listener failed\n");
+    MHD_stop_daemon (d);
+    return 32;
+  }
+  /* two requests: the second exercises the close path of the
+     first plaintext connection on the TLS daemon */
+  errorCount += expect_body (42342, "plain");
+  errorCount += expect_body (42342, "plain");
+  MHD_stop_daemon (d);
+  return errorCount;
+}
+
+
+#endif /* HTTPS_SUPPORT */
+
+
+int
+main (int argc,
+      char *const *argv)
+{
+  unsigned int errorCount = 0;
+  (void) argc; (void) argv; /* Unused. Silent compiler warning. */
+
+  errorCount += test_extra_listeners ();
+#ifdef HTTPS_SUPPORT
+  errorCount += test_plain_listener_on_tls_daemon ();
+#endif /* HTTPS_SUPPORT */
+  if (errorCount != 0)
+    fprintf (stderr,
+             "Error (code: %u)\n",
+             errorCount);
+  return (0 == errorCount) ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+/**
+ * @file test_proxy_protocol.c
+ * @brief  Testcase for PROXY protocol (v1/v2) preamble ingestion
+ * @author Christian Grothoff
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+/**
+ * Client address the handler observed for the last request,
+ * rendered as text ("-" when unavailable).
+ */
+static char seen_addr[64];
+
+
+static enum MHD_Result
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static int ptr;
+  const union MHD_ConnectionInfo *ci;
+  struct MHD_Response *response;
+  enum MHD_Result ret;
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+
+  if (&ptr != *unused)
+  {
+    *unused = &ptr;
+    return MHD_YES;
+  }
+  *unused = NULL;
+  strcpy (seen_addr, "-");
+  ci = MHD_get_connection_info (connection,
+                                MHD_CONNECTION_INFO_CLIENT_ADDRESS);
+  if ( (NULL != ci) &&
+       (AF_INET == ci->client_addr->sa_family) )
+    inet_ntop (AF_INET,
+               &((struct sockaddr_in *) ci->client_addr)->sin_addr,
+               seen_addr,
+               sizeof (seen_addr));
+  response = MHD_create_response_from_buffer (2,
+                                              "ok",
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection,
+                            MHD_HTTP_OK,
+                            response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Send @a preamble (if any) followed by a GET request and collect
+ * the reply.
+ *
+ * @param port port to connect to
+ * @param preamble bytes to send before the HTTP request, may be NULL
+ * @param preamble_len number of bytes in @a preamble
+ * @param split_at if non-zero, send the preamble in two writes with
+ *        a pause after this many bytes (partial-preamble handling)
+ * @param[out] reply buffer for the server's reply
+ * @param reply_size size of @a reply
+ * @return number of reply bytes, -1 on connect failure
+ */
+static int
+do_request (uint16_t port,
+            const char *preamble,
+            size_t preamble_len,
+            size_t split_at,
+            char *reply,
+            size_t reply_size)
+{
+  static const char request[] = "GET / HTTP/1.0\r\nHost: x\r\n\r\n";
+  struct sockaddr_in addr;
+  struct timeval tv = { 2, 0 };
+  int s;
+  int n;
+  int tot = 0;
+
+  s = socket (AF_INET, SOCK_STREAM, 0);
+  if (0 > s)
+    return -1;
+  setsockopt (s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (0 != connect (s, (struct sockaddr *) &addr, sizeof (addr)))
+  {
+    close (s);
+    return -1;
+  }
+  if (0 != preamble_len)
+  {
+    if ( (0 != split_at) &&
+         (split_at < preamble_len) )
+    {
+      if (0 > send (s, preamble, split_at, 0))
+        goto send_failed;
+      usleep (50 * 1000);
+      if (0 > send (s, preamble + split_at, preamble_len - split_at, 0))
+        goto send_failed;
+    }
+    else if (0 > send (s, preamble, preamble_len, 0))
+      goto send_failed;
+  }
+  if (0 > send (s, request, sizeof (request) - 1, 0))
+    goto send_failed;
+  while ( (tot < (int) reply_size - 1) &&
+          (0 < (n = recv (s, reply + tot, reply_size - 1 - tot, 0))) )
+    tot += n;
+  reply[tot] = '\0';
+  close (s);
+  return tot;
+send_failed:
+  close (s);
+  return 0;
+}
+
+
+/**
+ * Expect a successful request whose observed client address is
+ * @a want_addr.
+ *
+ * @param port port to connect to
+ * @param preamble the PROXY preamble to send
+ * @param preamble_len number of bytes in @a preamble
+ * @param split_at partial-write split point, 0 for a single write
+ * @param want_addr expected client address text
+ * @return 0 on success, 1 on failure
+ */
+static unsigned int
+expect_ok (uint16_t port,
+           const char *preamble,
+           size_t preamble_len,
+           size_t split_at,
+           const char *want_addr)
+{
+  char reply[2048];
+
+  seen_addr[0] = '\0';
+  if (0 >= do_request (port, preamble, preamble_len, split_at,
+                       reply, sizeof (reply)))
+  {
+    fprintf (stderr, "request failed entirely\n");
+    return 1;
+  }
+  if (NULL == strstr (reply, "200"))
+  {
+    fprintf (stderr, "no 200 in reply: %.60s\n", reply);
+    return 1;
+  }
+  if (0 != strcmp (seen_addr, want_addr))
+  {
+    fprintf (stderr, "address mismatch: got '%s', want '%s'\n",
+             seen_addr, want_addr);
+    return 1;
+  }
+  return 0;
+}
+
+
+/**
+ * Expect the server to reject the connection (no 200 served).
+ *
+ * @param port port to connect to
+ * @param preamble the (malformed) preamble to send
+ * @param preamble_len number of bytes in @a preamble
+ * @return 0 on success (rejected), 1 on failure (served)
+ */
+static unsigned int
+expect_reject (uint16_t port,
+               const char *preamble,
+               size_t preamble_len)
+{
+  char reply[2048];
+
+  if (0 > do_request (port, preamble, preamble_len, 0,
+                      reply, sizeof (reply)))
+    return 1; /* connect failure is a test error, not a reject */
+  if (NULL != strstr (reply, "200"))
+  {
+    fprintf (stderr, "malformed preamble was served: %.60s\n", reply);
+    return 1;
+  }
+  return 0;
+}
+
+
+static unsigned int
+test_preambles (void)
+{
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *dinfo;
+  uint16_t port;
+  unsigned int errorCount = 0;
+  static const char v1[] = "PROXY TCP4 203.0.113.7 10.0.0.1 55555 80\r\n";
+  static const char v1_unknown[] = "PROXY UNKNOWN\r\n";
+  static const unsigned char v2[] = {
+    0x0D, 0x0A, 0x0D, 0x0A, 0x00, 0x0D, 0x0A, 0x51,
+    0x55, 0x49, 0x54, 0x0A,             /* signature */
+    0x21, 0x11, 0x00, 12,               /* PROXY, TCP/IPv4, len 12 */
+    198, 51, 100, 9,                    /* source address */
+    10, 0, 0, 1,                        /* destination address */
+    0xD9, 0x03, 0x00, 0x50              /* ports 55555, 80 */
+  };
+  static const unsigned char v2_local[] = {
+    0x0D, 0x0A, 0x0D, 0x0A, 0x00, 0x0D, 0x0A, 0x51,
+    0x55, 0x49, 0x54, 0x0A,
+    0x20, 0x00, 0x00, 0                 /* LOCAL, UNSPEC, len 0 */
+  };
+
+  d = MHD_start_daemon (MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG,
+                        0, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_PROXY_PROTOCOL, (unsigned int) 1,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 16;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  if ( (NULL == dinfo) || (0 == dinfo->port) )
+  {
+    MHD_stop_daemon (d);
+    return 32;
+  }
+  port = dinfo->port;
+
+  /* v1 text preamble carries the real client address */
+  errorCount += expect_ok (port, v1, sizeof (v1) - 1, 0,
+                           "203.0.113.7");
+  /* ... also when split across two packets mid-preamble */
+  errorCount += expect_ok (port, v1, sizeof (v1) - 1, 4,
+                           "203.0.113.7");
+  /* v1 UNKNOWN keeps the socket address (loopback) */
+  errorCount += expect_ok (port, v1_unknown, sizeof (v1_unknown) - 1, 0,
+                           "127.0.0.1");
+  /* v2 binary preamble */
+  errorCount += expect_ok (port, (const char *) v2, sizeof (v2), 0,
+                           "198.51.100.9");
+  /* ... split inside the binary header */
+  errorCount += expect_ok (port, (const char *) v2, sizeof (v2), 9,
+                           "198.51.100.9");
+  /* v2 LOCAL (health check) keeps the socket address */
+  errorCount += expect_ok (port, (const char *) v2_local,
+                           sizeof (v2_local), 0,
+                           "127.0.0.1");
+  /* not a preamble at all: reject */
+  errorCount += expect_reject (port, "HELLO WORLD\r\n", 13);
+  /* truncated v2 signature that can never match: reject */
+  errorCount += expect_reject (port, "\x0D\x0A\x0D\x0A\x42", 5);
+  /* v1 line with a bad port: reject */
+  {
+    static const char bad[] = "PROXY TCP4 1.2.3.4 5.6.7.8 99999 80\r\n";
+
+    errorCount += expect_reject (port, bad, sizeof (bad) - 1);
+  }
+
+  /* after the PROXY daemon: plain daemon must still work without
+     preambles (option off by default) */
+  MHD_stop_daemon (d);
+  d = MHD_start_daemon (MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG,
+                        0, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 64;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  port = dinfo->port;
+  errorCount += expect_ok (port, NULL, 0, 0,
+                           "127.0.0.1");
+  MHD_stop_daemon (d);
+  return errorCount;
+}
+
+
+int
+main (int argc,
+      char *const *argv)
+{
+  unsigned int errorCount = 0;
+  (void) argc; (void) argv; /* Unused. Silent compiler warning. */
+
+  errorCount += test_preambles ();
+  if (errorCount != 0)
+    fprintf (stderr,
+             "Error (code: %u)\n",
+             errorCount);
+  return (0 == errorCount) ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 Christian Grothoff
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+/**
+ * @file test_smuggling.c
+ * @brief  Testcase for rejection of smuggling-shaped request framing
+ *         (Transfer-Encoding/Content-Length conflicts)
+ * @author Christian Grothoff
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+
+static enum MHD_Result
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static int ptr;
+  struct MHD_Response *response;
+  enum MHD_Result ret;
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data;
+
+  if (&ptr != *unused)
+  {
+    *unused = &ptr;
+    return MHD_YES;
+  }
+  if (0 != *upload_data_size)
+  {
+    *upload_data_size = 0;
+    return MHD_YES;
+  }
+  *unused = NULL;
+  response = MHD_create_response_from_buffer (2,
+                                              "ok",
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection,
+                            MHD_HTTP_OK,
+                            response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Send @a request verbatim and return the HTTP status code of the
+ * reply (0 if the connection was closed without one).
+ *
+ * @param port port to connect to
+ * @param request the raw request bytes
+ * @return status code, 0 for a bare close, -1 on connect failure
+ */
+static int
+status_of (uint16_t port,
+           const char *request)
+{
+  struct sockaddr_in addr;
+  struct timeval tv = { 2, 0 };
+  char reply[2048];
+  int s;
+  int n;
+  int tot = 0;
+  int code = 0;
+
+  s = socket (AF_INET, SOCK_STREAM, 0);
+  if (0 > s)
+    return -1;
+  setsockopt (s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (0 != connect (s, (struct sockaddr *) &addr, sizeof (addr)))
+  {
+    close (s);
+    return -1;
+  }
+  if (0 > send (s, request, strlen (request), 0))
+  {
+    close (s);
+    return -1;
+  }
+  while ( (tot < (int) sizeof (reply) - 1) &&
+          (0 < (n = recv (s, reply + tot, sizeof (reply) - 1 - tot, 0))) )
+    tot += n;
+  reply[tot] = '\0';
+  close (s);
+  (void) sscanf (reply, "HTTP/1.%*d %d", &code);
+  return code;
+}
+
+
+static unsigned int
+test_framing (void)
+{
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *dinfo;
+  uint16_t port;
+  unsigned int errorCount = 0;
+  unsigned int i;
+  static const struct
+  {
+    const char *request;
+    int expected;
+    const char *what;
+  } cases[] = {
+    /* the smuggling shapes: must be rejected with 400 at the
+       offending header line */
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+      MHD_HTTP_BAD_REQUEST, "CL then TE" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n"
+      "Content-Length: 3\r\n\r\n0\r\n\r\n",
+      MHD_HTTP_BAD_REQUEST, "TE then CL" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n"
+      "Content-Length: 5\r\n\r\nabc",
+      MHD_HTTP_BAD_REQUEST, "differing duplicate CL" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+      MHD_HTTP_BAD_REQUEST, "duplicate TE" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: +3\r\n\r\nabc",
+      MHD_HTTP_BAD_REQUEST, "signed CL" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: 3 \r\n\r\nabc",
+      MHD_HTTP_BAD_REQUEST, "CL with trailing space" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length:\r\n\r\n",
+      MHD_HTTP_BAD_REQUEST, "empty CL" },
+    /* legitimate framings: must still be served */
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n"
+      "Content-Length: 3\r\n\r\nabc",
+      MHD_HTTP_OK, "equal duplicate CL" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n\r\nabc",
+      MHD_HTTP_OK, "plain CL" },
+    { "POST / HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "3\r\nabc\r\n0\r\n\r\n",
+      MHD_HTTP_OK, "plain chunked" },
+  };
+
+  d = MHD_start_daemon (MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG,
+                        0, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 16;
+  dinfo = MHD_get_daemon_info (d, MHD_DAEMON_INFO_BIND_PORT);
+  if ( (NULL == dinfo) || (0 == dinfo->port) )
+  {
+    MHD_stop_daemon (d);
+    return 32;
+  }
+  port = dinfo->port;
+  for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++)
+  {
+    const int code = status_of (port, cases[i].request);
+
+    if (code != cases[i].expected)
+    {
+      fprintf (stderr,
+               "%s: got %d, expected %d\n",
+               cases[i].what,
+               code,
+               cases[i].expected);
+      errorCount++;
+    }
+  }
+  MHD_stop_daemon (d);
+  return errorCount;
+}
+
+
+int
+main (int argc,
+      char *const *argv)
+{
+  unsigned int errorCount = 0;
+  (void) argc; (void) argv; /* Unused. Silent compiler warning. */
+
+  errorCount += test_framing ();
+  if (errorCount != 0)
+    fprintf (stderr,
+             "Error (code: %u)\n",
+             errorCount);
+  return (0 == errorCount) ? 0 : 1;
+}